@@ -780,6 +780,27 @@ intptr_t CL_CgameSystemCalls( intptr_t *args )
 	return 0;
 }
 
+/*
+====================
+Fast path cgame system calls
+
+CG_UpdateCvars syncs every registered cvar each frame; skip the switch
+====================
+*/
+static intptr_t CL_CgameMilliseconds( byte *dataBase, int dataMask, const int *args ) {
+	return Sys_Milliseconds();
+}
+
+static intptr_t CL_CgameCvarUpdate( byte *dataBase, int dataMask, const int *args ) {
+	Cvar_Update( (vmCvar_t*)VMFA(1) );
+	return 0;
+}
+
+static const vmSyscall_t cl_cgameSyscalls[] = {
+	{ CG_MILLISECONDS,		"CG_MILLISECONDS",		CL_CgameMilliseconds },
+	{ CG_CVAR_UPDATE,		"CG_CVAR_UPDATE",		CL_CgameCvarUpdate }
+};
+
 
 /*
 ====================
@@ -815,6 +836,7 @@ void CL_InitCGame( void ) {
 	if ( !cls.cgame ) {
 		Com_Error( ERR_DROP, "VM_Create on cgame failed" );
 	}
+	VM_SetSyscallTable( cls.cgame, cl_cgameSyscalls, ARRAY_LEN( cl_cgameSyscalls ) );
 	clc.state = CA_LOADING;
 
 	Cvar_VariableStringBuffer( "cl_voipSendTarget", backup, sizeof( backup ) );
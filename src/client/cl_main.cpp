@@ -31,6 +31,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #include <climits>
 
+#include "qcommon/jobs.h"
 #include "sys/sys_loadlib.h"
 #include "sys/sys_local.h"
 
@@ -917,6 +918,42 @@ static float CL_DemoFrameDurationSDev(void)
     return sqrt(variance);
 }
 
+/*
+=================
+CL_DemoFrameDurationPercentile
+
+The logged durations are whole msec clamped to UCHAR_MAX, so a
+histogram gives the exact percentile without sorting
+=================
+*/
+static int CL_DemoFrameDurationPercentile(int percent)
+{
+    int i;
+    int numFrames;
+    int target;
+    int counts[UCHAR_MAX + 1] = {0};
+
+    if ((clc.timeDemoFrames - 1) > MAX_TIMEDEMO_DURATIONS)
+        numFrames = MAX_TIMEDEMO_DURATIONS;
+    else
+        numFrames = clc.timeDemoFrames - 1;
+
+    if (numFrames <= 0)
+        return 0;
+
+    for (i = 0; i < numFrames; i++) counts[clc.timeDemoDurations[i]]++;
+
+    target = (numFrames - 1) * percent / 100;
+    for (i = 0; i < UCHAR_MAX; i++)
+    {
+        target -= counts[i];
+        if (target < 0)
+            break;
+    }
+
+    return i;
+}
+
 /*
 =================
 CL_DemoCompleted
@@ -925,11 +962,17 @@ CL_DemoCompleted
 void CL_DemoCompleted(void)
 {
     char buffer[MAX_STRING_CHARS];
+    char percentiles[MAX_STRING_CHARS];
 
     if (cl_timedemo && cl_timedemo->integer)
     {
         int time;
 
+        // end a renderer profile capture running alongside the timedemo,
+        // so its trace and report cover the same frames
+        if (Cvar_VariableIntegerValue("r_profile"))
+            Cvar_Set("r_profile", "0");
+
         time = Sys_Milliseconds() - clc.timeDemoStart;
         if (time > 0)
         {
@@ -940,6 +983,11 @@ void CL_DemoCompleted(void)
                 time / (float)clc.timeDemoFrames, clc.timeDemoMaxDuration, CL_DemoFrameDurationSDev());
             Com_Printf("%s", buffer);
 
+            Com_sprintf(percentiles, sizeof(percentiles), "frame duration percentiles: 50%% %d 90%% %d 99%% %d ms\n",
+                CL_DemoFrameDurationPercentile(50), CL_DemoFrameDurationPercentile(90),
+                CL_DemoFrameDurationPercentile(99));
+            Com_Printf("%s", percentiles);
+
             // Write a log of all the frame durations
             if (cl_timedemoLog && strlen(cl_timedemoLog->string) > 0)
             {
@@ -956,6 +1004,7 @@ void CL_DemoCompleted(void)
                 if (f)
                 {
                     FS_Printf(f, "# %s", buffer);
+                    FS_Printf(f, "# %s", percentiles);
 
                     for (i = 0; i < numFrames; i++) FS_Printf(f, "%d\n", clc.timeDemoDurations[i]);
 
@@ -4744,6 +4793,7 @@ static void CL_InitRef(void)
     ri.Printf = CL_RefPrintf;
     ri.Error = Com_Error;
     ri.Milliseconds = CL_ScaledMilliseconds;
+    ri.Microseconds = Sys_Microseconds;
     ri.Malloc = CL_RefMalloc;
     ri.Free = Z_Free;
 #ifdef HUNK_DEBUG
@@ -4764,6 +4814,7 @@ static void CL_InitRef(void)
     ri.FS_ListFiles = FS_ListFiles;
     ri.FS_FileIsInPAK = FS_FileIsInPAK;
     ri.FS_FileExists = FS_FileExists;
+    ri.FS_HomeRemove = FS_HomeRemove;
     ri.Cvar_Get = Cvar_Get;
     ri.Cvar_Set = Cvar_Set;
     ri.Cvar_SetValue = Cvar_SetValue;
@@ -4787,6 +4838,11 @@ static void CL_InitRef(void)
     ri.Sys_GLimpInit = Sys_GLimpInit;
     ri.Sys_LowPhysicalMemory = Sys_LowPhysicalMemory;
 
+    ri.ParallelFor = Com_ParallelFor;
+    ri.FS_FOpenFileRead = FS_FOpenFileRead;
+    ri.FS_Read = FS_Read;
+    ri.FS_FCloseFile = FS_FCloseFile;
+
     ret = GetRefAPI(REF_API_VERSION, &ri);
 
 #if defined __USEA3D && defined __A3D_GEOM
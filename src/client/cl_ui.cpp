@@ -1182,6 +1182,23 @@ intptr_t CL_UISystemCalls(intptr_t *args)
     return 0;
 }
 
+/*
+====================
+Fast path ui system calls
+
+UI_UpdateCvars syncs every registered cvar each frame; skip the switch
+====================
+*/
+static intptr_t CL_UICvarUpdate(byte *dataBase, int dataMask, const int *args)
+{
+    Cvar_Update((vmCvar_t *)VMFA(1));
+    return 0;
+}
+
+static const vmSyscall_t cl_uiSyscalls[] = {
+    { UI_CVAR_UPDATE, "UI_CVAR_UPDATE", CL_UICvarUpdate }
+};
+
 /*
 ====================
 CL_ShutdownUI
@@ -1245,6 +1262,11 @@ void CL_InitUI(void)
 
     probingUI = false;
 
+    // 1.1 syscall numbers are remapped in CL_UISystemCalls, so they can't
+    // be looked up in the fast path table
+    if (cls.uiInterface != 2)
+        VM_SetSyscallTable(cls.ui, cl_uiSyscalls, ARRAY_LEN(cl_uiSyscalls));
+
     if (clc.state >= CA_CONNECTED && clc.state <= CA_ACTIVE &&
         (clc.netchan.alternateProtocol == 2) != (cls.uiInterface == 2))
     {
@@ -1241,6 +1241,8 @@ void      trap_Trace( trace_t *results, const vec3_t start, const vec3_t mins, c
 int       trap_PointContents( const vec3_t point, int passEntityNum );
 qboolean  trap_InPVS( const vec3_t p1, const vec3_t p2 );
 qboolean  trap_InPVSIgnorePortals( const vec3_t p1, const vec3_t p2 );
+void      trap_InPVSMany( const vec3_t *origins, int numOrigins, const vec3_t *targets, int numTargets,
+                          byte *results, qboolean ignorePortals );
 void      trap_AdjustAreaPortalState( gentity_t *ent, qboolean open );
 qboolean  trap_AreasConnected( int area1, int area2 );
 void      trap_LinkEntity( gentity_t *ent );
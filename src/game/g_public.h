@@ -229,7 +229,12 @@ typedef enum {
 
     G_ADDCOMMAND,
     G_REMOVECOMMAND,
-    G_FS_GETFILTEREDFILES
+    G_FS_GETFILTEREDFILES,
+
+    G_IN_PVS_MANY  // ( const vec3_t *origins, int numOrigins, const vec3_t *targets, int numTargets,
+                   // byte *results, qboolean ignorePortals );
+    // results[ i * numTargets + j ] is qtrue when targets[ j ] is in the PVS of
+    // origins[ i ]; each point's cluster is only looked up once
 } gameImport_t;
 
 //
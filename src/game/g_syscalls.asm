@@ -55,6 +55,7 @@ equ trap_SendGameStat                 -49
 equ trap_AddCommand                   -50
 equ trap_RemoveCommand                -51
 equ trap_FS_GetFilteredFiles           -52
+equ trap_InPVSMany                    -53
 
 equ memset                            -101
 equ memcpy                            -102
@@ -202,6 +202,12 @@ qboolean trap_InPVSIgnorePortals( const vec3_t p1, const vec3_t p2 )
   return syscall( G_IN_PVS_IGNORE_PORTALS, p1, p2 );
 }
 
+void trap_InPVSMany( const vec3_t *origins, int numOrigins, const vec3_t *targets, int numTargets,
+                     byte *results, qboolean ignorePortals )
+{
+  syscall( G_IN_PVS_MANY, origins, numOrigins, targets, numTargets, results, ignorePortals );
+}
+
 void trap_AdjustAreaPortalState( gentity_t *ent, qboolean open )
 {
   syscall( G_ADJUST_AREA_PORTAL_STATE, ent, open );
@@ -280,6 +280,80 @@ gentity_t *Team_GetLocation( gentity_t *ent )
 }
 
 
+static gentity_t *teamLocations[ MAX_CLIENTS ];
+
+/*
+============
+Team_GetLocations
+
+Team_GetLocation for every player on a team, with all of the
+visibility tests done by a single trap_InPVSMany call
+============
+*/
+static void Team_GetLocations( void )
+{
+  static vec3_t   origins[ MAX_CLIENTS ], targets[ MAX_LOCATIONS ];
+  static byte     visible[ MAX_CLIENTS * MAX_LOCATIONS ];
+  static int      players[ MAX_CLIENTS ];
+  gentity_t       *locations[ MAX_LOCATIONS ];
+  gentity_t       *ent, *eloc;
+  int             numPlayers, numLocations;
+  int             i, j;
+  float           bestlen, len;
+
+  numPlayers = 0;
+  for( i = 0; i < g_maxclients.integer; i++ )
+  {
+    ent = g_entities + i;
+    teamLocations[ i ] = NULL;
+
+    if( ent->client->pers.connected != CON_CONNECTED || !ent->inuse )
+      continue;
+
+    if( ent->client->ps.stats[ STAT_TEAM ] != TEAM_HUMANS &&
+        ent->client->ps.stats[ STAT_TEAM ] != TEAM_ALIENS )
+      continue;
+
+    VectorCopy( ent->r.currentOrigin, origins[ numPlayers ] );
+    players[ numPlayers++ ] = i;
+  }
+
+  numLocations = 0;
+  for( eloc = level.locationHead; eloc && numLocations < MAX_LOCATIONS; eloc = eloc->nextTrain )
+  {
+    VectorCopy( eloc->r.currentOrigin, targets[ numLocations ] );
+    locations[ numLocations++ ] = eloc;
+  }
+
+  if( !numPlayers || !numLocations )
+    return;
+
+  trap_InPVSMany( (const vec3_t *)origins, numPlayers, (const vec3_t *)targets, numLocations,
+                  visible, qfalse );
+
+  // same choice as Team_GetLocation: the nearest visible location,
+  // ties going to the one latest in the list
+  for( i = 0; i < numPlayers; i++ )
+  {
+    bestlen = 3.0f * 8192.0f * 8192.0f;
+
+    for( j = 0; j < numLocations; j++ )
+    {
+      len = DistanceSquared( origins[ i ], targets[ j ] );
+
+      if( len > bestlen )
+        continue;
+
+      if( !visible[ i * numLocations + j ] )
+        continue;
+
+      bestlen = len;
+      teamLocations[ players[ i ] ] = locations[ j ];
+    }
+  }
+}
+
+
 /*---------------------------------------------------------------------------*/
 
 /*
@@ -401,6 +475,8 @@ void CheckTeamStatus( void )
   {
     level.lastTeamLocationTime = level.time;
 
+    Team_GetLocations( );
+
     for( i = 0; i < g_maxclients.integer; i++ )
     {
       ent = g_entities + i;
@@ -411,7 +487,7 @@ void CheckTeamStatus( void )
                           ent->client->ps.stats[ STAT_TEAM ] == TEAM_ALIENS ) )
       {
 
-        loc = Team_GetLocation( ent );
+        loc = teamLocations[ i ];
 
         if( loc )
         {
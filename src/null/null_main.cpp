@@ -58,6 +58,10 @@ int		Sys_Milliseconds (void) {
 	return 0;
 }
 
+int64_t	Sys_Microseconds (void) {
+	return 0;
+}
+
 FILE	*Sys_FOpen(const char *ospath, const char *mode) {
 	return fopen( ospath, mode );
 }
@@ -65,6 +69,17 @@ FILE	*Sys_FOpen(const char *ospath, const char *mode) {
 void	Sys_Mkdir (char *path) {
 }
 
+const void	*Sys_MapFile(const char *ospath, long *size) {
+	return NULL;
+}
+
+void	Sys_UnmapFile(const void *data, long size) {
+}
+
+bool	Sys_FileStat(const char *ospath, int64_t *size, int64_t *mtime) {
+	return false;
+}
+
 bool Sys_OpenWithDefault( const char *path )
 {
     return false;
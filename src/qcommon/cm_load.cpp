@@ -24,6 +24,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 // cmodel.c -- model loading
 
 #include "cm_local.h"
+#include "cm_patch.h"
 #include "files.h"
 #include "md4.h"
 
@@ -66,6 +67,9 @@ byte		*cmod_base;
 cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
+cvar_t		*cm_mapCache;
+cvar_t		*cm_simdTrace;
+cvar_t		*cm_traceCache;
 #endif
 
 cmodel_t	box_model;
@@ -626,6 +630,9 @@ void CMod_LoadVisibility( lump_t *l ) {
 /*
 =================
 CMod_LoadPatches
+
+The patches are gathered first and their collision is generated
+together, spread over the job threads
 =================
 */
 #define	MAX_PATCH_VERTS		1024
@@ -636,7 +643,9 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 	int			i, j;
 	int			c;
 	cPatch_t	*patch;
-	vec3_t		points[MAX_PATCH_VERTS];
+	patchBuild_t	*builds;
+	vec3_t		*points;
+	int			numBuilds, numPoints;
 	int			width, height;
 	int			shaderNum;
 
@@ -650,8 +659,30 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 	if (verts->filelen % sizeof(*dv))
 		Com_Error (ERR_DROP, "MOD_LoadBmodel: funny lump size");
 
+	// size the scratch space
+	numBuilds = numPoints = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
+			continue;
+		}
+		c = LittleLong( in[i].patchWidth ) * LittleLong( in[i].patchHeight );
+		if ( c > MAX_PATCH_VERTS ) {
+			Com_Error( ERR_DROP, "ParseMesh: MAX_PATCH_VERTS" );
+		}
+		numBuilds++;
+		numPoints += c;
+	}
+	if ( !numBuilds ) {
+		return;
+	}
+
+	builds = (patchBuild_t *)Hunk_AllocateTempMemory( numBuilds * sizeof( *builds ) + numPoints * sizeof( *points ) );
+	::memset( builds, 0, numBuilds * sizeof( *builds ) );
+	points = (vec3_t *)( builds + numBuilds );
+
 	// scan through all the surfaces, but only load patches,
 	// not planar faces
+	numBuilds = 0;
 	for ( i = 0 ; i < count ; i++, in++ ) {
 		if ( LittleLong( in->surfaceType ) != MST_PATCH ) {
 			continue;		// ignore other surfaces
@@ -660,13 +691,10 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 
 		cm.surfaces[ i ] = patch = (cPatch_t*)Hunk_Alloc( sizeof( *patch ), h_high );
 
-		// load the full drawverts onto the stack
+		// load the full drawverts into the scratch space
 		width = LittleLong( in->patchWidth );
 		height = LittleLong( in->patchHeight );
 		c = width * height;
-		if ( c > MAX_PATCH_VERTS ) {
-			Com_Error( ERR_DROP, "ParseMesh: MAX_PATCH_VERTS" );
-		}
 
 		dv_p = dv + LittleLong( in->firstVert );
 		for ( j = 0 ; j < c ; j++, dv_p++ ) {
@@ -679,9 +707,23 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 		patch->contents = cm.shaders[shaderNum].contentFlags;
 		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
 
-		// create the internal facet structure
-		patch->pc = CM_GeneratePatchCollide( width, height, points );
+		builds[numBuilds].width = width;
+		builds[numBuilds].height = height;
+		builds[numBuilds].points = points;
+		numBuilds++;
+		points += c;
+	}
+
+	// create the internal facet structures
+	CM_GeneratePatchCollides( numBuilds, builds );
+
+	for ( i = 0, j = 0 ; i < count ; i++ ) {
+		if ( cm.surfaces[i] ) {
+			cm.surfaces[i]->pc = builds[j++].result;
+		}
 	}
+
+	Hunk_FreeTempMemory( builds );
 }
 
 //==================================================================
@@ -707,6 +749,589 @@ unsigned CM_Checksum(dheader_t *header) {
 	return LittleLong(Com_BlockChecksum(checksums, 11 * 4));
 }
 
+#ifndef BSPC
+/*
+===============================================================================
+
+					COMPILED MAP CACHE
+
+Once a map has been built from its BSP, the whole clipMap_t, patch
+collision included, is written to cmcache/<checksum>.cm in the home path.
+Loading the same BSP again reads that back in one piece onto the hunk
+and fixes up its pointers, which are stored as offsets into the file.
+
+===============================================================================
+*/
+
+#define	CM_CACHE_IDENT		(('P'<<24)+('A'<<16)+('M'<<8)+'C')
+#define	CM_CACHE_VERSION	1
+#define	CM_CACHE_ALIGN		16
+
+typedef struct {
+	int			ident;
+	int			version;
+	int			layout;			// struct sizes of the build that wrote it
+	int			checksum;		// of the BSP
+	int			bspLength;
+	int			length;			// of the whole file
+	clipMap_t	map;			// pointers are offsets from the start of the file
+} cmCacheHeader_t;
+
+typedef struct {
+	byte		*data;			// NULL while sizing
+	int			length;
+} cmCacheBuf_t;
+
+/*
+=================
+CM_CacheLayout
+
+Caches are only good for builds that lay the structures out the same way
+=================
+*/
+static int CM_CacheLayout( void ) {
+	int		sizes[] = {
+		(int)sizeof( void * ), (int)sizeof( clipMap_t ), (int)sizeof( dshader_t ),
+		(int)sizeof( cplane_t ), (int)sizeof( cNode_t ), (int)sizeof( cLeaf_t ),
+		(int)sizeof( cmodel_t ), (int)sizeof( cbrushside_t ), (int)sizeof( cbrush_t ),
+		(int)sizeof( cbrushedge_t ), (int)sizeof( cArea_t ), (int)sizeof( cPatch_t ),
+		(int)sizeof( patchCollide_t ), (int)sizeof( patchPlane_t ), (int)sizeof( facet_t )
+	};
+
+	return Com_BlockChecksum( sizes, sizeof( sizes ) );
+}
+
+/*
+=================
+CM_CacheReserve
+
+Returns the offset of bytes more in the image.  The image is built
+twice, first without data just to size it.
+=================
+*/
+static intptr_t CM_CacheReserve( cmCacheBuf_t *buf, int bytes ) {
+	intptr_t	ofs = buf->length;
+
+	buf->length += PAD( bytes, CM_CACHE_ALIGN );
+	return ofs;
+}
+
+static intptr_t CM_CacheAppend( cmCacheBuf_t *buf, const void *src, int bytes ) {
+	intptr_t	ofs = CM_CacheReserve( buf, bytes );
+
+	if ( buf->data && bytes ) {
+		::memcpy( buf->data + ofs, src, bytes );
+	}
+	return ofs;
+}
+
+#define	CM_CACHE_PTR(type, ofs)	((type *)(intptr_t)(ofs))
+#define	CM_CACHE_OFS(ptr)		((intptr_t)(ptr))
+
+/*
+=================
+CM_BuildMapCache
+=================
+*/
+static void CM_BuildMapCache( cmCacheBuf_t *buf, int checksum, int bspLength ) {
+	cmCacheHeader_t	header;
+	clipMap_t		*out = &header.map;
+	intptr_t		ofs, edgesOfs;
+	int				i, count;
+
+	::memset( &header, 0, sizeof( header ) );
+	header.ident = CM_CACHE_IDENT;
+	header.version = CM_CACHE_VERSION;
+	header.layout = CM_CacheLayout();
+	header.checksum = checksum;
+	header.bspLength = bspLength;
+	header.map = cm;
+	::memset( out->name, 0, sizeof( out->name ) );
+
+	buf->length = 0;
+	CM_CacheReserve( buf, sizeof( header ) );
+
+	out->shaders = CM_CACHE_PTR( dshader_t,
+		CM_CacheAppend( buf, cm.shaders, cm.numShaders * sizeof( *cm.shaders ) ) );
+	out->planes = CM_CACHE_PTR( cplane_t,
+		CM_CacheAppend( buf, cm.planes, ( cm.numPlanes + BOX_PLANES ) * sizeof( *cm.planes ) ) );
+
+	count = cm.numBrushSides + BOX_SIDES;
+	ofs = CM_CacheAppend( buf, cm.brushsides, count * sizeof( *cm.brushsides ) );
+	out->brushsides = CM_CACHE_PTR( cbrushside_t, ofs );
+	if ( buf->data ) {
+		cbrushside_t	*s = (cbrushside_t *)( buf->data + ofs );
+
+		for ( i = 0 ; i < count ; i++, s++ ) {
+			s->plane = CM_CACHE_PTR( cplane_t, CM_CACHE_OFS( out->planes ) +
+				( cm.brushsides[i].plane - cm.planes ) * sizeof( cplane_t ) );
+			s->winding = NULL;
+		}
+	}
+
+	ofs = CM_CacheAppend( buf, cm.nodes, cm.numNodes * sizeof( *cm.nodes ) );
+	out->nodes = CM_CACHE_PTR( cNode_t, ofs );
+	if ( buf->data ) {
+		cNode_t		*n = (cNode_t *)( buf->data + ofs );
+
+		for ( i = 0 ; i < cm.numNodes ; i++, n++ ) {
+			n->plane = CM_CACHE_PTR( cplane_t, CM_CACHE_OFS( out->planes ) +
+				( cm.nodes[i].plane - cm.planes ) * sizeof( cplane_t ) );
+		}
+	}
+
+	out->leafs = CM_CACHE_PTR( cLeaf_t,
+		CM_CacheAppend( buf, cm.leafs, ( cm.numLeafs + BOX_LEAFS ) * sizeof( *cm.leafs ) ) );
+
+	// the submodels' leaf brushes and surfaces live in their own hunk
+	// blocks, indexed from the main arrays; they go after them here
+	count = cm.numLeafBrushes + BOX_BRUSHES;
+	for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+		count += cm.cmodels[i].leaf.numLeafBrushes;
+	}
+	ofs = CM_CacheReserve( buf, count * sizeof( int ) );
+	out->leafbrushes = CM_CACHE_PTR( int, ofs );
+	if ( buf->data ) {
+		int		*lb = (int *)( buf->data + ofs );
+
+		::memcpy( lb, cm.leafbrushes, ( cm.numLeafBrushes + BOX_BRUSHES ) * sizeof( int ) );
+		lb += cm.numLeafBrushes + BOX_BRUSHES;
+		for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+			const cLeaf_t	*leaf = &cm.cmodels[i].leaf;
+
+			::memcpy( lb, cm.leafbrushes + leaf->firstLeafBrush, leaf->numLeafBrushes * sizeof( int ) );
+			lb += leaf->numLeafBrushes;
+		}
+	}
+
+	count = cm.numLeafSurfaces;
+	for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+		count += cm.cmodels[i].leaf.numLeafSurfaces;
+	}
+	ofs = CM_CacheReserve( buf, count * sizeof( int ) );
+	out->leafsurfaces = CM_CACHE_PTR( int, ofs );
+	if ( buf->data ) {
+		int		*ls = (int *)( buf->data + ofs );
+
+		::memcpy( ls, cm.leafsurfaces, cm.numLeafSurfaces * sizeof( int ) );
+		ls += cm.numLeafSurfaces;
+		for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+			const cLeaf_t	*leaf = &cm.cmodels[i].leaf;
+
+			::memcpy( ls, cm.leafsurfaces + leaf->firstLeafSurface, leaf->numLeafSurfaces * sizeof( int ) );
+			ls += leaf->numLeafSurfaces;
+		}
+	}
+
+	ofs = CM_CacheAppend( buf, cm.cmodels, cm.numSubModels * sizeof( *cm.cmodels ) );
+	out->cmodels = CM_CACHE_PTR( cmodel_t, ofs );
+	if ( buf->data ) {
+		cmodel_t	*m = (cmodel_t *)( buf->data + ofs );
+		int			firstLeafBrush = cm.numLeafBrushes + BOX_BRUSHES;
+		int			firstLeafSurface = cm.numLeafSurfaces;
+
+		for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+			m[i].leaf.firstLeafBrush = firstLeafBrush;
+			m[i].leaf.firstLeafSurface = firstLeafSurface;
+			firstLeafBrush += m[i].leaf.numLeafBrushes;
+			firstLeafSurface += m[i].leaf.numLeafSurfaces;
+		}
+	}
+
+	count = 0;
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		count += cm.brushes[i].numEdges;
+	}
+	edgesOfs = CM_CacheReserve( buf, count * sizeof( cbrushedge_t ) );
+
+	count = cm.numBrushes + BOX_BRUSHES;
+	ofs = CM_CacheAppend( buf, cm.brushes, count * sizeof( *cm.brushes ) );
+	out->brushes = CM_CACHE_PTR( cbrush_t, ofs );
+	if ( buf->data ) {
+		cbrush_t		*b = (cbrush_t *)( buf->data + ofs );
+		cbrushedge_t	*e = (cbrushedge_t *)( buf->data + edgesOfs );
+
+		for ( i = 0 ; i < cm.numBrushes ; i++, b++ ) {
+			b->sides = CM_CACHE_PTR( cbrushside_t, CM_CACHE_OFS( out->brushsides ) +
+				( cm.brushes[i].sides - cm.brushsides ) * sizeof( cbrushside_t ) );
+			b->edges = CM_CACHE_PTR( cbrushedge_t, edgesOfs );
+			b->checkcount = 0;
+			b->collided = false;
+			b->soa = NULL;
+
+			::memcpy( e, cm.brushes[i].edges, b->numEdges * sizeof( *e ) );
+			e += b->numEdges;
+			edgesOfs += b->numEdges * sizeof( *e );
+		}
+
+		// CM_InitBoxHull sets up the box brush again
+		::memset( b, 0, BOX_BRUSHES * sizeof( *b ) );
+	}
+
+	out->visibility = CM_CACHE_PTR( byte, CM_CacheAppend( buf, cm.visibility,
+		cm.vised ? cm.numClusters * cm.clusterBytes : cm.clusterBytes ) );
+	out->entityString = CM_CACHE_PTR( char,
+		CM_CacheAppend( buf, cm.entityString, cm.numEntityChars ) );
+	out->areas = CM_CACHE_PTR( cArea_t,
+		CM_CacheAppend( buf, cm.areas, cm.numAreas * sizeof( *cm.areas ) ) );
+	out->areaPortals = CM_CACHE_PTR( int,
+		CM_CacheAppend( buf, cm.areaPortals, cm.numAreas * cm.numAreas * sizeof( *cm.areaPortals ) ) );
+
+	ofs = CM_CacheReserve( buf, cm.numSurfaces * sizeof( *cm.surfaces ) );
+	out->surfaces = CM_CACHE_PTR( cPatch_t *, ofs );
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		const cPatch_t			*patch = cm.surfaces[i];
+		const patchCollide_t	*pc;
+		intptr_t				patchOfs, pcOfs, planesOfs, facetsOfs;
+
+		if ( !patch ) {
+			if ( buf->data ) {
+				( (cPatch_t **)( buf->data + ofs ) )[i] = NULL;
+			}
+			continue;
+		}
+
+		pc = patch->pc;
+		patchOfs = CM_CacheAppend( buf, patch, sizeof( *patch ) );
+		pcOfs = CM_CacheAppend( buf, pc, sizeof( *pc ) );
+		planesOfs = CM_CacheAppend( buf, pc->planes, pc->numPlanes * sizeof( *pc->planes ) );
+		facetsOfs = CM_CacheAppend( buf, pc->facets, pc->numFacets * sizeof( *pc->facets ) );
+
+		if ( buf->data ) {
+			cPatch_t		*p = (cPatch_t *)( buf->data + patchOfs );
+			patchCollide_t	*c = (patchCollide_t *)( buf->data + pcOfs );
+
+			( (cPatch_t **)( buf->data + ofs ) )[i] = CM_CACHE_PTR( cPatch_t, patchOfs );
+			p->checkcount = 0;
+			p->pc = CM_CACHE_PTR( patchCollide_t, pcOfs );
+			c->planes = CM_CACHE_PTR( patchPlane_t, planesOfs );
+			c->facets = CM_CACHE_PTR( facet_t, facetsOfs );
+		}
+	}
+
+	header.length = buf->length;
+	if ( buf->data ) {
+		::memcpy( buf->data, &header, sizeof( header ) );
+	}
+
+}
+
+/*
+=================
+CM_WriteMapCache
+=================
+*/
+static void CM_WriteMapCache( int checksum, int bspLength ) {
+	cmCacheBuf_t	buf;
+	fileHandle_t	f;
+	char			path[MAX_QPATH], tmppath[MAX_QPATH];
+
+	buf.data = NULL;
+	CM_BuildMapCache( &buf, checksum, bspLength );
+
+	buf.data = (byte *)Hunk_AllocateTempMemory( buf.length );
+	::memset( buf.data, 0, buf.length );
+	CM_BuildMapCache( &buf, checksum, bspLength );
+
+	Com_sprintf( path, sizeof( path ), "cmcache/%08x.cm", (unsigned)checksum );
+	Com_sprintf( tmppath, sizeof( tmppath ), "%s.tmp", path );
+
+	f = FS_SV_FOpenFileWrite( tmppath );
+	if ( f ) {
+		int written = FS_Write( buf.data, buf.length, f );
+
+		FS_FCloseFile( f );
+		if ( written == buf.length ) {
+			FS_SV_Rename( tmppath, path, false );
+			Com_DPrintf( "wrote %s, %i bytes\n", path, buf.length );
+		}
+	}
+
+	Hunk_FreeTempMemory( buf.data );
+}
+
+/*
+=================
+CM_CacheFixup
+
+Turns an offset back into a pointer, if bytes from it are in the file
+=================
+*/
+static bool CM_CacheFixup( byte *base, int length, void *ptr, size_t bytes ) {
+	intptr_t	ofs = *(intptr_t *)ptr;
+
+	if ( ofs < (intptr_t)sizeof( cmCacheHeader_t ) || (size_t)ofs + bytes > (size_t)length ) {
+		return false;
+	}
+
+	*(void **)ptr = base + ofs;
+	return true;
+}
+
+#define	CM_FIXUP(p, n)	CM_CacheFixup( base, header.length, &(p), (size_t)(n) * sizeof( *(p) ) )
+
+/*
+=================
+CM_CacheInArray
+
+True if ptr is one of the count elements of array
+=================
+*/
+static bool CM_CacheInArray( const void *array, size_t size, int count, const void *ptr ) {
+	intptr_t	ofs = (intptr_t)ptr - (intptr_t)array;
+
+	return ofs >= 0 && ofs % size == 0 && ofs / size < (size_t)count;
+}
+
+#define	CM_IN_ARRAY(a, n, p)	CM_CacheInArray( (a), sizeof( *(a) ), (n), (p) )
+
+/*
+=================
+CM_CacheRange
+
+True if first .. first + num - 1 lie in an array of count elements
+=================
+*/
+static bool CM_CacheRange( int first, int num, int count ) {
+	return first >= 0 && num >= 0 && num <= count && first <= count - num;
+}
+
+/*
+=================
+CM_ValidateMapCache
+
+Range checks every index stored in a loaded cache, so a damaged file that
+still matches the BSP is parsed again instead of indexing out of bounds
+=================
+*/
+static bool CM_ValidateMapCache( int numLeafBrushes, int numLeafSurfaces ) {
+	int		i, j;
+
+	for ( i = 0 ; i < cm.numBrushSides + BOX_SIDES ; i++ ) {
+		const cbrushside_t	*side = &cm.brushsides[i];
+
+		if ( !CM_IN_ARRAY( cm.planes, cm.numPlanes + BOX_PLANES, side->plane ) ) {
+			return false;
+		}
+		if ( i < cm.numBrushSides && ( side->shaderNum < 0 || side->shaderNum >= cm.numShaders ) ) {
+			return false;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numNodes ; i++ ) {
+		const cNode_t	*node = &cm.nodes[i];
+
+		if ( !CM_IN_ARRAY( cm.planes, cm.numPlanes, node->plane ) ) {
+			return false;
+		}
+		for ( j = 0 ; j < 2 ; j++ ) {
+			if ( node->children[j] >= cm.numNodes || -1 - node->children[j] >= cm.numLeafs ) {
+				return false;
+			}
+		}
+	}
+
+	for ( i = 0 ; i < cm.numLeafs ; i++ ) {
+		const cLeaf_t	*leaf = &cm.leafs[i];
+
+		if ( leaf->cluster < -1 || leaf->cluster >= cm.numClusters ||
+			leaf->area < -1 || leaf->area >= cm.numAreas ||
+			!CM_CacheRange( leaf->firstLeafBrush, leaf->numLeafBrushes, cm.numLeafBrushes ) ||
+			!CM_CacheRange( leaf->firstLeafSurface, leaf->numLeafSurfaces, cm.numLeafSurfaces ) ) {
+			return false;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numSubModels ; i++ ) {
+		const cLeaf_t	*leaf = &cm.cmodels[i].leaf;
+
+		if ( !CM_CacheRange( leaf->firstLeafBrush, leaf->numLeafBrushes, numLeafBrushes ) ||
+			!CM_CacheRange( leaf->firstLeafSurface, leaf->numLeafSurfaces, numLeafSurfaces ) ) {
+			return false;
+		}
+	}
+
+	for ( i = 0 ; i < numLeafBrushes ; i++ ) {
+		if ( cm.leafbrushes[i] < 0 || cm.leafbrushes[i] >= cm.numBrushes + BOX_BRUSHES ) {
+			return false;
+		}
+	}
+
+	for ( i = 0 ; i < numLeafSurfaces ; i++ ) {
+		if ( cm.leafsurfaces[i] < 0 || cm.leafsurfaces[i] >= cm.numSurfaces ) {
+			return false;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		const cbrush_t	*b = &cm.brushes[i];
+
+		if ( b->shaderNum < 0 || b->shaderNum >= cm.numShaders || b->numsides < 0 ||
+			( b->numsides && ( !CM_IN_ARRAY( cm.brushsides, cm.numBrushSides, b->sides ) ||
+			!CM_IN_ARRAY( cm.brushsides, cm.numBrushSides, b->sides + b->numsides - 1 ) ) ) ) {
+			return false;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		const patchCollide_t	*pc;
+
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+
+		pc = cm.surfaces[i]->pc;
+		for ( j = 0 ; j < pc->numFacets ; j++ ) {
+			const facet_t	*facet = &pc->facets[j];
+			int				k;
+
+			if ( facet->surfacePlane < 0 || facet->surfacePlane >= pc->numPlanes ||
+				facet->numBorders < 0 || facet->numBorders > ARRAY_LEN( facet->borderPlanes ) ) {
+				return false;
+			}
+			for ( k = 0 ; k < facet->numBorders ; k++ ) {
+				if ( facet->borderPlanes[k] < 0 || facet->borderPlanes[k] >= pc->numPlanes ) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+=================
+CM_LoadMapCache
+
+Returns false, with nothing loaded, if there is no cache for this BSP
+=================
+*/
+static bool CM_LoadMapCache( int checksum, int bspLength ) {
+	cmCacheHeader_t	header;
+	fileHandle_t	f;
+	long			length;
+	byte			*base;
+	int				i;
+	int				numLeafBrushes, numLeafSurfaces;
+
+	length = FS_SV_FOpenFileRead( va( "cmcache/%08x.cm", (unsigned)checksum ), &f );
+	if ( !f ) {
+		return false;
+	}
+
+	if ( length < (long)sizeof( header ) || FS_Read( &header, sizeof( header ), f ) != sizeof( header ) ||
+		header.ident != CM_CACHE_IDENT || header.version != CM_CACHE_VERSION ||
+		header.layout != CM_CacheLayout() || header.checksum != checksum ||
+		header.bspLength != bspLength || header.length != length ) {
+		FS_FCloseFile( f );
+		return false;
+	}
+
+	base = (byte *)Hunk_Alloc( length, h_high );
+	::memcpy( base, &header, sizeof( header ) );
+	i = FS_Read( base + sizeof( header ), length - sizeof( header ), f );
+	FS_FCloseFile( f );
+	if ( i != (int)( length - sizeof( header ) ) ) {
+		goto damaged;
+	}
+
+	cm = header.map;
+
+	if ( cm.numShaders < 0 || cm.numBrushSides < 0 || cm.numPlanes < 0 || cm.numNodes < 0 ||
+		cm.numLeafs < 0 || cm.numLeafBrushes < 0 || cm.numLeafSurfaces < 0 ||
+		cm.numSubModels < 0 || cm.numSubModels > MAX_SUBMODELS || cm.numBrushes < 0 ||
+		cm.numClusters < 0 || cm.clusterBytes < 0 || cm.numEntityChars < 0 ||
+		cm.numAreas < 0 || cm.numAreas > MAX_MAP_AREAS || cm.numSurfaces < 0 ||
+		(int64_t)cm.numClusters * cm.clusterBytes > length ) {
+		goto damaged;
+	}
+
+	if ( !CM_FIXUP( cm.shaders, cm.numShaders ) ||
+		!CM_FIXUP( cm.planes, cm.numPlanes + BOX_PLANES ) ||
+		!CM_FIXUP( cm.brushsides, cm.numBrushSides + BOX_SIDES ) ||
+		!CM_FIXUP( cm.nodes, cm.numNodes ) ||
+		!CM_FIXUP( cm.leafs, cm.numLeafs + BOX_LEAFS ) ||
+		!CM_FIXUP( cm.cmodels, cm.numSubModels ) ||
+		!CM_FIXUP( cm.brushes, cm.numBrushes + BOX_BRUSHES ) ||
+		!CM_FIXUP( cm.visibility, cm.vised ? cm.numClusters * cm.clusterBytes : cm.clusterBytes ) ||
+		!CM_FIXUP( cm.entityString, cm.numEntityChars ) ||
+		!CM_FIXUP( cm.areas, cm.numAreas ) ||
+		!CM_FIXUP( cm.areaPortals, cm.numAreas * cm.numAreas ) ||
+		!CM_FIXUP( cm.surfaces, cm.numSurfaces ) ) {
+		goto damaged;
+	}
+
+	// the submodels' leaf brushes and surfaces follow the main ones
+	numLeafBrushes = cm.numLeafBrushes + BOX_BRUSHES;
+	numLeafSurfaces = cm.numLeafSurfaces;
+	for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+		if ( cm.cmodels[i].leaf.numLeafBrushes < 0 || cm.cmodels[i].leaf.numLeafBrushes > length ||
+			cm.cmodels[i].leaf.numLeafSurfaces < 0 || cm.cmodels[i].leaf.numLeafSurfaces > length ) {
+			goto damaged;
+		}
+		numLeafBrushes += cm.cmodels[i].leaf.numLeafBrushes;
+		numLeafSurfaces += cm.cmodels[i].leaf.numLeafSurfaces;
+		if ( numLeafBrushes > length || numLeafSurfaces > length ) {
+			goto damaged;
+		}
+	}
+	if ( !CM_FIXUP( cm.leafbrushes, numLeafBrushes ) || !CM_FIXUP( cm.leafsurfaces, numLeafSurfaces ) ) {
+		goto damaged;
+	}
+
+	for ( i = 0 ; i < cm.numBrushSides + BOX_SIDES ; i++ ) {
+		if ( !CM_FIXUP( cm.brushsides[i].plane, 1 ) ) {
+			goto damaged;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numNodes ; i++ ) {
+		if ( !CM_FIXUP( cm.nodes[i].plane, 1 ) ) {
+			goto damaged;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		cbrush_t	*b = &cm.brushes[i];
+
+		if ( !CM_FIXUP( b->sides, b->numsides ) || !CM_FIXUP( b->edges, b->numEdges ) ) {
+			goto damaged;
+		}
+	}
+
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		patchCollide_t	*pc;
+
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+		if ( !CM_FIXUP( cm.surfaces[i], 1 ) || !CM_FIXUP( cm.surfaces[i]->pc, 1 ) ) {
+			goto damaged;
+		}
+
+		pc = cm.surfaces[i]->pc;
+		if ( pc->numPlanes < 0 || pc->numFacets < 0 ||
+			!CM_FIXUP( pc->planes, pc->numPlanes ) || !CM_FIXUP( pc->facets, pc->numFacets ) ) {
+			goto damaged;
+		}
+	}
+
+	if ( !CM_ValidateMapCache( numLeafBrushes, numLeafSurfaces ) ) {
+		goto damaged;
+	}
+
+	Com_DPrintf( "loaded collision map from cmcache/%08x.cm\n", (unsigned)checksum );
+	return true;
+
+damaged:
+	// the hunk block stays allocated until the next map, which is harmless
+	Com_Printf( S_COLOR_YELLOW "WARNING: cmcache/%08x.cm is damaged, rebuilding it\n", (unsigned)checksum );
+	::memset( &cm, 0, sizeof( cm ) );
+	return false;
+}
+#endif
+
 /*
 ==================
 CM_LoadMap
@@ -716,12 +1341,13 @@ Loads in the map and all submodels
 */
 void CM_LoadMap( const char *name, bool clientload, int *checksum ) {
 	union {
-		int				*i;
-		void			*v;
+		const int		*i;
+		const void		*v;
 	} buf;
 	dheader_t		header;
 	int				length;
 	static unsigned	last_checksum;
+	bool			cached = false;
 
 	if ( !name || !name[0] ) {
 		Com_Error( ERR_DROP, "CM_LoadMap: NULL name" );
@@ -731,6 +1357,10 @@ void CM_LoadMap( const char *name, bool clientload, int *checksum ) {
 	cm_noAreas = Cvar_Get ("cm_noAreas", "0", CVAR_CHEAT);
 	cm_noCurves = Cvar_Get ("cm_noCurves", "0", CVAR_CHEAT);
 	cm_playerCurveClip = Cvar_Get ("cm_playerCurveClip", "1", CVAR_ARCHIVE|CVAR_CHEAT );
+	cm_mapCache = Cvar_Get ("cm_mapCache", "1", CVAR_ARCHIVE);
+	cm_simdTrace = Cvar_Get ("cm_simdTrace", "1", 0);
+	cm_traceCache = Cvar_Get ("cm_traceCache", "0", 0);
+	CM_TraceCacheFrame();
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -756,9 +1386,10 @@ void CM_LoadMap( const char *name, bool clientload, int *checksum ) {
 	// load the file
 	//
 #ifndef BSPC
-	length = FS_ReadFile( name, &buf.v );
+	// the BSP is only read from, so a stored one is used in place
+	length = FS_MapFile( name, &buf.v );
 #else
-	length = LoadQuakeFile((quakefile_t *) name, &buf.v);
+	length = LoadQuakeFile((quakefile_t *) name, (void **)&buf.v);
 #endif
 
 	if ( !buf.i ) {
@@ -780,28 +1411,51 @@ void CM_LoadMap( const char *name, bool clientload, int *checksum ) {
 
 	cmod_base = (byte *)buf.i;
 
-	// load into heap
-	CMod_LoadShaders( &header.lumps[LUMP_SHADERS] );
-	CMod_LoadLeafs (&header.lumps[LUMP_LEAFS]);
-	CMod_LoadLeafBrushes (&header.lumps[LUMP_LEAFBRUSHES]);
-	CMod_LoadLeafSurfaces (&header.lumps[LUMP_LEAFSURFACES]);
-	CMod_LoadPlanes (&header.lumps[LUMP_PLANES]);
-	CMod_LoadBrushSides (&header.lumps[LUMP_BRUSHSIDES]);
-	CMod_LoadBrushes (&header.lumps[LUMP_BRUSHES]);
-	CMod_LoadSubmodels (&header.lumps[LUMP_MODELS]);
-	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
-	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
-	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
-
-	CMod_CreateBrushSideWindings( );
+#ifndef BSPC
+	if ( cm_mapCache->integer ) {
+		cached = CM_LoadMapCache( last_checksum, length );
+	}
+#endif
+
+	if ( !cached ) {
+		// load into heap
+		CMod_LoadShaders( &header.lumps[LUMP_SHADERS] );
+		CMod_LoadLeafs (&header.lumps[LUMP_LEAFS]);
+		CMod_LoadLeafBrushes (&header.lumps[LUMP_LEAFBRUSHES]);
+		CMod_LoadLeafSurfaces (&header.lumps[LUMP_LEAFSURFACES]);
+		CMod_LoadPlanes (&header.lumps[LUMP_PLANES]);
+		CMod_LoadBrushSides (&header.lumps[LUMP_BRUSHSIDES]);
+		CMod_LoadBrushes (&header.lumps[LUMP_BRUSHES]);
+		CMod_LoadSubmodels (&header.lumps[LUMP_MODELS]);
+		CMod_LoadNodes (&header.lumps[LUMP_NODES]);
+		CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
+		CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
+		CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+
+		CMod_CreateBrushSideWindings( );
+	}
 
 	// we are NOT freeing the file, because it is cached for the ref
-	FS_FreeFile (buf.v);
+#ifndef BSPC
+	FS_UnmapFile (buf.v);
+#else
+	FS_FreeFile ((void *)buf.v);
+#endif
+
+	CM_BuildBrushSoA ();
 
 	CM_InitBoxHull ();
 
-	CM_FloodAreaConnections ();
+	if ( !cached ) {
+		CM_FloodAreaConnections ();
+
+#ifndef BSPC
+		// before the game can change any area portal state
+		if ( cm_mapCache->integer ) {
+			CM_WriteMapCache( last_checksum, length );
+		}
+#endif
+	}
 
 	// allow this to be cached if it is loaded by the server
 	if ( !clientload ) {
@@ -817,6 +1471,9 @@ CM_ClearMap
 void CM_ClearMap( void ) {
 	::memset( &cm, 0, sizeof( cm ) );
 	CM_ClearLevelPatches();
+#ifndef BSPC
+	CM_TraceCacheFrame();
+#endif
 }
 
 /*
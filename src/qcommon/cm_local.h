@@ -30,6 +30,14 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include "qcommon.h"
 #include "cm_polylib.h"
 
+// brush planes are also kept in SoA form so CM_TraceThroughBrush can
+// test four sides at a time
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define	CM_SIMD					1
+#else
+#define	CM_SIMD					0
+#endif
+
 #define	MAX_SUBMODELS			256
 #define	BOX_MODEL_HANDLE		255
 #define CAPSULE_MODEL_HANDLE	254
@@ -79,6 +87,8 @@ typedef struct {
 	bool	    collided; // marker for optimisation
 	cbrushedge_t	*edges;
 	int						numEdges;
+	float		*soa;			// normal x, y, z and dist of each side, in
+								// runs of numsides padded to a multiple of 4
 } cbrush_t;
 
 
@@ -155,6 +165,8 @@ extern	int			c_traces, c_brush_traces, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
+extern	cvar_t		*cm_simdTrace;
+extern	cvar_t		*cm_traceCache;
 
 // cm_test.c
 
@@ -222,4 +234,7 @@ void CM_ClearLevelPatches( void );
 // cm_test.c
 void	CM_FloodAreaConnections (void);
 
+// cm_trace.c
+void	CM_BuildBrushSoA( void );
+
 #endif
@@ -24,6 +24,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #include "cm_local.h"
 #include "cm_patch.h"
+#include "jobs.h"
 
 /*
 
@@ -416,15 +417,151 @@ PATCH COLLIDE GENERATION
 ================================================================================
 */
 
-static	int				numPlanes;
-static	patchPlane_t	planes[MAX_PATCH_PLANES];
+/*
+The generation state lives in a per-thread patchWork_t so that patches
+can be built on the job threads.  Nothing from here to
+CM_FinishPatchCollide touches the hunk, the zone or the console: errors
+and warnings are recorded and replayed on the main thread.
 
-static	int				numFacets;
-static	facet_t			facets[MAX_FACETS];
+Planes are also chained in a grid over their normals, so that plane
+lookups only visit planes whose normal is close enough to possibly match.
+*/
 
 #define	NORMAL_EPSILON	0.0001
 #define	DIST_EPSILON	0.02
 
+#define	PLANE_HASH_RES		8		// cells per unit of a normal component
+#define	PLANE_HASH_SIZE		( 2 * PLANE_HASH_RES + 1 )
+#define	PLANE_HASH_CELLS	( PLANE_HASH_SIZE * PLANE_HASH_SIZE * PLANE_HASH_SIZE )
+#define	PLANE_HASH_MIN		64		// below this many planes a plain scan is faster
+
+typedef struct {
+	int				numPlanes;
+	patchPlane_t	planes[MAX_PATCH_PLANES];
+	int				planeNext[MAX_PATCH_PLANES];	// chains run in ascending plane order
+	int				planeCell[MAX_PATCH_PLANES];
+	int				planeHead[PLANE_HASH_CELLS];
+	int				planeTail[PLANE_HASH_CELLS];
+
+	int				numFacets;
+	facet_t			facets[MAX_FACETS];
+
+	const char		*error;
+	char			log[4096];
+	int				logLength;
+	int				logDropped;
+
+	bool			debugBlock;
+	vec3_t			debugBlockPoints[4];
+} patchWork_t;
+
+static thread_local patchWork_t	*work;
+
+/*
+==================
+CM_PatchLog
+
+Keeps a warning for CM_FinishPatchCollide to print
+==================
+*/
+static void CM_PatchLog( bool developer, const char *fmt, ... ) {
+	va_list		argptr;
+	char		msg[256];
+	int			len;
+
+	va_start( argptr, fmt );
+	len = Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	va_end( argptr );
+
+	if ( len < 0 || len >= (int)sizeof( msg ) ||
+		work->logLength + 1 + len >= (int)sizeof( work->log ) ) {
+		work->logDropped++;
+		return;
+	}
+
+	work->log[work->logLength++] = developer ? 'd' : 'p';
+	::memcpy( work->log + work->logLength, msg, len + 1 );
+	work->logLength += len;
+}
+
+/*
+==================
+CM_PlaneHashCell
+==================
+*/
+static int CM_PlaneHashCell( float c ) {
+	int		cell = (int)floor( ( c + 1.0f ) * PLANE_HASH_RES );
+
+	return cell < 0 ? 0 : cell >= PLANE_HASH_SIZE ? PLANE_HASH_SIZE - 1 : cell;
+}
+
+/*
+==================
+CM_PlaneHashRange
+
+Cells holding every normal within radius of normal in each component
+==================
+*/
+static void CM_PlaneHashRange( const float *normal, float radius, int lo[3], int hi[3] ) {
+	int		i;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		lo[i] = CM_PlaneHashCell( normal[i] - radius );
+		hi[i] = CM_PlaneHashCell( normal[i] + radius );
+	}
+}
+
+/*
+==================
+CM_ClearPlanes
+==================
+*/
+static void CM_ClearPlanes( void ) {
+	static thread_local bool	cleared;
+	int		i;
+
+	if ( !cleared ) {
+		::memset( work->planeHead, -1, sizeof( work->planeHead ) );
+		cleared = true;
+	}
+
+	for ( i = 0 ; i < work->numPlanes ; i++ ) {
+		work->planeHead[work->planeCell[i]] = -1;
+	}
+	work->numPlanes = 0;
+}
+
+/*
+==================
+CM_AddPlane
+==================
+*/
+static int CM_AddPlane( const float plane[4] ) {
+	int		cell;
+
+	if ( work->numPlanes == MAX_PATCH_PLANES ) {
+		// keep going with a valid index, the patch is dropped afterwards
+		work->error = "MAX_PATCH_PLANES";
+		return MAX_PATCH_PLANES - 1;
+	}
+
+	Vector4Copy( plane, work->planes[work->numPlanes].plane );
+	work->planes[work->numPlanes].signbits = CM_SignbitsForNormal( (float *)plane );
+
+	cell = ( CM_PlaneHashCell( plane[0] ) * PLANE_HASH_SIZE + CM_PlaneHashCell( plane[1] ) )
+		* PLANE_HASH_SIZE + CM_PlaneHashCell( plane[2] );
+	work->planeCell[work->numPlanes] = cell;
+	work->planeNext[work->numPlanes] = -1;
+	if ( work->planeHead[cell] == -1 ) {
+		work->planeHead[cell] = work->numPlanes;
+	} else {
+		work->planeNext[work->planeTail[cell]] = work->numPlanes;
+	}
+	work->planeTail[cell] = work->numPlanes;
+
+	return work->numPlanes++;
+}
+
 /*
 ==================
 CM_PlaneEqual
@@ -490,26 +627,123 @@ CM_FindPlane2
 ==================
 */
 int CM_FindPlane2(float plane[4], int *flipped) {
-	int i;
+	int		best, bestFlipped, side, i, x, y, z;
+	int		lo[3], hi[3];
+	vec3_t	normal;
+
+	if ( work->numPlanes < PLANE_HASH_MIN ) {
+		for ( i = 0 ; i < work->numPlanes ; i++ ) {
+			if ( CM_PlaneEqual( &work->planes[i], plane, flipped ) ) return i;
+		}
 
-	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if (CM_PlaneEqual(&planes[i], plane, flipped)) return i;
+		*flipped = false;
+		return CM_AddPlane( plane );
+	}
+
+	// see if the points are close enough to an existing plane, as
+	// either side; the lowest numbered match wins, as with a linear scan
+	best = work->numPlanes;
+	bestFlipped = false;
+	for ( side = 0 ; side < 2 ; side++ ) {
+		if ( side ) {
+			VectorNegate( plane, normal );
+		} else {
+			VectorCopy( plane, normal );
+		}
+		CM_PlaneHashRange( normal, 2 * NORMAL_EPSILON, lo, hi );
+
+		for ( x = lo[0] ; x <= hi[0] ; x++ ) {
+			for ( y = lo[1] ; y <= hi[1] ; y++ ) {
+				for ( z = lo[2] ; z <= hi[2] ; z++ ) {
+					i = work->planeHead[( x * PLANE_HASH_SIZE + y ) * PLANE_HASH_SIZE + z];
+					for ( ; i != -1 && i < best ; i = work->planeNext[i] ) {
+						if ( CM_PlaneEqual( &work->planes[i], plane, flipped ) ) {
+							best = i;
+							bestFlipped = *flipped;
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if ( best < work->numPlanes ) {
+		*flipped = bestFlipped;
+		return best;
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	*flipped = false;
+
+	return CM_AddPlane( plane );
+}
+
+/*
+==================
+CM_PlaneSearchRadius
+
+How far, per normal component, the normal of a plane can be from the
+triangle's own and still have all three points within PLANE_TRI_EPSILON
+of it.  An in-plane tilt of sin(theta) moves the points apart by at
+least the triangle's smallest height times that, which must stay within
+twice the epsilon.  The bound is padded for rounding; slivers get the
+whole table.
+==================
+*/
+static float CM_PlaneSearchRadius( const float *p1, const float *p2, const float *p3 ) {
+	vec3_t	e1, e2, e3, cross;
+	float	longest, height, s;
+
+	VectorSubtract( p2, p1, e1 );
+	VectorSubtract( p3, p1, e2 );
+	VectorSubtract( p3, p2, e3 );
+	CrossProduct( e1, e2, cross );
+
+	longest = MAX( VectorLength( e1 ), MAX( VectorLength( e2 ), VectorLength( e3 ) ) );
+	if ( longest <= 0 ) {
+		return 2;
 	}
+	height = VectorLength( cross ) / longest;
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	s = ( 2 * ( PLANE_TRI_EPSILON + 0.01 ) + 1e-5 * longest ) / height * 1.01;
+	if ( !( s < 0.5 ) ) {
+		return 2;
+	}
 
-	numPlanes++;
+	// backwards planes are skipped, so cos(theta) is positive
+	return sqrt( 2 - 2 * sqrt( 1 - s * s ) ) * 1.01 + 1e-4;
+}
 
-	*flipped = false;
+/*
+==================
+CM_PlaneFitsPoints
+==================
+*/
+static bool CM_PlaneFitsPoints( const patchPlane_t *p, const float *plane,
+								const float *p1, const float *p2, const float *p3 ) {
+	float	d;
+
+	if ( DotProduct( plane, p->plane ) < 0 ) {
+		return false;	// allow backwards planes?
+	}
+
+	d = DotProduct( p1, p->plane ) - p->plane[3];
+	if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
+		return false;
+	}
 
-	return numPlanes-1;
+	d = DotProduct( p2, p->plane ) - p->plane[3];
+	if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
+		return false;
+	}
+
+	d = DotProduct( p3, p->plane ) - p->plane[3];
+	if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
+		return false;
+	}
+
+	return true;
 }
 
 /*
@@ -519,49 +753,50 @@ CM_FindPlane
 */
 static int CM_FindPlane( float *p1, float *p2, float *p3 ) {
 	float	plane[4];
-	int		i;
-	float	d;
+	int		best, i, x, y, z;
+	int		lo[3], hi[3];
+	float	radius;
 
 	if ( !CM_PlaneFromPoints( plane, p1, p2, p3 ) ) {
 		return -1;
 	}
 
-	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if ( DotProduct( plane, planes[i].plane ) < 0 ) {
-			continue;	// allow backwards planes?
-		}
-
-		d = DotProduct( p1, planes[i].plane ) - planes[i].plane[3];
-		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
-			continue;
+	if ( work->numPlanes < PLANE_HASH_MIN ) {
+		for ( i = 0 ; i < work->numPlanes ; i++ ) {
+			if ( CM_PlaneFitsPoints( &work->planes[i], plane, p1, p2, p3 ) ) {
+				return i;
+			}
 		}
 
-		d = DotProduct( p2, planes[i].plane ) - planes[i].plane[3];
-		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
-			continue;
-		}
+		return CM_AddPlane( plane );
+	}
 
-		d = DotProduct( p3, planes[i].plane ) - planes[i].plane[3];
-		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
-			continue;
+	radius = CM_PlaneSearchRadius( p1, p2, p3 );
+	CM_PlaneHashRange( plane, radius, lo, hi );
+
+	// see if the points are close enough to an existing plane; the
+	// lowest numbered match wins, as with a linear scan
+	best = work->numPlanes;
+	for ( x = lo[0] ; x <= hi[0] ; x++ ) {
+		for ( y = lo[1] ; y <= hi[1] ; y++ ) {
+			for ( z = lo[2] ; z <= hi[2] ; z++ ) {
+				i = work->planeHead[( x * PLANE_HASH_SIZE + y ) * PLANE_HASH_SIZE + z];
+				for ( ; i != -1 && i < best ; i = work->planeNext[i] ) {
+					if ( CM_PlaneFitsPoints( &work->planes[i], plane, p1, p2, p3 ) ) {
+						best = i;
+						break;
+					}
+				}
+			}
 		}
-
-		// found it
-		return i;
 	}
 
-	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( best < work->numPlanes ) {
+		return best;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
-
-	numPlanes++;
-
-	return numPlanes-1;
+	// add a new plane
+	return CM_AddPlane( plane );
 }
 
 /*
@@ -576,7 +811,7 @@ static int CM_PointOnPlaneSide( float *p, int planeNum ) {
 	if ( planeNum == -1 ) {
 		return SIDE_ON;
 	}
-	plane = planes[ planeNum ].plane;
+	plane = work->planes[ planeNum ].plane;
 
 	d = DotProduct( p, plane ) - plane[3];
 
@@ -609,7 +844,7 @@ static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i,
 	}
 
 	// should never happen
-	Com_Printf( "WARNING: CM_GridPlane unresolvable\n" );
+	CM_PatchLog( false, "WARNING: CM_GridPlane unresolvable\n" );
 	return -1;
 }
 
@@ -631,7 +866,7 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
+		VectorMA( p1, 4, work->planes[ p ].plane, up );
 		return CM_FindPlane( p1, p2, up );
 
 	case 2:	// bottom border
@@ -641,7 +876,7 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
+		VectorMA( p1, 4, work->planes[ p ].plane, up );
 		return CM_FindPlane( p2, p1, up );
 
 	case 3: // left border
@@ -651,7 +886,7 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
+		VectorMA( p1, 4, work->planes[ p ].plane, up );
 		return CM_FindPlane( p2, p1, up );
 
 	case 1:	// right border
@@ -661,7 +896,7 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
+		VectorMA( p1, 4, work->planes[ p ].plane, up );
 		return CM_FindPlane( p1, p2, up );
 
 	case 4:	// diagonal out of triangle 0
@@ -671,7 +906,7 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
+		VectorMA( p1, 4, work->planes[ p ].plane, up );
 		return CM_FindPlane( p1, p2, up );
 
 	case 5:	// diagonal out of triangle 1
@@ -681,12 +916,12 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
+		VectorMA( p1, 4, work->planes[ p ].plane, up );
 		return CM_FindPlane( p1, p2, up );
 
 	}
 
-	Com_Error( ERR_DROP, "CM_EdgePlaneNum: bad k" );
+	work->error = "CM_EdgePlaneNum: bad k";
 	return -1;
 }
 
@@ -722,9 +957,8 @@ static void CM_SetBorderInward( facet_t *facet, cGrid_t *grid, int gridPlanes[MA
 		numPoints = 3;
 		break;
 	default:
-		Com_Error( ERR_FATAL, "CM_SetBorderInward: bad parameter" );
-		numPoints = 0;
-		break;
+		work->error = "CM_SetBorderInward: bad parameter";
+		return;
 	}
 
 	for ( k = 0 ; k < facet->numBorders ; k++ ) {
@@ -753,14 +987,14 @@ static void CM_SetBorderInward( facet_t *facet, cGrid_t *grid, int gridPlanes[MA
 			facet->borderPlanes[k] = -1;
 		} else {
 			// bisecting side border
-			Com_DPrintf( "WARNING: CM_SetBorderInward: mixed plane sides\n" );
+			CM_PatchLog( true, "WARNING: CM_SetBorderInward: mixed plane sides\n" );
 			facet->borderInward[k] = false;
-			if ( !debugBlock ) {
-				debugBlock = true;
-				VectorCopy( grid->points[i][j], debugBlockPoints[0] );
-				VectorCopy( grid->points[i+1][j], debugBlockPoints[1] );
-				VectorCopy( grid->points[i+1][j+1], debugBlockPoints[2] );
-				VectorCopy( grid->points[i][j+1], debugBlockPoints[3] );
+			if ( !work->debugBlock ) {
+				work->debugBlock = true;
+				VectorCopy( grid->points[i][j], work->debugBlockPoints[0] );
+				VectorCopy( grid->points[i+1][j], work->debugBlockPoints[1] );
+				VectorCopy( grid->points[i+1][j+1], work->debugBlockPoints[2] );
+				VectorCopy( grid->points[i][j+1], work->debugBlockPoints[3] );
 			}
 		}
 	}
@@ -783,14 +1017,14 @@ static bool CM_ValidateFacet( facet_t *facet ) {
 		return false;
 	}
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( work->planes[ facet->surfacePlane ].plane, plane );
 	w = BaseWindingForPlane( plane,  plane[3] );
 	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
 		if ( facet->borderPlanes[j] == -1 ) {
 			FreeWinding( w );
 			return false;
 		}
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( work->planes[ facet->borderPlanes[j] ].plane, plane );
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
@@ -833,12 +1067,12 @@ void CM_AddFacetBevels( facet_t *facet ) {
 	winding_t *w, *w2;
 	vec3_t mins, maxs, vec, vec2;
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( work->planes[ facet->surfacePlane ].plane, plane );
 
 	w = BaseWindingForPlane( plane,  plane[3] );
 	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
 		if (facet->borderPlanes[j] == facet->surfacePlane) continue;
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( work->planes[ facet->borderPlanes[j] ].plane, plane );
 
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
@@ -867,18 +1101,18 @@ void CM_AddFacetBevels( facet_t *facet ) {
 				plane[3] = -mins[axis];
 			}
 			//if it's the surface plane
-			if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+			if (CM_PlaneEqual(&work->planes[facet->surfacePlane], plane, &flipped)) {
 				continue;
 			}
 			// see if the plane is allready present
 			for ( i = 0 ; i < facet->numBorders ; i++ ) {
-				if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped))
+				if (CM_PlaneEqual(&work->planes[facet->borderPlanes[i]], plane, &flipped))
 					break;
 			}
 
 			if ( i == facet->numBorders ) {
 				if ( facet->numBorders >= 4 + 6 + 16 ) {
-					Com_Printf( "ERROR: too many bevels\n" );
+					CM_PatchLog( false, "ERROR: too many bevels\n" );
 					continue;
 				}
 				facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
@@ -931,33 +1165,36 @@ void CM_AddFacetBevels( facet_t *facet ) {
 					continue;
 
 				//if it's the surface plane
-				if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+				if (CM_PlaneEqual(&work->planes[facet->surfacePlane], plane, &flipped)) {
 					continue;
 				}
 				// see if the plane is allready present
 				for ( i = 0 ; i < facet->numBorders ; i++ ) {
-					if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped)) {
+					if (CM_PlaneEqual(&work->planes[facet->borderPlanes[i]], plane, &flipped)) {
 							break;
 					}
 				}
 
 				if ( i == facet->numBorders ) {
 					if ( facet->numBorders >= 4 + 6 + 16 ) {
-						Com_Printf( "ERROR: too many bevels\n" );
+						CM_PatchLog( false, "ERROR: too many bevels\n" );
 						continue;
 					}
 					facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
 
 					for ( k = 0 ; k < facet->numBorders ; k++ ) {
 						if (facet->borderPlanes[facet->numBorders] ==
-							facet->borderPlanes[k]) Com_Printf("WARNING: bevel plane already used\n");
+							facet->borderPlanes[k]) CM_PatchLog( false, "WARNING: bevel plane already used\n" );
 					}
 
 					facet->borderNoAdjust[facet->numBorders] = false;
 					facet->borderInward[facet->numBorders] = flipped;
 					//
 					w2 = CopyWinding(w);
-					Vector4Copy(planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
+					if (!w2) {
+						continue;	// the error is in work->error
+					}
+					Vector4Copy(work->planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
 					if (!facet->borderInward[facet->numBorders])
 					{
 						VectorNegate(newplane, newplane);
@@ -965,7 +1202,7 @@ void CM_AddFacetBevels( facet_t *facet ) {
 					} //end if
 					ChopWindingInPlace( &w2, newplane, newplane[3], 0.1f );
 					if (!w2) {
-						Com_DPrintf("WARNING: CM_AddFacetBevels... invalid bevel\n");
+						CM_PatchLog( true, "WARNING: CM_AddFacetBevels... invalid bevel\n" );
 						continue;
 					}
 					else {
@@ -984,7 +1221,7 @@ void CM_AddFacetBevels( facet_t *facet ) {
 #ifndef BSPC
 	//add opposite plane
 	if ( facet->numBorders >= 4 + 6 + 16 ) {
-		Com_Printf( "ERROR: too many bevels\n" );
+		CM_PatchLog( false, "ERROR: too many bevels\n" );
 		return;
 	}
 	facet->borderPlanes[facet->numBorders] = facet->surfacePlane;
@@ -1015,8 +1252,8 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 	int				borders[4];
 	int				noAdjust[4];
 
-	numPlanes = 0;
-	numFacets = 0;
+	CM_ClearPlanes();
+	work->numFacets = 0;
 
 	// find the planes for each triangle of the grid
 	for ( i = 0 ; i < grid->width - 1 ; i++ ) {
@@ -1081,10 +1318,11 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				borders[EN_RIGHT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 1 );
 			}
 
-			if ( numFacets == MAX_FACETS ) {
-				Com_Error( ERR_DROP, "MAX_FACETS" );
+			if ( work->numFacets == MAX_FACETS ) {
+				work->error = "MAX_FACETS";
+				return;
 			}
-			facet = &facets[numFacets];
+			facet = &work->facets[work->numFacets];
 			::memset( facet, 0, sizeof( *facet ) );
 
 			if ( gridPlanes[i][j][0] == gridPlanes[i][j][1] ) {
@@ -1104,7 +1342,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, -1 );
 				if ( CM_ValidateFacet( facet ) ) {
 					CM_AddFacetBevels( facet );
-					numFacets++;
+					work->numFacets++;
 				}
 			} else {
 				// two seperate triangles
@@ -1124,13 +1362,14 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
  				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 0 );
 				if ( CM_ValidateFacet( facet ) ) {
 					CM_AddFacetBevels( facet );
-					numFacets++;
+					work->numFacets++;
 				}
 
-				if ( numFacets == MAX_FACETS ) {
-					Com_Error( ERR_DROP, "MAX_FACETS" );
+				if ( work->numFacets == MAX_FACETS ) {
+					work->error = "MAX_FACETS";
+					return;
 				}
-				facet = &facets[numFacets];
+				facet = &work->facets[work->numFacets];
 				::memset( facet, 0, sizeof( *facet ) );
 
 				facet->surfacePlane = gridPlanes[i][j][1];
@@ -1149,58 +1388,66 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 1 );
 				if ( CM_ValidateFacet( facet ) ) {
 					CM_AddFacetBevels( facet );
-					numFacets++;
+					work->numFacets++;
 				}
 			}
 		}
 	}
 
-	// copy the results out
-	pf->numPlanes = numPlanes;
-	pf->numFacets = numFacets;
-	pf->facets = (facet_t*)Hunk_Alloc( numFacets * sizeof( *pf->facets ), h_high );
-	::memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
-	pf->planes = (patchPlane_t*)Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
-	::memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
+	// copy the results out, CM_FinishPatchCollide moves them to the hunk
+	pf->numPlanes = work->numPlanes;
+	pf->numFacets = work->numFacets;
+	pf->facets = (facet_t*)malloc( work->numFacets * sizeof( *pf->facets ) );
+	pf->planes = (patchPlane_t*)malloc( work->numPlanes * sizeof( *pf->planes ) );
+	if ( ( work->numFacets && !pf->facets ) || ( work->numPlanes && !pf->planes ) ) {
+		work->error = "out of memory";
+		return;
+	}
+	if ( work->numFacets ) {
+		::memcpy( pf->facets, work->facets, work->numFacets * sizeof( *pf->facets ) );
+	}
+	if ( work->numPlanes ) {
+		::memcpy( pf->planes, work->planes, work->numPlanes * sizeof( *pf->planes ) );
+	}
 }
 
 
 /*
 ===================
-CM_GeneratePatchCollide
+CM_BuildPatchCollide
 
-Creates an internal structure that will be used to perform
-collision detection with a patch mesh.
-
-Points is packed as concatenated rows.
+The thread safe part of CM_GeneratePatchCollide: subdivides the patch
+and builds its planes and facets into malloced memory.
 ===================
 */
-struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
-	patchCollide_t	*pf;
+static void CM_BuildPatchCollide( patchBuild_t *build ) {
+	patchCollide_t	*pf = &build->pc;
 	cGrid_t			grid;
 	int				i, j;
 
-	if ( width <= 2 || height <= 2 || !points ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
-			width, height, (void *)points );
-	}
-
-	if ( !(width & 1) || !(height & 1) ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes" );
-	}
-
-	if ( width > MAX_GRID_SIZE || height > MAX_GRID_SIZE ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
+	if ( !work ) {
+		// one per thread, never freed; the job threads live as long as the process
+		work = (patchWork_t *)malloc( sizeof( *work ) );
+		if ( !work ) {
+			build->error = "out of memory";
+			return;
+		}
 	}
+	work->error = NULL;
+	WindingErrors( &work->error );
+	work->log[0] = '\0';
+	work->logLength = 0;
+	work->logDropped = 0;
+	work->debugBlock = false;
 
 	// build a grid
-	grid.width = width;
-	grid.height = height;
+	grid.width = build->width;
+	grid.height = build->height;
 	grid.wrapWidth = false;
 	grid.wrapHeight = false;
-	for ( i = 0 ; i < width ; i++ ) {
-		for ( j = 0 ; j < height ; j++ ) {
-			VectorCopy( points[j*width + i], grid.points[i][j] );
+	for ( i = 0 ; i < build->width ; i++ ) {
+		for ( j = 0 ; j < build->height ; j++ ) {
+			VectorCopy( build->points[j*build->width + i], grid.points[i][j] );
 		}
 	}
 
@@ -1218,7 +1465,7 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	// we now have a grid of points exactly on the curve
 	// the aproximate surface defined by these points will be
 	// collided against
-	pf = (patchCollide_t*)Hunk_Alloc( sizeof( *pf ), h_high );
+	::memset( pf, 0, sizeof( *pf ) );
 	ClearBounds( pf->bounds[0], pf->bounds[1] );
 	for ( i = 0 ; i < grid.width ; i++ ) {
 		for ( j = 0 ; j < grid.height ; j++ ) {
@@ -1226,7 +1473,7 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 		}
 	}
 
-	c_totalPatchBlocks += ( grid.width - 1 ) * ( grid.height - 1 );
+	build->blocks = ( grid.width - 1 ) * ( grid.height - 1 );
 
 	// generate a bsp tree for the surface
 	CM_PatchCollideFromGrid( &grid, pf );
@@ -1240,9 +1487,159 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	pf->bounds[1][1] += 1;
 	pf->bounds[1][2] += 1;
 
+	build->error = work->error;
+	build->log = work->logLength ? strdup( work->log ) : NULL;
+	build->logDropped = work->logDropped;
+	build->debugBlock = work->debugBlock;
+	::memcpy( build->debugBlockPoints, work->debugBlockPoints, sizeof( build->debugBlockPoints ) );
+
+	WindingErrors( NULL );
+}
+
+/*
+===================
+CM_BuildPatchCollideJob
+===================
+*/
+static void CM_BuildPatchCollideJob( void *data, int index ) {
+	CM_BuildPatchCollide( (patchBuild_t *)data + index );
+}
+
+/*
+===================
+CM_FreePatchBuild
+===================
+*/
+static void CM_FreePatchBuild( patchBuild_t *build ) {
+	free( build->pc.facets );
+	free( build->pc.planes );
+	free( build->log );
+	build->pc.facets = NULL;
+	build->pc.planes = NULL;
+	build->log = NULL;
+}
+
+/*
+===================
+CM_FinishPatchCollide
+
+Prints what the build had to say and moves it to the hunk
+===================
+*/
+static struct patchCollide_s *CM_FinishPatchCollide( patchBuild_t *build ) {
+	patchCollide_t	*pf;
+	const char		*s;
+	char			line[256];
+	int				len;
+
+	for ( s = build->log ; s && *s ; s += len ) {
+		bool	developer = *s++ == 'd';
+
+		len = strchr( s, '\n' ) ? strchr( s, '\n' ) - s + 1 : strlen( s );
+		Q_strncpyz( line, s, MIN( len + 1, (int)sizeof( line ) ) );
+		if ( developer ) {
+			Com_DPrintf( "%s", line );
+		} else {
+			Com_Printf( "%s", line );
+		}
+	}
+	if ( build->logDropped ) {
+		Com_Printf( "...and %i more patch warnings\n", build->logDropped );
+	}
+
+	if ( build->debugBlock && !debugBlock ) {
+		debugBlock = true;
+		::memcpy( debugBlockPoints, build->debugBlockPoints, sizeof( debugBlockPoints ) );
+	}
+
+	c_totalPatchBlocks += build->blocks;
+
+	pf = (patchCollide_t*)Hunk_Alloc( sizeof( *pf ), h_high );
+	*pf = build->pc;
+	pf->facets = (facet_t*)Hunk_Alloc( pf->numFacets * sizeof( *pf->facets ), h_high );
+	::memcpy( pf->facets, build->pc.facets, pf->numFacets * sizeof( *pf->facets ) );
+	pf->planes = (patchPlane_t*)Hunk_Alloc( pf->numPlanes * sizeof( *pf->planes ), h_high );
+	::memcpy( pf->planes, build->pc.planes, pf->numPlanes * sizeof( *pf->planes ) );
+
+	CM_FreePatchBuild( build );
+
 	return pf;
 }
 
+/*
+===================
+CM_GeneratePatchCollides
+
+Builds every patch on the job threads, then moves the results to the
+hunk in order.  Each patch has its own plane table, so the results are
+identical to building them one at a time.
+===================
+*/
+void CM_GeneratePatchCollides( int count, patchBuild_t *builds ) {
+	const char	*error = NULL;
+	int			i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		int			width = builds[i].width;
+		int			height = builds[i].height;
+
+		if ( width <= 2 || height <= 2 || !builds[i].points ) {
+			Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
+				width, height, (void *)builds[i].points );
+		}
+
+		if ( !(width & 1) || !(height & 1) ) {
+			Com_Error( ERR_DROP, "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes" );
+		}
+
+		if ( width > MAX_GRID_SIZE || height > MAX_GRID_SIZE ) {
+			Com_Error( ERR_DROP, "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
+		}
+	}
+
+	Com_ParallelFor( count, CM_BuildPatchCollideJob, builds );
+
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( builds[i].error && !error ) {
+			error = builds[i].error;
+		}
+	}
+
+	if ( error ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			CM_FreePatchBuild( &builds[i] );
+		}
+		Com_Error( ERR_DROP, "%s", error );
+	}
+
+	for ( i = 0 ; i < count ; i++ ) {
+		builds[i].result = CM_FinishPatchCollide( &builds[i] );
+	}
+}
+
+/*
+===================
+CM_GeneratePatchCollide
+
+Creates an internal structure that will be used to perform
+collision detection with a patch mesh.
+
+Points is packed as concatenated rows.
+===================
+*/
+struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
+	patchBuild_t	build;
+
+	::memset( &build, 0, sizeof( build ) );
+	build.width = width;
+	build.height = height;
+	build.points = points;
+
+	CM_GeneratePatchCollides( 1, &build );
+
+	return build.result;
+}
+
 /*
 ================================================================================
 
@@ -102,4 +102,22 @@ typedef struct {
 #define	WRAP_POINT_EPSILON	0.1
 
 
+// one patch for CM_GeneratePatchCollides; the rest is private to cm_patch.c
+typedef struct {
+	int				width;
+	int				height;
+	vec3_t			*points;
+
+	struct patchCollide_s	*result;
+
+	patchCollide_t	pc;			// planes and facets are malloced until finished
+	int				blocks;
+	const char		*error;
+	char			*log;
+	int				logDropped;
+	bool			debugBlock;
+	vec3_t			debugBlockPoints[4];
+} patchBuild_t;
+
 struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+void CM_GeneratePatchCollides( int count, patchBuild_t *builds );
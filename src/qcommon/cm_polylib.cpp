@@ -28,12 +28,34 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include "cm_local.h"
 
 
-// counters are only bumped when running single threaded,
-// because they are an awful coherence problem
-int	c_active_windings;
-int	c_peak_windings;
-int	c_winding_allocs;
-int	c_winding_points;
+// windings are built on the job threads while patches are generated, so
+// they come from malloc rather than the zone and there are no counters.
+// Com_Error can't be used there either: a thread that hands WindingErrors
+// an error slot gets failures recorded in it, and the failing call cleans
+// up and returns a NULL winding instead.
+
+static thread_local const char	**windingError;
+
+void WindingErrors (const char **error)
+{
+	windingError = error;
+}
+
+/*
+=============
+WindingError
+
+Returns only if the error was recorded
+=============
+*/
+static void WindingError (int code, const char *msg)
+{
+	if (!windingError)
+		Com_Error (code, "%s", msg);
+
+	if (!*windingError)
+		*windingError = msg;
+}
 
 void pw(winding_t *w)
 {
@@ -53,26 +75,27 @@ winding_t	*AllocWinding (int points)
 	winding_t	*w;
 	int			s;
 
-	c_winding_allocs++;
-	c_winding_points += points;
-	c_active_windings++;
-	if (c_active_windings > c_peak_windings)
-		c_peak_windings = c_active_windings;
-
 	s = sizeof(vec_t)*3*points + sizeof(int);
-	w = (winding_t*)Z_Malloc (s);
-	::memset (w, 0, s); 
+	w = (winding_t*)calloc (1, s);
+	if (!w)
+	{
+		if (!windingError)
+			Com_Error (ERR_FATAL, "AllocWinding: failed on allocation of %i bytes", s);
+		WindingError (ERR_FATAL, "AllocWinding: out of memory");
+	}
 	return w;
 }
 
 void FreeWinding (winding_t *w)
 {
 	if (*(unsigned *)w == 0xdeaddead)
-		Com_Error (ERR_FATAL, "FreeWinding: freed a freed winding");
+	{
+		WindingError (ERR_FATAL, "FreeWinding: freed a freed winding");
+		return;
+	}
 	*(unsigned *)w = 0xdeaddead;
 
-	c_active_windings--;
-	Z_Free (w);
+	free (w);
 }
 
 /*
@@ -222,7 +245,10 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 		}
 	}
 	if (x==-1)
-		Com_Error (ERR_DROP, "BaseWindingForPlane: no axis found");
+	{
+		WindingError (ERR_DROP, "BaseWindingForPlane: no axis found");
+		return NULL;
+	}
 		
 	VectorCopy (vec3_origin, vup);	
 	switch (x)
@@ -249,6 +275,8 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 
 // project a really big	axis aligned box onto the plane
 	w = AllocWinding (4);
+	if (!w)
+		return NULL;
 	
 	VectorSubtract (org, vright, w->p[0]);
 	VectorAdd (w->p[0], vup, w->p[0]);
@@ -278,6 +306,8 @@ winding_t	*CopyWinding (winding_t *w)
 	winding_t	*c;
 
 	c = AllocWinding (w->numpoints);
+	if (!c)
+		return NULL;
 	size = (intptr_t) ((winding_t *)0)->p[w->numpoints];
 	::memcpy (c, w, size);
 	return c;
@@ -294,6 +324,8 @@ winding_t	*ReverseWinding (winding_t *w)
 	winding_t	*c;
 
 	c = AllocWinding (w->numpoints);
+	if (!c)
+		return NULL;
 	for (i=0 ; i<w->numpoints ; i++)
 	{
 		VectorCopy (w->p[w->numpoints-1-i], c->p[i]);
@@ -314,7 +346,7 @@ void	ClipWindingEpsilon (winding_t *in, vec3_t normal, vec_t dist,
 	vec_t	dists[MAX_POINTS_ON_WINDING+4] = { 0 };
 	int		sides[MAX_POINTS_ON_WINDING+4] = { 0 };
 	int		counts[3];
-	static	vec_t	dot;		// VC 4.2 optimizer bug if not static
+	static thread_local vec_t	dot;	// VC 4.2 optimizer bug if not static
 	int		i, j;
 	vec_t	*p1, *p2;
 	vec3_t	mid;
@@ -360,6 +392,15 @@ void	ClipWindingEpsilon (winding_t *in, vec3_t normal, vec_t dist,
 
 	*front = f = AllocWinding (maxpts);
 	*back = b = AllocWinding (maxpts);
+	if (!f || !b)
+	{
+		if (f)
+			FreeWinding (f);
+		if (b)
+			FreeWinding (b);
+		*front = *back = NULL;
+		return;
+	}
 		
 	for (i=0 ; i<in->numpoints ; i++)
 	{
@@ -408,10 +449,17 @@ void	ClipWindingEpsilon (winding_t *in, vec3_t normal, vec_t dist,
 		b->numpoints++;
 	}
 	
-	if (f->numpoints > maxpts || b->numpoints > maxpts)
-		Com_Error (ERR_DROP, "ClipWinding: points exceeded estimate");
-	if (f->numpoints > MAX_POINTS_ON_WINDING || b->numpoints > MAX_POINTS_ON_WINDING)
-		Com_Error (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+	if (f->numpoints > maxpts || b->numpoints > maxpts ||
+		f->numpoints > MAX_POINTS_ON_WINDING || b->numpoints > MAX_POINTS_ON_WINDING)
+	{
+		if (f->numpoints > maxpts || b->numpoints > maxpts)
+			WindingError (ERR_DROP, "ClipWinding: points exceeded estimate");
+		else
+			WindingError (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+		FreeWinding (f);
+		FreeWinding (b);
+		*front = *back = NULL;
+	}
 }
 
 
@@ -426,7 +474,7 @@ void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t eps
 	vec_t	dists[MAX_POINTS_ON_WINDING+4] = { 0 };
 	int		sides[MAX_POINTS_ON_WINDING+4] = { 0 };
 	int		counts[3];
-	static	vec_t	dot;		// VC 4.2 optimizer bug if not static
+	static thread_local vec_t	dot;	// VC 4.2 optimizer bug if not static
 	int		i, j;
 	vec_t	*p1, *p2;
 	vec3_t	mid;
@@ -468,6 +516,12 @@ void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t eps
 								// of fp grouping errors
 
 	f = AllocWinding (maxpts);
+	if (!f)
+	{
+		FreeWinding (in);
+		*inout = NULL;
+		return;
+	}
 		
 	for (i=0 ; i<in->numpoints ; i++)
 	{
@@ -507,10 +561,15 @@ void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t eps
 		f->numpoints++;
 	}
 	
-	if (f->numpoints > maxpts)
-		Com_Error (ERR_DROP, "ClipWinding: points exceeded estimate");
-	if (f->numpoints > MAX_POINTS_ON_WINDING)
-		Com_Error (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+	if (f->numpoints > maxpts || f->numpoints > MAX_POINTS_ON_WINDING)
+	{
+		if (f->numpoints > maxpts)
+			WindingError (ERR_DROP, "ClipWinding: points exceeded estimate");
+		else
+			WindingError (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+		FreeWinding (f);
+		f = NULL;
+	}
 
 	FreeWinding (in);
 	*inout = f;
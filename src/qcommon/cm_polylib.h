@@ -71,4 +71,7 @@ void	ChopWindingInPlace (winding_t **w, vec3_t normal, vec_t dist, vec_t epsilon
 
 void pw(winding_t *w);
 
+void	WindingErrors (const char **error);
+// record errors in *error instead of calling Com_Error, NULL to stop
+
 #endif
@@ -73,6 +73,11 @@ bool	CM_AreasConnected( int area1, int area2 );
 
 int			CM_WriteAreaBits( byte *buffer, int area );
 
+// cm_trace.c
+void		CM_TraceCompare_f( void );
+void		CM_TraceCacheFrame( void );
+void		CM_TraceCacheStats_f( void );
+
 // cm_patch.c
 void CM_DrawDebugSurface( void (*drawPoly)(int color, int numPoints, float *points) );
 
@@ -24,6 +24,17 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #include "cm_local.h"
 
+#include "cmd.h"
+#include "sys/sys_shared.h"
+
+#if CM_SIMD
+#include <xmmintrin.h>
+#endif
+
+#ifndef BSPC
+static bool	cm_traceScalar;		// set by cm_traceCompare
+#endif
+
 // always use bbox vs. bbox collision and never capsule vs. bbox or vice versa
 //#define ALWAYS_BBOX_VS_BBOX
 // always use capsule vs. capsule collision and never capsule vs. bbox or vice versa
@@ -476,6 +487,176 @@ void CM_TraceThroughPatch( traceWork_t *tw, cPatch_t *patch ) {
 	}
 }
 
+/*
+===============================================================================
+
+SOA BRUSH PLANES
+
+===============================================================================
+*/
+
+/*
+================
+CM_BuildBrushSoA
+
+Copies every brush's side planes into one block, four floats wide, so
+the AABB case of CM_TraceThroughBrush can test four sides per step.
+The box brush keeps using the planes directly since CM_TempBoxModel
+rewrites them for every trace.
+================
+*/
+void CM_BuildBrushSoA( void ) {
+#if CM_SIMD
+	int			i, j, n, total;
+	float		*soa;
+	cbrush_t	*b;
+
+	total = 0;
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		total += PAD( cm.brushes[i].numsides, 4 ) * 4;
+	}
+
+	soa = (float *)Hunk_Alloc( total * sizeof( float ), h_high );
+
+	for ( i = 0, b = cm.brushes ; i < cm.numBrushes ; i++, b++ ) {
+		n = PAD( b->numsides, 4 );
+		b->soa = soa;
+
+		for ( j = 0 ; j < n ; j++ ) {
+			if ( j < b->numsides ) {
+				const cplane_t *plane = b->sides[j].plane;
+
+				soa[j] = plane->normal[0];
+				soa[n + j] = plane->normal[1];
+				soa[n * 2 + j] = plane->normal[2];
+				soa[n * 3 + j] = plane->dist;
+			} else {
+				// padding that never crosses a trace: d1 and d2 are
+				// always far behind it
+				soa[j] = soa[n + j] = soa[n * 2 + j] = 0;
+				soa[n * 3 + j] = 1e30f;
+			}
+		}
+
+		soa += n * 4;
+	}
+#endif
+}
+
+#if CM_SIMD && !defined( BSPC )
+/*
+================
+CM_ClipBrushSoA
+
+The AABB side loop of CM_TraceThroughBrush, four sides at a time.  The
+distances are computed with the same float operations as the scalar
+loop; everything that decides the result is then replayed per side in
+the original order, so the trace comes out bit for bit the same.
+Returns false if the trace is completely in front of a side.
+================
+*/
+static bool CM_ClipBrushSoA( traceWork_t *tw, cbrush_t *brush, float *enterFrac,
+		float *leaveFrac, int *lead, bool *getout, bool *startout ) {
+	const int	n = PAD( brush->numsides, 4 );
+	const float	*nx = brush->soa, *ny = nx + n, *nz = ny + n, *pd = nz + n;
+	const __m128	zero = _mm_setzero_ps();
+	const __m128	eps = _mm_set1_ps( SURFACE_CLIP_EPSILON );
+	const __m128	s0x = _mm_set1_ps( tw->size[0][0] ), s1x = _mm_set1_ps( tw->size[1][0] );
+	const __m128	s0y = _mm_set1_ps( tw->size[0][1] ), s1y = _mm_set1_ps( tw->size[1][1] );
+	const __m128	s0z = _mm_set1_ps( tw->size[0][2] ), s1z = _mm_set1_ps( tw->size[1][2] );
+	const __m128	sx = _mm_set1_ps( tw->start[0] ), sy = _mm_set1_ps( tw->start[1] );
+	const __m128	sz = _mm_set1_ps( tw->start[2] );
+	const __m128	ex = _mm_set1_ps( tw->end[0] ), ey = _mm_set1_ps( tw->end[1] );
+	const __m128	ez = _mm_set1_ps( tw->end[2] );
+	float		d1s[4], d2s[4];
+	float		f;
+
+	for ( int i = 0 ; i < brush->numsides ; i += 4 ) {
+		__m128	x = _mm_loadu_ps( nx + i ), y = _mm_loadu_ps( ny + i ), z = _mm_loadu_ps( nz + i );
+		__m128	ox, oy, oz, dist, d1, d2, m;
+		int		out, cross, lanes;
+
+		// tw->offsets[signbits]: the maxs corner on axes the normal points down
+		m = _mm_cmplt_ps( x, zero );
+		ox = _mm_or_ps( _mm_and_ps( m, s1x ), _mm_andnot_ps( m, s0x ) );
+		m = _mm_cmplt_ps( y, zero );
+		oy = _mm_or_ps( _mm_and_ps( m, s1y ), _mm_andnot_ps( m, s0y ) );
+		m = _mm_cmplt_ps( z, zero );
+		oz = _mm_or_ps( _mm_and_ps( m, s1z ), _mm_andnot_ps( m, s0z ) );
+
+		// adjust the plane distance apropriately for mins/maxs
+		dist = _mm_sub_ps( _mm_loadu_ps( pd + i ),
+			_mm_add_ps( _mm_add_ps( _mm_mul_ps( ox, x ), _mm_mul_ps( oy, y ) ), _mm_mul_ps( oz, z ) ) );
+
+		d1 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( sx, x ), _mm_mul_ps( sy, y ) ),
+			_mm_mul_ps( sz, z ) ), dist );
+		d2 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, x ), _mm_mul_ps( ey, y ) ),
+			_mm_mul_ps( ez, z ) ), dist );
+
+		lanes = ( brush->numsides - i >= 4 ) ? 15 : ( 1 << ( brush->numsides - i ) ) - 1;
+
+		// completely in front of a face, no intersection with the entire brush
+		out = _mm_movemask_ps( _mm_and_ps( _mm_cmpgt_ps( d1, zero ),
+			_mm_or_ps( _mm_cmpge_ps( d2, eps ), _mm_cmpge_ps( d2, d1 ) ) ) ) & lanes;
+
+		// sides that aren't entirely behind the trace, NaN included
+		cross = _mm_movemask_ps( _mm_or_ps( _mm_cmpnle_ps( d1, zero ), _mm_cmpnle_ps( d2, zero ) ) ) & lanes;
+
+		if ( out ) {
+			// the sides before the first one that rejects still count
+			if ( cross & ( ( out & -out ) - 1 ) ) {
+				brush->collided = true;
+			}
+			return false;
+		}
+
+		if ( _mm_movemask_ps( _mm_cmpgt_ps( d2, zero ) ) & lanes ) {
+			*getout = true;	// endpoint is not in solid
+		}
+		if ( _mm_movemask_ps( _mm_cmpgt_ps( d1, zero ) ) & lanes ) {
+			*startout = true;
+		}
+
+		if ( !cross ) {
+			continue;
+		}
+
+		brush->collided = true;
+
+		_mm_storeu_ps( d1s, d1 );
+		_mm_storeu_ps( d2s, d2 );
+
+		for ( int j = 0 ; j < 4 ; j++ ) {
+			if ( !( cross & ( 1 << j ) ) ) {
+				continue;
+			}
+
+			// crosses face
+			if ( d1s[j] > d2s[j] ) {	// enter
+				f = ( d1s[j] - SURFACE_CLIP_EPSILON ) / ( d1s[j] - d2s[j] );
+				if ( f < 0 ) {
+					f = 0;
+				}
+				if ( f > *enterFrac ) {
+					*enterFrac = f;
+					*lead = i + j;
+				}
+			} else {	// leave
+				f = ( d1s[j] + SURFACE_CLIP_EPSILON ) / ( d1s[j] - d2s[j] );
+				if ( f > 1 ) {
+					f = 1;
+				}
+				if ( f < *leaveFrac ) {
+					*leaveFrac = f;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+#endif
+
 /*
 ================
 CM_TraceThroughBrush
@@ -641,6 +822,18 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
 				}
 			}
 		}
+#if CM_SIMD && !defined( BSPC )
+	} else if ( brush->soa && cm_simdTrace->integer && !cm_traceScalar ) {
+		int		lead = -1;
+
+		if ( !CM_ClipBrushSoA( tw, brush, &enterFrac, &leaveFrac, &lead, &getout, &startout ) ) {
+			return;
+		}
+		if ( lead >= 0 ) {
+			leadside = brush->sides + lead;
+			clipplane = leadside->plane;
+		}
+#endif
 	} else {
 		//
 		// compare the trace against all planes of the brush
@@ -1563,6 +1756,94 @@ void CM_Trace( trace_t *results, const vec3_t start,
 	*results = tw.trace;
 }
 
+#ifndef BSPC
+/*
+===============================================================================
+
+TRACE CACHE
+
+Game code traces the same segment through the world many times a frame
+(visibility checks from several buildables to one target, build probes,
+pmove retries).  Traces against inline model geometry in its own space
+never change while a map is loaded, so CM_BoxTrace can hand back a stored
+result instead of descending the tree again.  Movers are clipped through
+CM_TransformedBoxTrace with their current origin and are never cached.
+Entries are dropped every frame by CM_TraceCacheFrame.
+
+===============================================================================
+*/
+
+#define	TRACE_CACHE_SIZE	1024		// must be a power of two
+
+typedef struct {
+	float		start[3], end[3];
+	float		mins[3], maxs[3];
+	int			brushmask;
+	int			model;
+	int			flags;					// trace type and the cvars that change results
+} traceKey_t;
+
+typedef struct {
+	traceKey_t	key;
+	int			generation;
+	trace_t		trace;
+} traceCacheEntry_t;
+
+static traceCacheEntry_t	traceCache[TRACE_CACHE_SIZE];
+static int					traceGeneration = 1;
+static int					c_cacheLookups, c_cacheHits;
+
+/*
+==================
+CM_TraceCacheFrame
+
+Invalidates every cached trace.  Called once a frame and whenever the
+collision map changes.
+==================
+*/
+void CM_TraceCacheFrame( void ) {
+	// on wrap, clear so that no stale entry can match the new generation
+	if ( ++traceGeneration <= 0 ) {
+		::memset( traceCache, 0, sizeof( traceCache ) );
+		traceGeneration = 1;
+	}
+}
+
+/*
+==================
+CM_TraceCacheSlot
+==================
+*/
+static traceCacheEntry_t *CM_TraceCacheSlot( const traceKey_t *key ) {
+	const unsigned	*words = (const unsigned *)key;
+	unsigned		hash = 2166136261u;
+	int				i;
+
+	for ( i = 0 ; i < (int)( sizeof( *key ) / sizeof( *words ) ) ; i++ ) {
+		hash = ( hash ^ words[i] ) * 16777619u;
+	}
+	hash ^= hash >> 15;
+
+	return &traceCache[hash & ( TRACE_CACHE_SIZE - 1 )];
+}
+
+/*
+==================
+CM_TraceCacheStats_f
+==================
+*/
+void CM_TraceCacheStats_f( void ) {
+	if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		c_cacheLookups = c_cacheHits = 0;
+		return;
+	}
+
+	Com_Printf( "trace cache %s: %i lookups, %i hits (%.1f%%)\n",
+		cm_traceCache && cm_traceCache->integer ? "on" : "off", c_cacheLookups, c_cacheHits,
+		c_cacheLookups ? 100.0f * c_cacheHits / c_cacheLookups : 0.0f );
+}
+#endif
+
 /*
 ==================
 CM_BoxTrace
@@ -1571,7 +1852,47 @@ CM_BoxTrace
 void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask, traceType_t type ) {
+#ifndef BSPC
+	traceKey_t			key;
+	traceCacheEntry_t	*entry;
+
+	// the temporary box and capsule models are rebuilt for every entity
+	if ( !cm_traceCache || !cm_traceCache->integer || model < 0 || model >= cm.numSubModels ) {
+		CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, type, NULL );
+		return;
+	}
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	VectorCopy( start, key.start );
+	VectorCopy( end, key.end );
+	VectorCopy( mins, key.mins );
+	VectorCopy( maxs, key.maxs );
+	key.brushmask = brushmask;
+	key.model = model;
+	key.flags = type | ( cm_noCurves->integer ? 0x100 : 0 ) | ( cm_playerCurveClip->integer ? 0x200 : 0 );
+
+	c_cacheLookups++;
+	entry = CM_TraceCacheSlot( &key );
+	if ( entry->generation == traceGeneration && !::memcmp( &entry->key, &key, sizeof( key ) ) ) {
+		c_cacheHits++;
+		*results = entry->trace;
+		return;
+	}
+
+	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, type, NULL );
+
+	entry->key = key;
+	entry->generation = traceGeneration;
+	entry->trace = *results;
+#else
 	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, type, NULL );
+#endif
 }
 
 /*
@@ -1799,3 +2120,112 @@ void CM_TransformedBiSphereTrace( trace_t *results, const vec3_t start,
 
 	*results = trace;
 }
+
+#ifndef BSPC
+/*
+==================
+CM_TraceCompare_f
+
+Fires random box traces through the loaded map with the SoA brush path
+and the scalar one, reporting any trace_t that differs and the time
+each path took.  The traces are run in batches, each path timing a whole
+batch, since a single trace is far below the timer resolution.
+cm_traceCompare [count] [seed]
+==================
+*/
+#define	TRACE_COMPARE_BATCH		256
+
+void CM_TraceCompare_f( void ) {
+	typedef struct {
+		vec3_t		start, end, mins, maxs;
+		int			mask;
+	} compareTrace_t;
+
+	const cmodel_t	*world;
+	unsigned		seed;
+	int				count, mismatches, batch, i, j, k;
+	int64_t			usec[2] = { 0, 0 };
+	compareTrace_t	traces[TRACE_COMPARE_BATCH];
+	trace_t			results[2][TRACE_COMPARE_BATCH];
+
+	if ( !CM_SIMD ) {
+		Com_Printf( "this build has no SIMD trace path\n" );
+		return;
+	}
+	if ( !cm.numNodes ) {
+		Com_Printf( "no map loaded\n" );
+		return;
+	}
+
+	count = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100000;
+	seed = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 1;
+	world = &cm.cmodels[0];
+	mismatches = 0;
+
+#define	CM_RAND()	( seed = seed * 1664525 + 1013904223, ( seed >> 8 ) / (float)( 1 << 24 ) )
+
+	for ( i = 0 ; i < count ; i += batch ) {
+		batch = MIN( count - i, TRACE_COMPARE_BATCH );
+
+		for ( k = 0 ; k < batch ; k++ ) {
+			compareTrace_t	*t = &traces[k];
+			int				n = i + k;
+
+			t->mask = ( n & 1 ) ? CONTENTS_SOLID :
+				( CONTENTS_SOLID | CONTENTS_PLAYERCLIP | CONTENTS_BODY );
+
+			for ( j = 0 ; j < 3 ; j++ ) {
+				t->start[j] = world->mins[j] + CM_RAND() * ( world->maxs[j] - world->mins[j] );
+
+				// mostly short traces, like movement, some across the map
+				if ( n % 8 ) {
+					t->end[j] = t->start[j] + ( CM_RAND() - 0.5f ) * 512;
+				} else {
+					t->end[j] = world->mins[j] + CM_RAND() * ( world->maxs[j] - world->mins[j] );
+				}
+
+				// a quarter are point traces
+				if ( n % 4 ) {
+					t->mins[j] = -CM_RAND() * 32;
+					t->maxs[j] = CM_RAND() * 32;
+				} else {
+					t->mins[j] = t->maxs[j] = 0;
+				}
+			}
+		}
+
+		for ( j = 0 ; j < 2 ; j++ ) {
+			int64_t		start = Sys_Microseconds();
+
+			cm_traceScalar = !j;
+			for ( k = 0 ; k < batch ; k++ ) {
+				compareTrace_t	*t = &traces[k];
+
+				CM_Trace( &results[j][k], t->start, t->end, t->mins, t->maxs, 0, vec3_origin,
+					t->mask, TT_AABB, NULL );
+			}
+			usec[j] += Sys_Microseconds() - start;
+		}
+
+		for ( k = 0 ; k < batch ; k++ ) {
+			const compareTrace_t	*t = &traces[k];
+
+			if ( ::memcmp( &results[0][k], &results[1][k], sizeof( trace_t ) ) ) {
+				if ( ++mismatches <= 10 ) {
+					Com_Printf( "mismatch: (%f %f %f) -> (%f %f %f): fraction %f / %f, allsolid %i / %i\n",
+						t->start[0], t->start[1], t->start[2], t->end[0], t->end[1], t->end[2],
+						results[0][k].fraction, results[1][k].fraction,
+						results[0][k].allsolid, results[1][k].allsolid );
+				}
+			}
+		}
+	}
+
+#undef CM_RAND
+
+	cm_traceScalar = false;
+
+	Com_Printf( "%i traces, %i mismatches; scalar %.3f msec, simd %.3f msec\n",
+		count, mismatches, usec[0] / 1000.0, usec[1] / 1000.0 );
+}
+#endif
@@ -27,6 +27,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include "qcommon.h"
 
 #include <setjmp.h>
+#include <atomic>
 #ifdef _WIN32
 #include <winsock.h>
 #else
@@ -862,10 +863,19 @@ int Com_RealTime(qtime_t *qtime)
 
 ZONE MEMORY ALLOCATION
 
-There is never any space between memblocks, and there will never be two
-contiguous free memblocks.
+The zone is a list of chunks, each carved into memblocks with no space
+between them; a block knows the size of its physical neighbours so free
+blocks are merged on release and there will never be two contiguous free
+memblocks within a chunk.
 
-The rover can be left pointing at a non-empty block
+Free blocks are kept in segregated bins: one bin per ZONE_ALIGN step for
+small sizes, so most allocations are an exact fit popped off a list, and
+one bin per power of two above that.  A bitmap of non-empty bins finds the
+next usable bin without walking.  Blocks in use are linked on a list per
+tag, for Z_FreeTags and accounting.
+
+When no bin can satisfy a request another chunk is added instead of
+failing, so running out only happens when the system does.
 
 The zone calls are pretty much only used for small strings and structures,
 all big things are allocated on the hunk.
@@ -875,6 +885,15 @@ all big things are allocated on the hunk.
 #define ZONEID 0x1d4a11
 #define MINFRAGMENT 64
 
+#define ZONE_ALIGN          16
+#define NUM_SMALL_BINS      64      // exact fit bins below SMALL_BIN_LIMIT
+#define SMALL_BIN_LIMIT     ( NUM_SMALL_BINS * ZONE_ALIGN )
+#define NUM_LARGE_BINS      22      // powers of two from SMALL_BIN_LIMIT up
+#define NUM_ZONE_BINS       ( NUM_SMALL_BINS + NUM_LARGE_BINS )
+#define NUM_ZONE_TAGS       ( TAG_STATIC + 1 )
+
+#define MIN_ZONE_GROW       ( 4 * 1024 * 1024 )
+
 typedef struct zonedebug_s {
     const char *label;
     const char *file;
@@ -885,62 +904,191 @@ typedef struct zonedebug_s {
 typedef struct memblock_s {
     int size;           // including the header and possibly tiny fragments
     int tag;            // a tag of 0 is a free block
-    struct memblock_s       *next, *prev;
+    struct memblock_s       *next, *prev;   // bin list when free, tag list when used
     int id;          // should be ZONEID
+    int prevSize;       // size of the block physically before, 0 if first in chunk
 #ifdef ZONE_DEBUG
     zonedebug_t d;
 #endif
 } memblock_t;
 
+typedef struct memchunk_s {
+    struct memchunk_s *next;
+    int size;           // total bytes malloced, including header
+    int pad;
+} memchunk_t;
+
+typedef struct {
+    int bytes;
+    int blocks;
+    int peak;
+} zonetag_t;
+
 typedef struct {
-    int size;   // total bytes malloced, including header
+    memchunk_t *chunks;
+    int size;   // total bytes malloced, including headers
     int used;   // total bytes used
-    memblock_t blocklist; // start / end cap for linked list
-    memblock_t *rover;
+    int grown;  // chunks added after startup
+    memblock_t bins[ NUM_ZONE_BINS ];           // list heads of free blocks
+    unsigned binMap[ ( NUM_ZONE_BINS + 31 ) / 32 ]; // non-empty bins
+    memblock_t tagLists[ NUM_ZONE_TAGS ];       // list heads of used blocks
+    zonetag_t tags[ NUM_ZONE_TAGS ];
 } memzone_t;
 
-// main zone for all "dynamic" memory allocation
-memzone_t *mainzone;
-// we also have a small zone for small allocations that would only
-// fragment the main zone (think of cvar and cmd strings)
-memzone_t *smallzone;
+static memzone_t zone;
+
+static int s_zoneTotal;
 
 void Z_CheckHeap( void );
 
+#define Z_FirstBlock( chunk ) ( (memblock_t *)( (byte *)(chunk) + sizeof( memchunk_t ) ) )
+#define Z_NextBlock( block ) ( (memblock_t *)( (byte *)(block) + (block)->size ) )
+
 /*
 ========================
-Z_ClearZone
+Z_BinForSize
+
+Bin a free block of this size belongs in
 ========================
 */
-void Z_ClearZone( memzone_t *zone, int size )
+static int Z_BinForSize( int size )
 {
-    memblock_t *block;
+    int bin;
 
-    // set the entire zone to one free block
+    if ( size < SMALL_BIN_LIMIT )
+        return size / ZONE_ALIGN;
 
-    zone->blocklist.next = zone->blocklist.prev = block =
-        (memblock_t *)( (byte *)zone + sizeof(memzone_t) );
-    zone->blocklist.tag = 1; // in use block
-    zone->blocklist.id = 0;
-    zone->blocklist.size = 0;
-    zone->rover = block;
-    zone->size = size;
-    zone->used = 0;
+    bin = NUM_SMALL_BINS + Q_log2( size / SMALL_BIN_LIMIT );
+    if ( bin >= NUM_ZONE_BINS )
+        bin = NUM_ZONE_BINS - 1;
+    return bin;
+}
+
+/*
+========================
+Z_NextBin
+
+First non-empty bin at or after bin, -1 if none
+========================
+*/
+static int Z_NextBin( int bin )
+{
+    int word, bit;
+    unsigned bits;
+
+    for ( word = bin >> 5; word < ARRAY_LEN( zone.binMap ); word++ )
+    {
+        bits = zone.binMap[ word ];
+        if ( word == ( bin >> 5 ) )
+            bits &= ~0u << ( bin & 31 );
+        if ( !bits )
+            continue;
+
+        for ( bit = 0; !( bits & ( 1u << bit ) ); bit++ )
+            ;
+        return ( word << 5 ) + bit;
+    }
+
+    return -1;
+}
+
+static void Z_LinkBlock( memblock_t *head, memblock_t *block )
+{
+    block->prev = head;
+    block->next = head->next;
+    head->next->prev = block;
+    head->next = block;
+}
+
+static void Z_UnlinkBlock( memblock_t *block )
+{
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+}
+
+static void Z_InsertFree( memblock_t *block )
+{
+    int bin = Z_BinForSize( block->size );
 
-    block->prev = block->next = &zone->blocklist;
     block->tag = 0; // free block
+    Z_LinkBlock( &zone.bins[ bin ], block );
+    zone.binMap[ bin >> 5 ] |= 1u << ( bin & 31 );
+}
+
+static void Z_RemoveFree( memblock_t *block )
+{
+    int bin = Z_BinForSize( block->size );
+
+    Z_UnlinkBlock( block );
+    if ( zone.bins[ bin ].next == &zone.bins[ bin ] )
+        zone.binMap[ bin >> 5 ] &= ~( 1u << ( bin & 31 ) );
+}
+
+/*
+========================
+Z_AddChunk
+
+Adds a chunk of at least size bytes to the zone as one free block,
+capped by an in use sentinel so merging stops at its end
+========================
+*/
+static bool Z_AddChunk( int size )
+{
+    memchunk_t *chunk;
+    memblock_t *block, *end;
+
+    size = PAD( size, ZONE_ALIGN );
+    chunk = (memchunk_t *)calloc( size, 1 );
+    if ( !chunk )
+        return false;
+
+    chunk->size = size;
+    chunk->next = zone.chunks;
+    zone.chunks = chunk;
+    zone.size += size;
+
+    block = Z_FirstBlock( chunk );
+    block->size = size - sizeof( memchunk_t ) - sizeof( memblock_t );
     block->id = ZONEID;
-    block->size = size - sizeof(memzone_t);
+    block->prevSize = 0;
+
+    end = Z_NextBlock( block );
+    end->size = 0;
+    end->tag = TAG_STATIC;
+    end->id = ZONEID;
+    end->prevSize = block->size;
+
+    Z_InsertFree( block );
+
+    return true;
 }
 
 /*
 ========================
-Z_AvailableZoneMemory
+Z_ClearZone
 ========================
 */
-int Z_AvailableZoneMemory( memzone_t *zone )
+static void Z_ClearZone( void )
 {
-    return zone->size - zone->used;
+    memchunk_t *chunk, *next;
+    int i;
+
+    for ( chunk = zone.chunks; chunk; chunk = next )
+    {
+        next = chunk->next;
+        free( chunk );
+    }
+
+    ::memset( &zone, 0, sizeof( zone ) );
+
+    for ( i = 0; i < NUM_ZONE_BINS; i++ )
+        zone.bins[ i ].next = zone.bins[ i ].prev = &zone.bins[ i ];
+
+    for ( i = 0; i < NUM_ZONE_TAGS; i++ )
+    {
+        zone.tagLists[ i ].next = zone.tagLists[ i ].prev = &zone.tagLists[ i ];
+        zone.tagLists[ i ].tag = i;
+    }
 }
 
 /*
@@ -950,7 +1098,7 @@ Z_AvailableMemory
 */
 int Z_AvailableMemory( void )
 {
-    return Z_AvailableZoneMemory( mainzone );
+    return zone.size - zone.used;
 }
 
 /*
@@ -961,7 +1109,6 @@ Z_Free
 void Z_Free( void *ptr )
 {
     memblock_t *block, *other;
-    memzone_t *zone;
 
     if (!ptr) {
         Com_Printf(S_COLOR_YELLOW "Z_Free: NULL pointer" );
@@ -985,41 +1132,36 @@ void Z_Free( void *ptr )
         Com_Error( ERR_FATAL, "Z_Free: memory block wrote past end" );
     }
 
-    if (block->tag == TAG_SMALL) {
-        zone = smallzone;
-    }
-    else {
-        zone = mainzone;
-    }
+    zone.used -= block->size;
+    zone.tags[ block->tag ].bytes -= block->size;
+    zone.tags[ block->tag ].blocks--;
+    Z_UnlinkBlock( block );
 
-    zone->used -= block->size;
     // set the block to something that should cause problems
     // if it is referenced...
     ::memset( ptr, 0xaa, block->size - sizeof( *block ) );
 
     block->tag = 0; // mark as free
 
-    other = block->prev;
-    if (!other->tag) {
-        // merge with previous free block
-        other->size += block->size;
-        other->next = block->next;
-        other->next->prev = other;
-        if (block == zone->rover) {
-            zone->rover = other;
+    if ( block->prevSize ) {
+        other = (memblock_t *)( (byte *)block - block->prevSize );
+        if ( !other->tag ) {
+            // merge with previous free block
+            Z_RemoveFree( other );
+            other->size += block->size;
+            block = other;
         }
-        block = other;
     }
 
-    zone->rover = block;
-
-    other = block->next;
+    other = Z_NextBlock( block );
     if ( !other->tag ) {
         // merge the next free block onto the end
+        Z_RemoveFree( other );
         block->size += other->size;
-        block->next = other->next;
-        block->next->prev = block;
     }
+
+    Z_NextBlock( block )->prevSize = block->size;
+    Z_InsertFree( block );
 }
 
 
@@ -1030,28 +1172,63 @@ Z_FreeTags
 */
 void Z_FreeTags( int tag )
 {
-    memzone_t *zone;
+    memblock_t *head;
 
-    if ( tag == TAG_SMALL )
-    {
-        zone = smallzone;
+    if ( tag <= 0 || tag >= NUM_ZONE_TAGS ) {
+        return;
     }
-    else
-    {
-        zone = mainzone;
+
+    head = &zone.tagLists[ tag ];
+    while ( head->next != head ) {
+        Z_Free( (void *)( head->next + 1 ) );
     }
-    // use the rover as our pointer, because
-    // Z_Free automatically adjusts it
-    zone->rover = zone->blocklist.next;
-    do {
-        if ( zone->rover->tag == tag ) {
-            Z_Free( (void *)(zone->rover + 1) );
-            continue;
-        }
-        zone->rover = zone->rover->next;
-    } while ( zone->rover != &zone->blocklist );
 }
 
+/*
+================
+Z_FindFree
+
+Finds a free block of at least size bytes and takes it out of its bin
+================
+*/
+static memblock_t *Z_FindFree( int size )
+{
+    memblock_t *block, *head;
+    int bin;
+
+    bin = Z_BinForSize( size );
+
+    // exact fit bins hold blocks of a single size
+    if ( size < SMALL_BIN_LIMIT ) {
+        bin = Z_NextBin( bin );
+        if ( bin < 0 ) {
+            return NULL;
+        }
+        block = zone.bins[ bin ].next;
+        Z_RemoveFree( block );
+        return block;
+    }
+
+    // power of two bins need a first fit walk in the requested one
+    if ( zone.binMap[ bin >> 5 ] & ( 1u << ( bin & 31 ) ) ) {
+        head = &zone.bins[ bin ];
+        for ( block = head->next; block != head; block = block->next ) {
+            if ( block->size >= size ) {
+                Z_RemoveFree( block );
+                return block;
+            }
+        }
+    }
+
+    // any block in a bigger bin fits
+    if ( bin + 1 < NUM_ZONE_BINS && ( bin = Z_NextBin( bin + 1 ) ) >= 0 ) {
+        block = zone.bins[ bin ].next;
+        Z_RemoveFree( block );
+        return block;
+    }
+
+    return NULL;
+}
 
 /*
 ================
@@ -1064,53 +1241,52 @@ void *Z_TagMallocDebug( int size, int tag, const char *label, const char *file,
 void *Z_TagMalloc( int size, int tag )
 #endif
 {
-    int extra;
-    memblock_t *start, *rover, *_new, *base;
-    memzone_t *zone;
+    int extra, growSize;
+    memblock_t *base, *_new;
+    zonetag_t *stats;
 
     if (!tag)
         Com_Error( ERR_FATAL, "Z_TagMalloc: tried to use a 0 tag" );
-
-    if ( tag == TAG_SMALL )
-        zone = smallzone;
-    else
-        zone = mainzone;
+    if ( tag >= NUM_ZONE_TAGS )
+        Com_Error( ERR_FATAL, "Z_TagMalloc: bad tag %i", tag );
 
 #ifdef ZONE_DEBUG
     int allocSize = size;
 #endif
-    //
-    // scan through the block list looking for the first free block
-    // of sufficient size
-    //
     size += sizeof(memblock_t); // account for size of block header
     size += 4;     // space for memory trash tester
-    size = PAD(size, sizeof(intptr_t)); // align to 32/64 bit boundary
+    size = PAD(size, ZONE_ALIGN);
+
+    base = Z_FindFree( size );
+    growSize = 0;
+    if ( !base ) {
+        // grow instead of taking the whole process down
+        growSize = s_zoneTotal / 4;
+        if ( growSize < MIN_ZONE_GROW ) {
+            growSize = MIN_ZONE_GROW;
+        }
+        if ( growSize < size * 2 ) {
+            growSize = size * 2;
+        }
+        growSize += sizeof( memchunk_t ) + sizeof( memblock_t );
 
-    base = rover = zone->rover;
-    start = base->prev;
+        if ( Z_AddChunk( growSize ) ) {
+            zone.grown++;
+            base = Z_FindFree( size );
+        }
+    }
 
-    do {
-        if (rover == start)
-        {
-            // scaned all the way around the list
+    if ( !base ) {
 #ifdef ZONE_DEBUG
-            Z_LogHeap();
+        Z_LogHeap();
 
-            Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone: %s, line: %d (%s)",
-                    size, zone == smallzone ? "small" : "main", file, line, label);
+        Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes: %s, line: %d (%s)",
+                size, file, line, label);
 #else
-            Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
-                    size, zone == smallzone ? "small" : "main");
+        Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes", size);
 #endif
-            return NULL;
-        }
-        if (rover->tag) {
-            base = rover = rover->next;
-        } else {
-            rover = rover->next;
-        }
-    } while (base->tag || base->size < size);
+        return NULL;
+    }
 
     //
     // found a block big enough
@@ -1120,21 +1296,24 @@ void *Z_TagMalloc( int size, int tag )
         // there will be a free fragment after the allocated block
         _new = (memblock_t *) ((byte *)base + size );
         _new->size = extra;
-        _new->tag = 0;   // free block
-        _new->prev = base;
         _new->id = ZONEID;
-        _new->next = base->next;
-        _new->next->prev = _new;
-        base->next = _new;
+        _new->prevSize = size;
+        Z_NextBlock( _new )->prevSize = extra;
         base->size = size;
+        Z_InsertFree( _new );
     }
 
     base->tag = tag; // n_o longer a free block
-
-    zone->rover = base->next; // next allocation will start looking here
-    zone->used += base->size;
-
     base->id = ZONEID;
+    Z_LinkBlock( &zone.tagLists[ tag ], base );
+
+    zone.used += base->size;
+    stats = &zone.tags[ tag ];
+    stats->bytes += base->size;
+    stats->blocks++;
+    if ( stats->bytes > stats->peak ) {
+        stats->peak = stats->bytes;
+    }
 
 #ifdef ZONE_DEBUG
     base->d.label = label;
@@ -1146,6 +1325,10 @@ void *Z_TagMalloc( int size, int tag )
     // marker for memory trash testing
     *(int *)((byte *)base + base->size - 4) = ZONEID;
 
+    if ( growSize ) {
+        Com_Printf( S_COLOR_YELLOW "WARNING: zone grown by %i bytes, consider raising com_zoneMegs\n", growSize );
+    }
+
     return (void *) ((byte *)base + sizeof(memblock_t));
 }
 
@@ -1193,35 +1376,39 @@ Z_CheckHeap
 */
 void Z_CheckHeap( void )
 {
-    memblock_t *block;
+    memchunk_t *chunk;
+    memblock_t *block, *next;
 
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+    for ( chunk = zone.chunks; chunk; chunk = chunk->next )
     {
-        if (block->next == &mainzone->blocklist)
-            break; // all blocks have been hit
+        for ( block = Z_FirstBlock( chunk ); block->size; block = next )
+        {
+            next = Z_NextBlock( block );
 
-        if ( (byte *)block + block->size != (byte *)block->next)
-            Com_Error( ERR_FATAL, "Z_CheckHeap: block size does not touch the next block" );
+            if ( (byte *)next > (byte *)chunk + chunk->size - sizeof( memblock_t ) )
+                Com_Error( ERR_FATAL, "Z_CheckHeap: block runs past the end of its chunk" );
 
-        if ( block->next->prev != block)
-            Com_Error( ERR_FATAL, "Z_CheckHeap: next block doesn't have proper back link" );
+            if ( next->prevSize != block->size )
+                Com_Error( ERR_FATAL, "Z_CheckHeap: next block doesn't have proper back link" );
 
-        if ( !block->tag && !block->next->tag )
-            Com_Error( ERR_FATAL, "Z_CheckHeap: two consecutive free blocks" );
+            if ( !block->tag && !next->tag )
+                Com_Error( ERR_FATAL, "Z_CheckHeap: two consecutive free blocks" );
+        }
     }
 }
 
 /*
 ========================
-Z_LogZoneHeap
+Z_LogHeap
 ========================
 */
-void Z_LogZoneHeap( memzone_t *zone, const char *name )
+void Z_LogHeap( void )
 {
 #ifdef ZONE_DEBUG
     char dump[32], *ptr;
     int  i, j;
 #endif
+    memchunk_t *chunk;
     memblock_t *block;
     char buf[4096];
     int size, allocSize, numBlocks;
@@ -1233,32 +1420,35 @@ void Z_LogZoneHeap( memzone_t *zone, const char *name )
 #ifdef ZONE_DEBUG
     allocSize = 0;
 #endif
-    Com_sprintf(buf, sizeof(buf), "\r\n================\r\n%s log\r\n================\r\n", name);
+    Com_sprintf(buf, sizeof(buf), "\r\n================\r\nZone log\r\n================\r\n");
     FS_Write(buf, strlen(buf), logfile);
 
-    for (block = zone->blocklist.next ; block->next != &zone->blocklist; block = block->next)
+    for ( chunk = zone.chunks; chunk; chunk = chunk->next )
     {
-        if (block->tag)
+        for ( block = Z_FirstBlock( chunk ); block->size; block = Z_NextBlock( block ) )
         {
-#ifdef ZONE_DEBUG
-            ptr = ((char *) block) + sizeof(memblock_t);
-            j = 0;
-            for (i = 0; i < 20 && i < block->d.allocSize; i++)
+            if (block->tag)
             {
-                if (ptr[i] >= 32 && ptr[i] < 127) {
-                    dump[j++] = ptr[i];
-                }
-                else {
-                    dump[j++] = '_';
+#ifdef ZONE_DEBUG
+                ptr = ((char *) block) + sizeof(memblock_t);
+                j = 0;
+                for (i = 0; i < 20 && i < block->d.allocSize; i++)
+                {
+                    if (ptr[i] >= 32 && ptr[i] < 127) {
+                        dump[j++] = ptr[i];
+                    }
+                    else {
+                        dump[j++] = '_';
+                    }
                 }
-            }
-            dump[j] = '\0';
-            Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
-            FS_Write(buf, strlen(buf), logfile);
-            allocSize += block->d.allocSize;
+                dump[j] = '\0';
+                Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
+                FS_Write(buf, strlen(buf), logfile);
+                allocSize += block->d.allocSize;
 #endif
-            size += block->size;
-            numBlocks++;
+                size += block->size;
+                numBlocks++;
+            }
         }
     }
 #ifdef ZONE_DEBUG
@@ -1267,23 +1457,12 @@ void Z_LogZoneHeap( memzone_t *zone, const char *name )
 #else
     allocSize = numBlocks * sizeof(memblock_t); // + 32 bit alignment
 #endif
-    Com_sprintf(buf, sizeof(buf), "%d %s memory in %d blocks\r\n", size, name, numBlocks);
+    Com_sprintf(buf, sizeof(buf), "%d zone memory in %d blocks\r\n", size, numBlocks);
     FS_Write(buf, strlen(buf), logfile);
-    Com_sprintf(buf, sizeof(buf), "%d %s memory overhead\r\n", size - allocSize, name);
+    Com_sprintf(buf, sizeof(buf), "%d zone memory overhead\r\n", size - allocSize);
     FS_Write(buf, strlen(buf), logfile);
 }
 
-/*
-========================
-Z_LogHeap
-========================
-*/
-void Z_LogHeap( void )
-{
-    Z_LogZoneHeap( mainzone, "MAIN" );
-    Z_LogZoneHeap( smallzone, "SMALL" );
-}
-
 // static mem blocks to reduce a lot of small zone overhead
 typedef struct memstatic_s {
     memblock_t b;
@@ -1399,8 +1578,77 @@ static hunkUsed_t *hunk_permanent, *hunk_temp;
 static byte* s_hunkData = NULL;
 static int s_hunkTotal;
 
-static int s_zoneTotal;
-static int s_smallZoneTotal;
+/*
+=================
+Com_MeminfoSites
+
+Live zone bytes per allocation site, biggest first
+=================
+*/
+#ifdef ZONE_DEBUG
+#define MAX_MEMINFO_SITES 1024
+#define MEMINFO_SITES_SHOWN 20
+
+typedef struct {
+    const char *file;
+    int line;
+    const char *label;
+    int tag;
+    int bytes;
+    int blocks;
+} meminfoSite_t;
+
+static int Com_MeminfoSiteCompare( const void *a, const void *b )
+{
+    return ((const meminfoSite_t *)b)->bytes - ((const meminfoSite_t *)a)->bytes;
+}
+
+static void Com_MeminfoSites( void )
+{
+    static meminfoSite_t sites[ MAX_MEMINFO_SITES ];
+    memchunk_t *chunk;
+    memblock_t *block;
+    int numSites, i;
+
+    numSites = 0;
+    for ( chunk = zone.chunks; chunk; chunk = chunk->next ) {
+        for ( block = Z_FirstBlock( chunk ); block->size; block = Z_NextBlock( block ) ) {
+            if ( !block->tag ) {
+                continue;
+            }
+
+            // file pointers are string literals, so compare those first
+            for ( i = 0; i < numSites; i++ ) {
+                if ( sites[ i ].line == block->d.line && sites[ i ].file == block->d.file ) {
+                    break;
+                }
+            }
+            if ( i == numSites ) {
+                if ( numSites == MAX_MEMINFO_SITES ) {
+                    continue;
+                }
+                sites[ i ].file = block->d.file;
+                sites[ i ].line = block->d.line;
+                sites[ i ].label = block->d.label;
+                sites[ i ].tag = block->tag;
+                sites[ i ].bytes = sites[ i ].blocks = 0;
+                numSites++;
+            }
+            sites[ i ].bytes += block->size;
+            sites[ i ].blocks++;
+        }
+    }
+
+    qsort( sites, numSites, sizeof( sites[ 0 ] ), Com_MeminfoSiteCompare );
+
+    Com_Printf( "\n" );
+    Com_Printf( "top zone allocation sites:\n" );
+    for ( i = 0; i < numSites && i < MEMINFO_SITES_SHOWN; i++ ) {
+        Com_Printf( "%8i bytes %6i blocks tag:%i %s:%i (%s)\n", sites[ i ].bytes, sites[ i ].blocks,
+                sites[ i ].tag, sites[ i ].file, sites[ i ].line, sites[ i ].label );
+    }
+}
+#endif
 
 /*
 =================
@@ -1409,57 +1657,29 @@ Com_Meminfo_f
 */
 void Com_Meminfo_f( void )
 {
+    static const char *tagNames[ NUM_ZONE_TAGS ] = {
+        "free", "general", "botlib", "renderer", "small", "static"
+    };
+    memchunk_t *chunk;
     memblock_t *block;
-    int zoneBytes, zoneBlocks;
-    int smallZoneBytes;
-    int botlibBytes, rendererBytes;
+    int chunks;
+    int tag;
     int unused;
 
-    zoneBytes = 0;
-    botlibBytes = 0;
-    rendererBytes = 0;
-    zoneBlocks = 0;
-    for (block = mainzone->blocklist.next ; ; block = block->next) {
-        if ( Cmd_Argc() != 1 ) {
+    chunks = 0;
+    for ( chunk = zone.chunks; chunk; chunk = chunk->next ) {
+        chunks++;
+        if ( Cmd_Argc() == 1 ) {
+            continue;
+        }
+        for ( block = Z_FirstBlock( chunk ); block->size; block = Z_NextBlock( block ) ) {
             Com_Printf ("block:%p    size:%7i    tag:%3i\n",
                     (void *)block, block->size, block->tag);
         }
-        if ( block->tag ) {
-            zoneBytes += block->size;
-            zoneBlocks++;
-            if ( block->tag == TAG_BOTLIB ) {
-                botlibBytes += block->size;
-            } else if ( block->tag == TAG_RENDERER ) {
-                rendererBytes += block->size;
-            }
-        }
-
-        if (block->next == &mainzone->blocklist) {
-            break; // all blocks have been hit
-        }
-        if ( (byte *)block + block->size != (byte *)block->next) {
-            Com_Printf ("ERROR: block size does not touch the next block\n");
-        }
-        if ( block->next->prev != block) {
-            Com_Printf ("ERROR: next block doesn't have proper back link\n");
-        }
-        if ( !block->tag && !block->next->tag ) {
-            Com_Printf ("ERROR: two consecutive free blocks\n");
-        }
-    }
-
-    smallZoneBytes = 0;
-    for (block = smallzone->blocklist.next ; ; block = block->next)
-    {
-        if ( block->tag )
-            smallZoneBytes += block->size;
-
-        if (block->next == &smallzone->blocklist)
-            break; // all blocks have been hit
     }
 
     Com_Printf( "%8i bytes total hunk\n", s_hunkTotal );
-    Com_Printf( "%8i bytes total zone\n", s_zoneTotal );
+    Com_Printf( "%8i bytes total zone in %i chunks (%i grown)\n", zone.size, chunks, zone.grown );
     Com_Printf( "\n" );
     Com_Printf( "%8i low mark\n", hunk_low.mark );
     Com_Printf( "%8i low permanent\n", hunk_low.permanent );
@@ -1485,11 +1705,14 @@ void Com_Meminfo_f( void )
     }
     Com_Printf( "%8i unused highwater\n", unused );
     Com_Printf( "\n" );
-    Com_Printf( "%8i bytes in %i zone blocks\n", zoneBytes, zoneBlocks );
-    Com_Printf( "        %8i bytes in dynamic botlib\n", botlibBytes );
-    Com_Printf( "        %8i bytes in dynamic renderer\n", rendererBytes );
-    Com_Printf( "        %8i bytes in dynamic other\n", zoneBytes - ( botlibBytes + rendererBytes ) );
-    Com_Printf( "        %8i bytes in small Zone memory\n", smallZoneBytes );
+    Com_Printf( "%8i bytes in use in the zone\n", zone.used );
+    for ( tag = TAG_GENERAL; tag < TAG_STATIC; tag++ ) {
+        Com_Printf( "        %8i bytes in %6i %-8s blocks, peak %i\n", zone.tags[ tag ].bytes,
+                zone.tags[ tag ].blocks, tagNames[ tag ], zone.tags[ tag ].peak );
+    }
+#ifdef ZONE_DEBUG
+    Com_MeminfoSites();
+#endif
 }
 
 /*
@@ -1504,6 +1727,7 @@ void Com_TouchMemory( void )
     int start, end;
     int i, j;
     int sum;
+    memchunk_t *chunk;
     memblock_t *block;
 
     Z_CheckHeap();
@@ -1523,16 +1747,15 @@ void Com_TouchMemory( void )
         sum += ((int *)s_hunkData)[i];
     }
 
-    for (block = mainzone->blocklist.next ; ; block = block->next) {
-        if ( block->tag ) {
-            j = block->size >> 2;
-            for ( i = 0 ; i < j ; i+=64 ) { // only need to touch each page
-                sum += ((int *)block)[i];
+    for ( chunk = zone.chunks; chunk; chunk = chunk->next ) {
+        for ( block = Z_FirstBlock( chunk ); block->size; block = Z_NextBlock( block ) ) {
+            if ( block->tag ) {
+                j = block->size >> 2;
+                for ( i = 0 ; i < j ; i+=64 ) { // only need to touch each page
+                    sum += ((int *)block)[i];
+                }
             }
         }
-        if ( block->next == &mainzone->blocklist ) {
-            break; // all blocks have been hit
-        }
     }
 
     end = Sys_Milliseconds();
@@ -1549,12 +1772,10 @@ Com_InitZoneMemory
 */
 void Com_InitSmallZoneMemory( void )
 {
-    s_smallZoneTotal = (512 * 1024);
-    smallzone = (memzone_t*)calloc(s_smallZoneTotal, 1);
-    if ( !smallzone )
-        Com_Error(ERR_FATAL, "Small zone data failed to allocate %1.1f megs", (float)s_smallZoneTotal / (1024*1024));
-
-    Z_ClearZone( smallzone, s_smallZoneTotal );
+    // enough for the cvar and command system until com_zoneMegs is known
+    Z_ClearZone();
+    if ( !Z_AddChunk( 512 * 1024 ) )
+        Com_Error(ERR_FATAL, "Small zone data failed to allocate %1.1f megs", 0.5f);
 }
 
 void Com_InitZoneMemory( void )
@@ -1574,11 +1795,9 @@ void Com_InitZoneMemory( void )
         s_zoneTotal = cv->integer * 1024 * 1024;
     }
 
-    mainzone = (memzone_t*)calloc( s_zoneTotal, 1 );
-    if ( !mainzone ) {
+    if ( !Z_AddChunk( s_zoneTotal ) ) {
         Com_Error( ERR_FATAL, "Zone data failed to allocate %i megs", s_zoneTotal / (1024*1024) );
     }
-    Z_ClearZone( mainzone, s_zoneTotal );
 }
 
 /*
@@ -2043,6 +2262,13 @@ static int com_pushedEventsHead = 0;
 static int com_pushedEventsTail = 0;
 static sysEvent_t com_pushedEvents[MAX_PUSHED_EVENTS];
 
+// event payloads up to this size don't allocate: they are kept in the
+// queue slot, then in eventData until the next event is fetched, and in
+// com_pushedEventData while pushed
+#define EVENT_INLINE_DATA       64
+static char eventData[EVENT_INLINE_DATA];
+static char com_pushedEventData[MAX_PUSHED_EVENTS][EVENT_INLINE_DATA];
+
 /*
 =================
 Com_InitJournaling
@@ -2082,65 +2308,185 @@ EVENT LOOP
 ========================================================================
 */
 
+/*
+The system event queue is a bounded multi-producer, single-consumer queue:
+input, console and network producers may live on other threads, while only
+the main thread drains it.  Each slot carries a sequence number telling
+producers and the consumer whose turn it is, so neither side takes a lock.
+A full queue drops the new event and counts it instead of overwriting
+events that have not been seen yet.
+*/
+
 #define MAX_QUEUED_EVENTS  256
 #define MASK_QUEUED_EVENTS ( MAX_QUEUED_EVENTS - 1 )
 
-static sysEvent_t  eventQueue[ MAX_QUEUED_EVENTS ];
-static int         eventHead = 0;
-static int         eventTail = 0;
+typedef struct {
+    std::atomic<unsigned>   sequence;
+    sysEvent_t              event;      // evPtr is data when the payload fits
+    char                    data[EVENT_INLINE_DATA];
+} eventSlot_t;
+
+static eventSlot_t              eventQueue[ MAX_QUEUED_EVENTS ];
+static std::atomic<unsigned>    eventHead;  // next slot a producer claims
+static std::atomic<unsigned>    eventTail;  // next slot the consumer reads
+
+static struct {
+    std::atomic<int>    queued;
+    std::atomic<int>    dropped;        // queue was full
+    std::atomic<int>    lostData;       // couldn't allocate the event data
+    std::atomic<int>    retries;        // producers racing for a slot
+    std::atomic<int>    peak;           // deepest the queue has been
+    int                 coalesced;      // mouse moves merged by the consumer
+    int                 pushOverflows;
+    int                 reportedDrops;
+} eventStats;
+
+/*
+================
+Com_InitEventQueue
+================
+*/
+static void Com_InitEventQueue( void )
+{
+    int i;
+
+    for ( i = 0; i < MAX_QUEUED_EVENTS; i++ )
+    {
+        eventQueue[ i ].sequence.store( i, std::memory_order_relaxed );
+        ::memset( &eventQueue[ i ].event, 0, sizeof( sysEvent_t ) );
+    }
+    eventHead.store( 0, std::memory_order_relaxed );
+    eventTail.store( 0, std::memory_order_relaxed );
+}
 
 /*
 ================
 Com_QueueEvent
 
 A time of 0 will get the current time
-Ptr should either be null, or point to a block of data that can
-be freed by the game later.
+Data is copied into the event, the caller keeps ownership of its own copy.
+Payloads up to EVENT_INLINE_DATA bytes are kept in the slot, longer ones
+are allocated with malloc since the zone isn't thread safe.
+Safe to call from any thread.
 ================
 */
-void Com_QueueEvent( int time, sysEventType_t type, int value, int value2, int ptrLength, void *ptr )
+void Com_QueueEvent( int time, sysEventType_t type, int value, int value2, int dataLength, const void *data )
 {
-    sysEvent_t  *ev;
+    eventSlot_t *slot;
+    unsigned    pos, seq;
+    int         diff, depth, peak;
 
-    // combine mouse movement with previous mouse event
-    if ( type == SE_MOUSE && eventHead != eventTail )
+    pos = eventHead.load( std::memory_order_relaxed );
+    for ( ;; )
     {
-        ev = &eventQueue[ ( eventHead + MAX_QUEUED_EVENTS - 1 ) & MASK_QUEUED_EVENTS ];
+        slot = &eventQueue[ pos & MASK_QUEUED_EVENTS ];
+        seq = slot->sequence.load( std::memory_order_acquire );
+        diff = (int)( seq - pos );
 
-        if ( ev->evType == SE_MOUSE )
+        if ( diff == 0 )
         {
-            ev->evValue += value;
-            ev->evValue2 += value2;
+            if ( eventHead.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                break;
+            eventStats.retries++;
+        }
+        else if ( diff < 0 )
+        {
+            // the consumer hasn't freed this slot yet
+            eventStats.dropped++;
             return;
         }
+        else
+        {
+            pos = eventHead.load( std::memory_order_relaxed );
+        }
     }
 
-    ev = &eventQueue[ eventHead & MASK_QUEUED_EVENTS ];
+    if ( time == 0 )
+    {
+        time = Sys_Milliseconds();
+    }
 
-    if ( eventHead - eventTail >= MAX_QUEUED_EVENTS )
+    slot->event.evTime = time;
+    slot->event.evType = type;
+    slot->event.evValue = value;
+    slot->event.evValue2 = value2;
+    slot->event.evPtrLength = 0;
+    slot->event.evPtr = NULL;
+    if ( dataLength > 0 )
     {
-        Com_Printf("Com_QueueEvent: overflow\n");
-        // we are discarding an event, but don't leak memory
-        if ( ev->evPtr )
+        char *copy = dataLength <= EVENT_INLINE_DATA ? slot->data : (char *)::malloc( dataLength );
+
+        if ( copy )
+        {
+            ::memcpy( copy, data, dataLength );
+            if ( type == SE_CONSOLE )
+                copy[ dataLength - 1 ] = '\0';
+            slot->event.evPtrLength = dataLength;
+            slot->event.evPtr = copy;
+        }
+        else
         {
-            Z_Free( ev->evPtr );
+            // still publish the slot, the consumer skips empty payload events
+            eventStats.lostData++;
         }
-        eventTail++;
     }
 
-    eventHead++;
+    slot->sequence.store( pos + 1, std::memory_order_release );
 
-    if ( time == 0 )
+    eventStats.queued++;
+    depth = (int)( pos + 1 - eventTail.load( std::memory_order_relaxed ) );
+    peak = eventStats.peak.load( std::memory_order_relaxed );
+    while ( depth > peak && !eventStats.peak.compare_exchange_weak( peak, depth ) )
+        ;
+}
+
+/*
+================
+Com_DequeueEvent
+
+Consumer side, main thread only.  A payload kept in the slot is moved
+to eventData, as the slot is handed back to the producers.
+================
+*/
+static bool Com_DequeueEvent( sysEvent_t *ev )
+{
+    unsigned    tail = eventTail.load( std::memory_order_relaxed );
+    eventSlot_t *slot = &eventQueue[ tail & MASK_QUEUED_EVENTS ];
+
+    if ( slot->sequence.load( std::memory_order_acquire ) != tail + 1 )
+        return false;
+
+    if ( ev )
     {
-        time = Sys_Milliseconds();
+        *ev = slot->event;
+        if ( ev->evPtr == slot->data )
+        {
+            ::memcpy( eventData, slot->data, ev->evPtrLength );
+            ev->evPtr = eventData;
+        }
     }
+    slot->sequence.store( tail + MAX_QUEUED_EVENTS, std::memory_order_release );
+    eventTail.store( tail + 1, std::memory_order_relaxed );
+
+    return true;
+}
 
-    ev->evTime = time;
-    ev->evType = type;
-    ev->evValue = value;
-    ev->evValue2 = value2;
-    ev->evPtrLength = ptrLength;
-    ev->evPtr = ptr;
+/*
+================
+Com_PeekEvent
+
+Consumer side, returns the next event without dequeueing it
+================
+*/
+static const sysEvent_t *Com_PeekEvent( void )
+{
+    unsigned    tail = eventTail.load( std::memory_order_relaxed );
+    eventSlot_t *slot = &eventQueue[ tail & MASK_QUEUED_EVENTS ];
+
+    if ( slot->sequence.load( std::memory_order_acquire ) != tail + 1 )
+        return NULL;
+
+    return &slot->event;
 }
 
 /*
@@ -2155,39 +2501,70 @@ sysEvent_t Com_GetSystemEvent( void )
     char        *s;
 
     // return if we have data
-    if ( eventHead > eventTail )
+    if ( Com_DequeueEvent( &ev ) )
     {
-        eventTail++;
-        return eventQueue[ ( eventTail - 1 ) & MASK_QUEUED_EVENTS ];
+        // combine mouse movement with the moves queued right after it
+        if ( ev.evType == SE_MOUSE )
+        {
+            const sysEvent_t *next;
+
+            while ( ( next = Com_PeekEvent() ) != NULL && next->evType == SE_MOUSE )
+            {
+                ev.evValue += next->evValue;
+                ev.evValue2 += next->evValue2;
+                Com_DequeueEvent( NULL );
+                eventStats.coalesced++;
+            }
+        }
+        return ev;
     }
 
     // check for console commands
     s = Sys_ConsoleInput();
     if ( s )
     {
-        char  *b;
-        int   len;
-
-        len = strlen( s ) + 1;
-        b = (char*)Z_Malloc( len );
-        strcpy( b, s );
-        Com_QueueEvent( 0, SE_CONSOLE, 0, 0, len, b );
+        Com_QueueEvent( 0, SE_CONSOLE, 0, 0, strlen( s ) + 1, s );
     }
 
     // return if we have data
-    if ( eventHead > eventTail )
+    if ( Com_DequeueEvent( &ev ) )
     {
-        eventTail++;
-        return eventQueue[ ( eventTail - 1 ) & MASK_QUEUED_EVENTS ];
+        return ev;
+    }
+
+    // producers can't print, so report drops once the queue has drained
+    if ( eventStats.dropped.load( std::memory_order_relaxed ) != eventStats.reportedDrops )
+    {
+        eventStats.reportedDrops = eventStats.dropped.load( std::memory_order_relaxed );
+        Com_Printf( "WARNING: system event queue overflow, %i events dropped\n", eventStats.reportedDrops );
     }
 
     // create an empty event to return
-    memset( &ev, 0, sizeof( ev ) );
     ev.evTime = Sys_Milliseconds();
+    ev.evType = SE_NONE;
+    ev.evValue = ev.evValue2 = 0;
+    ev.evPtrLength = 0;
+    ev.evPtr = NULL;
 
     return ev;
 }
 
+/*
+================
+Com_EventInfo_f
+================
+*/
+static void Com_EventInfo_f( void )
+{
+    Com_Printf( "%8i events queued\n", eventStats.queued.load() );
+    Com_Printf( "%8i events dropped on a full queue\n", eventStats.dropped.load() );
+    Com_Printf( "%8i events that lost their data\n", eventStats.lostData.load() );
+    Com_Printf( "%8i producer retries\n", eventStats.retries.load() );
+    Com_Printf( "%8i mouse events coalesced\n", eventStats.coalesced );
+    Com_Printf( "%8i pushed event overflows\n", eventStats.pushOverflows );
+    Com_Printf( "%8i of %i slots peak depth\n", eventStats.peak.load(), MAX_QUEUED_EVENTS );
+}
+
 /*
 =================
 Com_GetRealEvent
@@ -2204,9 +2581,18 @@ sysEvent_t Com_GetRealEvent( void )
         if ( r != sizeof(ev) )
             Com_Error( ERR_FATAL, "Error reading from journal file" );
 
+        if ( ev.evPtrLength < 0 )
+            Com_Error( ERR_FATAL, "Bad event data length in journal file" );
+
+        ev.evPtr = NULL;
         if ( ev.evPtrLength )
         {
-            ev.evPtr = Z_Malloc( ev.evPtrLength );
+            if ( ev.evPtrLength <= EVENT_INLINE_DATA )
+                ev.evPtr = eventData;
+            else
+                ev.evPtr = ::malloc( ev.evPtrLength );
+            if ( !ev.evPtr )
+                Com_Error( ERR_FATAL, "Couldn't allocate journaled event data" );
             r = FS_Read( ev.evPtr, ev.evPtrLength, com_journalFile );
             if ( r != ev.evPtrLength ) {
                 Com_Error( ERR_FATAL, "Error reading from journal file" );
@@ -2237,6 +2623,25 @@ sysEvent_t Com_GetRealEvent( void )
 }
 
 
+/*
+=================
+Com_FreeEventData
+
+Frees the payload of an event unless it is one of the inline buffers
+=================
+*/
+static void Com_FreeEventData( void *data )
+{
+    char *p = (char *)data;
+
+    if ( !p || p == eventData )
+        return;
+    if ( p >= com_pushedEventData[ 0 ] && p < com_pushedEventData[ MAX_PUSHED_EVENTS ] )
+        return;
+
+    ::free( p );
+}
+
 /*
 =================
 Com_InitPushEvent
@@ -2272,9 +2677,10 @@ void Com_PushEvent( sysEvent_t *event )
             Com_Printf("WARNING: Com_PushEvent overflow\n");
         }
 
-        if ( ev->evPtr )
-            Z_Free( ev->evPtr );
+        // we are discarding an event, but don't leak memory
+        Com_FreeEventData( ev->evPtr );
 
+        eventStats.pushOverflows++;
         com_pushedEventsTail++;
     }
     else
@@ -2283,6 +2689,14 @@ void Com_PushEvent( sysEvent_t *event )
     }
 
     *ev = *event;
+    if ( ev->evPtr == eventData )
+    {
+        // eventData only lasts until the next event is fetched
+        char *data = com_pushedEventData[ com_pushedEventsHead & (MAX_PUSHED_EVENTS-1) ];
+
+        ::memcpy( data, eventData, ev->evPtrLength );
+        ev->evPtr = data;
+    }
     com_pushedEventsHead++;
 }
 
@@ -2373,8 +2787,11 @@ int Com_EventLoop(void)
                 CL_JoystickEvent( ev.evValue, ev.evValue2, ev.evTime );
                 break;
             case SE_CONSOLE:
-                Cbuf_AddText( (char *)ev.evPtr );
-                Cbuf_AddText( "\n" );
+                if ( ev.evPtr )
+                {
+                    Cbuf_AddText( (char *)ev.evPtr );
+                    Cbuf_AddText( "\n" );
+                }
                 break;
             default:
                 Com_Error( ERR_FATAL, "Com_EventLoop: bad event type %i", ev.evType );
@@ -2382,8 +2799,7 @@ int Com_EventLoop(void)
         }
 
         // free any block data
-        if ( ev.evPtr )
-            Z_Free( ev.evPtr );
+        Com_FreeEventData( ev.evPtr );
     }
 
     return 0; // never reached
@@ -2658,7 +3074,7 @@ void Com_Init( char *commandLine )
     }
 
     // Clear queues
-    ::memset( &eventQueue[ 0 ], 0, MAX_QUEUED_EVENTS * sizeof( sysEvent_t ) );
+    Com_InitEventQueue();
 
     // initialize the weak pseudo-random number generator for use later.
     Com_InitRand();
@@ -2702,10 +3118,13 @@ void Com_Init( char *commandLine )
         Cmd_AddCommand ("error", Com_Error_f);
         Cmd_AddCommand ("crash", Com_Crash_f);
         Cmd_AddCommand ("freeze", Com_Freeze_f);
+        Cmd_AddCommand ("cm_traceCompare", CM_TraceCompare_f);
     }
     Cmd_AddCommand ("quit", Com_Quit_f);
+    Cmd_AddCommand ("eventinfo", Com_EventInfo_f);
     Cmd_AddCommand ("colors", Com_Colors_f);
     Cmd_AddCommand ("changeVectors", MSG_ReportChangeVectors_f );
+    Cmd_AddCommand ("cm_traceCacheStats", CM_TraceCacheStats_f );
     Cmd_AddCommand ("writeconfig", Com_WriteConfig_f );
     Cmd_SetCommandCompletionFunc( "writeconfig", Cmd_CompleteCfgName );
     Cmd_AddCommand("game_restart", Com_GameRestart_f);
@@ -3122,6 +3541,9 @@ void Com_Frame( void )
     // mess with msec if needed
     msec = Com_ModifyMsec(msec);
 
+    // cached world traces only live for one frame
+    CM_TraceCacheFrame();
+
     //
     // server side
     //
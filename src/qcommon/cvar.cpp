@@ -38,28 +38,92 @@ int cvar_modifiedFlags = 0;
 static cvar_t cvar_indexes[MAX_CVARS];
 static int cvar_numIndexes;
 
-#define FILE_HASH_SIZE 256
-static cvar_t *hashTable[FILE_HASH_SIZE];
+// open addressed, linear probing; kept at most half full
+#define CVAR_HASH_SIZE (MAX_CVARS * 2)
+
+typedef struct {
+    unsigned hash;
+    cvar_t *var;
+} cvarHashEntry_t;
+
+static cvarHashEntry_t hashTable[CVAR_HASH_SIZE];
 
 /*
 ================
-return a hash value for the filename
+return a case folded hash value for the cvar name
 ================
 */
-static long generateHashValue(const char *fname)
+static unsigned generateHashValue(const char *name)
 {
-    long hash = 0;
-    int i = 0;
-    while (fname[i] != '\0')
+    unsigned hash = 2166136261u;
+
+    while (*name)
     {
-        char letter = tolower(fname[i]);
-        hash += (long)(letter) * (i + 119);
-        i++;
+        hash ^= (unsigned char)tolower(*name++);
+        hash *= 16777619u;
     }
-    hash &= (FILE_HASH_SIZE - 1);
+
     return hash;
 }
 
+/*
+================
+Cvar_HashSlot
+
+Slot holding name, or the empty slot where it would go
+================
+*/
+static int Cvar_HashSlot(const char *name, unsigned hash)
+{
+    int i = hash & (CVAR_HASH_SIZE - 1);
+
+    // the stored hash rejects nearly every other name without touching it
+    while (hashTable[i].var)
+    {
+        if (hashTable[i].hash == hash && !Q_stricmp(name, hashTable[i].var->name))
+            break;
+        i = (i + 1) & (CVAR_HASH_SIZE - 1);
+    }
+
+    return i;
+}
+
+/*
+================
+Cvar_HashRemove
+
+Backward shift deletion, so lookups never need tombstones
+================
+*/
+static void Cvar_HashRemove(cvar_t *var)
+{
+    int i = Cvar_HashSlot(var->name, var->hashValue);
+    int j = i;
+
+    if (hashTable[i].var != var)
+        return;
+
+    for (;;)
+    {
+        hashTable[i].var = nullptr;
+
+        for (;;)
+        {
+            j = (j + 1) & (CVAR_HASH_SIZE - 1);
+            if (!hashTable[j].var)
+                return;
+
+            // move the entry back if its home slot is not in (i, j]
+            int home = hashTable[j].hash & (CVAR_HASH_SIZE - 1);
+            if (i <= j ? (home <= i || home > j) : (home <= i && home > j))
+                break;
+        }
+
+        hashTable[i] = hashTable[j];
+        i = j;
+    }
+}
+
 /*
 ============
 Cvar_ValidateString
@@ -93,13 +157,7 @@ Cvar_FindVar
 */
 cvar_t *Cvar_FindVar(const char *var_name)
 {
-    long hash = generateHashValue(var_name);
-
-    for (cvar_t *var = hashTable[hash]; var; var = var->hashNext)
-        if (!Q_stricmp(var_name, var->name))
-            return var;
-
-    return nullptr;
+    return hashTable[Cvar_HashSlot(var_name, generateHashValue(var_name))].var;
 }
 
 /*
@@ -445,15 +503,11 @@ cvar_t *Cvar_Get(const char *var_name, const char *var_value, int flags)
     if (var->flags & CVAR_ALTERNATE_SYSTEMINFO)
         cvar_modifiedFlags |= CVAR_SYSTEMINFO;
 
-    long hash = generateHashValue(var_name);
-    var->hashIndex = hash;
+    var->hashValue = generateHashValue(var_name);
 
-    var->hashNext = hashTable[hash];
-    if (hashTable[hash])
-        hashTable[hash]->hashPrev = var;
-
-    var->hashPrev = nullptr;
-    hashTable[hash] = var;
+    int slot = Cvar_HashSlot(var_name, var->hashValue);
+    hashTable[slot].hash = var->hashValue;
+    hashTable[slot].var = var;
 
     return var;
 }
@@ -1186,7 +1240,10 @@ cvar_t *Cvar_Unset(cvar_t *cv)
     cvar_modifiedFlags |= cv->flags;
 
     if (cv->name)
+    {
+        Cvar_HashRemove(cv);
         Z_Free(cv->name);
+    }
     if (cv->string)
         Z_Free(cv->string);
     if (cv->latchedString)
@@ -1203,13 +1260,6 @@ cvar_t *Cvar_Unset(cvar_t *cv)
     if (cv->next)
         cv->next->prev = cv->prev;
 
-    if (cv->hashPrev)
-        cv->hashPrev->hashNext = cv->hashNext;
-    else
-        hashTable[cv->hashIndex] = cv->hashNext;
-    if (cv->hashNext)
-        cv->hashNext->hashPrev = cv->hashPrev;
-
     ::memset(cv, '\0', sizeof(*cv));
 
     return next;
@@ -80,9 +80,7 @@ struct cvar_s {
 
     cvar_t *next;
     cvar_t *prev;
-    cvar_t *hashNext;
-    cvar_t *hashPrev;
-    int hashIndex;
+    unsigned hashValue;  // case folded hash of name
 };
 
 /*
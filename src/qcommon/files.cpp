@@ -35,9 +35,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "cmd.h"
 #include "cvar.h"
+#include "jobs.h"
 #include "md4.h"
 #include "q_platform.h"
 #include "q_shared.h"
@@ -55,14 +57,18 @@ using namespace std;
 #define MAX_ZPATH 256
 #define MAX_SEARCH_PATHS 4096
 #define MAX_FILEHASH_SIZE 1024
+#define MAX_FOUND_FILES 0x1000
 
 static bool FS_IsDemoExt(const char *filename);
 static bool FS_IsExt(const char *filename, const char *ext, int namelen);
+static void FS_IndexWrittenFile(const char *base, const char *gamedir, const char *qpath);
+static void FS_IndexWrittenSVFile(const char *path);
 
 struct fileInPack_t {
     char* name;
     unsigned long pos;  // file info position in zip
     unsigned long len;  // uncompressed file size
+    unsigned long crc;
     fileInPack_t* next;
 };
 
@@ -72,6 +78,10 @@ struct pack_t {
     char pakBasename[MAX_OSPATH];  // pak0
     char pakGamename[MAX_OSPATH];  // base
     unzFile handle;  // handle to zip file
+    const byte *mapData;  // whole pk3 mapped read only, or nullptr
+    long mapSize;
+    int64_t fileSize;  // for the pak index cache
+    int64_t fileTime;  // 0 if it isn't cached
     int checksum;  // regular checksum
     int pure_checksum;  // checksum for pure
     int numfiles;  // number of files in pk3
@@ -89,20 +99,35 @@ struct pack_t {
     inline bool is_pure();
 };
 
+struct fileInDir_t {
+    char* name;
+    fileInDir_t* next;
+};
+
 struct directory_t {
     char path[MAX_OSPATH];
     char fullpath[MAX_OSPATH];  // /tremulous/base
     char gamedir[MAX_OSPATH];  // base
+    bool scanned;  // files lists everything below fullpath
+    int numfiles;
+    char *files;  // nul separated relative paths
+    int numdirs;
+    char *dirs;  // nul separated relative paths of the scanned directories
+    int64_t *dirTimes;  // their modification times before the scan
+    int64_t scanTime;
+    fileInDir_t *written;  // files created by us since the scan
 };
 
 struct searchpath_t {
     pack_t *pack;  // only one of pack / dir will be non nullptr
     directory_t *dir;
     searchpath_t *next;
+    int order;  // position in fs_searchpaths when the file index was built
 };
 
 static char fs_gamedir[MAX_OSPATH];  // this will be a single file name with no separators
 static cvar_t *fs_debug;
+static cvar_t *fs_mmap;
 static cvar_t *fs_homepath;
 
 static cvar_t *fs_basepath;
@@ -120,6 +145,45 @@ static int fs_packFiles = 0;  // total number of files in packs
 
 static int fs_checksumFeed;
 
+// global file index, see FS_BuildFileIndex
+struct fileIndexHit_t {
+    searchpath_t *search;
+    fileInPack_t *pakFile;  // nullptr for directories
+    fileIndexHit_t *next;
+};
+
+struct fileIndexSlot_t {
+    unsigned hash;
+    const char *name;  // nullptr for an empty slot
+    fileIndexHit_t *hits;  // in search path order
+};
+
+static cvar_t *fs_index;
+static fileIndexSlot_t *fs_indexSlots;
+static int fs_indexSize;  // power of 2
+static int fs_indexNames;
+static fileIndexHit_t *fs_indexHits;
+static searchpath_t **fs_indexUnscanned;  // directories that must still be probed
+static int fs_numIndexUnscanned;
+static bool fs_indexDirty;
+
+static int fs_indexLookups;
+static int fs_indexMisses;
+static int fs_indexProbes;
+static int fs_indexRescans;  // directories changed on disk since their scan
+static int fs_indexBuilds;
+static int fs_indexLastCheck;  // Sys_Milliseconds of the last directory check
+
+// where FS_Startup spends its time, in usec
+static struct {
+    int64_t list;  // listing game directories
+    int64_t scan;  // wall time scanning paks
+    int64_t scanWork;  // sum of the scan times of every pak
+    int64_t build;  // building pack_ts and splicing them in
+    int64_t index;  // building the file index
+    int paks;
+} fs_startupTimes;
+
 union qfile_gut {
     FILE *o;
     unzFile z;
@@ -137,6 +201,7 @@ struct fileHandleData_t {
     int zipFilePos;
     int zipFileLen;
     bool zipFile;
+    pack_t *pak;  // pak the zip entry came from
     char name[MAX_ZPATH];
 
     void close();
@@ -656,6 +721,10 @@ fileHandle_t FS_SV_FOpenFileWrite(const char *filename)
     {
         f = 0;
     }
+    else
+    {
+        FS_IndexWrittenSVFile(filename);
+    }
 
     return f;
 }
@@ -752,6 +821,7 @@ void FS_SV_Rename(const char *from, const char *to, bool safe)
     }
 
     rename(from_ospath, to_ospath);
+    FS_IndexWrittenSVFile(to);
 }
 
 /*
@@ -778,6 +848,7 @@ void FS_Rename(const char *from, const char *to)
     FS_CheckFilenameIsMutable(to_ospath, __FUNCTION__);
 
     rename(from_ospath, to_ospath);
+    FS_IndexWrittenFile(fs_homepath->string, fs_gamedir, to);
 }
 
 /*
@@ -858,6 +929,10 @@ fileHandle_t FS_FOpenFileWrite(const char *filename)
     {
         f = 0;
     }
+    else
+    {
+        FS_IndexWrittenFile(fs_homepath->string, fs_gamedir, filename);
+    }
     return f;
 }
 
@@ -902,6 +977,10 @@ fileHandle_t FS_FOpenFileAppend(const char *filename)
     {
         f = 0;
     }
+    else
+    {
+        FS_IndexWrittenFile(fs_homepath->string, fs_gamedir, filename);
+    }
     return f;
 }
 
@@ -1034,6 +1113,9 @@ static bool FS_IsDemoExt(const char *filename)
     return false;
 }
 
+static long FS_FOpenFileReadFound(const char *filename, searchpath_t *search,
+    fileInPack_t *pakfile, fileHandle_t *file, bool uniqueFILE, bool unpure);
+
 /*
 ===========
 FS_FOpenFileReadDir
@@ -1045,12 +1127,6 @@ Returns filesize and an open FILE pointer.
 long FS_FOpenFileReadDir(
     const char *filename, void *_search, fileHandle_t *file, bool uniqueFILE, bool unpure)
 {
-    pack_t *pak;
-    directory_t *dir;
-    char *netpath;
-    FILE *filep;
-    int len;
-
     searchpath_t *search = static_cast<searchpath_t *>(_search);
 
     if (filename == nullptr)
@@ -1070,6 +1146,29 @@ long FS_FOpenFileReadDir(
         return -1;
     }
 
+    fileInPack_t *pakfile = nullptr;
+    if (search->pack)
+        pakfile = search->pack->find(filename);
+
+    return FS_FOpenFileReadFound(filename, search, pakfile, file, uniqueFILE, unpure);
+}
+
+/*
+===========
+FS_FOpenFileReadFound
+
+FS_FOpenFileReadDir once the pak entry, if any, has been looked up
+===========
+*/
+static long FS_FOpenFileReadFound(const char *filename, searchpath_t *search,
+    fileInPack_t *pakfile, fileHandle_t *file, bool uniqueFILE, bool unpure)
+{
+    pack_t *pak;
+    directory_t *dir;
+    char *netpath;
+    FILE *filep;
+    int len;
+
     if (file == nullptr)
     {
         // just wants to see if file is there
@@ -1082,7 +1181,6 @@ long FS_FOpenFileReadDir(
         // is the element a pak file?
         if (search->pack)
         {
-            auto pakfile = search->pack->find(filename);
             if (pakfile)
             {
                 // found it!
@@ -1125,8 +1223,7 @@ long FS_FOpenFileReadDir(
     if (search->pack)
     {
         pak = search->pack;
-        auto pakfile = pak->find(filename);
-        if (pakfile )
+        if (pakfile)
         {
             if ( fs_debug->integer == 2 )
                 Com_Printf(S_COLOR_GREEN "#2 Searching for: " S_COLOR_RED "%s\n", filename);
@@ -1177,6 +1274,7 @@ long FS_FOpenFileReadDir(
 
             Q_strncpyz(fsh[*file].name, filename, sizeof(fsh[*file].name));
             fsh[*file].zipFile = true;
+            fsh[*file].pak = pak;
 
             // set the file position in the zip file (also sets the current file info)
             unzSetOffset(fsh[*file].handleFiles.file.z, pakfile->pos);
@@ -1250,224 +1348,796 @@ long FS_FOpenFileReadDir(
 }
 
 /*
-===========
-FS_FOpenFileRead
+========================================================================================
 
-Finds the file in the search path.
-Returns filesize and an open FILE pointer.
-Used for streaming data out of either a
-separate file or a ZIP file.
-===========
-*/
-long FS_FOpenFileRead(const char *filename, fileHandle_t *file, bool uniqueFILE)
-{
-    searchpath_t *search;
-    long len;
+GLOBAL FILE INDEX
 
-    if (!fs_searchpaths) Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+Every pak entry and every file below an indexed directory is hashed once
+into a single table, each name mapping to the search paths that can supply
+it in search path order.  FS_FOpenFileRead then only visits the search paths
+that actually hold the file, and a missing file costs one hash lookup
+instead of a hash lookup per pak and an fopen per directory.
 
-    bool isLocalConfig = !strcmp(filename, "autoexec.cfg") || !strcmp(filename, Q3CONFIG_CFG);
-    for (search = fs_searchpaths; search; search = search->next)
-    {
-        // autoexec.cfg and q3config.cfg can only be loaded outside of pk3 files.
-        if (isLocalConfig && search->pack) continue;
+Directories are scanned at FS_Startup.  Files we create ourselves are
+added as they are written.  For anything dropped into the directories by
+other means while running, a miss stats the scanned directories, at most
+once every FS_INDEX_CHECK_MSEC, and rescans those whose modification time
+moved.  Directories too large to scan are probed on every lookup as before.
+
+========================================================================================
+*/
 
-        len = FS_FOpenFileReadDir(filename, search, file, uniqueFILE, false);
+#define MAX_SCANNED_FILES 0x8000
+#define MAX_SCAN_DEPTH 8
+#define FS_INDEX_CHECK_MSEC 1000
 
-        if (file == nullptr)
-        {
-            if (len > 0) return len;
-        }
-        else
-        {
-            if (len >= 0 && *file) return len;
-        }
-    }
+/*
+=================
+FS_IndexHash
 
-#ifdef FS_MISSING
-    if (missingFiles) fprintf(missingFiles, "%s\n", filename);
-#endif
+Case and separator insensitive, to agree with FS_FilenameCompare
+=================
+*/
+static unsigned FS_IndexHash(const char *name)
+{
+    unsigned hash = 2166136261u;
 
-    if (file)
-    {
-        *file = 0;
-        return -1;
-    }
-    else
+    for (; *name; name++)
     {
-        // When file is nullptr, we're querying the existance of the file
-        // If we've got here, it doesn't exist
-        return 0;
+        int c = *name;
+
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        if (c == '\\' || c == ':')
+            c = '/';
+
+        hash ^= c;
+        hash *= 16777619u;
     }
+
+    return hash;
 }
 
 /*
 =================
-FS_FindVM
+FS_IndexSlot
 
-Find a suitable VM file in search path order.
-
-In each searchpath try:
- - open DLL file if DLL loading enabled
- - open QVM file
-
-Enable search for DLL by setting enableDll to FSVM_ENABLEDLL
-
-write found DLL or QVM to "found" and return VMI_NATIVE if DLL, VMI_COMPILED if QVM
-Return the searchpath in "startSearch".
+Slot holding name, or the empty slot where it would go
 =================
 */
-
-int FS_FindVM(void **startSearch, char *found, int foundlen, const char *name, int enableDll)
+static fileIndexSlot_t *FS_IndexSlot(const char *name, unsigned hash)
 {
-    searchpath_t *search, *lastSearch;
-    directory_t *dir;
-    pack_t *pack;
-    char dllName[MAX_OSPATH], qvmName[MAX_OSPATH];
-    char *netpath;
+    int i = hash & (fs_indexSize - 1);
 
-    if (!fs_searchpaths) Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    while (fs_indexSlots[i].name)
+    {
+        if (fs_indexSlots[i].hash == hash && !FS_FilenameCompare(fs_indexSlots[i].name, name))
+            break;
 
-    if (enableDll) Com_sprintf(dllName, sizeof(dllName), "%s" DLL_EXT, name);
+        i = (i + 1) & (fs_indexSize - 1);
+    }
 
-    Com_sprintf(qvmName, sizeof(qvmName), "vm/%s.qvm", name);
+    return &fs_indexSlots[i];
+}
 
-    lastSearch = static_cast<searchpath_t *>(*startSearch);
-    if (*startSearch == nullptr)
-        search = fs_searchpaths;
-    else
-        search = lastSearch->next;
+/*
+=================
+FS_ScanDirectoryTree
 
-    while (search)
-    {
-        if (search->dir && (!fs_numServerPaks || !strcmp(name, "game")))
-        {
-            dir = search->dir;
+Appends every file below base/subdir to files, and every directory
+with its modification time to dirs and dirTimes.  Returns false if the
+listing had to be cut short
+=================
+*/
+static bool FS_ScanDirectoryTree(const char *base, const char *subdir, int depth,
+    string &files, int &numfiles, string &dirs, vector<int64_t> &dirTimes)
+{
+    char path[MAX_OSPATH];
+    char name[MAX_OSPATH];
+    char **list;
+    int64_t size, mtime;
+    int n;
+    bool complete;
+
+    if (subdir[0])
+        Com_sprintf(path, sizeof(path), "%s%c%s", base, PATH_SEP, subdir);
+    else
+        Q_strncpyz(path, base, sizeof(path));
 
-            if (enableDll)
-            {
-                netpath = FS_BuildOSPath(dir->path, dir->gamedir, dllName);
+    // taken before the listing so that a file added during it is seen later
+    if (!Sys_FileStat(path, &size, &mtime))
+        mtime = 0;
+    dirs.append(subdir, strlen(subdir) + 1);
+    dirTimes.push_back(mtime);
 
-                if (FS_FileInPathExists(netpath))
-                {
-                    Q_strncpyz(found, netpath, foundlen);
-                    *startSearch = search;
+    list = Sys_ListFiles(path, "", nullptr, &n, false);
+    complete = n < MAX_FOUND_FILES - 1;
 
-                    return VMI_NATIVE;
-                }
-            }
+    for (int i = 0; i < n; i++)
+    {
+        if (subdir[0])
+            Com_sprintf(name, sizeof(name), "%s/%s", subdir, list[i]);
+        else
+            Q_strncpyz(name, list[i], sizeof(name));
 
-            if (FS_FOpenFileReadDir(qvmName, search, nullptr, false, false) > 0)
-            {
-                *startSearch = search;
-                return VMI_COMPILED;
-            }
-        }
-        else if (search->pack)
-        {
-            pack = search->pack;
+        files.append(name, strlen(name) + 1);
+        numfiles++;
+    }
+    Sys_FreeFileList(list);
 
-            if (lastSearch && lastSearch->pack)
-            {
-                // make sure we only try loading one VM file per game dir
-                // i.e. if VM from pak7.pk3 fails we won't try one from pak6.pk3
+    if (!complete || numfiles > MAX_SCANNED_FILES)
+        return false;
 
-                if (!FS_FilenameCompare(lastSearch->pack->pakPathname, pack->pakPathname))
-                {
-                    search = search->next;
-                    continue;
-                }
-            }
+    list = Sys_ListFiles(path, "/", nullptr, &n, false);
+    complete = n < MAX_FOUND_FILES - 1;
 
-            if (FS_FOpenFileReadDir(qvmName, search, nullptr, false, false) > 0)
-            {
-                *startSearch = search;
+    for (int i = 0; i < n && complete; i++)
+    {
+        if (!strcmp(list[i], ".") || !strcmp(list[i], ".."))
+            continue;
 
-                return VMI_COMPILED;
-            }
+        if (depth == MAX_SCAN_DEPTH)
+        {
+            complete = false;
+            break;
         }
 
-        search = search->next;
+        if (subdir[0])
+            Com_sprintf(name, sizeof(name), "%s/%s", subdir, list[i]);
+        else
+            Q_strncpyz(name, list[i], sizeof(name));
+
+        complete = FS_ScanDirectoryTree(base, name, depth + 1, files, numfiles, dirs, dirTimes);
     }
+    Sys_FreeFileList(list);
 
-    return -1;
+    return complete;
 }
 
-int FS_Read(void *buffer, int len, fileHandle_t f)
+/*
+=================
+FS_ScanDirectory
+=================
+*/
+static void FS_ScanDirectory(directory_t *dir)
 {
-    int block, remaining;
-    int read;
-    byte *buf;
-    int tries;
+    char *base = FS_BuildOSPath(dir->path, dir->gamedir, "");
+    string files, dirs;
+    vector<int64_t> dirTimes;
+    int numfiles = 0;
 
-    if (!fs_searchpaths)
+    base[strlen(base) - 1] = '\0';  // strip the trailing slash
+
+    dir->scanTime = time(nullptr);
+    dir->scanned = FS_ScanDirectoryTree(base, "", 0, files, numfiles, dirs, dirTimes);
+    if (!dir->scanned)
     {
-        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+        if (fs_debug->integer)
+            Com_Printf("FS_ScanDirectory: %s is too large to index\n", base);
+        return;
     }
 
-    if (!f)
+    dir->numfiles = numfiles;
+    if (numfiles)
     {
-        return 0;
+        dir->files = static_cast<char *>(Z_Malloc(files.size()));
+        memcpy(dir->files, files.data(), files.size());
     }
 
-    buf = (byte *)buffer;
-    fs_readCount += len;
-
-    if (fsh[f].zipFile == false)
-    {
-        remaining = len;
-        tries = 0;
-        while (remaining)
-        {
-            block = remaining;
-            read = fread(buf, 1, block, fsh[f].handleFiles.file.o);
-            if (read == 0)
-            {
-                // we might have been trying to read from a CD, which
-                // sometimes returns a 0 read on windows
-                if (!tries)
-                {
-                    tries = 1;
-                }
-                else
-                {
-                    return len - remaining;  // Com_Error (ERR_FATAL, "FS_Read: 0 bytes read");
-                }
-            }
+    dir->numdirs = dirTimes.size();
+    dir->dirs = static_cast<char *>(Z_Malloc(dirs.size()));
+    memcpy(dir->dirs, dirs.data(), dirs.size());
+    dir->dirTimes = static_cast<int64_t *>(Z_Malloc(dirTimes.size() * sizeof(*dir->dirTimes)));
+    memcpy(dir->dirTimes, dirTimes.data(), dirTimes.size() * sizeof(*dir->dirTimes));
+}
 
-            if (read == -1)
-            {
-                Com_Error(ERR_FATAL, "FS_Read: -1 bytes read");
-            }
+/*
+=================
+FS_FreeDirectoryScan
+=================
+*/
+static void FS_FreeDirectoryScan(directory_t *dir)
+{
+    fileInDir_t *next;
 
-            remaining -= read;
-            buf += read;
-        }
-        return len;
-    }
-    else
+    for (auto f = dir->written; f; f = next)
     {
-        return unzReadCurrentFile(fsh[f].handleFiles.file.z, buffer, len);
+        next = f->next;
+        Z_Free(f->name);
+        Z_Free(f);
     }
+
+    if (dir->files)
+        Z_Free(dir->files);
+    if (dir->dirs)
+        Z_Free(dir->dirs);
+    if (dir->dirTimes)
+        Z_Free(dir->dirTimes);
+
+    dir->written = nullptr;
+    dir->files = nullptr;
+    dir->dirs = nullptr;
+    dir->dirTimes = nullptr;
+    dir->numfiles = 0;
+    dir->numdirs = 0;
+    dir->scanned = false;
 }
 
 /*
 =================
-FS_Write
+FS_DirectoryChanged
 
-Properly handles partial writes
+True if a directory below a scanned search path was modified since the
+scan.  Modification times only have a resolution of a second, so one in
+the second of the scan counts as a change as well.
 =================
 */
-int FS_Write(const void *buffer, int len, fileHandle_t h)
+static bool FS_DirectoryChanged(directory_t *dir)
 {
-    if (!fs_searchpaths)
-    {
-        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
-    }
+    char *base = FS_BuildOSPath(dir->path, dir->gamedir, "");
+    char path[MAX_OSPATH];
+    const char *name = dir->dirs;
+    int64_t size, mtime;
 
-    if (!h)
+    base[strlen(base) - 1] = '\0';  // strip the trailing slash
+
+    for (int i = 0; i < dir->numdirs; i++, name += strlen(name) + 1)
     {
-        return 0;
+        if (name[0])
+            Com_sprintf(path, sizeof(path), "%s%c%s", base, PATH_SEP, name);
+        else
+            Q_strncpyz(path, base, sizeof(path));
+
+        if (!Sys_FileStat(path, &size, &mtime))
+            mtime = 0;
+        if (mtime != dir->dirTimes[i] || mtime >= dir->scanTime)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+=================
+FS_FreeDirectory
+=================
+*/
+static void FS_FreeDirectory(directory_t *dir)
+{
+    FS_FreeDirectoryScan(dir);
+    Z_Free(dir);
+}
+
+/*
+=================
+FS_FreeFileIndex
+=================
+*/
+static void FS_FreeFileIndex(void)
+{
+    if (fs_indexSlots)
+        Z_Free(fs_indexSlots);
+    if (fs_indexHits)
+        Z_Free(fs_indexHits);
+    if (fs_indexUnscanned)
+        Z_Free(fs_indexUnscanned);
+
+    fs_indexSlots = nullptr;
+    fs_indexHits = nullptr;
+    fs_indexUnscanned = nullptr;
+    fs_indexSize = 0;
+    fs_indexNames = 0;
+    fs_numIndexUnscanned = 0;
+}
+
+/*
+=================
+FS_IndexAdd
+
+Search paths are added last to first, so the new hit goes in front
+=================
+*/
+static void FS_IndexAdd(const char *name, searchpath_t *search, fileInPack_t *pakFile, int &numHits)
+{
+    unsigned hash = FS_IndexHash(name);
+    fileIndexSlot_t *slot = FS_IndexSlot(name, hash);
+
+    if (!slot->name)
+    {
+        slot->name = name;
+        slot->hash = hash;
+        fs_indexNames++;
+    }
+    else if (slot->hits && slot->hits->search == search)
+    {
+        return;  // same name twice in one search path
+    }
+
+    fileIndexHit_t *hit = &fs_indexHits[numHits++];
+    hit->search = search;
+    hit->pakFile = pakFile;
+    hit->next = slot->hits;
+    slot->hits = hit;
+}
+
+/*
+=================
+FS_BuildFileIndex
+
+Called whenever the search path order changes
+=================
+*/
+static void FS_BuildFileIndex(void)
+{
+    searchpath_t *search;
+    searchpath_t **order;
+    int numSearch, numNames, numHits;
+    int i;
+
+    FS_FreeFileIndex();
+    fs_indexDirty = false;
+    fs_indexBuilds++;
+
+    numSearch = 0;
+    numNames = 0;
+    for (search = fs_searchpaths; search; search = search->next)
+    {
+        search->order = numSearch++;
+
+        if (search->pack)
+        {
+            numNames += search->pack->numfiles;
+        }
+        else
+        {
+            numNames += search->dir->numfiles;
+            for (auto f = search->dir->written; f; f = f->next)
+                numNames++;
+
+            if (!search->dir->scanned)
+                fs_numIndexUnscanned++;
+        }
+    }
+
+    for (fs_indexSize = 1024; fs_indexSize < numNames * 2; fs_indexSize <<= 1)
+        ;
+
+    fs_indexSlots = static_cast<fileIndexSlot_t *>(Z_Malloc(fs_indexSize * sizeof(*fs_indexSlots)));
+    fs_indexHits = static_cast<fileIndexHit_t *>(Z_Malloc((numNames + 1) * sizeof(*fs_indexHits)));
+    fs_indexUnscanned = static_cast<searchpath_t **>(
+        Z_Malloc((fs_numIndexUnscanned + 1) * sizeof(*fs_indexUnscanned)));
+    order = static_cast<searchpath_t **>(Z_Malloc((numSearch + 1) * sizeof(*order)));
+
+    fs_numIndexUnscanned = 0;
+    for (search = fs_searchpaths; search; search = search->next)
+    {
+        order[search->order] = search;
+
+        if (search->dir && !search->dir->scanned)
+            fs_indexUnscanned[fs_numIndexUnscanned++] = search;
+    }
+
+    numHits = 0;
+    for (i = numSearch - 1; i >= 0; i--)
+    {
+        search = order[i];
+
+        if (search->pack)
+        {
+            for (int j = 0; j < search->pack->numfiles; j++)
+                FS_IndexAdd(search->pack->buildBuffer[j].name, search,
+                        &search->pack->buildBuffer[j], numHits);
+        }
+        else
+        {
+            const char *name = search->dir->files;
+            for (int j = 0; j < search->dir->numfiles; j++, name += strlen(name) + 1)
+                FS_IndexAdd(name, search, nullptr, numHits);
+
+            for (auto f = search->dir->written; f; f = f->next)
+                FS_IndexAdd(f->name, search, nullptr, numHits);
+        }
+    }
+
+    Z_Free(order);
+}
+
+/*
+=================
+FS_IndexWrittenFile
+
+Keeps the index in step with files created below base/gamedir
+=================
+*/
+static void FS_IndexWrittenFile(const char *base, const char *gamedir, const char *qpath)
+{
+    searchpath_t *search;
+
+    for (search = fs_searchpaths; search; search = search->next)
+    {
+        if (search->dir && !Q_stricmp(search->dir->path, base) &&
+            !Q_stricmp(search->dir->gamedir, gamedir))
+            break;
+    }
+
+    // unscanned directories are probed anyway
+    if (!search || !search->dir->scanned)
+        return;
+
+    if (fs_indexSlots && !fs_indexDirty)
+    {
+        auto slot = FS_IndexSlot(qpath, FS_IndexHash(qpath));
+        for (auto hit = slot->hits; hit; hit = hit->next)
+        {
+            if (hit->search == search)
+                return;  // already known
+        }
+    }
+
+    auto f = static_cast<fileInDir_t *>(Z_Malloc(sizeof(fileInDir_t)));
+    f->name = CopyString(qpath);
+    f->next = search->dir->written;
+    search->dir->written = f;
+
+    fs_indexDirty = true;
+}
+
+/*
+=================
+FS_IndexWrittenSVFile
+
+As FS_IndexWrittenFile for paths relative to fs_homepath
+=================
+*/
+static void FS_IndexWrittenSVFile(const char *path)
+{
+    char gamedir[MAX_OSPATH];
+    const char *slash = strchr(path, '/');
+
+    if (!slash || slash - path >= (int)sizeof(gamedir))
+        return;
+
+    Q_strncpyz(gamedir, path, slash - path + 1);
+    FS_IndexWrittenFile(fs_homepath->string, gamedir, slash + 1);
+}
+
+/*
+=================
+FS_RescanChangedDirectories
+
+Called on an index miss.  Rescans the scanned directories that changed
+on disk since their scan, returns true if any did.
+=================
+*/
+static bool FS_RescanChangedDirectories(void)
+{
+    bool changed = false;
+    int now = Sys_Milliseconds();
+
+    if (fs_indexLastCheck && now - fs_indexLastCheck < FS_INDEX_CHECK_MSEC)
+        return false;
+    fs_indexLastCheck = now;
+
+    for (auto search = fs_searchpaths; search; search = search->next)
+    {
+        if (!search->dir || !search->dir->scanned || !FS_DirectoryChanged(search->dir))
+            continue;
+
+        FS_FreeDirectoryScan(search->dir);
+        FS_ScanDirectory(search->dir);
+        fs_indexRescans++;
+        changed = true;
+    }
+
+    if (changed)
+        fs_indexDirty = true;
+    return changed;
+}
+
+/*
+=================
+FS_FOpenFileReadIndexed
+
+FS_FOpenFileRead through the file index, merging the index hits with
+the directories that could not be scanned.  Returns false if not found.
+=================
+*/
+static bool FS_FOpenFileReadIndexed(
+    const char *filename, fileHandle_t *file, bool uniqueFILE, bool isLocalConfig, long *len)
+{
+    fileIndexSlot_t *slot;
+    fileIndexHit_t *hit;
+    searchpath_t *search;
+    fileInPack_t *pakFile;
+    int unscanned;
+
+    if (fs_indexDirty)
+        FS_BuildFileIndex();
+
+    // qpaths are not supposed to have a leading slash
+    if (filename[0] == '/' || filename[0] == '\\')
+        filename++;
+
+    fs_indexLookups++;
+    slot = FS_IndexSlot(filename, FS_IndexHash(filename));
+    hit = slot->hits;
+    unscanned = 0;
+
+    if (!hit && FS_RescanChangedDirectories())
+    {
+        FS_BuildFileIndex();
+        slot = FS_IndexSlot(filename, FS_IndexHash(filename));
+        hit = slot->hits;
+    }
+
+    if (!hit && !fs_numIndexUnscanned)
+    {
+        fs_indexMisses++;
+        return false;
+    }
+
+    while (hit || unscanned < fs_numIndexUnscanned)
+    {
+        if (hit && (unscanned == fs_numIndexUnscanned ||
+                       hit->search->order < fs_indexUnscanned[unscanned]->order))
+        {
+            search = hit->search;
+            pakFile = hit->pakFile;
+            hit = hit->next;
+        }
+        else
+        {
+            search = fs_indexUnscanned[unscanned++];
+            pakFile = nullptr;
+        }
+
+        // autoexec.cfg and q3config.cfg can only be loaded outside of pk3 files.
+        if (isLocalConfig && search->pack) continue;
+
+        fs_indexProbes++;
+        *len = FS_FOpenFileReadFound(filename, search, pakFile, file, uniqueFILE, false);
+
+        if (file == nullptr)
+        {
+            if (*len > 0) return true;
+        }
+        else
+        {
+            if (*len >= 0 && *file) return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+===========
+FS_FOpenFileRead
+
+Finds the file in the search path.
+Returns filesize and an open FILE pointer.
+Used for streaming data out of either a
+separate file or a ZIP file.
+===========
+*/
+long FS_FOpenFileRead(const char *filename, fileHandle_t *file, bool uniqueFILE)
+{
+    searchpath_t *search;
+    long len;
+
+    if (!fs_searchpaths) Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+
+    bool isLocalConfig = !strcmp(filename, "autoexec.cfg") || !strcmp(filename, Q3CONFIG_CFG);
+    if (fs_index->integer && (fs_indexSlots || fs_indexDirty) &&
+        !strstr(filename, "..") && !strstr(filename, "::"))
+    {
+        if (FS_FOpenFileReadIndexed(filename, file, uniqueFILE, isLocalConfig, &len))
+            return len;
+    }
+    else
+    {
+        for (search = fs_searchpaths; search; search = search->next)
+        {
+            // autoexec.cfg and q3config.cfg can only be loaded outside of pk3 files.
+            if (isLocalConfig && search->pack) continue;
+
+            len = FS_FOpenFileReadDir(filename, search, file, uniqueFILE, false);
+
+            if (file == nullptr)
+            {
+                if (len > 0) return len;
+            }
+            else
+            {
+                if (len >= 0 && *file) return len;
+            }
+        }
+    }
+
+#ifdef FS_MISSING
+    if (missingFiles) fprintf(missingFiles, "%s\n", filename);
+#endif
+
+    if (file)
+    {
+        *file = 0;
+        return -1;
+    }
+    else
+    {
+        // When file is nullptr, we're querying the existance of the file
+        // If we've got here, it doesn't exist
+        return 0;
+    }
+}
+
+/*
+=================
+FS_FindVM
+
+Find a suitable VM file in search path order.
+
+In each searchpath try:
+ - open DLL file if DLL loading enabled
+ - open QVM file
+
+Enable search for DLL by setting enableDll to FSVM_ENABLEDLL
+
+write found DLL or QVM to "found" and return VMI_NATIVE if DLL, VMI_COMPILED if QVM
+Return the searchpath in "startSearch".
+=================
+*/
+
+int FS_FindVM(void **startSearch, char *found, int foundlen, const char *name, int enableDll)
+{
+    searchpath_t *search, *lastSearch;
+    directory_t *dir;
+    pack_t *pack;
+    char dllName[MAX_OSPATH], qvmName[MAX_OSPATH];
+    char *netpath;
+
+    if (!fs_searchpaths) Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+
+    if (enableDll) Com_sprintf(dllName, sizeof(dllName), "%s" DLL_EXT, name);
+
+    Com_sprintf(qvmName, sizeof(qvmName), "vm/%s.qvm", name);
+
+    lastSearch = static_cast<searchpath_t *>(*startSearch);
+    if (*startSearch == nullptr)
+        search = fs_searchpaths;
+    else
+        search = lastSearch->next;
+
+    while (search)
+    {
+        if (search->dir && (!fs_numServerPaks || !strcmp(name, "game")))
+        {
+            dir = search->dir;
+
+            if (enableDll)
+            {
+                netpath = FS_BuildOSPath(dir->path, dir->gamedir, dllName);
+
+                if (FS_FileInPathExists(netpath))
+                {
+                    Q_strncpyz(found, netpath, foundlen);
+                    *startSearch = search;
+
+                    return VMI_NATIVE;
+                }
+            }
+
+            if (FS_FOpenFileReadDir(qvmName, search, nullptr, false, false) > 0)
+            {
+                *startSearch = search;
+                return VMI_COMPILED;
+            }
+        }
+        else if (search->pack)
+        {
+            pack = search->pack;
+
+            if (lastSearch && lastSearch->pack)
+            {
+                // make sure we only try loading one VM file per game dir
+                // i.e. if VM from pak7.pk3 fails we won't try one from pak6.pk3
+
+                if (!FS_FilenameCompare(lastSearch->pack->pakPathname, pack->pakPathname))
+                {
+                    search = search->next;
+                    continue;
+                }
+            }
+
+            if (FS_FOpenFileReadDir(qvmName, search, nullptr, false, false) > 0)
+            {
+                *startSearch = search;
+
+                return VMI_COMPILED;
+            }
+        }
+
+        search = search->next;
+    }
+
+    return -1;
+}
+
+int FS_Read(void *buffer, int len, fileHandle_t f)
+{
+    int block, remaining;
+    int read;
+    byte *buf;
+    int tries;
+
+    if (!fs_searchpaths)
+    {
+        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    }
+
+    if (!f)
+    {
+        return 0;
+    }
+
+    buf = (byte *)buffer;
+    fs_readCount += len;
+
+    if (fsh[f].zipFile == false)
+    {
+        remaining = len;
+        tries = 0;
+        while (remaining)
+        {
+            block = remaining;
+            read = fread(buf, 1, block, fsh[f].handleFiles.file.o);
+            if (read == 0)
+            {
+                // we might have been trying to read from a CD, which
+                // sometimes returns a 0 read on windows
+                if (!tries)
+                {
+                    tries = 1;
+                }
+                else
+                {
+                    return len - remaining;  // Com_Error (ERR_FATAL, "FS_Read: 0 bytes read");
+                }
+            }
+
+            if (read == -1)
+            {
+                Com_Error(ERR_FATAL, "FS_Read: -1 bytes read");
+            }
+
+            remaining -= read;
+            buf += read;
+        }
+        return len;
+    }
+    else
+    {
+        return unzReadCurrentFile(fsh[f].handleFiles.file.z, buffer, len);
+    }
+}
+
+/*
+=================
+FS_Write
+
+Properly handles partial writes
+=================
+*/
+int FS_Write(const void *buffer, int len, fileHandle_t h)
+{
+    if (!fs_searchpaths)
+    {
+        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    }
+
+    if (!h)
+    {
+        return 0;
     }
 
     FILE *f = FS_FileForHandle(h);
@@ -1668,30 +2338,110 @@ int FS_FileIsInPAK_A(bool alternate, const char *filename, int *pChecksum)
         if (!search->pack)
             continue;
 
-        // disregard if it doesn't match one of the allowed pure pak files
-        if (!search->pack->is_pure())
-            continue;
+        // disregard if it doesn't match one of the allowed pure pak files
+        if (!search->pack->is_pure())
+            continue;
+
+        if ((alternate && search->pack->onlyPrimary) ||
+            (!alternate && search->pack->onlyAlternate))
+            continue;
+
+        auto found = search->pack->find(filename);
+        if (found)
+        {
+            if (pChecksum)
+                *pChecksum = search->pack->pure_checksum;
+
+            return 1;
+        }
+    }
+    return -1;
+}
+
+int FS_FileIsInPAK(const char *filename, int *pChecksum)
+{
+    return FS_FileIsInPAK_A(false, filename, pChecksum);
+}
+/*
+============
+FS_MappedEntry
+
+Where the data of the zip entry open on f starts in its pak's mapping.
+Sets stored to whether it is kept uncompressed.
+============
+*/
+static const byte *FS_MappedEntry(fileHandle_t f, bool *stored, unsigned long *size)
+{
+    pack_t *pak = fsh[f].pak;
+    unz_file_info fi;
+
+    if (!fsh[f].zipFile || !pak || !pak->mapData)
+        return nullptr;
+
+    if (unzGetCurrentFileInfo(fsh[f].handleFiles.file.z, &fi, nullptr, 0, nullptr, 0, nullptr, 0))
+        return nullptr;
+
+    if (fi.compression_method != 0 && fi.compression_method != Z_DEFLATED)
+        return nullptr;
+
+    ZPOS64_T pos = unzGetCurrentFileZStreamPos64(fsh[f].handleFiles.file.z);
+    if (!pos || pos + fi.compressed_size > (ZPOS64_T)pak->mapSize)
+        return nullptr;
+
+    *stored = fi.compression_method == 0;
+    *size = fi.compressed_size;
+    return pak->mapData + pos;
+}
+
+/*
+============
+FS_ReadMappedEntry
+
+Reads a whole pak entry straight out of the mapping, inflating
+deflated entries into buffer in one call instead of through
+the unzip read buffers.  Returns false if f isn't a mapped entry.
+============
+*/
+static bool FS_ReadMappedEntry(fileHandle_t f, void *buffer, int len)
+{
+    unsigned long size;
+    bool stored;
+    const byte *data = FS_MappedEntry(f, &stored, &size);
+
+    if (!data)
+        return false;
+
+    if (stored)
+    {
+        if (size != (unsigned long)len)
+            return false;
+
+        memcpy(buffer, data, len);
+        fs_readCount += len;
+        return true;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return false;
+
+    stream.next_in = const_cast<Bytef *>(data);
+    stream.avail_in = size;
+    stream.next_out = static_cast<Bytef *>(buffer);
+    stream.avail_out = len;
 
-        if ((alternate && search->pack->onlyPrimary) ||
-            (!alternate && search->pack->onlyAlternate))
-            continue;
+    int err = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
 
-        auto found = search->pack->find(filename);
-        if (found)
-        {
-            if (pChecksum)
-                *pChecksum = search->pack->pure_checksum;
+    // fall back to the unzip path, which reports the damage its own way
+    if (err != Z_STREAM_END || stream.total_out != (uLong)len)
+        return false;
 
-            return 1;
-        }
-    }
-    return -1;
+    fs_readCount += len;
+    return true;
 }
 
-int FS_FileIsInPAK(const char *filename, int *pChecksum)
-{
-    return FS_FileIsInPAK_A(false, filename, pChecksum);
-}
 /*
 ============
 FS_ReadFileDir
@@ -1816,155 +2566,806 @@ long FS_ReadFileDir(const char *qpath, void *searchPath, bool unpure, void **buf
         return len;
     }
 
-    fs_loadCount++;
-    fs_loadStack++;
+    fs_loadCount++;
+    fs_loadStack++;
+
+    buf = static_cast<byte *>(Hunk_AllocateTempMemory(len + 1));
+    *buffer = buf;
+
+    if (!FS_ReadMappedEntry(h, buf, len))
+        FS_Read(buf, len, h);
+
+    // guarantee that it will have a trailing 0 for string operations
+    buf[len] = 0;
+    FS_FCloseFile(h);
+
+    // if we are journalling and it is a config file, write it to the journal file
+    if (isConfig && com_journal && com_journal->integer == 1)
+    {
+        Com_DPrintf("Writing %s to journal file.\n", qpath);
+        FS_Write(&len, sizeof(len), com_journalDataFile);
+        FS_Write(buf, len, com_journalDataFile);
+        FS_Flush(com_journalDataFile);
+    }
+    return len;
+}
+
+/*
+============
+FS_ReadFile
+
+Filename are relative to the quake search path
+a null buffer will just return the file length without loading
+============
+*/
+long FS_ReadFile(const char *qpath, void **buffer)
+{
+    return FS_ReadFileDir(qpath, nullptr, false, buffer);
+}
+/*
+============
+FS_MapFile
+
+Like FS_ReadFile, but the buffer is read only and must be released with
+FS_UnmapFile.  Entries stored uncompressed in a mapped pak are returned
+as a pointer into the mapping, without a copy or a trailing 0.
+============
+*/
+long FS_MapFile(const char *qpath, const void **buffer)
+{
+    fileHandle_t h;
+    unsigned long size;
+    bool stored;
+    long len;
+
+    if (!fs_searchpaths)
+    {
+        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    }
+
+    // journaled files have to go through FS_ReadFileDir
+    if (com_journal && com_journal->integer)
+    {
+        return FS_ReadFile(qpath, const_cast<void **>(buffer));
+    }
+
+    len = FS_FOpenFileRead(qpath, &h, false);
+    if (!h)
+    {
+        *buffer = nullptr;
+        return -1;
+    }
+
+    const byte *data = FS_MappedEntry(h, &stored, &size);
+    FS_FCloseFile(h);
+
+    // callers read lumps of ints and floats straight out of the buffer
+    if (!data || !stored || size != (unsigned long)len || ((uintptr_t)data & 3))
+    {
+        return FS_ReadFile(qpath, const_cast<void **>(buffer));
+    }
+
+    fs_loadCount++;
+    *buffer = data;
+    return len;
+}
+
+/*
+=============
+FS_UnmapFile
+=============
+*/
+void FS_UnmapFile(const void *buffer)
+{
+    if (!fs_searchpaths)
+    {
+        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    }
+
+    for (auto search = fs_searchpaths; search; search = search->next)
+    {
+        pack_t *pak = search->pack;
+
+        if (pak && pak->mapData && (const byte *)buffer >= pak->mapData &&
+            (const byte *)buffer < pak->mapData + pak->mapSize)
+            return;  // nothing to free
+    }
+
+    FS_FreeFile(const_cast<void *>(buffer));
+}
+
+/*
+=============
+FS_FreeFile
+=============
+*/
+void FS_FreeFile(void *buffer)
+{
+    if (!fs_searchpaths)
+    {
+        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    }
+    if (!buffer)
+    {
+        Com_Error(ERR_FATAL, "FS_FreeFile( nullptr )");
+    }
+
+    fs_loadStack--;
+    Hunk_FreeTempMemory(buffer);
+
+    // if all of our temp files are free, clear all of our space
+    if (fs_loadStack == 0)
+    {
+        Hunk_ClearTempMemory();
+    }
+}
+
+/*
+============
+FS_WriteFile
+
+Filename are relative to the quake search path
+============
+*/
+void FS_WriteFile(const char *qpath, const void *buffer, int size)
+{
+    if (!fs_searchpaths)
+    {
+        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+    }
+
+    if (!qpath || !buffer)
+    {
+        Com_Error(ERR_FATAL, "FS_WriteFile: nullptr parameter");
+    }
+
+    fileHandle_t f = FS_FOpenFileWrite(qpath);
+    if (!f)
+    {
+        Com_Printf("Failed to open %s\n", qpath);
+        return;
+    }
+
+    FS_Write(buffer, size, f);
+    FS_FCloseFile(f);
+}
+
+/*
+==========================================================================
+
+ZIP FILE LOADING
+
+==========================================================================
+*/
+
+/*
+=================
+Pak directory parsing and the pak index cache
+
+The central directory is read in one piece, from the mapping when the pak
+is mapped, and parsed in a single pass.  What FS_LoadZipFile needs from it
+is also kept in fs_homepath/pakindex.dat keyed on the pak's path, size and
+modification time, so paks that haven't changed are never parsed again.
+=================
+*/
+
+#define ZIP_EOCD_SIG 0x06054b50
+#define ZIP_CDIR_SIG 0x02014b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CDIR_SIZE 46
+
+#define PAKCACHE_NAME "pakindex.dat"
+#define PAKCACHE_IDENT (('X' << 24) + ('I' << 16) + ('K' << 8) + 'P')
+#define PAKCACHE_VERSION 1
+
+// one central directory entry, as much as the search paths need
+struct zipEntry_t {
+    uint32_t pos;  // offset in the central directory, for unzSetOffset
+    uint32_t len;  // uncompressed size
+    uint32_t crc;
+    uint32_t name;  // offset in names
+};
+
+struct zipIndex_t {
+    int numEntries;
+    zipEntry_t *entries;
+    int namesLen;
+    char *names;
+};
+
+// record in pakindex.dat, followed by the path, the entries and the names
+struct pakCacheHeader_t {
+    int64_t size;
+    int64_t mtime;
+    int32_t pathLen;  // including the 0
+    int32_t numEntries;
+    int32_t namesLen;
+    int32_t pad;
+};
+
+static cvar_t *fs_pakCache;
+static byte *fs_pakCacheData;
+static int fs_pakCacheLen;
+static int fs_pakCacheHits;
+static int fs_pakCacheMisses;
+
+static unsigned FS_ZipShort(const byte *p) { return p[0] | (p[1] << 8); }
+
+static unsigned FS_ZipLong(const byte *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+}
+
+/*
+=================
+FS_ReadZipRange
+
+Returns len bytes at offset, straight from the mapping if there is one,
+otherwise read into temp, which the caller frees.  Like the rest of
+the pak scanning this runs on job threads, so it stays off the zone.
+=================
+*/
+static const byte *FS_ReadZipRange(FILE *f, const byte *map, long offset, long len, byte **temp)
+{
+    *temp = nullptr;
+
+    if (map)
+        return map + offset;
+
+    *temp = static_cast<byte *>(malloc(len + 1));
+    if (!*temp)
+        return nullptr;
+    if (fseek(f, offset, SEEK_SET) || fread(*temp, 1, len, f) != (size_t)len)
+    {
+        free(*temp);
+        *temp = nullptr;
+        return nullptr;
+    }
+
+    return *temp;
+}
+
+/*
+=================
+FS_ParseZipDirectory
+
+Reads the end of central directory record and the central directory,
+filling index in one pass.  Zip64 and anything odd is left to minizip.
+=================
+*/
+static bool FS_ParseZipDirectory(const char *zipfile, const byte *map, long mapSize, zipIndex_t *index)
+{
+    FILE *f = nullptr;
+    byte *tempTail = nullptr, *tempDir = nullptr;
+    const byte *tail, *eocd, *dir, *p, *end;
+    long fileSize, tailLen, before;
+    unsigned numEntries, dirSize, dirOfs;
+    bool ok = false;
+
+    if (map)
+    {
+        fileSize = mapSize;
+    }
+    else
+    {
+        f = Sys_FOpen(zipfile, "rb");
+        if (!f)
+            return false;
+        fileSize = FS_fplength(f);
+    }
+
+    if (fileSize < ZIP_EOCD_SIZE)
+        goto done;
+
+    // the record is at the end, behind a comment of up to 64k
+    tailLen = fileSize < 0xffff + ZIP_EOCD_SIZE ? fileSize : 0xffff + ZIP_EOCD_SIZE;
+    tail = FS_ReadZipRange(f, map, fileSize - tailLen, tailLen, &tempTail);
+    if (!tail)
+        goto done;
+
+    for (eocd = tail + tailLen - ZIP_EOCD_SIZE; eocd >= tail; eocd--)
+    {
+        if (FS_ZipLong(eocd) == ZIP_EOCD_SIG)
+            break;
+    }
+    if (eocd < tail)
+        goto done;
+
+    numEntries = FS_ZipShort(eocd + 10);
+    dirSize = FS_ZipLong(eocd + 12);
+    dirOfs = FS_ZipLong(eocd + 16);
+    if (numEntries == 0xffff || dirOfs == 0xffffffff || dirSize == 0xffffffff)
+        goto done;  // zip64
+
+    // self extracting archives have data in front of the zip
+    before = (fileSize - tailLen + (eocd - tail)) - ((long)dirOfs + dirSize);
+    if (before < 0)
+        goto done;
+
+    dir = FS_ReadZipRange(f, map, dirOfs + before, dirSize, &tempDir);
+    if (!dir)
+        goto done;
+
+    index->entries = static_cast<zipEntry_t *>(malloc(numEntries * sizeof(zipEntry_t) + dirSize + 1));
+    if (!index->entries)
+        goto done;
+    index->names = reinterpret_cast<char *>(index->entries + numEntries);
+    index->numEntries = 0;
+    index->namesLen = 0;
+
+    end = dir + dirSize;
+    for (p = dir; index->numEntries < (int)numEntries; )
+    {
+        if (p + ZIP_CDIR_SIZE > end || FS_ZipLong(p) != ZIP_CDIR_SIG)
+            break;
+
+        unsigned nameLen = FS_ZipShort(p + 28);
+        unsigned skip = ZIP_CDIR_SIZE + nameLen + FS_ZipShort(p + 30) + FS_ZipShort(p + 32);
+        if (p + skip > end)
+            break;
+
+        zipEntry_t *e = &index->entries[index->numEntries++];
+        e->pos = dirOfs + (p - dir);
+        e->crc = FS_ZipLong(p + 16);
+        e->len = FS_ZipLong(p + 24);
+        e->name = index->namesLen;
+
+        // same truncation as unzGetCurrentFileInfo into a MAX_ZPATH buffer
+        if (nameLen > MAX_ZPATH - 1)
+            nameLen = MAX_ZPATH - 1;
+        memcpy(index->names + index->namesLen, p + ZIP_CDIR_SIZE, nameLen);
+        index->names[index->namesLen + nameLen] = '\0';
+        Q_strlwr(index->names + index->namesLen);
+        index->namesLen += strlen(index->names + index->namesLen) + 1;
+
+        p += skip;
+    }
+
+    // a short or damaged record would silently lose the entries after it,
+    // let minizip have a go instead
+    ok = index->numEntries == (int)numEntries;
+    if (!ok)
+    {
+        free(index->entries);
+        index->entries = nullptr;
+        index->names = nullptr;
+        index->numEntries = 0;
+        index->namesLen = 0;
+    }
+
+done:
+    free(tempTail);
+    free(tempDir);
+    if (f)
+        fclose(f);
+    return ok;
+}
+
+/*
+=================
+FS_WalkZipDirectory
+
+The minizip walk, for whatever FS_ParseZipDirectory turns down
+=================
+*/
+static bool FS_WalkZipDirectory(unzFile z, zipIndex_t *index)
+{
+    unz_global_info gi;
+    char filename[MAX_ZPATH];
+    string names;
+
+    if (unzGetGlobalInfo(z, &gi) || unzGoToFirstFile(z))
+        return false;
+
+    index->entries = static_cast<zipEntry_t *>(malloc(gi.number_entry * sizeof(zipEntry_t) + 1));
+    index->numEntries = 0;
+
+    for (uLong i = 0; i < gi.number_entry; i++)
+    {
+        unz_file_info fi;
+        if (unzGetCurrentFileInfo(z, &fi, filename, sizeof(filename), nullptr, 0, nullptr, 0))
+            break;
+
+        Q_strlwr(filename);
 
-    buf = static_cast<byte *>(Hunk_AllocateTempMemory(len + 1));
-    *buffer = buf;
+        zipEntry_t *e = &index->entries[index->numEntries++];
+        e->pos = unzGetOffset(z);
+        e->crc = fi.crc;
+        e->len = fi.uncompressed_size;
+        e->name = names.size();
+        names.append(filename, strlen(filename) + 1);
 
-    FS_Read(buf, len, h);
+        unzGoToNextFile(z);
+    }
 
-    // guarantee that it will have a trailing 0 for string operations
-    buf[len] = 0;
-    FS_FCloseFile(h);
+    // names go in a second block so the index can be freed in one go
+    zipEntry_t *entries = static_cast<zipEntry_t *>(
+        malloc(index->numEntries * sizeof(zipEntry_t) + names.size() + 1));
+    memcpy(entries, index->entries, index->numEntries * sizeof(zipEntry_t));
+    free(index->entries);
 
-    // if we are journalling and it is a config file, write it to the journal file
-    if (isConfig && com_journal && com_journal->integer == 1)
-    {
-        Com_DPrintf("Writing %s to journal file.\n", qpath);
-        FS_Write(&len, sizeof(len), com_journalDataFile);
-        FS_Write(buf, len, com_journalDataFile);
-        FS_Flush(com_journalDataFile);
-    }
-    return len;
+    index->entries = entries;
+    index->names = reinterpret_cast<char *>(entries + index->numEntries);
+    index->namesLen = names.size();
+    memcpy(index->names, names.data(), names.size());
+
+    return true;
 }
 
 /*
-============
-FS_ReadFile
+=================
+FS_NextPakCacheRecord
 
-Filename are relative to the quake search path
-a null buffer will just return the file length without loading
-============
+Steps over the record at ofs, nullptr at the end or if it is damaged
+=================
 */
-long FS_ReadFile(const char *qpath, void **buffer)
+static const pakCacheHeader_t *FS_NextPakCacheRecord(int *ofs, const char **path, zipIndex_t *index)
 {
-    return FS_ReadFileDir(qpath, nullptr, false, buffer);
+    const pakCacheHeader_t *header;
+    int len;
+
+    if (*ofs + (int)sizeof(pakCacheHeader_t) > fs_pakCacheLen)
+        return nullptr;
+
+    header = reinterpret_cast<const pakCacheHeader_t *>(fs_pakCacheData + *ofs);
+    if (header->pathLen <= 0 || header->numEntries < 0 || header->namesLen < 0 ||
+        header->pathLen > MAX_OSPATH || header->numEntries > 0x100000)
+        return nullptr;
+
+    len = sizeof(*header) + PAD(header->pathLen, 8) +
+          header->numEntries * sizeof(zipEntry_t) + PAD(header->namesLen, 8);
+    if (*ofs + len > fs_pakCacheLen)
+        return nullptr;
+
+    *path = reinterpret_cast<const char *>(header + 1);
+    index->numEntries = header->numEntries;
+    index->entries = (zipEntry_t *)(*path + PAD(header->pathLen, 8));
+    index->namesLen = header->namesLen;
+    index->names = (char *)(index->entries + header->numEntries);
+
+    if ((*path)[header->pathLen - 1] || (header->namesLen && index->names[header->namesLen - 1]))
+        return nullptr;
+
+    *ofs += len;
+    return header;
 }
+
 /*
-=============
-FS_FreeFile
-=============
+=================
+FS_LoadPakCache
+=================
 */
-void FS_FreeFile(void *buffer)
+static void FS_LoadPakCache(void)
 {
-    if (!fs_searchpaths)
-    {
-        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
-    }
-    if (!buffer)
+    char ospath[MAX_OSPATH];
+    FILE *f;
+    long len;
+    int32_t ident[2];
+
+    fs_pakCacheHits = fs_pakCacheMisses = 0;
+    if (!fs_pakCache->integer)
+        return;
+
+    Com_sprintf(ospath, sizeof(ospath), "%s%c%s", fs_homepath->string, PATH_SEP, PAKCACHE_NAME);
+    f = Sys_FOpen(ospath, "rb");
+    if (!f)
+        return;
+
+    len = FS_fplength(f) - sizeof(ident);
+    if (len > 0 && fread(ident, sizeof(ident), 1, f) == 1 &&
+        ident[0] == PAKCACHE_IDENT && ident[1] == PAKCACHE_VERSION)
     {
-        Com_Error(ERR_FATAL, "FS_FreeFile( nullptr )");
+        fs_pakCacheData = static_cast<byte *>(Z_Malloc(len));
+        if (fread(fs_pakCacheData, 1, len, f) == (size_t)len)
+        {
+            fs_pakCacheLen = len;
+        }
+        else
+        {
+            Z_Free(fs_pakCacheData);
+            fs_pakCacheData = nullptr;
+        }
     }
 
-    fs_loadStack--;
-    Hunk_FreeTempMemory(buffer);
+    fclose(f);
+}
 
-    // if all of our temp files are free, clear all of our space
-    if (fs_loadStack == 0)
+/*
+=================
+FS_FindPakCache
+=================
+*/
+static bool FS_FindPakCache(const char *zipfile, int64_t size, int64_t mtime, zipIndex_t *index)
+{
+    const pakCacheHeader_t *header;
+    const char *path;
+    int ofs = 0;
+
+    while ((header = FS_NextPakCacheRecord(&ofs, &path, index)))
     {
-        Hunk_ClearTempMemory();
+        if (header->size != size || header->mtime != mtime || strcmp(path, zipfile))
+            continue;
+
+        for (int i = 0; i < index->numEntries; i++)
+        {
+            if (index->entries[i].name >= (uint32_t)index->namesLen)
+                return false;
+        }
+        return true;
     }
+
+    return false;
 }
 
 /*
-============
-FS_WriteFile
+=================
+FS_WritePakCacheRecord
+=================
+*/
+static void FS_WritePakCacheRecord(FILE *f, const char *path, int64_t size, int64_t mtime,
+    int numEntries, const zipEntry_t *entries, int namesLen, const char *names)
+{
+    static const byte zeros[8] = {};
+    pakCacheHeader_t header;
+
+    header.size = size;
+    header.mtime = mtime;
+    header.pathLen = strlen(path) + 1;
+    header.numEntries = numEntries;
+    header.namesLen = namesLen;
+    header.pad = 0;
+
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(path, header.pathLen, 1, f);
+    fwrite(zeros, PADLEN(header.pathLen, 8), 1, f);
+    fwrite(entries, sizeof(zipEntry_t), numEntries, f);
+    fwrite(names, namesLen, 1, f);
+    fwrite(zeros, PADLEN(namesLen, 8), 1, f);
+}
 
-Filename are relative to the quake search path
-============
+/*
+=================
+FS_WritePakCache
+
+Rewrites the cache after paks had to be parsed: every loaded pak, and
+the cached ones from other game directories that are still current
+=================
 */
-void FS_WriteFile(const char *qpath, const void *buffer, int size)
+static void FS_WritePakCache(void)
 {
-    if (!fs_searchpaths)
+    char ospath[MAX_OSPATH];
+    char tmppath[MAX_OSPATH];
+    const pakCacheHeader_t *header;
+    const char *path;
+    zipIndex_t index;
+    int64_t size, mtime;
+    int32_t ident[2] = {PAKCACHE_IDENT, PAKCACHE_VERSION};
+    FILE *f;
+    int ofs;
+
+    Com_sprintf(ospath, sizeof(ospath), "%s%c%s", fs_homepath->string, PATH_SEP, PAKCACHE_NAME);
+    Com_sprintf(tmppath, sizeof(tmppath), "%s.tmp", ospath);
+
+    f = Sys_FOpen(tmppath, "wb");
+    if (!f)
+        return;
+
+    fwrite(ident, sizeof(ident), 1, f);
+
+    for (auto search = fs_searchpaths; search; search = search->next)
     {
-        Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+        pack_t *pak = search->pack;
+        if (!pak || !pak->fileTime)
+            continue;
+
+        zipEntry_t *entries = static_cast<zipEntry_t *>(Z_Malloc(pak->numfiles * sizeof(zipEntry_t) + 1));
+        string names;
+
+        for (int i = 0; i < pak->numfiles; i++)
+        {
+            entries[i].pos = pak->buildBuffer[i].pos;
+            entries[i].len = pak->buildBuffer[i].len;
+            entries[i].crc = pak->buildBuffer[i].crc;
+            entries[i].name = names.size();
+            names.append(pak->buildBuffer[i].name, strlen(pak->buildBuffer[i].name) + 1);
+        }
+
+        FS_WritePakCacheRecord(f, pak->pakFilename, pak->fileSize, pak->fileTime,
+                pak->numfiles, entries, names.size(), names.data());
+        Z_Free(entries);
     }
 
-    if (!qpath || !buffer)
+    ofs = 0;
+    while ((header = FS_NextPakCacheRecord(&ofs, &path, &index)))
     {
-        Com_Error(ERR_FATAL, "FS_WriteFile: nullptr parameter");
+        bool loaded = false;
+        for (auto search = fs_searchpaths; search && !loaded; search = search->next)
+            loaded = search->pack && !strcmp(search->pack->pakFilename, path);
+
+        if (loaded || !Sys_FileStat(path, &size, &mtime) || size != header->size || mtime != header->mtime)
+            continue;
+
+        FS_WritePakCacheRecord(f, path, header->size, header->mtime,
+                index.numEntries, index.entries, index.namesLen, index.names);
     }
 
-    fileHandle_t f = FS_FOpenFileWrite(qpath);
-    if (!f)
+    if (fclose(f))
     {
-        Com_Printf("Failed to open %s\n", qpath);
+        FS_Remove(tmppath);
         return;
     }
 
-    FS_Write(buffer, size, f);
-    FS_FCloseFile(f);
+    FS_Remove(ospath);
+    rename(tmppath, ospath);
 }
 
 /*
-==========================================================================
+=================
+FS_FreePakCache
+=================
+*/
+static void FS_FreePakCache(void)
+{
+    if (fs_pakCacheData)
+        Z_Free(fs_pakCacheData);
 
-ZIP FILE LOADING
+    fs_pakCacheData = nullptr;
+    fs_pakCacheLen = 0;
+}
 
-==========================================================================
+/*
+=================
+Pak loading
+
+Paks are loaded in two steps so a game directory's paks can be scanned
+on the job threads: FS_ScanPak does the I/O, the directory parsing and
+the checksums without touching the zone, and FS_BuildPak turns the
+result into a pack_t on the main thread.
+=================
 */
 
+struct pakScan_t {
+    char ospath[MAX_OSPATH];
+    const char *basename;
+    const byte *mapData;
+    long mapSize;
+    int64_t fileSize;
+    int64_t fileTime;  // 0 if it isn't to be cached
+    bool cached;  // index points into the pak index cache
+    bool parsed;  // index was allocated by the scan
+    zipIndex_t index;
+    int checksum;
+    int pure_checksum;
+    int64_t usec;  // time spent scanning
+};
+
 /*
 =================
-FS_LoadZipFile
+FS_ChecksumPak
 
-Creates a new pack_t in the search chain for the contents of a zip file.
+The checksums cover the CRCs of every non-empty entry, the pure one
+prefixed with fs_checksumFeed
 =================
 */
-static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
+static void FS_ChecksumPak(pakScan_t *scan)
 {
+    const zipIndex_t *index = &scan->index;
+    int *fs_headerLongs = static_cast<int *>(malloc((index->numEntries + 1) * sizeof(int)));
     int fs_numHeaderLongs = 0;
-    unsigned long len = 0;
-    char filename[MAX_ZPATH];
 
-    auto z = unzOpen(zipfile);
+    fs_headerLongs[fs_numHeaderLongs] = LittleLong(fs_checksumFeed);
+    fs_numHeaderLongs++;
 
-    unz_global_info gi;
-    int err = unzGetGlobalInfo(z, &gi);
-    if (err) return nullptr;
+    for (int i = 0; i < index->numEntries; i++)
+    {
+        if (index->entries[i].len)
+        {
+            fs_headerLongs[fs_numHeaderLongs] = LittleLong(index->entries[i].crc);
+            fs_numHeaderLongs++;
+        }
+    }
 
-    err = unzGoToFirstFile(z);
-    if (err) return nullptr;
+    scan->checksum =
+        Com_BlockChecksum(&fs_headerLongs[1], sizeof(*fs_headerLongs) * (fs_numHeaderLongs - 1));
+    scan->pure_checksum =
+        Com_BlockChecksum(fs_headerLongs, sizeof(*fs_headerLongs) * fs_numHeaderLongs);
+    scan->checksum = LittleLong(scan->checksum);
+    scan->pure_checksum = LittleLong(scan->pure_checksum);
 
-    for (uLong i = 0; i < gi.number_entry; i++)
+    free(fs_headerLongs);
+}
+
+/*
+=================
+FS_ScanPak
+
+Safe to run on a job thread
+=================
+*/
+static void FS_ScanPak(pakScan_t *scan)
+{
+    int64_t start = Sys_Microseconds();
+
+    scan->mapData = nullptr;
+    scan->mapSize = 0;
+    scan->cached = false;
+    scan->parsed = false;
+
+    if (fs_mmap && fs_mmap->integer)
+        scan->mapData = static_cast<const byte *>(Sys_MapFile(scan->ospath, &scan->mapSize));
+
+    if (!(fs_pakCache && fs_pakCache->integer) ||
+        !Sys_FileStat(scan->ospath, &scan->fileSize, &scan->fileTime))
     {
-        unz_file_info fi;
-        err = unzGetCurrentFileInfo(
-            z, &fi, filename, sizeof(filename), nullptr, 0, nullptr, 0);
+        scan->fileSize = scan->fileTime = 0;
+    }
 
-        if (err) break;
+    if (scan->fileTime)
+        scan->cached = FS_FindPakCache(scan->ospath, scan->fileSize, scan->fileTime, &scan->index);
 
-        len += strlen(filename) + 1;
-        unzGoToNextFile(z);
+    if (!scan->cached)
+        scan->parsed = FS_ParseZipDirectory(scan->ospath, scan->mapData, scan->mapSize, &scan->index);
+
+    if (scan->cached || scan->parsed)
+        FS_ChecksumPak(scan);
+
+    scan->usec = Sys_Microseconds() - start;
+}
+
+static void FS_ScanPakJob(void *data, int index)
+{
+    FS_ScanPak(static_cast<pakScan_t *>(data) + index);
+}
+
+/*
+=================
+FS_BuildPak
+
+Creates a new pack_t in the search chain for the contents of a scanned
+zip file, or returns nullptr if it isn't one
+=================
+*/
+static pack_t *FS_BuildPak(pakScan_t *scan)
+{
+    zipIndex_t *index = &scan->index;
+
+    auto z = unzOpen(scan->ospath);
+    if (z && !scan->cached && !scan->parsed)
+    {
+        // left to minizip
+        scan->parsed = FS_WalkZipDirectory(z, index);
+        if (scan->parsed)
+            FS_ChecksumPak(scan);
     }
 
-    fileInPack_t *buildBuffer =
-        static_cast<fileInPack_t *>(Z_Malloc((gi.number_entry * sizeof(fileInPack_t)) + len));
+    if (!z || (!scan->cached && !scan->parsed))
+    {
+        if (scan->parsed)
+            free(index->entries);
+        if (scan->mapData)
+            Sys_UnmapFile(scan->mapData, scan->mapSize);
+        if (z)
+            unzClose(z);
+        return nullptr;
+    }
 
-    char *namePtr = ((char *)buildBuffer) + gi.number_entry * sizeof(fileInPack_t);
+    if (scan->cached)
+        fs_pakCacheHits++;
+    else if (scan->fileTime)
+        fs_pakCacheMisses++;
 
-    int *fs_headerLongs = static_cast<int *>(Z_Malloc((gi.number_entry + 1) * sizeof(int)));
+    fileInPack_t *buildBuffer = static_cast<fileInPack_t *>(
+        Z_Malloc((index->numEntries * sizeof(fileInPack_t)) + index->namesLen + 1));
 
-    fs_headerLongs[fs_numHeaderLongs] = LittleLong(fs_checksumFeed);
-    fs_numHeaderLongs++;
+    char *namePtr = ((char *)buildBuffer) + index->numEntries * sizeof(fileInPack_t);
+    memcpy(namePtr, index->names, index->namesLen);
 
     // get the hash table size from the number of files in the zip
     // because lots of custom pk3 files have less than 32 or 64 files
-    uLong hashsiz;
+    int hashsiz;
     for (hashsiz = 1; hashsiz <= MAX_FILEHASH_SIZE; hashsiz <<= 1)
     {
-        if (hashsiz > gi.number_entry) break;
+        if (hashsiz > index->numEntries) break;
     }
 
     pack_t *pack = static_cast<pack_t *>(Z_Malloc(sizeof(pack_t) + hashsiz * sizeof(fileInPack_t *)));
@@ -1977,8 +3378,8 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
         pack->hashTable[i] = nullptr;
     }
 
-    Q_strncpyz(pack->pakFilename, zipfile, sizeof(pack->pakFilename));
-    Q_strncpyz(pack->pakBasename, basename, sizeof(pack->pakBasename));
+    Q_strncpyz(pack->pakFilename, scan->ospath, sizeof(pack->pakFilename));
+    Q_strncpyz(pack->pakBasename, scan->basename, sizeof(pack->pakBasename));
 
     // strip .pk3 if needed
     if ( strlen(pack->pakBasename) > 4 &&
@@ -1988,51 +3389,55 @@ static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
     }
 
     pack->handle = z;
-    pack->numfiles = gi.number_entry;
-    unzGoToFirstFile(z);
-    for (uLong i = 0; i < gi.number_entry; i++)
-    {
-        unz_file_info fi;
-        err = unzGetCurrentFileInfo(
-            z, &fi, filename, sizeof(filename), nullptr, 0, nullptr, 0);
+    pack->numfiles = index->numEntries;
+    pack->mapData = scan->mapData;
+    pack->mapSize = scan->mapSize;
+    pack->fileSize = scan->fileSize;
+    pack->fileTime = scan->fileTime;
+    pack->checksum = scan->checksum;
+    pack->pure_checksum = scan->pure_checksum;
 
-        if (err) break;
-
-        if (fi.uncompressed_size)
-        {
-            fs_headerLongs[fs_numHeaderLongs] = LittleLong(fi.crc);
-            fs_numHeaderLongs++;
-        }
-
-        Q_strlwr(filename);
-        long hash = FS_HashFileName(filename, pack->hashSize);
+    for (int i = 0; i < index->numEntries; i++)
+    {
+        const zipEntry_t *e = &index->entries[i];
 
-        buildBuffer[i].name = namePtr;
-        strcpy(buildBuffer[i].name, filename);
-        namePtr += strlen(filename) + 1;
+        buildBuffer[i].name = namePtr + e->name;
+        long hash = FS_HashFileName(buildBuffer[i].name, pack->hashSize);
 
         // store the file position in the zip
-        buildBuffer[i].pos = unzGetOffset(z);
-        buildBuffer[i].len = fi.uncompressed_size;
+        buildBuffer[i].pos = e->pos;
+        buildBuffer[i].len = e->len;
+        buildBuffer[i].crc = e->crc;
         buildBuffer[i].next = pack->hashTable[hash];
 
         pack->hashTable[hash] = &buildBuffer[i];
-        unzGoToNextFile(z);
     }
 
-    pack->checksum =
-        Com_BlockChecksum(&fs_headerLongs[1], sizeof(*fs_headerLongs) * (fs_numHeaderLongs - 1));
-    pack->pure_checksum =
-        Com_BlockChecksum(fs_headerLongs, sizeof(*fs_headerLongs) * fs_numHeaderLongs);
-    pack->checksum = LittleLong(pack->checksum);
-    pack->pure_checksum = LittleLong(pack->pure_checksum);
-
-    Z_Free(fs_headerLongs);
+    if (scan->parsed)
+        free(index->entries);
 
     pack->buildBuffer = buildBuffer;
     return pack;
 }
 
+/*
+=================
+FS_LoadZipFile
+
+Creates a new pack_t in the search chain for the contents of a zip file.
+=================
+*/
+static pack_t *FS_LoadZipFile(const char *zipfile, const char *basename)
+{
+    pakScan_t scan;
+
+    Q_strncpyz(scan.ospath, zipfile, sizeof(scan.ospath));
+    scan.basename = basename;
+
+    FS_ScanPak(&scan);
+    return FS_BuildPak(&scan);
+}
+
 /*
 =================
 FS_FreePak
@@ -2043,6 +3448,8 @@ Frees a pak structure and releases all associated resources
 
 static void FS_FreePak(pack_t *thepak)
 {
+    if (thepak->mapData)
+        Sys_UnmapFile(thepak->mapData, thepak->mapSize);
     unzClose(thepak->handle);
     Z_Free(thepak->buildBuffer);
     Z_Free(thepak);
@@ -2080,8 +3487,6 @@ DIRECTORY SCANNING FUNCTIONS
 =================================================================================
 */
 
-#define MAX_FOUND_FILES 0x1000
-
 static int FS_ReturnPath(const char *zname, char *zpath, int *depth)
 {
     int newdep = 0;
@@ -2749,6 +4154,13 @@ void FS_Path_f(void)
         }
     }
 
+    Com_Printf("\n");
+    Com_Printf("file index: %i names, %i unindexed dirs, %i builds\n",
+            fs_indexNames, fs_numIndexUnscanned, fs_indexBuilds);
+    Com_Printf("%i lookups, %i misses, %i search paths probed, %i directories rescanned\n",
+            fs_indexLookups, fs_indexMisses, fs_indexProbes, fs_indexRescans);
+    Com_Printf("pak index cache: %i hits, %i misses\n", fs_pakCacheHits, fs_pakCacheMisses);
+
     Com_Printf("\n");
     for (int i = 1; i < MAX_FILE_HANDLES; i++)
     {
@@ -2878,6 +4290,8 @@ void FS_AddGameDirectory(const char *path, const char *dir)
     Q_strncpyz(curpath, FS_BuildOSPath(path, dir, ""), sizeof(curpath));
     curpath[strlen(curpath) - 1] = '\0';  // strip the trailing slash
 
+    int64_t start = Sys_Microseconds();
+
     // Get .pk3 files
     pakfiles = Sys_ListFiles(curpath, ".pk3", nullptr, &numfiles, false);
 
@@ -2896,6 +4310,30 @@ void FS_AddGameDirectory(const char *path, const char *dir)
         qsort(pakdirs, numdirs, sizeof(char *), paksort);
     }
 
+    // scan the paks on the job threads, they are spliced in below in
+    // paksort order just as if they had been loaded one by one
+    pakScan_t *scans = nullptr;
+    if (numfiles)
+    {
+        scans = static_cast<pakScan_t *>(Z_Malloc(numfiles * sizeof(*scans)));
+        for (int i = 0; i < numfiles; i++)
+        {
+            Q_strncpyz(scans[i].ospath, FS_BuildOSPath(path, dir, pakfiles[i]), sizeof(scans[i].ospath));
+            scans[i].basename = pakfiles[i];
+        }
+    }
+
+    int64_t scanStart = Sys_Microseconds();
+    fs_startupTimes.list += scanStart - start;
+
+    Com_ParallelFor(numfiles, FS_ScanPakJob, scans);
+
+    int64_t buildStart = Sys_Microseconds();
+    fs_startupTimes.scan += buildStart - scanStart;
+    for (int i = 0; i < numfiles; i++)
+        fs_startupTimes.scanWork += scans[i].usec;
+    fs_startupTimes.paks += numfiles;
+
     char prefixBuf[MAX_STRING_CHARS];
     Q_strncpyz(prefixBuf, Cvar_VariableString("fs_pk3PrefixPairs"), sizeof(prefixBuf));
     int numPairs = 0;
@@ -2975,8 +4413,7 @@ void FS_AddGameDirectory(const char *path, const char *dir)
         if (pakwhich)
         {
             // The next .pk3 file is before the next .pk3dir
-            char *pakfile = FS_BuildOSPath(path, dir, pakfiles[pakfilesi]);
-            if ((pak = FS_LoadZipFile(pakfile, pakfiles[pakfilesi])) == 0)
+            if ((pak = FS_BuildPak(&scans[pakfilesi])) == 0)
             {
                 // This isn't a .pk3! Next!
                 pakfilesi++;
@@ -3047,6 +4484,8 @@ void FS_AddGameDirectory(const char *path, const char *dir)
     }
 
     // done
+    if (scans)
+        Z_Free(scans);
     Sys_FreeFileList(pakfiles);
     Sys_FreeFileList(pakdirs);
 
@@ -3097,6 +4536,8 @@ void FS_AddGameDirectory(const char *path, const char *dir)
 
     search->next = fs_searchpaths;
     fs_searchpaths = search;
+
+    fs_startupTimes.build += Sys_Microseconds() - buildStart;
 }
 
 /*
@@ -3259,10 +4700,13 @@ void FS_Shutdown(bool closemfp)
     {
         next = p->next;
         if (p->pack) FS_FreePak(p->pack);
-        if (p->dir) Z_Free(p->dir);
+        if (p->dir) FS_FreeDirectory(p->dir);
         Z_Free(p);
     }
 
+    FS_FreeFileIndex();
+    fs_indexDirty = false;
+
     // Any FS_ calls will now be an error until reinitialized
     fs_searchpaths = nullptr;
 
@@ -3323,6 +4767,9 @@ static void FS_ReorderPurePaks(void)
             p_previous = &s->next;
         }
     }
+
+    if (fs_reordered)
+        fs_indexDirty = true;
 }
 
 /*
@@ -3335,7 +4782,14 @@ static void FS_Startup(const char *gameName)
     Com_Printf("----- FS_Startup -----\n");
     fs_packFiles = 0;
 
+    int64_t start = Sys_Microseconds();
+    Com_Memset(&fs_startupTimes, 0, sizeof(fs_startupTimes));
+
     fs_debug = Cvar_Get("fs_debug", "0", 0);
+    fs_index = Cvar_Get("fs_index", "1", 0);
+    // address space is too tight to map every pak on 32 bit
+    fs_mmap = Cvar_Get("fs_mmap", sizeof(void *) >= 8 ? "1" : "0", CVAR_LATCH);
+    fs_pakCache = Cvar_Get("fs_pakCache", "1", 0);
     fs_basepath = Cvar_Get("fs_basepath", Sys_DefaultInstallPath(), CVAR_INIT | CVAR_PROTECTED);
     fs_basegame = Cvar_Get("fs_basegame", BASEGAME, CVAR_INIT);
 
@@ -3348,6 +4802,8 @@ static void FS_Startup(const char *gameName)
     fs_homepath = Cvar_Get("fs_homepath", homePath, CVAR_INIT | CVAR_PROTECTED);
     fs_gamedirvar = Cvar_Get("fs_game", BASEGAME, CVAR_INIT | CVAR_SYSTEMINFO);
 
+    FS_LoadPakCache();
+
 #ifdef DEDICATED
     // add search path elements in reverse priority order
     if (fs_basepath->string[0])
@@ -3443,6 +4899,10 @@ static void FS_Startup(const char *gameName)
 #endif
 #endif
 
+    if (fs_pakCacheMisses && fs_homepath->string[0])
+        FS_WritePakCache();
+    FS_FreePakCache();
+
     // add our commands
     Cmd_AddCommand("path", FS_Path_f);
     Cmd_AddCommand("dir", FS_Dir_f);
@@ -3453,6 +4913,18 @@ static void FS_Startup(const char *gameName)
     // reorder the pure pk3 files according to server order
     FS_ReorderPurePaks();
 
+    int64_t indexStart = Sys_Microseconds();
+    if (fs_index->integer)
+    {
+        for (auto s = fs_searchpaths; s; s = s->next)
+        {
+            if (s->dir)
+                FS_ScanDirectory(s->dir);
+        }
+    }
+    FS_BuildFileIndex();
+    fs_startupTimes.index = Sys_Microseconds() - indexStart;
+
     // print the current search paths
     FS_Path_f();
 
@@ -3469,6 +4941,11 @@ static void FS_Startup(const char *gameName)
 #endif
 
     Com_Printf("%d files in pk3 files\n", fs_packFiles);
+    Com_Printf("filesystem startup: %.1f msec\n"
+               "  listing %.1f, %i paks %.1f (%.1f of work on %i threads), building %.1f, file index %.1f\n",
+            (Sys_Microseconds() - start) / 1000.0, fs_startupTimes.list / 1000.0, fs_startupTimes.paks,
+            fs_startupTimes.scan / 1000.0, fs_startupTimes.scanWork / 1000.0, Com_JobThreads(),
+            fs_startupTimes.build / 1000.0, fs_startupTimes.index / 1000.0);
 }
 
 /*
@@ -3672,6 +5149,30 @@ const char *FS_ReferencedPakNames(bool alternate)
     return info;
 }
 
+/*
+=====================
+FS_PakOSPath
+
+Returns the full path of the loaded pak "gamename/basename", as listed
+by FS_ReferencedPakNames, or NULL if no such pak is on the search path
+=====================
+*/
+const char *FS_PakOSPath(const char *name)
+{
+    char pakName[MAX_OSPATH];
+
+    for (auto search = fs_searchpaths; search; search = search->next)
+    {
+        if (!search->pack) continue;
+
+        Com_sprintf(pakName, sizeof(pakName), "%s/%s",
+            search->pack->pakGamename, search->pack->pakBasename);
+        if (!FS_FilenameCompare(pakName, name)) return search->pack->pakFilename;
+    }
+
+    return NULL;
+}
+
 /*
 =====================
 FS_ClearPakReferences
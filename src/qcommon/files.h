@@ -204,6 +204,7 @@ void         FS_Restart (int checksumFeed);
 void         FS_PureServerSetLoadedPaks (const char* pakSums, const char* pakNames);
 void         FS_ClearPakReferences (int flags);
 const char*  FS_ReferencedPakNames (bool alternate);
+const char*  FS_PakOSPath (const char* name);
 const char*  FS_ReferencedPakPureChecksums (void);
 const char*  FS_ReferencedPakChecksums (bool alternate);
 const char*  FS_LoadedPakPureChecksums (bool alternate);
@@ -227,6 +228,8 @@ bool     FS_CompareZipChecksum (const char* zipfile);
 void         FS_WriteFile (const char* qpath, const void* buffer, int size);
 void         FS_FreeFile (void* buffer);
 long         FS_ReadFile (const char* qpath, void** buffer);
+long         FS_MapFile (const char* qpath, const void** buffer);
+void         FS_UnmapFile (const void* buffer);
 void         FS_Flush (fileHandle_t f);
 long         FS_ReadFileDir (const char* qpath, void* searchPath, bool unpure, void** buffer);
 int          FS_FileIsInPAK_A(bool alternate, const char *filename, int *pChecksum);
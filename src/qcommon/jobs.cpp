@@ -0,0 +1,209 @@
+/*
+ * This file is part of Tremulous.
+ * Copyright (C) 2015-2019 GrangerHub
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License,  or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not,  see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jobs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "cvar.h"
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define MAX_JOB_THREADS 16
+
+/*
+The pool is started on first use and never torn down: the workers are
+detached and the pool is leaked, so nothing is destroyed under a worker
+that is still waiting when the process exits.
+*/
+struct jobPool_t {
+    std::mutex lock;  // serializes Com_ParallelFor callers
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    unsigned generation;  // bumped for every batch, under wakeLock
+    jobFunc_t func;
+    void *data;
+    int count;
+    std::atomic<int> next;  // next index to claim
+    std::atomic<int> finished;  // indexes run
+    int busy;  // workers inside the batch, under wakeLock
+
+    int numWorkers;
+};
+
+static cvar_t *com_jobThreads;
+static jobPool_t *jobPool;
+static thread_local bool inJob;
+
+/*
+=================
+Com_RunJobs
+
+Claims and runs indexes until the batch is exhausted
+=================
+*/
+static void Com_RunJobs(jobPool_t *pool)
+{
+    int i;
+
+    inJob = true;
+    while ((i = pool->next.fetch_add(1)) < pool->count)
+    {
+        pool->func(pool->data, i);
+        pool->finished.fetch_add(1);
+    }
+    inJob = false;
+}
+
+/*
+=================
+Com_JobWorker
+=================
+*/
+static void Com_JobWorker(jobPool_t *pool)
+{
+    unsigned seen = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lk(pool->wakeLock);
+            pool->wake.wait(lk, [&] { return pool->generation != seen; });
+            seen = pool->generation;
+            pool->busy++;
+        }
+
+        Com_RunJobs(pool);
+
+        {
+            std::lock_guard<std::mutex> lk(pool->wakeLock);
+            pool->busy--;
+        }
+        pool->done.notify_one();
+    }
+}
+
+/*
+=================
+Com_StartJobPool
+
+The pool is first needed while the filesystem starts, before any config
+is executed, and it is never rebuilt; com_jobThreads can only be set on
+the command line
+=================
+*/
+static void Com_StartJobPool(void)
+{
+    int threads;
+
+    com_jobThreads = Cvar_Get("com_jobThreads", "-1", CVAR_INIT);
+
+    // -1 is one thread per core
+    threads = com_jobThreads->integer;
+    if (threads < 0)
+        threads = std::thread::hardware_concurrency();
+    threads = MIN(MAX(threads, 1), MAX_JOB_THREADS);
+
+    jobPool = new jobPool_t;
+    jobPool->generation = 0;
+    jobPool->func = nullptr;
+    jobPool->data = nullptr;
+    jobPool->count = 0;
+    jobPool->next = 0;
+    jobPool->finished = 0;
+    jobPool->busy = 0;
+    jobPool->numWorkers = 0;
+
+    for (int i = 1; i < threads; i++)
+    {
+        try
+        {
+            std::thread(Com_JobWorker, jobPool).detach();
+        }
+        catch (const std::system_error &)
+        {
+            break;
+        }
+        jobPool->numWorkers++;
+    }
+
+    Com_DPrintf("job pool: %i worker threads\n", jobPool->numWorkers);
+}
+
+/*
+=================
+Com_JobThreads
+=================
+*/
+int Com_JobThreads(void)
+{
+    if (!jobPool)
+        Com_StartJobPool();
+
+    return jobPool->numWorkers + 1;
+}
+
+/*
+=================
+Com_ParallelFor
+=================
+*/
+void Com_ParallelFor(int count, jobFunc_t func, void *data)
+{
+    if (count <= 0)
+        return;
+
+    if (!jobPool)
+        Com_StartJobPool();
+
+    if (count == 1 || inJob || !jobPool->numWorkers)
+    {
+        for (int i = 0; i < count; i++)
+            func(data, i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> batch(jobPool->lock);
+
+    {
+        // a worker that woke too late for the last batch may still be
+        // looking at it
+        std::unique_lock<std::mutex> lk(jobPool->wakeLock);
+        jobPool->done.wait(lk, [] { return !jobPool->busy; });
+
+        jobPool->func = func;
+        jobPool->data = data;
+        jobPool->count = count;
+        jobPool->next = 0;
+        jobPool->finished = 0;
+        jobPool->generation++;
+    }
+    jobPool->wake.notify_all();
+
+    Com_RunJobs(jobPool);
+
+    // every index has been claimed; wait for the ones still running and
+    // for late workers to leave before the batch can be reused
+    std::unique_lock<std::mutex> lk(jobPool->wakeLock);
+    jobPool->done.wait(lk, [&] { return jobPool->finished == count && !jobPool->busy; });
+}
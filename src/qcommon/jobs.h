@@ -0,0 +1,45 @@
+/*
+ * This file is part of Tremulous.
+ * Copyright (C) 2015-2019 GrangerHub
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License,  or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not,  see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QCOMMON_JOBS_H
+#define QCOMMON_JOBS_H
+
+/*
+==============================================================
+
+JOBS
+
+A small pool of worker threads for loops whose iterations don't
+depend on each other.  Jobs must not touch the zone, the hunk,
+cvars or print; collect results and finish on the calling thread.
+
+==============================================================
+*/
+
+typedef void (*jobFunc_t)(void *data, int index);
+
+// runs func(data, 0) .. func(data, count - 1) spread over the workers and
+// the caller, returning when all are done.  Runs serially if the pool is
+// disabled (+set com_jobThreads 0 on the command line) or when called from
+// inside a job.
+void Com_ParallelFor(int count, jobFunc_t func, void *data);
+
+// number of threads Com_ParallelFor spreads work over, caller included
+int Com_JobThreads(void);
+
+#endif
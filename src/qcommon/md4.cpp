@@ -38,7 +38,8 @@ struct mdfour {
    It assumes that an int is at least 32 bits long
    */
 
-static struct mdfour *m;
+/* per thread, paks are checksummed on the job threads */
+static thread_local struct mdfour *m;
 
 #define F(X,Y,Z) (((X)&(Y)) | ((~(X))&(Z)))
 #define G(X,Y,Z) (((X)&(Y)) | ((X)&(Z)) | ((Y)&(Z)))
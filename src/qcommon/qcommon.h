@@ -161,13 +161,13 @@ typedef struct {
 	sysEventType_t	evType;
 	int				evValue, evValue2;
 	int				evPtrLength;	// bytes of data pointed to by evPtr, for journaling
-	void			*evPtr;			// this must be manually freed if not NULL
+	void			*evPtr;			// malloc'd or a static buffer, see Com_FreeEventData
 } sysEvent_t;
 
 void  Com_rgb_to_hsl(vec4_t rgb, vec4_t hsl);
 void  Com_hsl_to_rgb(vec4_t hsl, vec4_t rgb);
 
-void		Com_QueueEvent( int time, sysEventType_t type, int value, int value2, int ptrLength, void *ptr );
+void		Com_QueueEvent( int time, sysEventType_t type, int value, int value2, int dataLength, const void *data );
 int			Com_EventLoop( void );
 sysEvent_t	Com_GetSystemEvent( void );
 
@@ -48,6 +48,8 @@ vm_t	*currentVM = NULL;
 vm_t	*lastVM    = NULL;
 int		vm_debugLevel;
 
+cvar_t	*vm_profileSyscalls;
+
 // used by Com_Error to get rid of running vm's before longjmp
 static int forced_unload;
 
@@ -81,9 +83,11 @@ void VM_Init( void ) {
 	Cvar_Get( "vm_cgame", "2", CVAR_ARCHIVE );	// !@# SHIP WITH SET TO 2
 	Cvar_Get( "vm_game", "2", CVAR_ARCHIVE );	// !@# SHIP WITH SET TO 2
 	Cvar_Get( "vm_ui", "2", CVAR_ARCHIVE );		// !@# SHIP WITH SET TO 2
+	vm_profileSyscalls = Cvar_Get( "vm_profileSyscalls", "0", 0 );
 
 	Cmd_AddCommand ("vmprofile", VM_VmProfile_f );
 	Cmd_AddCommand ("vminfo", VM_VmInfo_f );
+	Cmd_AddCommand ("vmsample", VM_VmSample_f );
 
 	::memset( vmTable, 0, sizeof( vmTable ) );
 }
@@ -365,6 +369,72 @@ intptr_t QDECL VM_DllSyscall( intptr_t arg, ... ) {
 }
 
 
+/*
+=================
+VM_SetSyscallTable
+
+Registers the fast path handlers of a module; system calls without
+a handler keep going through vm->systemCall
+=================
+*/
+void VM_SetSyscallTable( vm_t *vm, const vmSyscall_t *table, int count ) {
+	int		i;
+
+	::memset( vm->syscallTable, 0, sizeof( vm->syscallTable ) );
+	::memset( vm->syscallNames, 0, sizeof( vm->syscallNames ) );
+
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( table[i].num < 0 || table[i].num >= MAX_VM_SYSCALLS ) {
+			Com_Error( ERR_FATAL, "VM_SetSyscallTable: bad syscall number %i", table[i].num );
+		}
+		vm->syscallTable[table[i].num] = table[i].func;
+		vm->syscallNames[table[i].num] = table[i].name;
+	}
+}
+
+/*
+=================
+VM_SystemCall
+
+Dispatches a system call made by an interpreted or compiled module.
+args points at the argument words on the program stack, args[0] holding
+the syscall number.
+=================
+*/
+intptr_t VM_SystemCall( vm_t *vm, int *args ) {
+	int			num = args[0];
+	int64_t		start = 0;
+	intptr_t	r;
+	bool		profile = vm_profileSyscalls->integer != 0;
+
+	if ( profile ) {
+		start = Sys_Microseconds( );
+	}
+
+	if ( (unsigned)num < MAX_VM_SYSCALLS && vm->syscallTable[num] ) {
+		r = vm->syscallTable[num]( vm->dataBase, vm->dataMask, args );
+	} else if ( sizeof( intptr_t ) != sizeof( int ) ) {
+		// the vm has ints on the stack, we expect
+		// pointers so we might have to convert it
+		intptr_t	argarr[MAX_VMSYSCALL_ARGS];
+		int			i;
+
+		for ( i = 0 ; i < ARRAY_LEN( argarr ) ; i++ ) {
+			argarr[i] = args[i];
+		}
+		r = vm->systemCall( argarr );
+	} else {
+		r = vm->systemCall( (intptr_t *)args );
+	}
+
+	if ( profile && (unsigned)num < MAX_VM_SYSCALLS ) {
+		vm->syscallCount[num]++;
+		vm->syscallUsec[num] += Sys_Microseconds( ) - start;
+	}
+
+	return r;
+}
+
 /*
 =================
 VM_LoadQVM
@@ -572,6 +642,22 @@ vm_t *VM_Restart(vm_t *vm, bool unpure)
 	return vm;
 }
 
+/*
+================
+VM_Find
+================
+*/
+vm_t *VM_Find( const char *module ) {
+	int		i;
+
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		if ( vmTable[i].name[0] && !Q_stricmp( vmTable[i].name, module ) ) {
+			return &vmTable[i];
+		}
+	}
+	return NULL;
+}
+
 /*
 ================
 VM_Create
@@ -713,6 +799,8 @@ void VM_Free( vm_t *vm ) {
 		}
 	}
 
+	VM_SampleForget(vm);
+
 	if(vm->destroy)
 		vm->destroy(vm);
 
@@ -790,6 +878,25 @@ void *VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue ) {
 	}
 }
 
+/*
+=================
+VM_CheckBlock
+
+Drops if the n bytes at intValue, a syscall argument of currentVM, are
+not all inside its data segment.  Native modules can't be checked.
+=================
+*/
+void VM_CheckBlock( intptr_t intValue, intptr_t n, const char *name ) {
+	if ( !currentVM || currentVM->entryPoint || n == 0 ) {
+		return;
+	}
+
+	if ( !intValue || n < 0 || ( intValue & currentVM->dataMask ) != intValue
+		|| n > (intptr_t)currentVM->dataMask + 1 - intValue ) {
+		Com_Error( ERR_DROP, "%s: block of %ld bytes at 0x%lx is out of range", name, (long)n, (long)intValue );
+	}
+}
+
 
 /*
 ==============
@@ -899,6 +1006,68 @@ static int QDECL VM_ProfileSort( const void *a, const void *b ) {
 	return 0;
 }
 
+static int QDECL VM_SyscallProfileSort( const void *a, const void *b ) {
+	const vm_t	*vm = lastVM;
+	int			na = *(const int *)a, nb = *(const int *)b;
+
+	if ( vm->syscallUsec[na] < vm->syscallUsec[nb] ) {
+		return -1;
+	}
+	if ( vm->syscallUsec[na] > vm->syscallUsec[nb] ) {
+		return 1;
+	}
+	return vm->syscallCount[na] - vm->syscallCount[nb];
+}
+
+/*
+==============
+VM_SyscallProfile
+
+Prints and resets the system call counters gathered with vm_profileSyscalls
+==============
+*/
+static void VM_SyscallProfile( vm_t *vm ) {
+	int		sorted[MAX_VM_SYSCALLS];
+	int		i, num, count;
+	int64_t	total;
+
+	count = 0;
+	total = 0;
+	for ( i = 0 ; i < MAX_VM_SYSCALLS ; i++ ) {
+		if ( vm->syscallCount[i] ) {
+			sorted[count++] = i;
+			total += vm->syscallUsec[i];
+		}
+	}
+
+	if ( !count ) {
+		if ( !vm_profileSyscalls->integer ) {
+			Com_Printf( "Set vm_profileSyscalls 1 to profile %s system calls\n", vm->name );
+		}
+		return;
+	}
+
+	qsort( sorted, count, sizeof( *sorted ), VM_SyscallProfileSort );
+
+	Com_Printf( "%s system calls:\n", vm->name );
+	Com_Printf( "  %%    calls     usec  usec/call syscall\n" );
+	for ( i = 0 ; i < count ; i++ ) {
+		num = sorted[i];
+
+		Com_Printf( "%3i%% %8i %8lld %10.2f %3i %s%s\n",
+			total ? (int)( 100 * vm->syscallUsec[num] / total ) : 0,
+			vm->syscallCount[num], (long long)vm->syscallUsec[num],
+			(float)vm->syscallUsec[num] / vm->syscallCount[num],
+			num, vm->syscallNames[num] ? vm->syscallNames[num] : "",
+			vm->syscallTable[num] ? " (fast)" : "" );
+
+		vm->syscallCount[num] = 0;
+		vm->syscallUsec[num] = 0;
+	}
+
+	Com_Printf( "     %8lld usec total\n", (long long)total );
+}
+
 /*
 ==============
 VM_VmProfile_f
@@ -917,6 +1086,8 @@ void VM_VmProfile_f( void ) {
 
 	vm = lastVM;
 
+	VM_SyscallProfile( vm );
+
 	if ( !vm->numSymbols ) {
 		return;
 	}
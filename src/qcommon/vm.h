@@ -54,6 +54,7 @@ void	VM_Debug( int level );
 
 void	*VM_ArgPtr( intptr_t intValue );
 void	*VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue );
+void	VM_CheckBlock( intptr_t intValue, intptr_t n, const char *name );
 
 #define	VMA(x) VM_ArgPtr(args[x])
 static ID_INLINE float _vmf(intptr_t x)
@@ -64,4 +65,26 @@ static ID_INLINE float _vmf(intptr_t x)
 }
 #define	VMF(x)	_vmf(args[x])
 
+/*
+Fast path system calls
+
+A module's hottest system calls can be registered as specialized handlers
+which get the raw argument words straight off the QVM program stack and the
+data segment to translate pointers against, bypassing the generic
+systemCall switch and the widening of every argument to intptr_t.
+*/
+typedef intptr_t (*vmSyscallFunc_t)( byte *dataBase, int dataMask, const int *args );
+
+typedef struct {
+	int				num;
+	const char		*name;
+	vmSyscallFunc_t	func;
+} vmSyscall_t;
+
+#define	MAX_VM_SYSCALLS	256
+
+void	VM_SetSyscallTable( vm_t *vm, const vmSyscall_t *table, int count );
+
+#define	VMFA(x) ( args[x] ? (void *)( dataBase + ( args[x] & dataMask ) ) : NULL )
+
 #endif
@@ -184,6 +184,17 @@ struct vm_s {
 
 	byte		*jumpTableTargets;
 	int			numJumpTableTargets;
+
+	// fast path handlers, indexed by system call number
+	vmSyscallFunc_t	syscallTable[MAX_VM_SYSCALLS];
+	const char	*syscallNames[MAX_VM_SYSCALLS];
+
+	// per system call profiling, gathered while vm_profileSyscalls is set
+	int			syscallCount[MAX_VM_SYSCALLS];
+	int64_t		syscallUsec[MAX_VM_SYSCALLS];
+
+	// host stack frame of the outermost VM_CallCompiled, for vmsample
+	void		*hostStackTop;
 };
 
 
@@ -200,5 +211,10 @@ vmSymbol_t *VM_ValueToFunctionSymbol( vm_t *vm, int value );
 int VM_SymbolToValue( vm_t *vm, const char *symbol );
 const char *VM_ValueToSymbol( vm_t *vm, int value );
 void VM_LogSyscalls( int *args );
+intptr_t VM_SystemCall( vm_t *vm, int *args );
+vm_t *VM_Find( const char *module );
+
+void VM_VmSample_f( void );
+void VM_SampleForget( vm_t *vm );
 
 void VM_BlockCopy(unsigned int dest, unsigned int src, size_t n);
@@ -0,0 +1,624 @@
+/*
+===========================================================================
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+// vm_sample.c -- sampling profiler for compiled virtual machines
+
+/*
+
+A SIGPROF interval timer interrupts the process; the handler maps the
+host program counter back through vm->instructionPointers to a QVM
+instruction number.  Compiled code keeps its call frames as bare return
+addresses on the host stack, so the caller chain is recovered by
+scanning the stack between the interrupted stack pointer and the frame
+of VM_CallCompiled for words that point into the generated code.
+
+Samples are aggregated by call stack in the handler itself, into a
+table allocated when sampling starts.  Symbols are resolved from
+vm/<module>.map only when a report is produced.
+
+*/
+
+#include "vm.h"
+#include "vm_local.h"
+
+#include "cmd.h"
+#include "files.h"
+
+#if defined(__linux__) && ( idx64 || id386 ) && !defined(NO_VM_COMPILED)
+#define VM_SAMPLING 1
+#endif
+
+#ifdef VM_SAMPLING
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+#define	MAX_SAMPLE_DEPTH	32
+#define	MAX_SAMPLE_STACKS	8192	// must be a power of two
+
+// pseudo instruction for samples taken outside of generated code,
+// i.e. in system calls made by the module
+#define	SAMPLE_ENGINE		-1
+
+typedef struct {
+	vm_t	*vm;
+	int		count;
+	int		depth;
+	int		frames[MAX_SAMPLE_DEPTH];	// innermost first
+} vmSampleStack_t;
+
+static vmSampleStack_t	*sampleStacks;
+static volatile int		sampleTotal;
+static volatile int		sampleDropped;
+static volatile bool	sampling;
+
+#ifdef VM_SAMPLING
+
+static struct sigaction	oldProfAction;
+
+/*
+=================
+VM_SampleInstruction
+
+Maps a host address inside the generated code to a QVM instruction number
+=================
+*/
+static int VM_SampleInstruction( const vm_t *vm, intptr_t pc ) {
+	int		lo, hi, mid;
+
+	lo = 0;
+	hi = vm->instructionCount - 1;
+	if ( hi < 0 || pc < vm->instructionPointers[0] ) {
+		return -1;
+	}
+
+	while ( lo < hi ) {
+		mid = ( lo + hi + 1 ) >> 1;
+		if ( vm->instructionPointers[mid] <= pc ) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return lo;
+}
+
+/*
+=================
+VM_SampleRecord
+
+Runs in signal context
+=================
+*/
+static void VM_SampleRecord( vm_t *vm, const int *frames, int depth ) {
+	unsigned	hash;
+	int			i, probe;
+	vmSampleStack_t	*s;
+
+	hash = (unsigned)( (intptr_t)vm >> 4 );
+	for ( i = 0 ; i < depth ; i++ ) {
+		hash = hash * 31 + frames[i];
+	}
+
+	for ( probe = 0 ; probe < MAX_SAMPLE_STACKS ; probe++ ) {
+		s = &sampleStacks[( hash + probe ) & ( MAX_SAMPLE_STACKS - 1 )];
+
+		if ( !s->count ) {
+			s->vm = vm;
+			s->depth = depth;
+			::memcpy( s->frames, frames, depth * sizeof( *frames ) );
+			s->count = 1;
+			sampleTotal++;
+			return;
+		}
+
+		if ( s->vm == vm && s->depth == depth &&
+			!::memcmp( s->frames, frames, depth * sizeof( *frames ) ) ) {
+			s->count++;
+			sampleTotal++;
+			return;
+		}
+	}
+
+	sampleDropped++;
+}
+
+/*
+=================
+VM_SampleSignal
+=================
+*/
+static void VM_SampleSignal( int sig, siginfo_t *info, void *context ) {
+	ucontext_t	*uc = (ucontext_t *)context;
+	vm_t		*vm = currentVM;
+	intptr_t	pc, sp, top, code, codeEnd, word;
+	int			frames[MAX_SAMPLE_DEPTH];
+	int			depth, instruction;
+
+	if ( !sampling || !vm || !vm->compiled || !vm->callLevel || !vm->hostStackTop ) {
+		return;
+	}
+
+#if idx64
+	pc = uc->uc_mcontext.gregs[REG_RIP];
+	sp = uc->uc_mcontext.gregs[REG_RSP];
+#else
+	pc = uc->uc_mcontext.gregs[REG_EIP];
+	sp = uc->uc_mcontext.gregs[REG_ESP];
+#endif
+
+	top = (intptr_t)vm->hostStackTop;
+	// another thread, or a stack we don't know the extent of
+	if ( sp > top || top - sp > 0x100000 ) {
+		return;
+	}
+
+	code = (intptr_t)vm->codeBase + vm->entryOfs;
+	codeEnd = (intptr_t)vm->codeBase + vm->codeLength;
+
+	depth = 0;
+	if ( pc >= code && pc < codeEnd ) {
+		frames[depth++] = VM_SampleInstruction( vm, pc );
+	} else {
+		frames[depth++] = SAMPLE_ENGINE;
+	}
+
+	for ( ; sp < top && depth < MAX_SAMPLE_DEPTH ; sp += sizeof( intptr_t ) ) {
+		word = *(intptr_t *)sp;
+		if ( word <= code || word > codeEnd ) {
+			continue;
+		}
+
+		// return addresses point past the call instruction
+		instruction = VM_SampleInstruction( vm, word - 1 );
+		if ( instruction >= 0 ) {
+			frames[depth++] = instruction;
+		}
+	}
+
+	VM_SampleRecord( vm, frames, depth );
+}
+
+/*
+=================
+VM_SampleSetTimer
+=================
+*/
+static bool VM_SampleSetTimer( int hz ) {
+	struct sigaction	action;
+	struct itimerval	timer;
+
+	if ( hz ) {
+		::memset( &action, 0, sizeof( action ) );
+		action.sa_sigaction = VM_SampleSignal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset( &action.sa_mask );
+
+		if ( sigaction( SIGPROF, &action, &oldProfAction ) ) {
+			return false;
+		}
+	}
+
+	::memset( &timer, 0, sizeof( timer ) );
+	if ( hz ) {
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_usec = 1000000 / hz;
+		timer.it_value = timer.it_interval;
+	}
+
+	if ( setitimer( ITIMER_PROF, &timer, NULL ) ) {
+		return false;
+	}
+
+	if ( !hz ) {
+		sigaction( SIGPROF, &oldProfAction, NULL );
+	}
+
+	return true;
+}
+
+#endif
+
+//=================================================================
+
+typedef struct {
+	int		instruction;
+	char	*name;
+	int		exclusive;
+	int		inclusive;
+	int		lastStack;		// avoid counting recursion twice for inclusive
+} vmSampleSymbol_t;
+
+typedef struct {
+	vmSampleSymbol_t	*symbols;
+	int					numSymbols;
+	char				*names;
+	vmSampleSymbol_t	engine, unknown;
+} vmSampleSymbols_t;
+
+int ParseHex( const char *text );
+
+/*
+=================
+VM_SampleLoadSymbols
+
+Unlike VM_LoadSymbols this keeps the instruction numbers from the map
+file, which is what samples are recorded in
+=================
+*/
+static bool VM_SampleLoadSymbols( vm_t *vm, vmSampleSymbols_t *syms ) {
+	union {
+		char	*c;
+		void	*v;
+	} mapfile;
+	char	name[MAX_QPATH];
+	char	filename[MAX_QPATH];
+	char	*text_p, *token, *names;
+	int		len, count, value;
+
+	::memset( syms, 0, sizeof( *syms ) );
+	syms->engine.name = (char *)"[engine]";
+	syms->unknown.name = (char *)"[unknown]";
+	syms->engine.lastStack = syms->unknown.lastStack = -1;
+
+	COM_StripExtension( vm->name, name, sizeof( name ) );
+	Com_sprintf( filename, sizeof( filename ), "vm/%s.map", name );
+	len = FS_ReadFile( filename, &mapfile.v );
+	if ( !mapfile.c ) {
+		Com_Printf( "Couldn't load symbol file: %s\n", filename );
+		return false;
+	}
+
+	// every symbol takes at least one line, and its name fits in the text
+	syms->symbols = (vmSampleSymbol_t *)Z_Malloc( ( len / 4 + 1 ) * sizeof( *syms->symbols ) );
+	syms->names = names = (char *)Z_Malloc( len + 1 );
+
+	text_p = mapfile.c;
+	count = 0;
+	while ( 1 ) {
+		token = COM_Parse( &text_p );
+		if ( !token[0] ) {
+			break;
+		}
+		if ( ParseHex( token ) ) {
+			COM_Parse( &text_p );
+			COM_Parse( &text_p );
+			continue;		// only load code segment values
+		}
+
+		token = COM_Parse( &text_p );
+		if ( !token[0] ) {
+			break;
+		}
+		value = ParseHex( token );
+
+		token = COM_Parse( &text_p );
+		if ( !token[0] ) {
+			break;
+		}
+
+		syms->symbols[count].instruction = value;
+		syms->symbols[count].name = names;
+		syms->symbols[count].lastStack = -1;
+		Q_strncpyz( names, token, strlen( token ) + 1 );
+		names += strlen( token ) + 1;
+		count++;
+	}
+
+	syms->numSymbols = count;
+	FS_FreeFile( mapfile.v );
+
+	return true;
+}
+
+static void VM_SampleFreeSymbols( vmSampleSymbols_t *syms ) {
+	if ( syms->symbols ) {
+		Z_Free( syms->symbols );
+	}
+	if ( syms->names ) {
+		Z_Free( syms->names );
+	}
+	::memset( syms, 0, sizeof( *syms ) );
+}
+
+/*
+=================
+VM_SampleFindSymbol
+
+Symbols are sorted by instruction number in the map file
+=================
+*/
+static vmSampleSymbol_t *VM_SampleFindSymbol( vmSampleSymbols_t *syms, int instruction ) {
+	int		lo, hi, mid;
+
+	if ( instruction == SAMPLE_ENGINE ) {
+		return &syms->engine;
+	}
+	if ( !syms->numSymbols || instruction < syms->symbols[0].instruction ) {
+		return &syms->unknown;
+	}
+
+	lo = 0;
+	hi = syms->numSymbols - 1;
+	while ( lo < hi ) {
+		mid = ( lo + hi + 1 ) >> 1;
+		if ( syms->symbols[mid].instruction <= instruction ) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return &syms->symbols[lo];
+}
+
+static int QDECL VM_SampleSort( const void *a, const void *b ) {
+	const vmSampleSymbol_t	*sa = *(const vmSampleSymbol_t **)a;
+	const vmSampleSymbol_t	*sb = *(const vmSampleSymbol_t **)b;
+
+	if ( sa->exclusive != sb->exclusive ) {
+		return sa->exclusive - sb->exclusive;
+	}
+	return sa->inclusive - sb->inclusive;
+}
+
+/*
+=================
+VM_SampleReport
+
+Prints the functions with the most exclusive samples, least first so the
+hottest end up next to the prompt like in vmprofile
+=================
+*/
+static void VM_SampleReport( vm_t *vm, int maxLines ) {
+	vmSampleSymbols_t	syms;
+	vmSampleSymbol_t	**sorted, *sym;
+	vmSampleStack_t		*s;
+	int					i, j, count, total;
+
+	VM_SampleLoadSymbols( vm, &syms );
+
+	total = 0;
+	for ( i = 0 ; i < MAX_SAMPLE_STACKS ; i++ ) {
+		s = &sampleStacks[i];
+		if ( !s->count || s->vm != vm ) {
+			continue;
+		}
+
+		total += s->count;
+		VM_SampleFindSymbol( &syms, s->frames[0] )->exclusive += s->count;
+
+		for ( j = 0 ; j < s->depth ; j++ ) {
+			sym = VM_SampleFindSymbol( &syms, s->frames[j] );
+			if ( sym->lastStack != i ) {
+				sym->lastStack = i;
+				sym->inclusive += s->count;
+			}
+		}
+	}
+
+	if ( !total ) {
+		Com_Printf( "No samples for %s\n", vm->name );
+		VM_SampleFreeSymbols( &syms );
+		return;
+	}
+
+	sorted = (vmSampleSymbol_t **)Z_Malloc( ( syms.numSymbols + 2 ) * sizeof( *sorted ) );
+	count = 0;
+	for ( i = 0 ; i < syms.numSymbols ; i++ ) {
+		if ( syms.symbols[i].inclusive ) {
+			sorted[count++] = &syms.symbols[i];
+		}
+	}
+	if ( syms.engine.inclusive ) {
+		sorted[count++] = &syms.engine;
+	}
+	if ( syms.unknown.inclusive ) {
+		sorted[count++] = &syms.unknown;
+	}
+
+	qsort( sorted, count, sizeof( *sorted ), VM_SampleSort );
+
+	Com_Printf( "%s samples:\n", vm->name );
+	Com_Printf( "  self%%   self  total%%  total function\n" );
+	for ( i = count > maxLines ? count - maxLines : 0 ; i < count ; i++ ) {
+		sym = sorted[i];
+		Com_Printf( "%5.1f%% %6i %5.1f%% %6i %s\n",
+			100.0f * sym->exclusive / total, sym->exclusive,
+			100.0f * sym->inclusive / total, sym->inclusive, sym->name );
+	}
+	Com_Printf( "       %6i total\n", total );
+
+	Z_Free( sorted );
+	VM_SampleFreeSymbols( &syms );
+}
+
+/*
+=================
+VM_SampleWriteFolded
+
+Writes the collapsed "root;caller;callee count" format read by
+flamegraph.pl and compatible tools
+=================
+*/
+static void VM_SampleWriteFolded( const char *filename ) {
+	vmSampleSymbols_t	syms;
+	vmSampleStack_t		*s;
+	vm_t				*vm, *vms[8];
+	fileHandle_t		f;
+	int					i, j, k, lines, numVMs;
+
+	f = FS_FOpenFileWrite( filename );
+	if ( !f ) {
+		Com_Printf( "Couldn't write %s\n", filename );
+		return;
+	}
+
+	// group the stacks by vm so each symbol file is loaded once
+	numVMs = 0;
+	for ( i = 0 ; i < MAX_SAMPLE_STACKS ; i++ ) {
+		if ( !sampleStacks[i].count || !sampleStacks[i].vm ) {
+			continue;
+		}
+		for ( j = 0 ; j < numVMs ; j++ ) {
+			if ( vms[j] == sampleStacks[i].vm ) {
+				break;
+			}
+		}
+		if ( j == numVMs && numVMs < ARRAY_LEN( vms ) ) {
+			vms[numVMs++] = sampleStacks[i].vm;
+		}
+	}
+
+	lines = 0;
+	for ( k = 0 ; k < numVMs ; k++ ) {
+		vm = vms[k];
+		VM_SampleLoadSymbols( vm, &syms );
+
+		for ( i = 0 ; i < MAX_SAMPLE_STACKS ; i++ ) {
+			s = &sampleStacks[i];
+			if ( !s->count || s->vm != vm ) {
+				continue;
+			}
+
+			FS_Printf( f, "%s", vm->name );
+			for ( j = s->depth - 1 ; j >= 0 ; j-- ) {
+				FS_Printf( f, ";%s", VM_SampleFindSymbol( &syms, s->frames[j] )->name );
+			}
+			FS_Printf( f, " %i\n", s->count );
+			lines++;
+		}
+
+		VM_SampleFreeSymbols( &syms );
+	}
+
+	FS_FCloseFile( f );
+	Com_Printf( "Wrote %i stacks to %s\n", lines, filename );
+}
+
+/*
+=================
+VM_VmSample_f
+=================
+*/
+void VM_VmSample_f( void ) {
+	const char	*cmd = Cmd_Argv( 1 );
+
+#ifndef VM_SAMPLING
+	Com_Printf( "vmsample is not supported on this platform\n" );
+#else
+	if ( !Q_stricmp( cmd, "start" ) ) {
+		int		hz = Cmd_Argc( ) > 2 ? atoi( Cmd_Argv( 2 ) ) : 1000;
+
+		if ( sampling ) {
+			Com_Printf( "Already sampling\n" );
+			return;
+		}
+
+		hz = Com_Clamp( 10, 10000, hz );
+		if ( !sampleStacks ) {
+			sampleStacks = (vmSampleStack_t *)Z_Malloc( MAX_SAMPLE_STACKS * sizeof( *sampleStacks ) );
+		}
+		::memset( sampleStacks, 0, MAX_SAMPLE_STACKS * sizeof( *sampleStacks ) );
+		sampleTotal = sampleDropped = 0;
+
+		sampling = true;
+		if ( !VM_SampleSetTimer( hz ) ) {
+			sampling = false;
+			Com_Printf( "Couldn't start the profiling timer\n" );
+			return;
+		}
+		Com_Printf( "Sampling compiled vms at %i Hz\n", hz );
+	} else if ( !Q_stricmp( cmd, "stop" ) ) {
+		if ( !sampling ) {
+			Com_Printf( "Not sampling\n" );
+			return;
+		}
+		VM_SampleSetTimer( 0 );
+		sampling = false;
+		Com_Printf( "%i samples, %i dropped\n", sampleTotal, sampleDropped );
+	} else if ( !Q_stricmp( cmd, "report" ) || !Q_stricmp( cmd, "folded" ) ) {
+		if ( !sampleStacks ) {
+			Com_Printf( "No samples, use vmsample start first\n" );
+			return;
+		}
+		if ( sampling ) {
+			Com_Printf( "Stop sampling first\n" );
+			return;
+		}
+
+		if ( !Q_stricmp( cmd, "folded" ) ) {
+			VM_SampleWriteFolded( Cmd_Argc( ) > 2 ? Cmd_Argv( 2 ) : "vmsample.folded" );
+		} else {
+			vm_t	*vm = VM_Find( Cmd_Argc( ) > 2 ? Cmd_Argv( 2 ) : "game" );
+
+			if ( !vm ) {
+				Com_Printf( "No such vm\n" );
+				return;
+			}
+			VM_SampleReport( vm, Cmd_Argc( ) > 3 ? atoi( Cmd_Argv( 3 ) ) : 30 );
+		}
+	} else {
+		Com_Printf( "usage: vmsample start [hz]\n"
+			"       vmsample stop\n"
+			"       vmsample report [vm] [lines]\n"
+			"       vmsample folded [filename]\n" );
+	}
+#endif
+}
+
+/*
+=================
+VM_SampleForget
+
+Called when a vm goes away, its samples can't be resolved anymore.
+The slots are left occupied with a NULL vm so probe chains through them
+stay intact, and SIGPROF is held off while they are rewritten
+=================
+*/
+void VM_SampleForget( vm_t *vm ) {
+	int		i;
+#ifdef VM_SAMPLING
+	sigset_t	block, old;
+#endif
+
+	if ( !sampleStacks ) {
+		return;
+	}
+
+#ifdef VM_SAMPLING
+	sigemptyset( &block );
+	sigaddset( &block, SIGPROF );
+	sigprocmask( SIG_BLOCK, &block, &old );
+#endif
+
+	for ( i = 0 ; i < MAX_SAMPLE_STACKS ; i++ ) {
+		if ( sampleStacks[i].count && sampleStacks[i].vm == vm ) {
+			sampleStacks[i].vm = NULL;
+		}
+	}
+
+#ifdef VM_SAMPLING
+	sigprocmask( SIG_SETMASK, &old, NULL );
+#endif
+}
@@ -422,24 +422,12 @@ static void DoSyscall(void)
 	if(vm_syscallNum < 0)
 	{
 		int *data, *ret;
-#if idx64
-		int index;
-		intptr_t args[MAX_VMSYSCALL_ARGS];
-#endif
 		
 		data = (int *) (savedVM->dataBase + vm_programStack + 4);
 		ret = &vm_opStackBase[vm_opStackOfs + 1];
 
-#if idx64
-		args[0] = ~vm_syscallNum;
-		for(index = 1; index < ARRAY_LEN(args); index++)
-			args[index] = data[index];
-			
-		*ret = savedVM->systemCall(args);
-#else
 		data[0] = ~vm_syscallNum;
-		*ret = savedVM->systemCall((intptr_t *) data);
-#endif
+		*ret = VM_SystemCall(savedVM, data);
 	}
 	else
 	{
@@ -1753,9 +1741,15 @@ int VM_CallCompiled(vm_t *vm, int *args)
 	int	*opStack;
 	int		opStackOfs;
 	int		arg;
+	void	*oldStackTop;
 
 	currentVM = vm;
 
+	// everything below this frame belongs to generated code and syscalls
+	oldStackTop = vm->hostStackTop;
+	if ( !oldStackTop )
+		vm->hostStackTop = stack;
+
 	// interpret the code
 	vm->currentlyInterpreting = true;
 
@@ -1835,6 +1829,7 @@ int VM_CallCompiled(vm_t *vm, int *args)
 		Com_Error(ERR_DROP, "programStack corrupted in compiled code");
 
 	vm->programStack = stackOnEntry;
+	vm->hostStackTop = oldStackTop;
 
 	return opStack[opStackOfs];
 }
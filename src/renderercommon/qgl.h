@@ -387,6 +387,10 @@ extern void (APIENTRYP qglUnlockArraysEXT) (void);
 	GLE(void, CompressedTexImage2D, GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) \
 	GLE(void, CompressedTexSubImage2D, GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data) \
 
+// OpenGL 1.4, was GL_EXT_multi_draw_arrays
+#define QGL_1_4_PROCS \
+	GLE(void, MultiDrawElements, GLenum mode, const GLsizei *count, GLenum type, const GLvoid * const *indices, GLsizei drawcount) \
+
 // OpenGL 1.5, was GL_ARB_vertex_buffer_object and GL_ARB_occlusion_query
 #define QGL_1_5_PROCS \
 	GLE(void, GenQueries, GLsizei n, GLuint *ids) \
@@ -507,6 +511,11 @@ extern void (APIENTRYP qglUnlockArraysEXT) (void);
 	GLE(void, DeleteVertexArrays, GLsizei n, const GLuint *arrays) \
 	GLE(void, GenVertexArrays, GLsizei n, GLuint *arrays) \
 
+// GL_ARB_timer_query, built-in to OpenGL 3.3
+#define QGL_ARB_timer_query_PROCS \
+	GLE(void, QueryCounter, GLuint id, GLenum target) \
+	GLE(void, GetQueryObjectui64v, GLuint id, GLenum pname, GLuint64 *params) \
+
 #ifndef GL_ARB_texture_compression_rgtc
 #define GL_ARB_texture_compression_rgtc
 #define GL_COMPRESSED_RED_RGTC1                       0x8DBB
@@ -559,11 +568,13 @@ extern void (APIENTRYP qglUnlockArraysEXT) (void);
 
 #define GLE(ret, name, ...) typedef ret APIENTRY name##proc(__VA_ARGS__); extern name##proc * qgl##name;
 QGL_1_3_PROCS;
+QGL_1_4_PROCS;
 QGL_1_5_PROCS;
 QGL_2_0_PROCS;
 QGL_3_0_PROCS;
 QGL_ARB_framebuffer_object_PROCS;
 QGL_ARB_vertex_array_object_PROCS;
+QGL_ARB_timer_query_PROCS;
 QGL_EXT_direct_state_access_PROCS;
 #undef GLE
 
@@ -114,6 +114,10 @@ extern cvar_t *r_ext_max_anisotropy;
 extern cvar_t *r_stereoEnabled;
 
 extern cvar_t	*r_saveFontData;
+extern cvar_t	*r_shaderCache;
+extern cvar_t	*r_imageJobs;
+extern cvar_t	*r_imageCache;
+extern cvar_t	*r_imageCacheSize;
 
 qboolean	R_GetModeInfo( int *width, int *height, float *windowAspect, int mode );
 
@@ -121,6 +125,7 @@ float R_NoiseGet4f( float x, float y, float z, double t );
 void  R_NoiseInit( void );
 
 image_t     *R_FindImageFile( const char *name, imgType_t type, int/*imgFlags_t*/ flags );
+bool        R_ImageLoaded( const char *name );
 image_t *R_CreateImage( const char *name, byte *pic, int width, int height, imgType_t type, int flags, int internalFormat );
 
 void R_IssuePendingRenderCommands( void );
@@ -129,6 +134,11 @@ qhandle_t		 RE_RegisterShader( const char *name );
 qhandle_t		 RE_RegisterShaderNoMip( const char *name );
 qhandle_t RE_RegisterShaderFromImage(const char *name, int lightmapIndex, image_t *image, qboolean mipRawImage);
 
+// tr_shadercache.cpp
+bool R_ShaderCacheKey( char filenames[][MAX_QPATH], int numFiles, uint64_t *key );
+bool R_LoadShaderCache( uint64_t key, int numFiles, char **text, int **starts, int *numStarts );
+void R_SaveShaderCache( uint64_t key, int numFiles, const char *text, const int *starts, int numStarts );
+
 // font stuff
 void R_InitFreeType( void );
 void R_DoneFreeType( void );
@@ -147,8 +157,98 @@ void R_LoadBMP( const char *name, byte **pic, int *width, int *height );
 void R_LoadJPG( const char *name, byte **pic, int *width, int *height );
 void R_LoadPCX( const char *name, byte **pic, int *width, int *height );
 void R_LoadPNG( const char *name, byte **pic, int *width, int *height );
+void R_PNGBench_f( void );
 void R_LoadTGA( const char *name, byte **pic, int *width, int *height );
 
+typedef struct {
+	const char *ext;
+	void (*ImageLoader)( const char *, unsigned char **, int *, int * );
+} imageExtToLoaderMap_t;
+
+// the loaders read, allocate and report through these so the same code
+// can run on a job thread, against a file read beforehand by the main
+// thread.  On a job any print or error abandons the job and the image is
+// loaded again on the main thread, where the message is shown.
+long	R_ReadImageFile( const char *name, void **buf );
+void	R_FreeImageFile( void *buf );
+void	*R_ImageMalloc( int size );
+void	R_ImageFree( void *ptr );
+void	*R_ImageTempAlloc( int size );
+void	R_ImageTempFree( void *ptr );
+void	QDECL R_ImagePrintf( int printLevel, const char *fmt, ... ) __attribute__ ((format (printf, 2, 3)));
+void	QDECL R_ImageError( int errorLevel, const char *fmt, ... ) __attribute__ ((noreturn, format (printf, 2, 3)));
+
+/*
+=============================================================
+
+IMAGE JOBS
+
+Images requested ahead of use are read on the main thread, then decoded
+and prepared for upload on the job threads in batches.  R_FindImageFile
+takes the result when it gets to the image, so GL uploads still happen
+on the main thread in the order the images are asked for.
+
+=============================================================
+*/
+
+typedef struct imageJob_s {
+	char		name[MAX_QPATH];
+	imgType_t	type;
+	int			flags;
+
+	// found and read by the main thread
+	char		fileName[MAX_QPATH];
+	void		*file;
+	long		fileLength;
+	int			loader;
+	bool		renamed;		// not found under its own extension
+
+	int			state;
+	bool		failed;			// load it again on the main thread
+	void		*blocks;		// everything allocated by the job
+
+	byte		*pic;
+	int			width, height;
+
+	// filled in by the renderer's prepare function
+	bool		prepared;
+	byte		*upload;
+	int			uploadWidth, uploadHeight;
+	int			internalFormat;
+	int			numLevels;
+	bool		scaled;
+
+	struct imageJob_s	*hashNext;
+} imageJob_t;
+
+void		R_InitImageJobs( const imageExtToLoaderMap_t *loaders, int numLoaders, void (*prepare)( imageJob_t *job ) );
+void		R_RequestImage( const char *name, imgType_t type, int/*imgFlags_t*/ flags );
+imageJob_t	*R_TakeImageJob( const char *name, imgType_t type, int/*imgFlags_t*/ flags );
+void		R_ReleaseImageJob( imageJob_t *job );
+void		R_ClearImageJobs( void );
+bool		R_FindImageSource( const char *name, char *fileName, int fileNameSize, int *loader, bool *renamed );
+
+/*
+=============================================================
+
+IMAGE CACHE
+
+Images as they are handed to GL, after decoding, resampling and mip
+generation, are kept under imagecache/ in the homepath.  They are keyed
+by the source file, the pak it came from and the settings that change
+the result, so a hit can be uploaded straight from the file.
+
+=============================================================
+*/
+
+void	R_InitImageCache( const void *settings, int settingsSize );
+bool	R_ImageCacheKey( const char *name, imgType_t type, int/*imgFlags_t*/ flags, uint64_t *key );
+bool	R_ImageCached( uint64_t key );
+bool	R_LoadCachedImage( uint64_t key, imageJob_t *job, void **buf );
+void	R_SaveCachedImage( uint64_t key, const imageJob_t *job );
+void	R_SaveImageCacheIndex( void );
+void	R_ImageCacheInfo( void );
+
 /*
 ====================================================================
 
@@ -63,7 +63,7 @@ static void R_JPGErrorExit(j_common_ptr cinfo)
   
   (*cinfo->err->format_message) (cinfo, buffer);
 
-  ri.Printf(PRINT_ALL, "Error: %s", buffer);
+  R_ImagePrintf(PRINT_ALL, "Error: %s", buffer);
 
   /* Return control to the setjmp point */
   longjmp(jerr->setjmp_buffer, 1);
@@ -77,7 +77,7 @@ static void R_JPGOutputMessage(j_common_ptr cinfo)
   (*cinfo->err->format_message) (cinfo, buffer);
   
   /* Send it to stderr, adding a newline */
-  ri.Printf(PRINT_ALL, "%s\n", buffer);
+  R_ImagePrintf(PRINT_ALL, "%s\n", buffer);
 }
 
 void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *height)
@@ -119,7 +119,7 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
    * requires it in order to read binary files.
    */
 
-  len = ri.FS_ReadFile ( ( char * ) filename, &fbuffer.v);
+  len = R_ReadImageFile ( ( char * ) filename, &fbuffer.v);
   if (!fbuffer.b || len < 0) {
 	return;
   }
@@ -142,10 +142,10 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
      * We need to clean up the JPEG object, close the input file, and return.
      */
     jpeg_destroy_decompress(&cinfo);
-    ri.FS_FreeFile(fbuffer.v);
+    R_FreeImageFile(fbuffer.v);
 
     /* Append the filename to the error for easier debugging */
-    ri.Printf(PRINT_ALL, ", loading file %s\n", filename);
+    R_ImagePrintf(PRINT_ALL, ", loading file %s\n", filename);
     return;
   }
 
@@ -196,17 +196,17 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
     )
   {
     // Free the memory to make sure we don't leak memory
-    ri.FS_FreeFile (fbuffer.v);
+    R_FreeImageFile (fbuffer.v);
     jpeg_destroy_decompress(&cinfo);
   
-    ri.Error(ERR_DROP, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
+    R_ImageError(ERR_DROP, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
 		    cinfo.output_width, cinfo.output_height, pixelcount * 4, cinfo.output_components);
   }
 
   memcount = pixelcount * 4;
   row_stride = cinfo.output_width * cinfo.output_components;
 
-  out = (byte*)ri.Malloc(memcount);
+  out = (byte*)R_ImageMalloc(memcount);
 
   *width = cinfo.output_width;
   *height = cinfo.output_height;
@@ -260,7 +260,7 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
    * so as to simplify the setjmp error logic above.  (Actually, I don't
    * think that jpeg_destroy can do an error exit, but why assume anything...)
    */
-  ri.FS_FreeFile (fbuffer.v);
+  R_FreeImageFile (fbuffer.v);
 
   /* At this point you may want to check to see whether any corrupt-data
    * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
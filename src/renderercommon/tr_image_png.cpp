@@ -22,7 +22,14 @@ along with this program; if not,  see <http://www.gnu.org/licenses/>.
 
 #include "tr_common.h"
 
-#include "qcommon/puff.h"
+#include <zlib.h>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define PNG_SIMD 1
+#include <emmintrin.h>
+#else
+#define PNG_SIMD 0
+#endif
 
 // we could limit the png size to a lower value here
 #ifndef INT_MAX
@@ -35,6 +42,13 @@ PNG LOADING
 =================
 */
 
+/*
+ *  Set by r_pngBench to time the reference path: the whole image is
+ *  inflated into one buffer and unfiltered with the scalar loops.
+ */
+
+static qboolean pngReference;
+
 /*
  *  Quake 3 image format : RGBA
  */
@@ -234,7 +248,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 	 *  Allocate control struct.
 	 */
 
-	BF = (struct BufferedFile*)ri.Malloc(sizeof(struct BufferedFile));
+	BF = (struct BufferedFile*)R_ImageMalloc(sizeof(struct BufferedFile));
 	if(!BF)
 	{
 		return(NULL);
@@ -253,7 +267,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 	 *  Read the file.
 	 */
 
-	BF->Length = ri.FS_ReadFile((char *) name, &buffer.v);
+	BF->Length = R_ReadImageFile((char *) name, &buffer.v);
 	BF->Buffer = buffer.b;
 
 	/*
@@ -262,7 +276,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 
 	if(!(BF->Buffer && (BF->Length > 0)))
 	{
-		ri.Free(BF);
+		R_ImageFree(BF);
 
 		return(NULL);
 	}
@@ -287,10 +301,10 @@ static void CloseBufferedFile(struct BufferedFile *BF)
 	{
 		if(BF->Buffer)
 		{
-			ri.FS_FreeFile(BF->Buffer);
+			R_FreeImageFile(BF->Buffer);
 		}
 
-		ri.Free(BF);
+		R_ImageFree(BF);
 	}
 }
 
@@ -502,315 +516,618 @@ static qboolean FindChunk(struct BufferedFile *BF, uint32_t ChunkType)
 }
 
 /*
- *  Decompress all IDATs
+ *  The IDAT chunks are inflated straight out of the file buffer,
+ *  one chunk after the other, without gathering them first.
  */
 
-static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
+struct PNG_Inflater
 {
-	uint8_t  *DecompressedData;
-	uint32_t  DecompressedDataLength;
+	struct BufferedFile *BF;
+	z_stream             Stream;
+	uint32_t             HeaderLeft;
+	qboolean             LastChunk;
+};
 
-	uint8_t  *CompressedData;
-	uint8_t  *CompressedDataPtr;
-	uint32_t  CompressedDataLength;
+/*
+ *  Point the stream at the data of the next IDAT chunk.
+ */
 
+static qboolean InflaterNextChunk(struct PNG_Inflater *Inf)
+{
 	struct PNG_ChunkHeader *CH;
-
 	uint32_t Length;
-	uint32_t Type;
+	uint8_t *Data;
 
-	int BytesToRewind;
+	while(!Inf->LastChunk)
+	{
+		CH = (struct PNG_ChunkHeader*)BufferedFileRead(Inf->BF, PNG_ChunkHeader_Size);
+		if(!CH)
+		{
+			return(qfalse);
+		}
 
-	int32_t   puffResult;
-	uint8_t  *puffDest;
-	uint32_t  puffDestLen;
-	uint8_t  *puffSrc;
-	uint32_t  puffSrcLen;
+		Length = BigLong(CH->Length);
 
-	/*
-	 *  input verification
-	 */
+		/*
+		 *  We have reached the end of the IDAT chunks
+		 */
 
-	if(!(BF && Buffer))
-	{
-		return(-1);
-	}
+		if(BigLong(CH->Type) != PNG_ChunkType_IDAT)
+		{
+			BufferedFileRewind(Inf->BF, PNG_ChunkHeader_Size);
+			Inf->LastChunk = qtrue;
 
-	/*
-	 *  some zeroing
-	 */
+			return(qfalse);
+		}
 
-	DecompressedData = NULL;
-	*Buffer = DecompressedData;
+		if(!Length)
+		{
+			if(!BufferedFileSkip(Inf->BF, PNG_ChunkCRC_Size))
+			{
+				return(qfalse);
+			}
 
-	CompressedData = NULL;
-	CompressedDataLength = 0;
+			continue;
+		}
 
-	BytesToRewind = 0;
+		Data = (uint8_t*)BufferedFileRead(Inf->BF, Length);
+		if(!(Data && BufferedFileSkip(Inf->BF, PNG_ChunkCRC_Size)))
+		{
+			return(qfalse);
+		}
 
-	/*
-	 *  Find the first IDAT chunk.
-	 */
+		/*
+		 *  The zlib header doesn't belong to the compressed data,
+		 *  and may in theory be split over chunks.
+		 */
+
+		while(Inf->HeaderLeft && Length)
+		{
+			Inf->HeaderLeft--;
+			Data++;
+			Length--;
+		}
+
+		if(!Length)
+		{
+			continue;
+		}
+
+		Inf->Stream.next_in  = Data;
+		Inf->Stream.avail_in = Length;
+
+		return(qtrue);
+	}
+
+	return(qfalse);
+}
+
+/*
+ *  Start inflating at the first IDAT chunk.
+ */
+
+static qboolean InflaterInit(struct PNG_Inflater *Inf, struct BufferedFile *BF)
+{
+	Com_Memset(Inf, 0, sizeof(*Inf));
+
+	Inf->BF         = BF;
+	Inf->HeaderLeft = PNG_ZlibHeader_Size;
 
 	if(!FindChunk(BF, PNG_ChunkType_IDAT))
 	{
-		return(-1);
+		return(qfalse);
 	}
 
 	/*
-	 *  Count the size of the uncompressed data
+	 *  Raw inflate, as puff() did: the header is skipped by hand and
+	 *  the check value after the deflate stream is never looked at.
 	 */
 
-	while(qtrue)
+	if(inflateInit2(&Inf->Stream, -MAX_WBITS) != Z_OK)
 	{
-		/*
-		 *  Read chunk header
-		 */
-
-		CH = (struct PNG_ChunkHeader*)BufferedFileRead(BF, PNG_ChunkHeader_Size);
-		if(!CH)
-		{
-			/*
-			 *  Rewind to the start of this adventure
-			 *  and return unsuccessfull
-			 */
+		return(qfalse);
+	}
 
-			BufferedFileRewind(BF, BytesToRewind);
+	return(qtrue);
+}
 
-			return(-1);
-		}
+static void InflaterEnd(struct PNG_Inflater *Inf)
+{
+	inflateEnd(&Inf->Stream);
+}
 
-		/*
-		 *  Length and Type of chunk
-		 */
+/*
+ *  Inflate exactly Length bytes into Dest.
+ */
 
-		Length = BigLong(CH->Length);
-		Type   = BigLong(CH->Type);
+static qboolean InflaterRead(struct PNG_Inflater *Inf, uint8_t *Dest, uint32_t Length)
+{
+	int Result;
 
-		/*
-		 *  We have reached the end of the IDAT chunks
-		 */
+	Inf->Stream.next_out  = Dest;
+	Inf->Stream.avail_out = Length;
 
-		if(!(Type == PNG_ChunkType_IDAT))
+	while(Inf->Stream.avail_out)
+	{
+		if(!Inf->Stream.avail_in && !InflaterNextChunk(Inf))
 		{
-			BufferedFileRewind(BF, PNG_ChunkHeader_Size); 
-
-			break;
+			return(qfalse);
 		}
 
-		/*
-		 *  Add chunk header to count.
-		 */
-
-		BytesToRewind += PNG_ChunkHeader_Size;
+		Result = inflate(&Inf->Stream, Z_NO_FLUSH);
 
-		/*
-		 *  Skip to next chunk
-		 */
-
-		if(Length)
+		if(Result == Z_STREAM_END)
 		{
-			if(!BufferedFileSkip(BF, Length + PNG_ChunkCRC_Size))
-			{
-				BufferedFileRewind(BF, BytesToRewind);
-
-				return(-1);
-			}
+			return(Inf->Stream.avail_out ? qfalse : qtrue);
+		}
 
-			BytesToRewind += Length + PNG_ChunkCRC_Size;
-			CompressedDataLength += Length;
-		} 
+		if(Result != Z_OK)
+		{
+			return(qfalse);
+		}
 	}
 
-	BufferedFileRewind(BF, BytesToRewind);
-
-	CompressedData = (uint8_t*)ri.Malloc(CompressedDataLength);
-	if(!CompressedData)
-	{
-		return(-1);
-	}
+	return(qtrue);
+}
 
-	CompressedDataPtr = CompressedData;
+/*
+ *  Check that the deflate stream ends right after the image data.
+ */
 
-	/*
-	 *  Collect the compressed Data
-	 */
+static qboolean InflaterFinish(struct PNG_Inflater *Inf)
+{
+	uint8_t Extra;
+	int Result;
 
 	while(qtrue)
 	{
-		/*
-		 *  Read chunk header
-		 */
+		Inf->Stream.next_out  = &Extra;
+		Inf->Stream.avail_out = 1;
 
-		CH = (struct PNG_ChunkHeader*)BufferedFileRead(BF, PNG_ChunkHeader_Size);
-		if(!CH)
+		if(!Inf->Stream.avail_in && !InflaterNextChunk(Inf))
 		{
-			ri.Free(CompressedData); 
+			return(qfalse);
+		}
+
+		Result = inflate(&Inf->Stream, Z_NO_FLUSH);
 
-			return(-1);
+		if(Result == Z_STREAM_END)
+		{
+			return(Inf->Stream.avail_out ? qtrue : qfalse);
 		}
 
-		/*
-		 *  Length and Type of chunk
-		 */
+		if((Result != Z_OK) || !Inf->Stream.avail_out)
+		{
+			return(qfalse);
+		}
+	}
+}
 
-		Length = BigLong(CH->Length);
-		Type   = BigLong(CH->Type);
+/*
+ *  The size of the decompressed data, filter type bytes included.
+ */
 
-		/*
-		 *  We have reached the end of the IDAT chunks
-		 */
+static uint32_t DecompressedLength(struct PNG_Chunk_IHDR *IHDR)
+{
+	static const uint32_t WSkip[PNG_Adam7_NumPasses]   = {8, 8, 4, 4, 2, 2, 1};
+	static const uint32_t WOffset[PNG_Adam7_NumPasses] = {0, 4, 0, 2, 0, 1, 0};
+	static const uint32_t HSkip[PNG_Adam7_NumPasses]   = {8, 8, 8, 4, 4, 2, 2};
+	static const uint32_t HOffset[PNG_Adam7_NumPasses] = {0, 0, 4, 0, 2, 0, 1};
 
-		if(!(Type == PNG_ChunkType_IDAT))
-		{
-			BufferedFileRewind(BF, PNG_ChunkHeader_Size); 
+	uint64_t Width, Height, BitsPerPixel, BytesPerScanline, Length;
+	uint32_t a;
 
-			break;
-		}
+	switch(IHDR->ColourType)
+	{
+		case PNG_ColourType_Grey      : BitsPerPixel = PNG_NumColourComponents_Grey;      break;
+		case PNG_ColourType_True      : BitsPerPixel = PNG_NumColourComponents_True;      break;
+		case PNG_ColourType_Indexed   : BitsPerPixel = PNG_NumColourComponents_Indexed;   break;
+		case PNG_ColourType_GreyAlpha : BitsPerPixel = PNG_NumColourComponents_GreyAlpha; break;
+		case PNG_ColourType_TrueAlpha : BitsPerPixel = PNG_NumColourComponents_TrueAlpha; break;
+		default                       : return(0);
+	}
 
-		/*
-		 *  Copy the Data
-		 */
+	BitsPerPixel *= IHDR->BitDepth;
 
-		if(Length)
-		{
-			uint8_t *OrigCompressedData;
+	Width  = BigLong(IHDR->Width);
+	Height = BigLong(IHDR->Height);
 
-			OrigCompressedData = (uint8_t*)BufferedFileRead(BF, Length);
-			if(!OrigCompressedData)
-			{
-				ri.Free(CompressedData); 
+	if(IHDR->InterlaceMethod == PNG_InterlaceMethod_NonInterlaced)
+	{
+		Length = ((Width * BitsPerPixel + 7) / 8 + 1) * Height;
+	}
+	else
+	{
+		Length = 0;
 
-				return(-1);
-			}
+		for(a = 0; a < PNG_Adam7_NumPasses; a++)
+		{
+			BytesPerScanline = ((Width + WSkip[a] - 1 - WOffset[a]) / WSkip[a] * BitsPerPixel + 7) / 8;
 
-			if(!BufferedFileSkip(BF, PNG_ChunkCRC_Size))
+			if(BytesPerScanline)
 			{
-				ri.Free(CompressedData); 
-
-				return(-1);
+				Length += (BytesPerScanline + 1) * ((Height + HSkip[a] - 1 - HOffset[a]) / HSkip[a]);
 			}
+		}
+	}
 
-			memcpy(CompressedDataPtr, OrigCompressedData, Length);
-			CompressedDataPtr += Length;
-		} 
+	if(Length > INT_MAX)
+	{
+		return(0);
 	}
 
-	/*
-	 *  Let puff() calculate the decompressed data length.
-	 */
+	return((uint32_t)Length);
+}
 
-	puffDest    = NULL;
-	puffDestLen = 0;
+/*
+ *  Decompress all IDATs
+ */
+
+static uint32_t DecompressIDATs(struct PNG_Chunk_IHDR *IHDR, struct BufferedFile *BF, uint8_t **Buffer)
+{
+	struct PNG_Inflater Inf;
+	uint8_t  *DecompressedData;
+	uint32_t  DecompressedDataLength;
 
 	/*
-	 *  The zlib header and checkvalue don't belong to the compressed data.
+	 *  input verification
 	 */
 
-	puffSrc    = CompressedData + PNG_ZlibHeader_Size;
-	puffSrcLen = CompressedDataLength - PNG_ZlibHeader_Size - PNG_ZlibCheckValue_Size;
+	if(!(IHDR && BF && Buffer))
+	{
+		return(-1);
+	}
+
+	*Buffer = NULL;
 
 	/*
-	 *  first puff() to calculate the size of the uncompressed data
+	 *  The header tells how much data there has to be, so it is
+	 *  inflated once into a buffer of exactly that size.
 	 */
 
-	puffResult = puff(puffDest, &puffDestLen, puffSrc, &puffSrcLen);
-	if(!((puffResult == 0) && (puffDestLen > 0)))
+	DecompressedDataLength = DecompressedLength(IHDR);
+	if(!DecompressedDataLength)
 	{
-		ri.Free(CompressedData);
+		return(-1);
+	}
 
+	DecompressedData = (uint8_t*)R_ImageMalloc(DecompressedDataLength);
+	if(!DecompressedData)
+	{
 		return(-1);
 	}
 
-	/*
-	 *  Allocate the buffer for the uncompressed data.
-	 */
+	if(!InflaterInit(&Inf, BF))
+	{
+		R_ImageFree(DecompressedData);
 
-	DecompressedData = (uint8_t*)ri.Malloc(puffDestLen);
-	if(!DecompressedData)
+		return(-1);
+	}
+
+	if(!(InflaterRead(&Inf, DecompressedData, DecompressedDataLength) && InflaterFinish(&Inf)))
 	{
-		ri.Free(CompressedData);
+		InflaterEnd(&Inf);
+		R_ImageFree(DecompressedData);
 
 		return(-1);
 	}
 
+	InflaterEnd(&Inf);
+
 	/*
-	 *  Set the input again in case something was changed by the last puff() .
+	 *  Set the output of this function.
 	 */
 
-	puffDest   = DecompressedData;
-	puffSrc    = CompressedData + PNG_ZlibHeader_Size;
-	puffSrcLen = CompressedDataLength - PNG_ZlibHeader_Size - PNG_ZlibCheckValue_Size;
+	*Buffer = DecompressedData;
 
-	/*
-	 *  decompression puff()
-	 */
+	return(DecompressedDataLength);
+}
 
-	puffResult = puff(puffDest, &puffDestLen, puffSrc, &puffSrcLen);
+/*
+ *  the Paeth predictor
+ */
 
+static uint8_t PredictPaeth(uint8_t a, uint8_t b, uint8_t c)
+{
 	/*
-	 *  The compressed data is not needed anymore.
+	 *  a == Left
+	 *  b == Up
+	 *  c == UpLeft
 	 */
 
-	ri.Free(CompressedData);
+	uint8_t Pr;
+	int p;
+	int pa, pb, pc;
 
-	/*
-	 *  Check if the last puff() was successfull.
-	 */
+	p  = ((int) a) + ((int) b) - ((int) c);
+	pa = abs(p - ((int) a));
+	pb = abs(p - ((int) b));
+	pc = abs(p - ((int) c));
+
+	if((pa <= pb) && (pa <= pc))
+	{
+		Pr = a;
+	}
+	else if(pb <= pc)
+	{
+		Pr = b;
+	}
+	else
+	{
+		Pr = c;
+	}
+
+	return(Pr);
+
+}
 
-	if(!((puffResult == 0) && (puffDestLen > 0)))
+#if PNG_SIMD
+
+/*
+ *  SSE2 versions of the filters that carry a dependency from one pixel
+ *  to the next, for the common 3 and 4 byte pixels.  Every pixel is
+ *  done as a whole, the Paeth one in 16 bit lanes.
+ */
+
+static inline __m128i LoadPixel(const uint8_t *p, uint32_t BytesPerPixel)
+{
+	int v = 0;
+
+	memcpy(&v, p, BytesPerPixel);
+
+	return(_mm_cvtsi32_si128(v));
+}
+
+static inline void StorePixel(uint8_t *p, __m128i x, uint32_t BytesPerPixel)
+{
+	int v = _mm_cvtsi128_si32(x);
+
+	memcpy(p, &v, BytesPerPixel);
+}
+
+static inline void UnfilterSubSIMD(uint8_t *Row, uint32_t Length, uint32_t BytesPerPixel)
+{
+	__m128i a = _mm_setzero_si128();
+	uint32_t i;
+
+	for(i = 0; i < Length; i += BytesPerPixel)
 	{
-		ri.Free(DecompressedData);
+		a = _mm_add_epi8(a, LoadPixel(Row + i, BytesPerPixel));
+		StorePixel(Row + i, a, BytesPerPixel);
+	}
+}
 
-		return(-1);
+static inline void UnfilterAverageSIMD(uint8_t *Row, const uint8_t *Prev, uint32_t Length, uint32_t BytesPerPixel)
+{
+	const __m128i Ones = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128();
+	__m128i b, Avg;
+	uint32_t i;
+
+	for(i = 0; i < Length; i += BytesPerPixel)
+	{
+		b = LoadPixel(Prev + i, BytesPerPixel);
+
+		/*
+		 *  _mm_avg_epu8 rounds up, the filter rounds down.
+		 */
+
+		Avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), Ones));
+		a = _mm_add_epi8(Avg, LoadPixel(Row + i, BytesPerPixel));
+		StorePixel(Row + i, a, BytesPerPixel);
 	}
+}
+
+static inline __m128i Abs16(__m128i x)
+{
+	return(_mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x)));
+}
+
+static inline __m128i Select(__m128i Mask, __m128i t, __m128i f)
+{
+	return(_mm_or_si128(_mm_and_si128(Mask, t), _mm_andnot_si128(Mask, f)));
+}
+
+static inline void UnfilterPaethSIMD(uint8_t *Row, const uint8_t *Prev, uint32_t Length, uint32_t BytesPerPixel)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	__m128i a = Zero, b, c = Zero;
+	__m128i pa, pb, pc, Smallest, Nearest;
+	uint32_t i;
+
+	for(i = 0; i < Length; i += BytesPerPixel)
+	{
+		b = _mm_unpacklo_epi8(LoadPixel(Prev + i, BytesPerPixel), Zero);
+
+		/*
+		 *  p - a == b - c, p - b == a - c, p - c == (b - c) + (a - c)
+		 */
+
+		pa = _mm_sub_epi16(b, c);
+		pb = _mm_sub_epi16(a, c);
+		pc = _mm_add_epi16(pa, pb);
+
+		pa = Abs16(pa);
+		pb = Abs16(pb);
+		pc = Abs16(pc);
+
+		Smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+		/*
+		 *  ties go to a, then b, as in PredictPaeth
+		 */
+
+		Nearest = Select(_mm_cmpeq_epi16(Smallest, pa), a,
+				Select(_mm_cmpeq_epi16(Smallest, pb), b, c));
+
+		/*
+		 *  The add has to wrap at 8 bits, the upper byte of every
+		 *  lane is zero in both.
+		 */
+
+		a = _mm_add_epi8(Nearest, _mm_unpacklo_epi8(LoadPixel(Row + i, BytesPerPixel), Zero));
+		StorePixel(Row + i, _mm_packus_epi16(a, a), BytesPerPixel);
+
+		c = b;
+	}
+}
+
+#endif
+
+/*
+ *  Reverse the filter of one scanline.
+ *  Prev is the unfiltered previous scanline, or NULL for the first one.
+ */
+
+static qboolean UnfilterScanline(uint8_t FilterType, uint8_t *Row, const uint8_t *Prev,
+		uint32_t BytesPerScanline, uint32_t BytesPerPixel)
+{
+	uint32_t i;
 
 	/*
-	 *  Set the output of this function.
+	 *  Above the first scanline everything is zero, which turns
+	 *  Up into None and Paeth into Sub.
 	 */
 
-	DecompressedDataLength = puffDestLen;
-	*Buffer = DecompressedData;
+	if(!Prev)
+	{
+		if(FilterType == PNG_FilterType_Up)
+		{
+			FilterType = PNG_FilterType_None;
+		}
+		else if(FilterType == PNG_FilterType_Paeth)
+		{
+			FilterType = PNG_FilterType_Sub;
+		}
+		else if(FilterType == PNG_FilterType_Average)
+		{
+			for(i = BytesPerPixel; i < BytesPerScanline; i++)
+			{
+				Row[i] += Row[i - BytesPerPixel] >> 1;
+			}
+
+			return(qtrue);
+		}
+	}
+
+	switch(FilterType)
+	{
+		case PNG_FilterType_None :
+		{
+			break;
+		}
+
+		case PNG_FilterType_Sub :
+		{
+#if PNG_SIMD
+			if(BytesPerPixel == 4 && !pngReference)
+			{
+				UnfilterSubSIMD(Row, BytesPerScanline, 4);
+				break;
+			}
+
+			if(BytesPerPixel == 3 && !pngReference)
+			{
+				UnfilterSubSIMD(Row, BytesPerScanline, 3);
+				break;
+			}
+#endif
+
+			for(i = BytesPerPixel; i < BytesPerScanline; i++)
+			{
+				Row[i] += Row[i - BytesPerPixel];
+			}
+
+			break;
+		}
+
+		case PNG_FilterType_Up :
+		{
+			i = 0;
+
+#if PNG_SIMD
+			for(; !pngReference && i + 16 <= BytesPerScanline; i += 16)
+			{
+				__m128i x = _mm_loadu_si128((const __m128i *)(Row + i));
+				__m128i b = _mm_loadu_si128((const __m128i *)(Prev + i));
+
+				_mm_storeu_si128((__m128i *)(Row + i), _mm_add_epi8(x, b));
+			}
+#endif
+
+			for(; i < BytesPerScanline; i++)
+			{
+				Row[i] += Prev[i];
+			}
+
+			break;
+		}
+
+		case PNG_FilterType_Average :
+		{
+#if PNG_SIMD
+			if(BytesPerPixel == 4 && !pngReference)
+			{
+				UnfilterAverageSIMD(Row, Prev, BytesPerScanline, 4);
+				break;
+			}
+
+			if(BytesPerPixel == 3 && !pngReference)
+			{
+				UnfilterAverageSIMD(Row, Prev, BytesPerScanline, 3);
+				break;
+			}
+#endif
+
+			for(i = 0; i < BytesPerPixel; i++)
+			{
+				Row[i] += Prev[i] >> 1;
+			}
+
+			for(; i < BytesPerScanline; i++)
+			{
+				Row[i] += (uint8_t)((((uint16_t) Row[i - BytesPerPixel]) + ((uint16_t) Prev[i])) / 2);
+			}
+
+			break;
+		}
 
-	return(DecompressedDataLength);
-}
+		case PNG_FilterType_Paeth :
+		{
+#if PNG_SIMD
+			if(BytesPerPixel == 4 && !pngReference)
+			{
+				UnfilterPaethSIMD(Row, Prev, BytesPerScanline, 4);
+				break;
+			}
 
-/*
- *  the Paeth predictor
- */
+			if(BytesPerPixel == 3 && !pngReference)
+			{
+				UnfilterPaethSIMD(Row, Prev, BytesPerScanline, 3);
+				break;
+			}
+#endif
 
-static uint8_t PredictPaeth(uint8_t a, uint8_t b, uint8_t c)
-{
-	/*
-	 *  a == Left
-	 *  b == Up
-	 *  c == UpLeft
-	 */
+			for(i = 0; i < BytesPerPixel; i++)
+			{
+				Row[i] += Prev[i];
+			}
 
-	uint8_t Pr;
-	int p;
-	int pa, pb, pc;
+			for(; i < BytesPerScanline; i++)
+			{
+				Row[i] += PredictPaeth(Row[i - BytesPerPixel], Prev[i], Prev[i - BytesPerPixel]);
+			}
 
-	p  = ((int) a) + ((int) b) - ((int) c);
-	pa = abs(p - ((int) a));
-	pb = abs(p - ((int) b));
-	pc = abs(p - ((int) c));
+			break;
+		}
 
-	if((pa <= pb) && (pa <= pc))
-	{
-		Pr = a;
-	}
-	else if(pb <= pc)
-	{
-		Pr = b;
-	}
-	else
-	{
-		Pr = c;
+		default :
+		{
+			return(qfalse);
+		}
 	}
 
-	return(Pr);
-
+	return(qtrue);
 }
 
 /*
@@ -823,15 +1140,7 @@ static qboolean UnfilterImage(uint8_t  *DecompressedData,
 		uint32_t  BytesPerPixel)
 {
 	uint8_t   *DecompPtr;
-	uint8_t   FilterType;
-	uint8_t  *PixelLeft, *PixelUp, *PixelUpLeft;
-	uint32_t  w, h, p;
-
-	/*
-	 *  some zeros for the filters
-	 */
-
-	uint8_t Zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	uint32_t  h;
 
 	/*
 	 *  input verification
@@ -852,141 +1161,129 @@ static qboolean UnfilterImage(uint8_t  *DecompressedData,
 	}
 
 	/*
-	 *  Set the pointer to the start of the decompressed Data.
+	 *  Un-filtering is done in place, one scanline at a time.
+	 *  Every scanline starts with a FilterType byte.
 	 */
 
 	DecompPtr = DecompressedData;
 
-	/*
-	 *  Un-filtering is done in place.
-	 */
-
-	/*
-	 *  Go trough all scanlines.
-	 */
-
 	for(h = 0; h < ImageHeight; h++)
 	{
-		/*
-		 *  Every scanline starts with a FilterType byte.
-		 */
-
-		FilterType = *DecompPtr;
-		DecompPtr++;
-
-		/*
-		 *  Left pixel of the first byte in a scanline is zero.
-		 */
-
-		PixelLeft = Zeros;
-
-		/*
-		 *  Set PixelUp to previous line only if we are on the second line or above.
-		 *
-		 *  Plus one byte for the FilterType
-		 */
-
-		if(h > 0)
-		{
-			PixelUp = DecompPtr - (BytesPerScanline + 1);
-		}
-		else
+		if(!UnfilterScanline(DecompPtr[0], DecompPtr + 1, h ? DecompPtr + 1 - (BytesPerScanline + 1) : NULL,
+					BytesPerScanline, BytesPerPixel))
 		{
-			PixelUp = Zeros;
+			return(qfalse);
 		}
 
-		/*
-		 * The pixel left to the first pixel of the previous scanline is zero too.
-		 */
-
-		PixelUpLeft = Zeros;
-
-		/*
-		 *  Cycle trough all pixels of the scanline.
-		 */
+		DecompPtr += BytesPerScanline + 1;
+	}
 
-		for(w = 0; w < (BytesPerScanline / BytesPerPixel); w++)
-		{
-			/*
-			 *  Cycle trough the bytes of the pixel.
-			 */
+	return(qtrue);
+}
 
-			for(p = 0; p < BytesPerPixel; p++)
-			{
-				switch(FilterType)
-				{ 
-					case PNG_FilterType_None :
-					{
-						/*
-						 *  The byte is unfiltered.
-						 */
+/*
+ *  Decode a non-interlaced 8 bit True or TrueAlpha image while it is
+ *  being inflated.  The scanlines are unfiltered right in OutBuffer,
+ *  or for True in a pair of scanline buffers, so the whole decompressed
+ *  image never exists at once.
+ */
 
-						break;
-					}
+static qboolean DecodeImageStreamed(struct PNG_Chunk_IHDR *IHDR,
+		struct BufferedFile   *BF,
+		byte                  *OutBuffer,
+		qboolean               HasTransparentColour,
+		uint8_t               *TransparentColour)
+{
+	struct PNG_Inflater Inf;
+	uint32_t IHDR_Width;
+	uint32_t IHDR_Height;
+	uint32_t BytesPerPixel, BytesPerScanline;
+	uint32_t w, h;
+	uint8_t FilterType;
+	uint8_t *Rows, *Row, *Prev;
+	byte *OutPtr;
 
-					case PNG_FilterType_Sub :
-					{
-						DecompPtr[p] += PixelLeft[p];
+	IHDR_Width  = BigLong(IHDR->Width);
+	IHDR_Height = BigLong(IHDR->Height);
 
-						break;
-					}
+	BytesPerPixel    = (IHDR->ColourType == PNG_ColourType_TrueAlpha) ? PNG_NumColourComponents_TrueAlpha : PNG_NumColourComponents_True;
+	BytesPerScanline = IHDR_Width * BytesPerPixel;
 
-					case PNG_FilterType_Up :
-					{
-						DecompPtr[p] += PixelUp[p];
+	Rows = NULL;
+	if(BytesPerPixel != Q3IMAGE_BYTESPERPIXEL)
+	{
+		Rows = (uint8_t*)R_ImageMalloc(2 * BytesPerScanline);
+		if(!Rows)
+		{
+			return(qfalse);
+		}
+	}
 
-						break;
-					}
+	if(!InflaterInit(&Inf, BF))
+	{
+		if(Rows)
+		{
+			R_ImageFree(Rows);
+		}
 
-					case PNG_FilterType_Average :
-					{
-						DecompPtr[p] += ((uint8_t) ((((uint16_t) PixelLeft[p]) + ((uint16_t) PixelUp[p])) / 2));
+		return(qfalse);
+	}
 
-						break;
-					}
+	Prev = NULL;
 
-					case PNG_FilterType_Paeth :
-					{
-						DecompPtr[p] += PredictPaeth(PixelLeft[p], PixelUp[p], PixelUpLeft[p]);
+	for(h = 0; h < IHDR_Height; h++)
+	{
+		OutPtr = OutBuffer + h * IHDR_Width * Q3IMAGE_BYTESPERPIXEL;
+		Row = Rows ? Rows + (h & 1) * BytesPerScanline : OutPtr;
 
-						break;
-					}
+		if(!(InflaterRead(&Inf, &FilterType, 1) && InflaterRead(&Inf, Row, BytesPerScanline) &&
+					UnfilterScanline(FilterType, Row, Prev, BytesPerScanline, BytesPerPixel)))
+		{
+			break;
+		}
 
-					default :
-					{
-						return(qfalse);
-					}
-				}
-			}
+		Prev = Row;
 
-			PixelLeft = DecompPtr;
+		if(!Rows)
+		{
+			continue;
+		}
 
-			/*
-			 *  We only have an upleft pixel if we are on the second line or above.
-			 */
+		/*
+		 *  True supports full transparency for one specified colour
+		 */
 
-			if(h > 0)
+		for(w = 0; w < IHDR_Width; w++, Row += 3, OutPtr += Q3IMAGE_BYTESPERPIXEL)
+		{
+			OutPtr[0] = Row[0];
+			OutPtr[1] = Row[1];
+			OutPtr[2] = Row[2];
+			OutPtr[3] = 0xFF;
+
+			if(HasTransparentColour &&
+					(TransparentColour[1] == Row[0]) &&
+					(TransparentColour[3] == Row[1]) &&
+					(TransparentColour[5] == Row[2]))
 			{
-				PixelUpLeft = DecompPtr - (BytesPerScanline + 1);
+				OutPtr[3] = 0x00;
 			}
+		}
+	}
 
-			/*
-			 *  Skip to the next pixel.
-			 */
-
-			DecompPtr += BytesPerPixel;
+	if(Rows)
+	{
+		R_ImageFree(Rows);
+	}
 
-			/*
-			 *  We only have a previous line if we are on the second line and above.
-			 */
+	if(!((h == IHDR_Height) && InflaterFinish(&Inf)))
+	{
+		InflaterEnd(&Inf);
 
-			if(h > 0)
-			{
-				PixelUp = DecompPtr - (BytesPerScanline + 1);
-			}
-		}
+		return(qfalse);
 	}
 
+	InflaterEnd(&Inf);
+
 	return(qtrue);
 }
 
@@ -2063,7 +2360,7 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 	{
 		CloseBufferedFile(ThePNG);
 
-		ri.Printf( PRINT_WARNING, "%s: invalid image size\n", name );
+		R_ImagePrintf( PRINT_WARNING, "%s: invalid image size\n", name );
 
 		return; 
 	}
@@ -2387,7 +2684,48 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 	 *  Decompress all IDAT chunks
 	 */
 
-	DecompressedDataLength = DecompressIDATs(ThePNG, &DecompressedData);
+	/*
+	 *  The common 8 bit True and TrueAlpha images are decoded
+	 *  while they are being inflated.
+	 */
+
+	if(!pngReference && (IHDR->InterlaceMethod == PNG_InterlaceMethod_NonInterlaced) && (IHDR->BitDepth == PNG_BitDepth_8) &&
+			((IHDR->ColourType == PNG_ColourType_True) || (IHDR->ColourType == PNG_ColourType_TrueAlpha)))
+	{
+		OutBuffer = (byte*)R_ImageMalloc(IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL);
+		if(!OutBuffer)
+		{
+			CloseBufferedFile(ThePNG);
+
+			return;
+		}
+
+		if(!DecodeImageStreamed(IHDR, ThePNG, OutBuffer, HasTransparentColour, TransparentColour))
+		{
+			R_ImageFree(OutBuffer);
+			CloseBufferedFile(ThePNG);
+
+			return;
+		}
+
+		*pic = OutBuffer;
+
+		if(width)
+		{
+			*width = IHDR_Width;
+		}
+
+		if(height)
+		{
+			*height = IHDR_Height;
+		}
+
+		CloseBufferedFile(ThePNG);
+
+		return;
+	}
+
+	DecompressedDataLength = DecompressIDATs(IHDR, ThePNG, &DecompressedData);
 	if(!(DecompressedDataLength && DecompressedData))
 	{
 		CloseBufferedFile(ThePNG);
@@ -2399,10 +2737,10 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 	 *  Allocate output buffer.
 	 */
 
-	OutBuffer = (byte*)ri.Malloc(IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL); 
+	OutBuffer = (byte*)R_ImageMalloc(IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL); 
 	if(!OutBuffer)
 	{
-		ri.Free(DecompressedData); 
+		R_ImageFree(DecompressedData); 
 		CloseBufferedFile(ThePNG);
 
 		return;  
@@ -2418,8 +2756,8 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 		{
 			if(!DecodeImageNonInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
 			{
-				ri.Free(OutBuffer); 
-				ri.Free(DecompressedData); 
+				R_ImageFree(OutBuffer); 
+				R_ImageFree(DecompressedData); 
 				CloseBufferedFile(ThePNG);
 
 				return;
@@ -2432,8 +2770,8 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 		{
 			if(!DecodeImageInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
 			{
-				ri.Free(OutBuffer); 
-				ri.Free(DecompressedData); 
+				R_ImageFree(OutBuffer); 
+				R_ImageFree(DecompressedData); 
 				CloseBufferedFile(ThePNG);
 
 				return;
@@ -2444,8 +2782,8 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 
 		default :
 		{
-			ri.Free(OutBuffer); 
-			ri.Free(DecompressedData); 
+			R_ImageFree(OutBuffer); 
+			R_ImageFree(DecompressedData); 
 			CloseBufferedFile(ThePNG);
 
 			return;
@@ -2476,7 +2814,7 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 	 *  DecompressedData is not needed anymore.
 	 */
 
-	ri.Free(DecompressedData); 
+	R_ImageFree(DecompressedData); 
 
 	/*
 	 *  We have all data, so close the file.
@@ -2484,3 +2822,153 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 
 	CloseBufferedFile(ThePNG);
 }
+
+/*
+ *  r_pngBench [dir] [rounds]
+ *
+ *  Decodes every PNG below dir, textures by default, with the reference
+ *  path and the default one, reports images that come out differently
+ *  and the time each path took.  Both read the files the same way, so
+ *  the difference is the decoding.
+ */
+
+#define PNG_BENCH_MAX_FILES (4096)
+#define PNG_BENCH_MAX_DEPTH (4)
+
+static int R_PNGBenchList(const char *dir, int depth, char (*names)[MAX_QPATH], int numNames)
+{
+	char **list;
+	char sub[MAX_QPATH];
+	int n, i, len;
+
+	list = ri.FS_ListFiles(dir, ".png", &n);
+	for(i = 0; i < n && numNames < PNG_BENCH_MAX_FILES; i++)
+	{
+		Com_sprintf(names[numNames++], MAX_QPATH, "%s/%s", dir, list[i]);
+	}
+	ri.FS_FreeFileList(list);
+
+	if(depth == PNG_BENCH_MAX_DEPTH)
+	{
+		return(numNames);
+	}
+
+	list = ri.FS_ListFiles(dir, "/", &n);
+	for(i = 0; i < n && numNames < PNG_BENCH_MAX_FILES; i++)
+	{
+		if(!strcmp(list[i], ".") || !strcmp(list[i], "..") || !list[i][0])
+		{
+			continue;
+		}
+
+		Com_sprintf(sub, sizeof(sub), "%s/%s", dir, list[i]);
+		len = strlen(sub);
+		if(sub[len - 1] == '/')
+		{
+			sub[len - 1] = '\0';
+		}
+
+		numNames = R_PNGBenchList(sub, depth + 1, names, numNames);
+	}
+	ri.FS_FreeFileList(list);
+
+	return(numNames);
+}
+
+void R_PNGBench_f(void)
+{
+	char (*names)[MAX_QPATH];
+	const char *dir;
+	byte *pic[2];
+	int width[2], height[2];
+	int numNames, rounds, failed, mismatches, round, path, i;
+	int64_t usec[2] = {0, 0};
+	int64_t start;
+
+	dir = ri.Cmd_Argc() > 1 ? ri.Cmd_Argv(1) : "textures";
+	rounds = ri.Cmd_Argc() > 2 ? atoi(ri.Cmd_Argv(2)) : 5;
+	rounds = MAX(rounds, 1);
+
+	names = (char (*)[MAX_QPATH])ri.Malloc(PNG_BENCH_MAX_FILES * MAX_QPATH);
+	numNames = R_PNGBenchList(dir, 0, names, 0);
+	if(!numNames)
+	{
+		ri.Printf(PRINT_ALL, "no PNGs below %s\n", dir);
+		ri.Free(names);
+		return;
+	}
+
+	/*
+	 *  Both paths must give the same pixels.
+	 */
+
+	failed = mismatches = 0;
+	for(i = 0; i < numNames; i++)
+	{
+		for(path = 0; path < 2; path++)
+		{
+			pngReference = (qboolean)(path == 0);
+			R_LoadPNG(names[i], &pic[path], &width[path], &height[path]);
+		}
+
+		if(!pic[0] || !pic[1])
+		{
+			if(pic[0] || pic[1])
+			{
+				ri.Printf(PRINT_WARNING, "%s: only decoded by the %s path\n", names[i], pic[0] ? "reference" : "default");
+				mismatches++;
+			}
+			else
+			{
+				failed++;
+			}
+		}
+		else if(width[0] != width[1] || height[0] != height[1] ||
+				memcmp(pic[0], pic[1], width[0] * height[0] * Q3IMAGE_BYTESPERPIXEL))
+		{
+			ri.Printf(PRINT_WARNING, "%s: the paths decode differently\n", names[i]);
+			mismatches++;
+		}
+
+		for(path = 0; path < 2; path++)
+		{
+			if(pic[path])
+			{
+				R_ImageFree(pic[path]);
+			}
+		}
+	}
+
+	/*
+	 *  Alternate the paths each round, so neither always has the
+	 *  warmer cache.
+	 */
+
+	for(round = 0; round < rounds; round++)
+	{
+		for(path = 0; path < 2; path++)
+		{
+			pngReference = (qboolean)((path ^ round) & 1);
+			start = ri.Microseconds();
+
+			for(i = 0; i < numNames; i++)
+			{
+				R_LoadPNG(names[i], &pic[0], NULL, NULL);
+				if(pic[0])
+				{
+					R_ImageFree(pic[0]);
+				}
+			}
+
+			usec[pngReference ? 0 : 1] += ri.Microseconds() - start;
+		}
+	}
+
+	pngReference = qfalse;
+	ri.Free(names);
+
+	ri.Printf(PRINT_ALL, "%i PNGs below %s, %i rounds, %i failed to decode, %i differ\n",
+			numNames, dir, rounds, failed, mismatches);
+	ri.Printf(PRINT_ALL, "reference: %8.1f msec\n", usec[0] / 1000.0);
+	ri.Printf(PRINT_ALL, "default:   %8.1f msec\n", usec[1] / 1000.0);
+}
@@ -65,14 +65,14 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	//
 	// load the file
 	//
-	length = ri.FS_ReadFile ( ( char * ) name, &buffer.v);
+	length = R_ReadImageFile ( ( char * ) name, &buffer.v);
 	if (!buffer.b || length < 0) {
 		return;
 	}
 
 	if(length < 18)
 	{
-		ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+		R_ImageError( ERR_DROP, "LoadTGA: header too short (%s)", name );
 	}
 
 	buf_p = buffer.b;
@@ -105,17 +105,17 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 		&& targa_header.image_type!=10
 		&& targa_header.image_type != 3 ) 
 	{
-		ri.Error (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported");
+		R_ImageError (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported");
 	}
 
 	if ( targa_header.colormap_type != 0 )
 	{
-		ri.Error( ERR_DROP, "LoadTGA: colormaps not supported" );
+		R_ImageError( ERR_DROP, "LoadTGA: colormaps not supported" );
 	}
 
 	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
 	{
-		ri.Error (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
+		R_ImageError (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
 	}
 
 	columns = targa_header.width;
@@ -124,16 +124,16 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
 	if(!columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows)
 	{
-		ri.Error (ERR_DROP, "LoadTGA: %s has an invalid image size", name);
+		R_ImageError (ERR_DROP, "LoadTGA: %s has an invalid image size", name);
 	}
 
 
-	targa_rgba = (byte*)ri.Malloc (numPixels);
+	targa_rgba = (byte*)R_ImageMalloc (numPixels);
 
 	if (targa_header.id_length != 0)
 	{
 		if (buf_p + targa_header.id_length > end)
-			ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+			R_ImageError( ERR_DROP, "LoadTGA: header too short (%s)", name );
 
 		buf_p += targa_header.id_length;  // skip TARGA image comment
 	}
@@ -142,7 +142,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	{ 
 		if(buf_p + columns*rows*targa_header.pixel_size/8 > end)
 		{
-			ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+			R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
 		}
 
 		// Uncompressed RGB or gray scale image
@@ -185,7 +185,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 					*pixbuf++ = alphabyte;
 					break;
 				default:
-					ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+					R_ImageError( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 					break;
 				}
 			}
@@ -198,12 +198,12 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 			pixbuf = targa_rgba + row*columns*4;
 			for(column=0; column<columns; ) {
 				if(buf_p + 1 > end)
-					ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+					R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
 				packetHeader= *buf_p++;
 				packetSize = 1 + (packetHeader & 0x7f);
 				if (packetHeader & 0x80) {        // run-length packet
 					if(buf_p + targa_header.pixel_size/8 > end)
-						ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+						R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
 					switch (targa_header.pixel_size) {
 						case 24:
 								blue = *buf_p++;
@@ -218,7 +218,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 								alphabyte = *buf_p++;
 								break;
 						default:
-							ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+							R_ImageError( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 							break;
 					}
 	
@@ -241,7 +241,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 				else {                            // non run-length packet
 
 					if(buf_p + targa_header.pixel_size/8*packetSize > end)
-						ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+						R_ImageError (ERR_DROP, "LoadTGA: file truncated (%s)", name);
 					for(j=0;j<packetSize;j++) {
 						switch (targa_header.pixel_size) {
 							case 24:
@@ -264,7 +264,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 									*pixbuf++ = alphabyte;
 									break;
 							default:
-								ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+								R_ImageError( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 								break;
 						}
 						column++;
@@ -303,7 +303,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 #endif
   // instead we just print a warning
   if (targa_header.attributes & 0x20) {
-    ri.Printf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
+    R_ImagePrintf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
   }
 
   if (width)
@@ -313,5 +313,5 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
   *pic = targa_rgba;
 
-  ri.FS_FreeFile (buffer.v);
+  R_FreeImageFile (buffer.v);
 }
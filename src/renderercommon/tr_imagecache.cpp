@@ -0,0 +1,519 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+// tr_imagecache.cpp -- images as they are handed to GL, kept in the
+// homepath so the next run can skip decoding, resampling and mipping
+
+#include "tr_common.h"
+
+#define IMAGECACHE_DIR		"imagecache"
+#define IMAGECACHE_INDEX	IMAGECACHE_DIR "/index.dat"
+#define IMAGECACHE_IDENT	(('E'<<24)+('H'<<16)+('C'<<8)+'I')
+#define IMAGECACHE_VERSION	1
+
+#define MAX_CACHED_IMAGES	4096
+#define MAX_CACHED_LEVELS	16
+#define CACHED_HASH_SIZE	1024
+
+// the index, followed by numEntries cachedImageEntry_t
+typedef struct {
+	int			ident;
+	int			version;
+	int			sequence;		// bumped every time the cache is opened
+	int			numEntries;
+} imageCacheIndex_t;
+
+typedef struct {
+	uint64_t	key;
+	int			size;
+	int			lastUsed;		// sequence it was last loaded or saved in
+} cachedImageEntry_t;
+
+// at the start of every cached image, followed by the levels, largest
+// first, 4 bytes per texel
+typedef struct {
+	int			ident;
+	int			version;
+	uint64_t	key;
+	int			width, height;
+	int			uploadWidth, uploadHeight;
+	int			internalFormat;
+	int			numLevels;
+	int			scaled;
+	int			pad;
+} cachedImageHeader_t;
+
+static bool					cacheOpened;
+static bool					cacheEnabled;
+static bool					cacheDirty;
+static uint64_t				cacheSettingsKey;
+static int					cacheSequence;
+
+static cachedImageEntry_t	cacheEntries[MAX_CACHED_IMAGES];
+static int					cacheNext[MAX_CACHED_IMAGES];
+static int					cacheHash[CACHED_HASH_SIZE];
+static int					numCacheEntries;
+static int64_t				cacheBytes;
+
+static int					cacheHits, cacheMisses;
+
+/*
+================
+R_HashBytes
+================
+*/
+static uint64_t R_HashBytes( uint64_t hash, const void *data, size_t len ) {
+	const byte	*b = (const byte *)data;
+	size_t		i;
+
+	for ( i = 0 ; i < len ; i++ ) {
+		hash = ( hash ^ b[i] ) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/*
+================
+R_CachedImagePath
+================
+*/
+static const char *R_CachedImagePath( uint64_t key ) {
+	return va( "%s/%016llx.dat", IMAGECACHE_DIR, (unsigned long long)key );
+}
+
+/*
+================
+R_CachedImageSize
+
+Bytes taken by the levels, or -1 if the sizes make no sense
+================
+*/
+static int R_CachedImageSize( int width, int height, int numLevels ) {
+	int64_t	size;
+	int		i;
+
+	if ( width < 1 || height < 1 || width > 16384 || height > 16384 ||
+		numLevels < 1 || numLevels > MAX_CACHED_LEVELS ) {
+		return -1;
+	}
+
+	size = 0;
+	for ( i = 0 ; i < numLevels ; i++ ) {
+		size += (int64_t)width * height * 4;
+		width = MAX( 1, width >> 1 );
+		height = MAX( 1, height >> 1 );
+	}
+
+	if ( size > 0x40000000 ) {
+		return -1;
+	}
+	return (int)size;
+}
+
+/*
+================
+R_RebuildImageCacheHash
+================
+*/
+static void R_RebuildImageCacheHash( void ) {
+	int		i, hash;
+
+	for ( i = 0 ; i < CACHED_HASH_SIZE ; i++ ) {
+		cacheHash[i] = -1;
+	}
+
+	cacheBytes = 0;
+	for ( i = 0 ; i < numCacheEntries ; i++ ) {
+		hash = cacheEntries[i].key & ( CACHED_HASH_SIZE - 1 );
+		cacheNext[i] = cacheHash[hash];
+		cacheHash[hash] = i;
+		cacheBytes += cacheEntries[i].size;
+	}
+}
+
+/*
+================
+R_FindCachedImage
+================
+*/
+static int R_FindCachedImage( uint64_t key ) {
+	int		i;
+
+	for ( i = cacheHash[key & ( CACHED_HASH_SIZE - 1 )] ; i != -1 ; i = cacheNext[i] ) {
+		if ( cacheEntries[i].key == key ) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+================
+R_DropCachedImage
+
+Deletes the file and forgets the entry.  The hash has to be rebuilt
+before the next lookup.
+================
+*/
+static void R_DropCachedImage( int i ) {
+	ri.FS_HomeRemove( R_CachedImagePath( cacheEntries[i].key ) );
+
+	cacheEntries[i] = cacheEntries[--numCacheEntries];
+	cacheDirty = true;
+}
+
+/*
+================
+R_TrimImageCache
+
+Drops the least recently used images until the cache is within
+r_imageCacheSize and has room for another entry
+================
+*/
+static void R_TrimImageCache( void ) {
+	int64_t	limit;
+	int		i, oldest;
+	bool	dropped;
+
+	limit = (int64_t)MAX( 0, r_imageCacheSize->integer ) * 1024 * 1024;
+
+	dropped = false;
+	while ( numCacheEntries && ( cacheBytes > limit || numCacheEntries == MAX_CACHED_IMAGES ) ) {
+		oldest = 0;
+		for ( i = 1 ; i < numCacheEntries ; i++ ) {
+			if ( cacheEntries[i].lastUsed < cacheEntries[oldest].lastUsed ) {
+				oldest = i;
+			}
+		}
+
+		cacheBytes -= cacheEntries[oldest].size;
+		R_DropCachedImage( oldest );
+		dropped = true;
+	}
+
+	if ( dropped ) {
+		R_RebuildImageCacheHash();
+	}
+}
+
+/*
+================
+R_OpenImageCache
+
+Reads the index, and deletes any cached image it does not know about,
+left behind by a run that did not get to save it
+================
+*/
+static void R_OpenImageCache( void ) {
+	imageCacheIndex_t	index;
+	byte		*buf;
+	char		**files;
+	long		length;
+	int			i, numFiles;
+	uint64_t	key;
+
+	cacheOpened = true;
+	numCacheEntries = 0;
+	cacheSequence = 1;
+
+	length = ri.FS_ReadFile( IMAGECACHE_INDEX, (void **)&buf );
+	if ( buf ) {
+		if ( length >= (long)sizeof( index ) ) {
+			Com_Memcpy( &index, buf, sizeof( index ) );
+			if ( index.ident == IMAGECACHE_IDENT && index.version == IMAGECACHE_VERSION &&
+				index.numEntries >= 0 && index.numEntries <= MAX_CACHED_IMAGES &&
+				length == (long)sizeof( index ) + index.numEntries * (long)sizeof( cachedImageEntry_t ) ) {
+				numCacheEntries = index.numEntries;
+				Com_Memcpy( cacheEntries, buf + sizeof( index ), numCacheEntries * sizeof( cachedImageEntry_t ) );
+				cacheSequence = index.sequence + 1;
+			}
+		}
+		ri.FS_FreeFile( buf );
+	}
+
+	R_RebuildImageCacheHash();
+
+	files = ri.FS_ListFiles( IMAGECACHE_DIR, "dat", &numFiles );
+	for ( i = 0 ; i < numFiles ; i++ ) {
+		if ( !Q_stricmp( files[i], "index.dat" ) ) {
+			continue;
+		}
+
+		key = strtoull( files[i], NULL, 16 );
+		if ( R_FindCachedImage( key ) == -1 ) {
+			ri.FS_HomeRemove( va( "%s/%s", IMAGECACHE_DIR, files[i] ) );
+		}
+	}
+	ri.FS_FreeFileList( files );
+
+	// the index changes on disk even if nothing is used, for the sequence
+	cacheDirty = true;
+
+	ri.Printf( PRINT_DEVELOPER, "...%i images in %s, %iMB\n", numCacheEntries, IMAGECACHE_DIR, (int)( cacheBytes >> 20 ) );
+}
+
+/*
+================
+R_InitImageCache
+
+settings is everything besides the source file that changes what the
+renderer uploads for an image; NULL turns the cache off
+================
+*/
+void R_InitImageCache( const void *settings, int settingsSize ) {
+	cacheHits = cacheMisses = 0;
+
+	cacheEnabled = settings && r_imageCache->integer;
+	if ( !cacheEnabled ) {
+		return;
+	}
+
+	cacheSettingsKey = R_HashBytes( 14695981039346656037ULL, settings, settingsSize );
+
+	if ( !cacheOpened ) {
+		R_OpenImageCache();
+	}
+}
+
+/*
+================
+R_ImageCacheKey
+
+Returns false if the image can't be cached: it isn't a file, or the
+file isn't in a pak, since loose files can change without anything
+here noticing
+================
+*/
+bool R_ImageCacheKey( const char *name, imgType_t type, int/*imgFlags_t*/ flags, uint64_t *key ) {
+	char		fileName[MAX_QPATH];
+	int			loader, values[4];
+	bool		renamed;
+	uint64_t	hash;
+
+	if ( !cacheEnabled || !r_imageCache->integer ) {
+		return false;
+	}
+
+	if ( !name || !name[0] || name[0] == '*' ) {
+		return false;
+	}
+
+	if ( !R_FindImageSource( name, fileName, sizeof( fileName ), &loader, &renamed ) ) {
+		return false;
+	}
+
+	if ( ri.FS_FileIsInPAK( fileName, &values[0] ) != 1 ) {
+		return false;
+	}
+	values[1] = ri.FS_ReadFile( fileName, NULL );
+	values[2] = type;
+	values[3] = flags;
+
+	hash = R_HashBytes( cacheSettingsKey, name, strlen( name ) + 1 );
+	hash = R_HashBytes( hash, fileName, strlen( fileName ) + 1 );
+	hash = R_HashBytes( hash, values, sizeof( values ) );
+
+	*key = hash;
+	return true;
+}
+
+/*
+================
+R_ImageCached
+================
+*/
+bool R_ImageCached( uint64_t key ) {
+	return R_FindCachedImage( key ) != -1;
+}
+
+/*
+================
+R_LoadCachedImage
+
+Fills in the size, format and levels of job from the cache, as the
+renderer's prepare function would have.  The levels point into *buf,
+which the caller frees with ri.FS_FreeFile once they are uploaded.
+================
+*/
+bool R_LoadCachedImage( uint64_t key, imageJob_t *job, void **buf ) {
+	cachedImageHeader_t	header;
+	byte	*data;
+	long	length;
+	int		i;
+
+	*buf = NULL;
+
+	i = R_FindCachedImage( key );
+	if ( i == -1 ) {
+		cacheMisses++;
+		return false;
+	}
+
+	length = ri.FS_ReadFile( R_CachedImagePath( key ), (void **)&data );
+	if ( !data ) {
+		cacheMisses++;
+		R_DropCachedImage( i );
+		R_RebuildImageCacheHash();
+		return false;
+	}
+
+	if ( length >= (long)sizeof( header ) ) {
+		Com_Memcpy( &header, data, sizeof( header ) );
+	} else {
+		Com_Memset( &header, 0, sizeof( header ) );
+	}
+
+	if ( header.ident != IMAGECACHE_IDENT || header.version != IMAGECACHE_VERSION || header.key != key ||
+		header.width < 1 || header.height < 1 ||
+		length != (long)sizeof( header ) + R_CachedImageSize( header.uploadWidth, header.uploadHeight, header.numLevels ) ) {
+		ri.FS_FreeFile( data );
+		cacheMisses++;
+		R_DropCachedImage( i );
+		R_RebuildImageCacheHash();
+		return false;
+	}
+
+	job->width = header.width;
+	job->height = header.height;
+	job->uploadWidth = header.uploadWidth;
+	job->uploadHeight = header.uploadHeight;
+	job->internalFormat = header.internalFormat;
+	job->numLevels = header.numLevels;
+	job->scaled = header.scaled != 0;
+	job->upload = data + sizeof( header );
+	job->prepared = true;
+
+	cacheEntries[i].lastUsed = cacheSequence;
+	cacheDirty = true;
+	cacheHits++;
+
+	*buf = data;
+	return true;
+}
+
+/*
+================
+R_SaveCachedImage
+
+Writes out the levels of a prepared job
+================
+*/
+void R_SaveCachedImage( uint64_t key, const imageJob_t *job ) {
+	cachedImageHeader_t	header;
+	byte	*buf;
+	int		i, size, hash;
+
+	if ( !cacheEnabled || !r_imageCache->integer || !job->prepared ) {
+		return;
+	}
+
+	size = R_CachedImageSize( job->uploadWidth, job->uploadHeight, job->numLevels );
+	if ( size < 0 || size > (int64_t)r_imageCacheSize->integer * 1024 * 1024 ) {
+		return;
+	}
+
+	Com_Memset( &header, 0, sizeof( header ) );
+	header.ident = IMAGECACHE_IDENT;
+	header.version = IMAGECACHE_VERSION;
+	header.key = key;
+	header.width = job->width;
+	header.height = job->height;
+	header.uploadWidth = job->uploadWidth;
+	header.uploadHeight = job->uploadHeight;
+	header.internalFormat = job->internalFormat;
+	header.numLevels = job->numLevels;
+	header.scaled = job->scaled;
+
+	buf = (byte *)ri.Hunk_AllocateTempMemory( sizeof( header ) + size );
+	Com_Memcpy( buf, &header, sizeof( header ) );
+	Com_Memcpy( buf + sizeof( header ), job->upload, size );
+	ri.FS_WriteFile( R_CachedImagePath( key ), buf, sizeof( header ) + size );
+	ri.Hunk_FreeTempMemory( buf );
+
+	i = R_FindCachedImage( key );
+	if ( i != -1 ) {
+		cacheBytes += size - cacheEntries[i].size;
+	} else {
+		if ( numCacheEntries == MAX_CACHED_IMAGES ) {
+			R_TrimImageCache();
+		}
+
+		i = numCacheEntries++;
+		cacheEntries[i].key = key;
+		hash = key & ( CACHED_HASH_SIZE - 1 );
+		cacheNext[i] = cacheHash[hash];
+		cacheHash[hash] = i;
+		cacheBytes += size;
+	}
+	cacheEntries[i].size = size;
+	cacheEntries[i].lastUsed = cacheSequence;
+	cacheDirty = true;
+
+	R_TrimImageCache();
+}
+
+/*
+================
+R_SaveImageCacheIndex
+================
+*/
+void R_SaveImageCacheIndex( void ) {
+	imageCacheIndex_t	index;
+	byte	*buf;
+	int		length;
+
+	if ( !cacheOpened || !cacheDirty ) {
+		return;
+	}
+
+	index.ident = IMAGECACHE_IDENT;
+	index.version = IMAGECACHE_VERSION;
+	index.sequence = cacheSequence;
+	index.numEntries = numCacheEntries;
+
+	length = sizeof( index ) + numCacheEntries * sizeof( cachedImageEntry_t );
+	buf = (byte *)ri.Hunk_AllocateTempMemory( length );
+	Com_Memcpy( buf, &index, sizeof( index ) );
+	Com_Memcpy( buf + sizeof( index ), cacheEntries, numCacheEntries * sizeof( cachedImageEntry_t ) );
+	ri.FS_WriteFile( IMAGECACHE_INDEX, buf, length );
+	ri.Hunk_FreeTempMemory( buf );
+
+	cacheDirty = false;
+}
+
+/*
+================
+R_ImageCacheInfo
+
+The imagelist footer
+================
+*/
+void R_ImageCacheInfo( void ) {
+	if ( !cacheEnabled ) {
+		ri.Printf( PRINT_ALL, " image cache off\n\n" );
+		return;
+	}
+
+	ri.Printf( PRINT_ALL, " image cache: %i hits, %i misses, %i images, %iMB of %iMB\n\n",
+			cacheHits, cacheMisses, numCacheEntries, (int)( cacheBytes >> 20 ), r_imageCacheSize->integer );
+}
@@ -0,0 +1,578 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+// tr_imagejobs.cpp -- decoding requested images on the job threads
+
+#include <setjmp.h>
+
+#include "tr_common.h"
+
+#define MAX_IMAGE_JOBS		1024
+#define IMAGE_JOB_BATCH		32		// decoded at a time, bounds the memory held
+#define IMAGE_JOB_HASH_SIZE	256
+
+typedef enum {
+	IMAGEJOB_QUEUED,
+	IMAGEJOB_DONE,
+	IMAGEJOB_RELEASED
+} imageJobState_t;
+
+// every allocation made on a job is linked to it, so an abandoned job
+// can be cleaned up and a finished one released in one go
+typedef struct jobBlock_s {
+	struct jobBlock_s	*prev, *next;
+} jobBlock_t;
+
+#define JOB_BLOCK_SIZE	( ( sizeof( jobBlock_t ) + 15 ) & ~15 )
+
+static imageJob_t	imageJobs[MAX_IMAGE_JOBS];
+static int			numImageJobs;
+static imageJob_t	*imageJobHash[IMAGE_JOB_HASH_SIZE];
+
+static const imageExtToLoaderMap_t	*jobLoaders;
+static int			numJobLoaders;
+static void			(*jobPrepare)( imageJob_t *job );
+
+static thread_local imageJob_t	*currentJob;
+static thread_local jmp_buf		*currentAbort;
+
+static int			jobBatches, jobsRun, jobsFallenBack, jobMsec;
+
+/*
+================
+R_JobHash
+================
+*/
+static int R_JobHash( const char *name ) {
+	unsigned	hash;
+
+	for ( hash = 0 ; *name ; name++ ) {
+		hash = hash * 31 + tolower( *name );
+	}
+	return hash & ( IMAGE_JOB_HASH_SIZE - 1 );
+}
+
+/*
+================
+R_AbortImageJob
+================
+*/
+static void R_AbortImageJob( void ) {
+	currentJob->failed = true;
+	longjmp( *currentAbort, 1 );
+}
+
+/*
+================
+R_JobAlloc
+================
+*/
+static void *R_JobAlloc( int size ) {
+	jobBlock_t	*block, *head;
+
+	block = (jobBlock_t *)malloc( JOB_BLOCK_SIZE + size );
+	if ( !block ) {
+		R_AbortImageJob();
+	}
+
+	head = (jobBlock_t *)currentJob->blocks;
+	block->prev = NULL;
+	block->next = head;
+	if ( head ) {
+		head->prev = block;
+	}
+	currentJob->blocks = block;
+
+	return (byte *)block + JOB_BLOCK_SIZE;
+}
+
+/*
+================
+R_JobFree
+================
+*/
+static void R_JobFree( imageJob_t *job, void *ptr ) {
+	jobBlock_t	*block;
+
+	if ( !ptr ) {
+		return;
+	}
+
+	block = (jobBlock_t *)( (byte *)ptr - JOB_BLOCK_SIZE );
+	if ( block->prev ) {
+		block->prev->next = block->next;
+	} else {
+		job->blocks = block->next;
+	}
+	if ( block->next ) {
+		block->next->prev = block->prev;
+	}
+	free( block );
+}
+
+/*
+================
+R_ReadImageFile
+
+A job can only see the file read for it
+================
+*/
+long R_ReadImageFile( const char *name, void **buf ) {
+	if ( !currentJob ) {
+		return ri.FS_ReadFile( name, buf );
+	}
+
+	if ( strcmp( name, currentJob->fileName ) ) {
+		if ( buf ) {
+			*buf = NULL;
+		}
+		return -1;
+	}
+
+	if ( buf ) {
+		*buf = currentJob->file;
+	}
+	return currentJob->fileLength;
+}
+
+/*
+================
+R_FreeImageFile
+================
+*/
+void R_FreeImageFile( void *buf ) {
+	// the main thread frees a job's file once the batch is done
+	if ( !currentJob ) {
+		ri.FS_FreeFile( buf );
+	}
+}
+
+/*
+================
+R_ImageMalloc
+================
+*/
+void *R_ImageMalloc( int size ) {
+	if ( currentJob ) {
+		return R_JobAlloc( size );
+	}
+	return ri.Malloc( size );
+}
+
+/*
+================
+R_ImageFree
+================
+*/
+void R_ImageFree( void *ptr ) {
+	if ( currentJob ) {
+		R_JobFree( currentJob, ptr );
+		return;
+	}
+	ri.Free( ptr );
+}
+
+/*
+================
+R_ImageTempAlloc
+================
+*/
+void *R_ImageTempAlloc( int size ) {
+	if ( currentJob ) {
+		return R_JobAlloc( size );
+	}
+	return ri.Hunk_AllocateTempMemory( size );
+}
+
+/*
+================
+R_ImageTempFree
+================
+*/
+void R_ImageTempFree( void *ptr ) {
+	if ( currentJob ) {
+		R_JobFree( currentJob, ptr );
+		return;
+	}
+	ri.Hunk_FreeTempMemory( ptr );
+}
+
+/*
+================
+R_ImagePrintf
+================
+*/
+void QDECL R_ImagePrintf( int printLevel, const char *fmt, ... ) {
+	va_list		argptr;
+	char		msg[1024];
+
+	if ( currentJob ) {
+		// let the main thread load it again and say it
+		currentJob->failed = true;
+		return;
+	}
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	va_end( argptr );
+
+	ri.Printf( printLevel, "%s", msg );
+}
+
+/*
+================
+R_ImageError
+================
+*/
+void QDECL R_ImageError( int errorLevel, const char *fmt, ... ) {
+	va_list		argptr;
+	char		msg[1024];
+
+	if ( currentJob ) {
+		R_AbortImageJob();
+	}
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	va_end( argptr );
+
+	ri.Error( errorLevel, "%s", msg );
+}
+
+/*
+================
+R_FindImageJob
+================
+*/
+static imageJob_t *R_FindImageJob( const char *name ) {
+	imageJob_t	*job;
+
+	for ( job = imageJobHash[R_JobHash( name )] ; job ; job = job->hashNext ) {
+		if ( !strcmp( name, job->name ) ) {
+			return job;
+		}
+	}
+	return NULL;
+}
+
+/*
+================
+R_FindImageSource
+
+Finds the file R_LoadImage would try first for name, and the loader
+for it.  renamed is set if it was not found under its own extension.
+================
+*/
+bool R_FindImageSource( const char *name, char *fileName, int fileNameSize, int *loader, bool *renamed ) {
+	char		localName[MAX_QPATH];
+	const char	*ext, *altName;
+	int			i, orgLoader;
+
+	if ( !jobLoaders ) {
+		return false;
+	}
+
+	Q_strncpyz( localName, name, sizeof( localName ) );
+	ext = COM_GetExtension( localName );
+	orgLoader = -1;
+
+	if ( *ext ) {
+		for ( i = 0 ; i < numJobLoaders ; i++ ) {
+			if ( !Q_stricmp( ext, jobLoaders[i].ext ) ) {
+				if ( ri.FS_ReadFile( localName, NULL ) > 0 ) {
+					Q_strncpyz( fileName, localName, fileNameSize );
+					*loader = i;
+					*renamed = false;
+					return true;
+				}
+
+				// try again without the extension
+				orgLoader = i;
+				COM_StripExtension( name, localName, sizeof( localName ) );
+				break;
+			}
+		}
+	}
+
+	for ( i = 0 ; i < numJobLoaders ; i++ ) {
+		if ( i == orgLoader ) {
+			continue;
+		}
+
+		altName = va( "%s.%s", localName, jobLoaders[i].ext );
+		if ( ri.FS_ReadFile( altName, NULL ) > 0 ) {
+			Q_strncpyz( fileName, altName, fileNameSize );
+			*loader = i;
+			*renamed = ( orgLoader != -1 );
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+================
+R_ReadImageJobFile
+
+Reads the file R_LoadImage would try first.  If that file turns out
+not to decode, the job fails and R_LoadImage goes through the rest of
+the candidates itself.
+================
+*/
+static bool R_ReadImageJobFile( imageJob_t *job ) {
+	void	*buf;
+	long	len;
+
+	if ( !R_FindImageSource( job->name, job->fileName, sizeof( job->fileName ), &job->loader, &job->renamed ) ) {
+		return false;
+	}
+
+	len = ri.FS_ReadFile( job->fileName, &buf );
+	if ( !buf ) {
+		return false;
+	}
+
+	job->file = buf;
+	job->fileLength = len;
+	return true;
+}
+
+/*
+================
+R_RunImageJob
+================
+*/
+static void R_RunImageJob( void *data, int index ) {
+	imageJob_t	*job = ( (imageJob_t **)data )[index];
+	jmp_buf		jobAbort;
+
+	currentJob = job;
+	currentAbort = &jobAbort;
+
+	if ( !setjmp( jobAbort ) ) {
+		jobLoaders[job->loader].ImageLoader( job->fileName, &job->pic, &job->width, &job->height );
+
+		if ( !job->pic ) {
+			job->failed = true;
+		}
+		if ( !job->failed ) {
+			jobPrepare( job );
+		}
+	}
+
+	currentJob = NULL;
+	currentAbort = NULL;
+}
+
+/*
+================
+R_RunImageJobs
+
+Reads the files for the next batch of queued jobs, starting with first,
+and runs the batch on the job threads
+================
+*/
+static void R_RunImageJobs( imageJob_t *first ) {
+	imageJob_t	*batch[IMAGE_JOB_BATCH];
+	imageJob_t	*job;
+	int			i, count, start;
+
+	count = 0;
+	for ( job = first ; job < imageJobs + numImageJobs && count < IMAGE_JOB_BATCH ; job++ ) {
+		if ( job->state != IMAGEJOB_QUEUED ) {
+			continue;
+		}
+
+		job->state = IMAGEJOB_DONE;
+		if ( !R_ReadImageJobFile( job ) ) {
+			job->failed = true;
+			continue;
+		}
+
+		batch[count++] = job;
+	}
+
+	start = ri.Milliseconds();
+	ri.ParallelFor( count, R_RunImageJob, batch );
+	jobMsec += ri.Milliseconds() - start;
+
+	// the files are temp memory, free them in reverse
+	for ( i = count - 1 ; i >= 0 ; i-- ) {
+		ri.FS_FreeFile( batch[i]->file );
+		batch[i]->file = NULL;
+	}
+
+	jobBatches++;
+	jobsRun += count;
+}
+
+/*
+================
+R_InitImageJobs
+
+The loaders are tried in the same order as R_LoadImage, and prepare is
+run on the job after a successful decode
+================
+*/
+void R_InitImageJobs( const imageExtToLoaderMap_t *loaders, int numLoaders, void (*prepare)( imageJob_t *job ) ) {
+	R_ClearImageJobs();
+
+	jobLoaders = loaders;
+	numJobLoaders = numLoaders;
+	jobPrepare = prepare;
+}
+
+/*
+================
+R_RequestImage
+
+Queues an image to be decoded ahead of the R_FindImageFile call that
+will use it.  Requests should be made in the order the images will be
+asked for, since they are decoded in that order.
+================
+*/
+void R_RequestImage( const char *name, imgType_t type, int/*imgFlags_t*/ flags ) {
+	imageJob_t	*job;
+	int			hash;
+	uint64_t	key;
+
+	if ( !r_imageJobs->integer || !jobLoaders ) {
+		return;
+	}
+
+	// leave room for R_LoadImage to add an extension
+	if ( !name || !name[0] || name[0] == '*' || strlen( name ) >= MAX_QPATH - 6 ) {
+		return;
+	}
+
+	if ( numImageJobs == MAX_IMAGE_JOBS ) {
+		return;
+	}
+
+	if ( R_FindImageJob( name ) || R_ImageLoaded( name ) ) {
+		return;
+	}
+
+	// nothing to decode if it will come from the image cache
+	if ( R_ImageCacheKey( name, type, flags, &key ) && R_ImageCached( key ) ) {
+		return;
+	}
+
+	job = &imageJobs[numImageJobs++];
+	Com_Memset( job, 0, sizeof( *job ) );
+	Q_strncpyz( job->name, name, sizeof( job->name ) );
+	job->type = type;
+	job->flags = flags;
+	job->state = IMAGEJOB_QUEUED;
+
+	hash = R_JobHash( name );
+	job->hashNext = imageJobHash[hash];
+	imageJobHash[hash] = job;
+}
+
+/*
+================
+R_TakeImageJob
+
+Returns the decoded image if it was requested with the same type and
+flags, running its batch first if need be.  The caller uploads it and
+hands it back with R_ReleaseImageJob.  NULL means load it as usual.
+================
+*/
+imageJob_t *R_TakeImageJob( const char *name, imgType_t type, int/*imgFlags_t*/ flags ) {
+	imageJob_t	*job;
+
+	if ( !numImageJobs ) {
+		return NULL;
+	}
+
+	job = R_FindImageJob( name );
+	if ( !job || job->state == IMAGEJOB_RELEASED ) {
+		return NULL;
+	}
+
+	if ( job->type != type || job->flags != flags ) {
+		jobsFallenBack++;
+		R_ReleaseImageJob( job );
+		return NULL;
+	}
+
+	if ( job->state == IMAGEJOB_QUEUED ) {
+		R_RunImageJobs( job );
+	}
+
+	if ( job->failed ) {
+		jobsFallenBack++;
+		R_ReleaseImageJob( job );
+		return NULL;
+	}
+
+	if ( job->renamed ) {
+		ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n",
+				name, job->fileName );
+	}
+
+	return job;
+}
+
+/*
+================
+R_ReleaseImageJob
+================
+*/
+void R_ReleaseImageJob( imageJob_t *job ) {
+	while ( job->blocks ) {
+		R_JobFree( job, (byte *)job->blocks + JOB_BLOCK_SIZE );
+	}
+
+	job->pic = NULL;
+	job->upload = NULL;
+	job->state = IMAGEJOB_RELEASED;
+}
+
+/*
+================
+R_ClearImageJobs
+
+Drops whatever was requested but never used
+================
+*/
+void R_ClearImageJobs( void ) {
+	int		i;
+
+	if ( !numImageJobs ) {
+		return;
+	}
+
+	for ( i = 0 ; i < numImageJobs ; i++ ) {
+		R_ReleaseImageJob( &imageJobs[i] );
+	}
+
+	ri.Printf( PRINT_DEVELOPER, "...%i of %i requested images decoded ahead in %i batches, %i msec, %i loaded on the main thread\n",
+			jobsRun, numImageJobs, jobBatches, jobMsec, jobsFallenBack );
+
+	numImageJobs = 0;
+	Com_Memset( imageJobHash, 0, sizeof( imageJobHash ) );
+	jobBatches = jobsRun = jobsFallenBack = jobMsec = 0;
+}
@@ -26,7 +26,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #include "renderercommon/tr_types.h"
 
-#define	REF_API_VERSION		8
+#define	REF_API_VERSION		12
 
 // AVI files have the start of pixel lines 4 byte-aligned
 #define AVI_LINE_PADDING 4
@@ -167,6 +167,7 @@ typedef struct {
 	void	(*FS_FreeFileList)( char **filelist );
 	void	(*FS_WriteFile)( const char *qpath, const void *buffer, int size );
 	bool (*FS_FileExists)( const char *file );
+	void	(*FS_HomeRemove)( const char *homePath );
 
 	// cinematic stuff
 	void	(*CIN_UploadCinematic)(int handle);
@@ -184,6 +185,18 @@ typedef struct {
 	void	(*Sys_GLimpSafeInit)( void );
 	void	(*Sys_GLimpInit)( void );
 	bool (*Sys_LowPhysicalMemory)( void );
+
+	// runs func( data, 0 ) .. func( data, count - 1 ) on the job threads,
+	// returning when all are done
+	void	(*ParallelFor)( int count, void (*func)( void *data, int index ), void *data );
+
+	// streamed file access, for files that shouldn't go through the hunk
+	long	(*FS_FOpenFileRead)( const char *qpath, fileHandle_t *file, bool uniqueFILE );
+	int		(*FS_Read)( void *buffer, int len, fileHandle_t f );
+	void	(*FS_FCloseFile)( fileHandle_t f );
+
+	// for profiling only, like Milliseconds
+	int64_t	(*Microseconds)( void );
 } refimport_t;
 
 
@@ -0,0 +1,182 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+// tr_shadercache.cpp -- the combined shader text and the position of every
+// shader in it, saved so R_InitShaders does not have to read and tokenize
+// every shader file again on the next vid_restart or launch
+
+#include "tr_common.h"
+
+#define SHADERCACHE_NAME	"shadercache.dat"
+#define SHADERCACHE_IDENT	(('C'<<24)+('H'<<16)+('S'<<8)+'R')
+#define SHADERCACHE_VERSION	1
+
+#define SHADERCACHE_TEXTSIZE( len )	( ( ( len ) + 4 ) & ~3 )
+
+// followed by the text, 0 terminated and padded to a multiple of 4
+// bytes, then numStarts ints
+typedef struct {
+	int			ident;
+	int			version;
+	uint64_t	key;
+	int			numFiles;
+	int			textLength;
+	int			numStarts;
+	int			pad;
+} shaderCacheHeader_t;
+
+/*
+====================
+R_ShaderCacheKey
+
+Hashes the name, pak checksum and length of every shader file, in the
+order they are loaded.  Returns false if any of them is not in a pak,
+since loose files can change without anything here noticing.
+====================
+*/
+bool R_ShaderCacheKey( char filenames[][MAX_QPATH], int numFiles, uint64_t *key ) {
+	uint64_t	hash;
+	int			i, values[2];
+	const byte	*b;
+	size_t		j, len;
+
+	if ( !r_shaderCache->integer ) {
+		return false;
+	}
+
+	hash = 14695981039346656037ULL;
+	for ( i = 0 ; i < numFiles ; i++ ) {
+		if ( ri.FS_FileIsInPAK( filenames[i], &values[0] ) != 1 ) {
+			return false;
+		}
+		values[1] = ri.FS_ReadFile( filenames[i], NULL );
+
+		len = strlen( filenames[i] ) + 1;
+		b = (const byte *)filenames[i];
+		for ( j = 0 ; j < len ; j++ ) {
+			hash = ( hash ^ b[j] ) * 1099511628211ULL;
+		}
+
+		b = (const byte *)values;
+		for ( j = 0 ; j < sizeof( values ) ; j++ ) {
+			hash = ( hash ^ b[j] ) * 1099511628211ULL;
+		}
+	}
+
+	*key = hash;
+	return true;
+}
+
+/*
+====================
+R_LoadShaderCache
+
+On success the text is copied to the low hunk and *starts is allocated
+with ri.Malloc, to be released by the caller.
+====================
+*/
+bool R_LoadShaderCache( uint64_t key, int numFiles, char **text, int **starts, int *numStarts ) {
+	shaderCacheHeader_t	header;
+	byte		*buf;
+	const char	*cachedText;
+	const int	*cachedStarts;
+	long		length;
+	int			i;
+
+	length = ri.FS_ReadFile( SHADERCACHE_NAME, (void **)&buf );
+	if ( !buf ) {
+		return false;
+	}
+
+	if ( length < (long)sizeof( header ) ) {
+		ri.FS_FreeFile( buf );
+		return false;
+	}
+
+	Com_Memcpy( &header, buf, sizeof( header ) );
+	if ( header.ident != SHADERCACHE_IDENT || header.version != SHADERCACHE_VERSION ||
+		header.key != key || header.numFiles != numFiles ||
+		header.textLength < 0 || header.numStarts < 0 ||
+		header.textLength > length || header.numStarts > length ||
+		length != (long)sizeof( header ) + SHADERCACHE_TEXTSIZE( header.textLength ) + header.numStarts * (long)sizeof( int ) ) {
+		ri.FS_FreeFile( buf );
+		return false;
+	}
+
+	cachedText = (const char *)buf + sizeof( header );
+	cachedStarts = (const int *)( cachedText + SHADERCACHE_TEXTSIZE( header.textLength ) );
+
+	// the starts must be in order and inside the text
+	if ( cachedText[header.textLength] ) {
+		ri.FS_FreeFile( buf );
+		return false;
+	}
+	for ( i = 0 ; i < header.numStarts ; i++ ) {
+		if ( cachedStarts[i] < ( i ? cachedStarts[i - 1] + 1 : 0 ) || cachedStarts[i] >= header.textLength ) {
+			ri.FS_FreeFile( buf );
+			return false;
+		}
+	}
+
+	*text = (char *)ri.Hunk_Alloc( header.textLength + 1, h_low );
+	Com_Memcpy( *text, cachedText, header.textLength + 1 );
+
+	*starts = (int *)ri.Malloc( ( header.numStarts + 1 ) * sizeof( int ) );
+	Com_Memcpy( *starts, cachedStarts, header.numStarts * sizeof( int ) );
+	*numStarts = header.numStarts;
+
+	ri.FS_FreeFile( buf );
+
+	ri.Printf( PRINT_DEVELOPER, "...loaded %i shaders from %s\n", header.numStarts, SHADERCACHE_NAME );
+	return true;
+}
+
+/*
+====================
+R_SaveShaderCache
+====================
+*/
+void R_SaveShaderCache( uint64_t key, int numFiles, const char *text, const int *starts, int numStarts ) {
+	shaderCacheHeader_t	header;
+	byte	*buf;
+	int		length;
+
+	Com_Memset( &header, 0, sizeof( header ) );
+	header.ident = SHADERCACHE_IDENT;
+	header.version = SHADERCACHE_VERSION;
+	header.key = key;
+	header.numFiles = numFiles;
+	header.textLength = strlen( text );
+	header.numStarts = numStarts;
+
+	length = sizeof( header ) + SHADERCACHE_TEXTSIZE( header.textLength ) + numStarts * sizeof( int );
+	buf = (byte *)ri.Hunk_AllocateTempMemory( length );
+
+	Com_Memset( buf, 0, length );
+	Com_Memcpy( buf, &header, sizeof( header ) );
+	Com_Memcpy( buf + sizeof( header ), text, header.textLength + 1 );
+	Com_Memcpy( buf + sizeof( header ) + SHADERCACHE_TEXTSIZE( header.textLength ), starts, numStarts * sizeof( int ) );
+
+	ri.FS_WriteFile( SHADERCACHE_NAME, buf, length );
+	ri.Hunk_FreeTempMemory( buf );
+}
@@ -66,15 +66,15 @@ static int R_MDRCullModel( mdrHeader_t *header, trRefEntity_t *ent ) {
 				// we do. After all, the purpose of mdrs are not that different, are they?
 				
 				case CULL_OUT:
-					tr.pc.c_sphere_cull_md3_out++;
+					fe->pc->c_sphere_cull_md3_out++;
 					return CULL_OUT;
 
 				case CULL_IN:
-					tr.pc.c_sphere_cull_md3_in++;
+					fe->pc->c_sphere_cull_md3_in++;
 					return CULL_IN;
 
 				case CULL_CLIP:
-					tr.pc.c_sphere_cull_md3_clip++;
+					fe->pc->c_sphere_cull_md3_clip++;
 					break;
 			}
 		}
@@ -93,17 +93,17 @@ static int R_MDRCullModel( mdrHeader_t *header, trRefEntity_t *ent ) {
 			{
 				if ( sphereCull == CULL_OUT )
 				{
-					tr.pc.c_sphere_cull_md3_out++;
+					fe->pc->c_sphere_cull_md3_out++;
 					return CULL_OUT;
 				}
 				else if ( sphereCull == CULL_IN )
 				{
-					tr.pc.c_sphere_cull_md3_in++;
+					fe->pc->c_sphere_cull_md3_in++;
 					return CULL_IN;
 				}
 				else
 				{
-					tr.pc.c_sphere_cull_md3_clip++;
+					fe->pc->c_sphere_cull_md3_clip++;
 				}
 			}
 		}
@@ -118,14 +118,14 @@ static int R_MDRCullModel( mdrHeader_t *header, trRefEntity_t *ent ) {
 	switch ( R_CullLocalBox( bounds ) )
 	{
 		case CULL_IN:
-			tr.pc.c_box_cull_md3_in++;
+			fe->pc->c_box_cull_md3_in++;
 			return CULL_IN;
 		case CULL_CLIP:
-			tr.pc.c_box_cull_md3_clip++;
+			fe->pc->c_box_cull_md3_clip++;
 			return CULL_CLIP;
 		case CULL_OUT:
 		default:
-			tr.pc.c_box_cull_md3_out++;
+			fe->pc->c_box_cull_md3_out++;
 			return CULL_OUT;
 	}
 }
@@ -192,9 +192,9 @@ void R_MDRAddAnimSurfaces( trRefEntity_t *ent ) {
 	int				cull;
 	bool	personalModel;
 
-	header = (mdrHeader_t *) tr.currentModel->modelData;
+	header = (mdrHeader_t *) fe->currentModel->modelData;
 	
-	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal;
+	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal;
 	
 	if ( ent->e.renderfx & RF_WRAP_FRAMES )
 	{
@@ -213,8 +213,11 @@ void R_MDRAddAnimSurfaces( trRefEntity_t *ent ) {
 		|| (ent->e.oldframe >= header->numFrames)
 		|| (ent->e.oldframe < 0) )
 	{
+		if ( R_EntityJobFailed() ) {
+			return;
+		}
 		ri.Printf( PRINT_DEVELOPER, "R_MDRAddAnimSurfaces: no such frame %d to %d for '%s'\n",
-			   ent->e.oldframe, ent->e.frame, tr.currentModel->name );
+			   ent->e.oldframe, ent->e.frame, fe->currentModel->name );
 		ent->e.frame = 0;
 		ent->e.oldframe = 0;
 	}
@@ -1223,6 +1223,42 @@ void R_MovePatchSurfacesToHunk(void) {
 	}
 }
 
+/*
+===============
+R_RequestWorldImages
+
+Queues the images of the world shaders in the order R_LoadSurfaces will
+first use them, so the job threads decode them ahead of it
+===============
+*/
+static void R_RequestWorldImages( lump_t *surfs ) {
+	dsurface_t	*in;
+	byte		*requested;
+	int			i, count, shaderNum;
+
+	if ( !r_imageJobs->integer || !s_worldData.numShaders ) {
+		return;
+	}
+
+	in = (dsurface_t *)(fileBase + surfs->fileofs);
+	count = surfs->filelen / sizeof(*in);
+
+	requested = (byte *)ri.Hunk_AllocateTempMemory( s_worldData.numShaders );
+	Com_Memset( requested, 0, s_worldData.numShaders );
+
+	for ( i = 0 ; i < count ; i++, in++ ) {
+		shaderNum = LittleLong( in->shaderNum );
+		if ( shaderNum < 0 || shaderNum >= s_worldData.numShaders || requested[shaderNum] ) {
+			continue;
+		}
+		requested[shaderNum] = 1;
+
+		R_RequestShaderImages( s_worldData.shaders[shaderNum].shader, true );
+	}
+
+	ri.Hunk_FreeTempMemory( requested );
+}
+
 /*
 ===============
 R_LoadSurfaces
@@ -1259,6 +1295,9 @@ static	void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump ) {
 
 	s_worldData.surfaces = out;
 	s_worldData.numsurfaces = count;
+	s_worldData.jobSurfaces = (msurface_t **)ri.Hunk_Alloc( count * sizeof( *s_worldData.jobSurfaces ), h_low );
+	s_worldData.jobDlightBits = (int *)ri.Hunk_Alloc( count * sizeof( *s_worldData.jobDlightBits ), h_low );
+	s_worldData.jobDrawSurfs = (drawSurf_t *)ri.Hunk_Alloc( count * sizeof( *s_worldData.jobDrawSurfs ), h_low );
 
 	for ( i = 0 ; i < count ; i++, in++, out++ ) {
 		switch ( LittleLong( in->surfaceType ) ) {
@@ -1352,10 +1391,13 @@ R_SetParent
 static	void R_SetParent (mnode_t *node, mnode_t *parent)
 {
 	node->parent = parent;
-	if (node->contents != -1)
+	if (node->contents != -1) {
+		node->numLeafs = 1;
 		return;
+	}
 	R_SetParent (node->children[0], node);
 	R_SetParent (node->children[1], node);
+	node->numLeafs = node->children[0]->numLeafs + node->children[1]->numLeafs;
 }
 
 /*
@@ -1432,6 +1474,8 @@ static	void R_LoadNodesAndLeafs (lump_t *nodeLump, lump_t *leafLump) {
 
 	// chain decendants
 	R_SetParent (s_worldData.nodes, NULL);
+
+	s_worldData.jobLeafs = (worldLeaf_t *)ri.Hunk_Alloc( numLeafs * sizeof( *s_worldData.jobLeafs ), h_low );
 }
 
 //=============================================================================
@@ -1852,6 +1896,7 @@ void RE_LoadWorldMap( const char *name ) {
 	R_LoadLightmaps( &header->lumps[LUMP_LIGHTMAPS] );
 	R_LoadPlanes (&header->lumps[LUMP_PLANES]);
 	R_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
+	R_RequestWorldImages( &header->lumps[LUMP_SURFACES] );
 	R_LoadSurfaces( &header->lumps[LUMP_SURFACES], &header->lumps[LUMP_DRAWVERTS], &header->lumps[LUMP_DRAWINDEXES] );
 	R_LoadMarksurfaces (&header->lumps[LUMP_LEAFSURFACES]);
 	R_LoadNodesAndLeafs (&header->lumps[LUMP_NODES], &header->lumps[LUMP_LEAFS]);
@@ -1865,5 +1910,9 @@ void RE_LoadWorldMap( const char *name ) {
 	// only set tr.world now that we know the entire level has loaded properly
 	tr.world = &s_worldData;
 
+	// anything left was asked for but never used
+	R_ClearImageJobs();
+	R_SaveImageCacheIndex();
+
     ri.FS_FreeFile( buffer.v );
 }
@@ -59,7 +59,7 @@ void R_PerformanceCounters( void ) {
 	} 
 	else if (r_speeds->integer == 5 )
 	{
-		ri.Printf( PRINT_ALL, "zFar: %.0f\n", tr.viewParms.zFar );
+		ri.Printf( PRINT_ALL, "zFar: %.0f\n", fe->viewParms.zFar );
 	}
 	else if (r_speeds->integer == 6 )
 	{
@@ -172,7 +172,7 @@ void	R_AddDrawSurfCmd( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	cmd->numDrawSurfs = numDrawSurfs;
 
 	cmd->refdef = tr.refdef;
-	cmd->viewParms = tr.viewParms;
+	cmd->viewParms = fe->viewParms;
 }
 
 
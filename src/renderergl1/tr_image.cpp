@@ -283,7 +283,8 @@ void R_ImageList_f( void ) {
 
 	ri.Printf (PRINT_ALL, " ---------\n");
 	ri.Printf (PRINT_ALL, " approx %i bytes\n", estTotalSize);
-	ri.Printf (PRINT_ALL, " %i total images\n\n", tr.numImages );
+	ri.Printf (PRINT_ALL, " %i total images\n", tr.numImages );
+	R_ImageCacheInfo();
 }
 
 //=======================================================================
@@ -310,7 +311,7 @@ static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *
 	byte		*pix1, *pix2, *pix3, *pix4;
 
 	if (outwidth>2048)
-		ri.Error(ERR_DROP, "ResampleTexture: max width");
+		R_ImageError(ERR_DROP, "ResampleTexture: max width");
 								
 	fracstep = inwidth*0x10000/outwidth;
 
@@ -418,7 +419,7 @@ static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
 
 	outWidth = inWidth >> 1;
 	outHeight = inHeight >> 1;
-	temp = (unsigned*)ri.Hunk_AllocateTempMemory( outWidth * outHeight * 4 );
+	temp = (unsigned*)R_ImageTempAlloc( outWidth * outHeight * 4 );
 
 	inWidthMask = inWidth - 1;
 	inHeightMask = inHeight - 1;
@@ -453,7 +454,7 @@ static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
 	}
 
 	Com_Memcpy( in, temp, outWidth * outHeight * 4 );
-	ri.Hunk_FreeTempMemory( temp );
+	R_ImageTempFree( temp );
 }
 
 /*
@@ -548,20 +549,26 @@ byte	mipBlendColors[16][4] = {
 };
 
 
+typedef void (*uploadLevel_t)( void *ctx, int level, int internalFormat, int width, int height, const byte *data );
+
 /*
 ===============
-Upload32
+R_PrepareUpload32
 
+Everything Upload32 does short of talking to GL: the power of two
+resample, picmip, the internal format and the mip levels, which are
+passed to uploadLevel largest first.  Safe to run on a job thread.
 ===============
 */
-static void Upload32( unsigned *data, 
+static void R_PrepareUpload32( unsigned *data, 
 						  int width, int height, 
 						  bool mipmap, 
 						  bool picmip, 
 							bool lightMap,
 						  bool allowCompression,
 						  int *format, 
-						  int *pUploadWidth, int *pUploadHeight )
+						  int *pUploadWidth, int *pUploadHeight,
+						  uploadLevel_t uploadLevel, void *ctx )
 {
 	int			samples;
 	unsigned	*scaledBuffer = NULL;
@@ -585,7 +592,7 @@ static void Upload32( unsigned *data,
 		scaled_height >>= 1;
 
 	if ( scaled_width != width || scaled_height != height ) {
-		resampledBuffer = (unsigned*)ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
+		resampledBuffer = (unsigned*)R_ImageTempAlloc( scaled_width * scaled_height * 4 );
 		ResampleTexture (data, width, height, resampledBuffer, scaled_width, scaled_height);
 		data = resampledBuffer;
 		width = scaled_width;
@@ -621,7 +628,7 @@ static void Upload32( unsigned *data,
 		scaled_height >>= 1;
 	}
 
-	scaledBuffer = (unsigned*)ri.Hunk_AllocateTempMemory( sizeof( unsigned ) * scaled_width * scaled_height );
+	scaledBuffer = (unsigned*)R_ImageTempAlloc( sizeof( unsigned ) * scaled_width * scaled_height );
 
 	//
 	// scan the texture for each channel's max values
@@ -751,10 +758,10 @@ static void Upload32( unsigned *data,
 		( scaled_height == height ) ) {
 		if (!mipmap)
 		{
-			qglTexImage2D (GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 			*pUploadWidth = scaled_width;
 			*pUploadHeight = scaled_height;
 			*format = internalFormat;
+			uploadLevel( ctx, 0, internalFormat, scaled_width, scaled_height, (byte *)data );
 
 			goto done;
 		}
@@ -783,7 +790,7 @@ static void Upload32( unsigned *data,
 	*pUploadHeight = scaled_height;
 	*format = internalFormat;
 
-	qglTexImage2D (GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+	uploadLevel( ctx, 0, internalFormat, scaled_width, scaled_height, (byte *)scaledBuffer );
 
 	if (mipmap)
 	{
@@ -805,11 +812,36 @@ static void Upload32( unsigned *data,
 				R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[miplevel] );
 			}
 
-			qglTexImage2D (GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+			uploadLevel( ctx, miplevel, internalFormat, scaled_width, scaled_height, (byte *)scaledBuffer );
 		}
 	}
 done:
 
+	if ( scaledBuffer != 0 )
+		R_ImageTempFree( scaledBuffer );
+	if ( resampledBuffer != 0 )
+		R_ImageTempFree( resampledBuffer );
+}
+
+/*
+===============
+R_UploadLevel
+===============
+*/
+static void R_UploadLevel( void *ctx, int level, int internalFormat, int width, int height, const byte *data )
+{
+	qglTexImage2D( GL_TEXTURE_2D, level, internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data );
+}
+
+/*
+===============
+R_FinishUpload32
+
+Filtering for the texture just uploaded
+===============
+*/
+static void R_FinishUpload32( bool mipmap )
+{
 	if (mipmap)
 	{
 		if ( glConfig.textureFilterAnisotropic )
@@ -829,27 +861,40 @@ done:
 	}
 
 	GL_CheckErrors();
+}
 
-	if ( scaledBuffer != 0 )
-		ri.Hunk_FreeTempMemory( scaledBuffer );
-	if ( resampledBuffer != 0 )
-		ri.Hunk_FreeTempMemory( resampledBuffer );
+/*
+===============
+Upload32
+
+===============
+*/
+static void Upload32( unsigned *data, 
+						  int width, int height, 
+						  bool mipmap, 
+						  bool picmip, 
+							bool lightMap,
+						  bool allowCompression,
+						  int *format, 
+						  int *pUploadWidth, int *pUploadHeight )
+{
+	R_PrepareUpload32( data, width, height, mipmap, picmip, lightMap, allowCompression,
+		format, pUploadWidth, pUploadHeight, R_UploadLevel, NULL );
+	R_FinishUpload32( mipmap );
 }
 
 
 /*
 ================
-R_CreateImage
+R_AllocImage
 
-This is the only way any image_t are created
+Sets up a new image_t and binds it, ready for the upload
 ================
 */
-image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
-		imgType_t type, int flags, int internalFormat ) {
+static image_t *R_AllocImage( const char *name, int width, int height,
+		imgType_t type, int flags ) {
 	image_t		*image;
 	bool	isLightmap = false;
-	long		hash;
-	int         glWrapClampMode;
 
 	if (strlen(name) >= MAX_QPATH ) {
 		ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long", name);
@@ -873,10 +918,6 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 
 	image->width = width;
 	image->height = height;
-	if (flags & IMGFLAG_CLAMPTOEDGE)
-		glWrapClampMode = GL_CLAMP_TO_EDGE;
-	else
-		glWrapClampMode = GL_REPEAT;
 
 	// lightmaps are always allocated on TMU 1
 	if ( qglActiveTextureARB && isLightmap ) {
@@ -891,14 +932,24 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 
 	GL_Bind(image);
 
-	Upload32( (unsigned *)pic, image->width, image->height, 
-								(image->flags & IMGFLAG_MIPMAP) == IMGFLAG_MIPMAP,
-								(image->flags & IMGFLAG_PICMIP) == IMGFLAG_PICMIP,
-								isLightmap,
-								!(image->flags & IMGFLAG_NO_COMPRESSION),
-								&image->internalFormat,
-								&image->uploadWidth,
-								&image->uploadHeight );
+	return image;
+}
+
+/*
+================
+R_FinishImage
+
+Wrap mode, unbind and add to the hash once the upload is done
+================
+*/
+static void R_FinishImage( image_t *image ) {
+	long		hash;
+	int         glWrapClampMode;
+
+	if (image->flags & IMGFLAG_CLAMPTOEDGE)
+		glWrapClampMode = GL_CLAMP_TO_EDGE;
+	else
+		glWrapClampMode = GL_REPEAT;
 
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapClampMode );
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapClampMode );
@@ -910,20 +961,89 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 		GL_SelectTexture( 0 );
 	}
 
-	hash = generateHashValue(name);
+	hash = generateHashValue(image->imgName);
 	image->next = hashTable[hash];
 	hashTable[hash] = image;
+}
+
+/*
+================
+R_CreateImage
+
+This is the only way any image_t are created
+================
+*/
+image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
+		imgType_t type, int flags, int internalFormat ) {
+	image_t		*image;
+
+	image = R_AllocImage( name, width, height, type, flags );
+
+	Upload32( (unsigned *)pic, image->width, image->height, 
+								(image->flags & IMGFLAG_MIPMAP) == IMGFLAG_MIPMAP,
+								(image->flags & IMGFLAG_PICMIP) == IMGFLAG_PICMIP,
+								!strncmp( name, "*lightmap", 9 ),
+								!(image->flags & IMGFLAG_NO_COMPRESSION),
+								&image->internalFormat,
+								&image->uploadWidth,
+								&image->uploadHeight );
+
+	R_FinishImage( image );
 
 	return image;
 }
 
-//===================================================================
+/*
+================
+R_CreateImageFromJob
 
-struct imageExtToLoaderMap_t
-{
-	const char *ext;
-	void (*ImageLoader)( const char *, unsigned char **, int *, int * );
-};
+Uploads the levels a job has already built
+================
+*/
+static image_t *R_CreateImageFromJob( imageJob_t *job ) {
+	image_t		*image;
+	byte		*data;
+	int			i, width, height;
+
+	image = R_AllocImage( job->name, job->width, job->height, job->type, job->flags );
+
+	image->internalFormat = job->internalFormat;
+	image->uploadWidth = job->uploadWidth;
+	image->uploadHeight = job->uploadHeight;
+
+	data = job->upload;
+	width = job->uploadWidth;
+	height = job->uploadHeight;
+	for ( i = 0 ; i < job->numLevels ; i++ ) {
+		R_UploadLevel( NULL, i, job->internalFormat, width, height, data );
+		data += width * height * 4;
+		width = MAX( 1, width >> 1 );
+		height = MAX( 1, height >> 1 );
+	}
+
+	R_FinishUpload32( (image->flags & IMGFLAG_MIPMAP) == IMGFLAG_MIPMAP );
+	R_FinishImage( image );
+
+	return image;
+}
+
+/*
+===============
+R_ImageLoaded
+===============
+*/
+bool R_ImageLoaded( const char *name ) {
+	image_t	*image;
+
+	for (image=hashTable[generateHashValue(name)]; image; image=image->next) {
+		if ( !strcmp( name, image->imgName ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//===================================================================
 
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
@@ -1022,6 +1142,68 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height )
 }
 
 
+/*
+===============
+R_StoreImageJobLevel
+
+Keeps the levels R_PrepareUpload32 builds for a job, one after the other
+===============
+*/
+static void R_StoreImageJobLevel( void *ctx, int level, int internalFormat, int width, int height, const byte *data )
+{
+	imageJob_t	*job = (imageJob_t *)ctx;
+	int			i, w, h, size, offset;
+
+	if ( level == 0 ) {
+		size = 0;
+		w = width;
+		h = height;
+		do {
+			size += w * h * 4;
+			if ( !( job->flags & IMGFLAG_MIPMAP ) || ( w == 1 && h == 1 ) ) {
+				break;
+			}
+			w = MAX( 1, w >> 1 );
+			h = MAX( 1, h >> 1 );
+		} while ( 1 );
+
+		job->upload = (byte *)R_ImageMalloc( size );
+		job->numLevels = 0;
+	}
+
+	offset = 0;
+	w = job->uploadWidth;
+	h = job->uploadHeight;
+	for ( i = 0 ; i < level ; i++ ) {
+		offset += w * h * 4;
+		w = MAX( 1, w >> 1 );
+		h = MAX( 1, h >> 1 );
+	}
+
+	Com_Memcpy( job->upload + offset, data, width * height * 4 );
+	job->numLevels = level + 1;
+}
+
+/*
+===============
+R_PrepareImageJob
+
+Runs on a job thread once the image is decoded
+===============
+*/
+static void R_PrepareImageJob( imageJob_t *job )
+{
+	R_PrepareUpload32( (unsigned *)job->pic, job->width, job->height,
+		(job->flags & IMGFLAG_MIPMAP) == IMGFLAG_MIPMAP,
+		(job->flags & IMGFLAG_PICMIP) == IMGFLAG_PICMIP,
+		false,
+		!(job->flags & IMGFLAG_NO_COMPRESSION),
+		&job->internalFormat, &job->uploadWidth, &job->uploadHeight,
+		R_StoreImageJobLevel, job );
+	job->prepared = true;
+}
+
+
 /*
 ===============
 R_FindImageFile
@@ -1033,9 +1215,13 @@ Returns NULL if it fails, not a default image.
 image_t	*R_FindImageFile( const char *name, imgType_t type, int /*imgFlags_t*/ flags )
 {
 	image_t	*image;
+	imageJob_t	*job, prepared;
 	int		width, height;
 	byte	*pic;
 	long	hash;
+	uint64_t	cacheKey;
+	bool	cacheable;
+	void	*cacheBuf;
 
 	if (!name) {
 		return NULL;
@@ -1058,6 +1244,34 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, int /*imgFlags_t*/ f
 		}
 	}
 
+	//
+	// see if the image cache has it ready to upload
+	//
+	Com_Memset( &prepared, 0, sizeof( prepared ) );
+	Q_strncpyz( prepared.name, name, sizeof( prepared.name ) );
+	prepared.type = type;
+	prepared.flags = flags;
+
+	cacheable = R_ImageCacheKey( name, type, flags, &cacheKey );
+	if ( cacheable && R_LoadCachedImage( cacheKey, &prepared, &cacheBuf ) ) {
+		image = R_CreateImageFromJob( &prepared );
+		ri.FS_FreeFile( cacheBuf );
+		return image;
+	}
+
+	//
+	// see if the job threads have it ready
+	//
+	job = R_TakeImageJob( name, type, flags );
+	if ( job ) {
+		if ( cacheable ) {
+			R_SaveCachedImage( cacheKey, job );
+		}
+		image = R_CreateImageFromJob( job );
+		R_ReleaseImageJob( job );
+		return image;
+	}
+
 	//
 	// load the pic from disk
 	//
@@ -1066,12 +1280,25 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, int /*imgFlags_t*/ f
 		return NULL;
 	}
 
+	if ( cacheable ) {
+		// prepare it here instead of in Upload32, to keep the levels
+		prepared.pic = pic;
+		prepared.width = width;
+		prepared.height = height;
+		R_PrepareImageJob( &prepared );
+		R_SaveCachedImage( cacheKey, &prepared );
+
+		image = R_CreateImageFromJob( &prepared );
+		R_ImageFree( prepared.upload );
+		ri.Free( pic );
+		return image;
+	}
+
 	image = R_CreateImage( ( char * ) name, pic, width, height, type, flags, 0 );
 	ri.Free( pic );
 	return image;
 }
 
-
 /*
 ================
 R_CreateDlightImage
@@ -1349,6 +1576,37 @@ void R_SetColorMappings( void ) {
 	}
 }
 
+/*
+===============
+R_InitImageCacheSettings
+
+Everything besides the source file that R_PrepareUpload32 depends on
+===============
+*/
+static void R_InitImageCacheSettings( void ) {
+	struct {
+		int		picmip, roundImagesDown, texturebits, simpleMipMaps, colorMipLevels;
+		float	greyscale;
+		int		maxTextureSize, textureCompression, deviceSupportsGamma;
+		byte	intensitytable[256], gammatable[256];
+	} settings;
+
+	Com_Memset( &settings, 0, sizeof( settings ) );
+	settings.picmip = r_picmip->integer;
+	settings.roundImagesDown = r_roundImagesDown->integer;
+	settings.texturebits = r_texturebits->integer;
+	settings.simpleMipMaps = r_simpleMipMaps->integer;
+	settings.colorMipLevels = r_colorMipLevels->integer;
+	settings.greyscale = r_greyscale->value;
+	settings.maxTextureSize = glConfig.maxTextureSize;
+	settings.textureCompression = glConfig.textureCompression;
+	settings.deviceSupportsGamma = glConfig.deviceSupportsGamma;
+	Com_Memcpy( settings.intensitytable, s_intensitytable, sizeof( s_intensitytable ) );
+	Com_Memcpy( settings.gammatable, s_gammatable, sizeof( s_gammatable ) );
+
+	R_InitImageCache( &settings, sizeof( settings ) );
+}
+
 /*
 ===============
 R_InitImages
@@ -1361,6 +1619,9 @@ void	R_InitImages( void ) {
 
 	// create default texture and white texture
 	R_CreateBuiltinImages();
+
+	R_InitImageJobs( imageLoaders, numImageLoaders, R_PrepareImageJob );
+	R_InitImageCacheSettings();
 }
 
 /*
@@ -1371,6 +1632,9 @@ R_DeleteTextures
 void R_DeleteTextures( void ) {
 	int		i;
 
+	R_ClearImageJobs();
+	R_SaveImageCacheIndex();
+
 	for ( i=0; i<tr.numImages ; i++ ) {
 		qglDeleteTextures( 1, &tr.images[i]->texnum );
 	}
@@ -155,6 +155,11 @@ cvar_t	*r_debugLight;
 cvar_t	*r_debugSort;
 cvar_t	*r_printShaders;
 cvar_t	*r_saveFontData;
+cvar_t	*r_shaderCache;
+cvar_t	*r_imageJobs;
+cvar_t	*r_imageCache;
+cvar_t	*r_imageCacheSize;
+cvar_t	*r_frontEndJobs;
 
 cvar_t	*r_marksOnTriangleMeshes;
 
@@ -1029,6 +1034,11 @@ void R_Register( void )
 	r_debugSort = ri.Cvar_Get( "r_debugSort", "0", CVAR_CHEAT );
 	r_printShaders = ri.Cvar_Get( "r_printShaders", "0", 0 );
 	r_saveFontData = ri.Cvar_Get( "r_saveFontData", "0", 0 );
+	r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE );
+	r_imageJobs = ri.Cvar_Get( "r_imageJobs", "1", CVAR_ARCHIVE );
+	r_imageCache = ri.Cvar_Get( "r_imageCache", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_imageCacheSize = ri.Cvar_Get( "r_imageCacheSize", "256", CVAR_ARCHIVE );
+	r_frontEndJobs = ri.Cvar_Get( "r_frontEndJobs", "1", CVAR_ARCHIVE );
 
 	r_nocurves = ri.Cvar_Get ("r_nocurves", "0", CVAR_CHEAT );
 	r_drawworld = ri.Cvar_Get ("r_drawworld", "1", CVAR_CHEAT );
@@ -1082,6 +1092,7 @@ void R_Register( void )
 	ri.Cmd_AddCommand( "screenshot", R_ScreenShot_f );
 	ri.Cmd_AddCommand( "screenshotJPEG", R_ScreenShotJPEG_f );
 	ri.Cmd_AddCommand( "gfxinfo", GfxInfo_f );
+	ri.Cmd_AddCommand( "r_pngBench", R_PNGBench_f );
 	ri.Cmd_AddCommand( "minimize", GLimp_Minimize );
 }
 
@@ -1101,6 +1112,7 @@ void R_Init( void ) {
 	Com_Memset( &tr, 0, sizeof( tr ) );
 	Com_Memset( &backEnd, 0, sizeof( backEnd ) );
 	Com_Memset( &tess, 0, sizeof( tess ) );
+	tr.frontEnd.pc = &tr.pc;
 
 //	Swap_Init();
 
@@ -1195,6 +1207,7 @@ void RE_Shutdown( bool destroyWindow ) {
 	ri.Cmd_RemoveCommand("shaderlist");
 	ri.Cmd_RemoveCommand("skinlist");
 	ri.Cmd_RemoveCommand("minimize");
+	ri.Cmd_RemoveCommand("r_pngBench");
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
@@ -28,6 +28,8 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #include <stdbool.h>
 
+#include <atomic>
+
 #include "qcommon/cvar.h"
 #include "qcommon/q_shared.h"
 #include "qcommon/qfiles.h"
@@ -69,6 +71,8 @@ typedef struct {
 	vec3_t		ambientLight;	// color normalized to 0-255
 	int			ambientLightInt;	// 32 bit rgba packed
 	vec3_t		directedLight;
+
+	struct animSurface_s	*animSurfaces;	// vertexes animated by R_AnimateEntitySurfaces
 } trRefEntity_t;
 
 
@@ -665,6 +669,7 @@ typedef struct mnode_s {
 	int			visframe;		// node needs to be traversed if current
 	vec3_t		mins, maxs;		// for bounding box culling
 	struct mnode_s	*parent;
+	int			numLeafs;		// leafs at or below this node
 
 	// node specific
 	cplane_t	*plane;
@@ -678,6 +683,11 @@ typedef struct mnode_s {
 	int			nummarksurfaces;
 } mnode_t;
 
+typedef struct {
+	mnode_t		*node;
+	int			dlightBits;
+} worldLeaf_t;
+
 typedef struct {
 	vec3_t		bounds[2];		// for culling
 	msurface_t	*firstSurface;
@@ -726,6 +736,12 @@ typedef struct {
 
 	char		*entityString;
 	char		*entityParsePoint;
+
+	// scratch space for walking the world on the job threads
+	worldLeaf_t	*jobLeafs;			// numnodes - numDecisionNodes
+	msurface_t	**jobSurfaces;		// numsurfaces
+	int			*jobDlightBits;
+	drawSurf_t	*jobDrawSurfs;
 } world_t;
 
 //======================================================================
@@ -813,6 +829,30 @@ typedef struct {
 	int		c_dlightSurfacesCulled;
 } frontEndCounters_t;
 
+/*
+** frontEndState_t
+**
+** The view and the entity the front end is adding surfaces for.  fe
+** points at tr.frontEnd on every thread, except inside the entity
+** jobs, which each add their surfaces with a copy of their own.
+*/
+typedef struct {
+	viewParms_t				viewParms;
+	orientationr_t			orientation;		// for current entity
+
+	trRefEntity_t			*currentEntity;
+	int						currentEntityNum;
+	int						shiftedEntityNum;	// currentEntityNum << QSORT_REFENTITYNUM_SHIFT
+	model_t					*currentModel;
+
+	frontEndCounters_t		*pc;				// tr.pc, or the counters of the job
+
+	drawSurf_t				*drawSurfs;			// NULL to add to tr.refdef.drawSurfs
+	int						numDrawSurfs;
+	int						maxDrawSurfs;
+	bool					failed;				// the calling thread has to add the entity
+} frontEndState_t;
+
 #define	FOG_TABLE_SIZE		256
 #define FUNCTABLE_SIZE		1024
 #define FUNCTABLE_SIZE2		10
@@ -902,20 +942,14 @@ typedef struct {
 	int						numLightmaps;
 	image_t					**lightmaps;
 
-	trRefEntity_t			*currentEntity;
 	trRefEntity_t			worldEntity;		// point currentEntity at this when rendering world
-	int						currentEntityNum;
-	int						shiftedEntityNum;	// currentEntityNum << QSORT_REFENTITYNUM_SHIFT
-	model_t					*currentModel;
 
-	viewParms_t				viewParms;
+	frontEndState_t			frontEnd;			// use fe, not this
 
 	float					identityLight;		// 1.0 / ( 1 << overbrightBits )
 	int						identityLightByte;	// identityLight * 255
 	int						overbrightBits;		// r_overbrightBits->integer, but set to 0 if no hw gamma
 
-	orientationr_t			orientation;					// for current entity
-
 	trRefdef_t				refdef;
 
 	int						viewCluster;
@@ -958,6 +992,7 @@ typedef struct {
 
 extern backEndState_t	backEnd;
 extern trGlobals_t	tr;
+extern thread_local frontEndState_t	*fe;
 extern glstate_t	glState;		// outside of TR since it shouldn't be cleared during ref re-init
 
 //
@@ -1000,6 +1035,7 @@ extern cvar_t	*r_dlightBacks;			// dlight non-facing surfaces for continuity
 extern	cvar_t	*r_norefresh;			// bypasses the ref rendering
 extern	cvar_t	*r_drawentities;		// disable/enable entity rendering
 extern	cvar_t	*r_drawworld;			// disable/enable world rendering
+extern	cvar_t	*r_frontEndJobs;		// walk the world and add entities on the job threads
 extern	cvar_t	*r_speeds;				// various levels of information display
 extern  cvar_t	*r_detailTextures;		// enables/disables detail texturing stages
 extern	cvar_t	*r_novis;				// disable/enable usage of PVS
@@ -1081,6 +1117,8 @@ void R_SwapBuffers( int );
 void R_RenderView( viewParms_t *parms );
 
 void R_AddMD3Surfaces( trRefEntity_t *e );
+void R_QueueSurfaceAnimation( trRefEntity_t *ent, surfaceType_t *surface, int numVertexes );
+void R_AnimateEntitySurfaces( int firstAnimSurface );
 void R_AddNullModelSurfaces( trRefEntity_t *e );
 void R_AddBeamSurfaces( trRefEntity_t *e );
 void R_AddRailSurfaces( trRefEntity_t *e, bool isUnderwater );
@@ -1092,6 +1130,9 @@ void R_DecomposeSort( unsigned sort, int *entityNum, shader_t **shader,
 					 int *fogNum, int *dlightMap );
 
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, int fogIndex, int dlightMap );
+void R_PackDrawSurf( drawSurf_t *drawSurf, surfaceType_t *surface, shader_t *shader, int fogIndex, int dlightMap );
+void R_AddDrawSurfs( const drawSurf_t *drawSurfs, int numDrawSurfs );
+bool R_EntityJobFailed( void );
 
 
 #define	CULL_IN		0		// completely unclipped
@@ -1198,6 +1239,7 @@ shader_t	*R_FindShader( const char *name, int lightmapIndex, bool mipRawImage );
 shader_t	*R_GetShaderByHandle( qhandle_t hShader );
 shader_t	*R_GetShaderByState( int index, long *cycleTime );
 shader_t *R_FindShaderByName( const char *name );
+void		R_RequestShaderImages( const char *name, bool mipRawImage );
 void		R_InitShaders( void );
 void		R_ShaderList_f( void );
 void    R_RemapShader(const char *oldShader, const char *newShader, const char *timeOffset);
@@ -1260,6 +1302,8 @@ void RB_StageIteratorLightmappedMultitexture( void );
 
 void RB_AddQuadStamp( vec3_t origin, vec3_t left, vec3_t up, byte *color );
 void RB_AddQuadStampExt( vec3_t origin, vec3_t left, vec3_t up, byte *color, float s1, float t1, float s2, float t2 );
+void R_LerpMeshVertexes( const md3Surface_t *surf, int frame, int oldframe, float backlerp,
+                         vec4_t *outXyz, vec4_t *outNormal );
 
 void RB_ShowImages( void );
 
@@ -1408,6 +1452,8 @@ void RB_MDRSurfaceAnim( mdrSurface_t *surface );
 bool R_LoadIQM (model_t *mod, void *buffer, int filesize, const char *name );
 void R_AddIQMSurfaces( trRefEntity_t *ent );
 void RB_IQMSurfaceAnim( surfaceType_t *surface );
+void R_IQMTransformVertexes( const srfIQModel_t *surf, int frame, int oldframe, float backlerp,
+                             vec4_t *outXYZ, vec4_t *outNormal );
 int R_IQMLerpTag( orientation_t *tag, iqmData_t *data,
                   int startFrame, int endFrame,
                   float frac, const char *tagName );
@@ -1562,6 +1608,19 @@ typedef enum {
 #define	MAX_POLYS		600
 #define	MAX_POLYVERTS	3000
 
+// md3 and iqm surfaces animated by the front end before the back end
+// draws them, anything over these is animated by the back end as before
+#define	MAX_ANIMSURFACES	1024
+#define	MAX_ANIMVERTEXES	65536
+
+typedef struct animSurface_s {
+	surfaceType_t			*surface;
+	trRefEntity_t			*entity;
+	int						firstVertex;	// in backEndData->animXyz / animNormals
+	int						numVertexes;
+	struct animSurface_s	*next;			// the next surface of the same entity
+} animSurface_t;
+
 // all of the information needed by the back end must be
 // contained in a backEndData_t
 typedef struct {
@@ -1570,12 +1629,20 @@ typedef struct {
 	trRefEntity_t	entities[MAX_REFENTITIES];
 	srfPoly_t	*polys;//[MAX_POLYS];
 	polyVert_t	*polyVerts;//[MAX_POLYVERTS];
+	animSurface_t	animSurfaces[MAX_ANIMSURFACES];
+	vec4_t		animXyz[MAX_ANIMVERTEXES];
+	vec4_t		animNormals[MAX_ANIMVERTEXES];
 	renderCommandList_t	commands;
 } backEndData_t;
 
 extern	int		max_polys;
 extern	int		max_polyverts;
 
+extern	std::atomic<int>	r_numAnimSurfaces;		// queued from the entity jobs too
+extern	std::atomic<int>	r_numAnimVertexes;
+
+const animSurface_t *R_FindSurfaceAnimation( const trRefEntity_t *ent, const surfaceType_t *surface );
+
 extern	backEndData_t	*backEndData;	// the second one may not be allocated
 
 
@@ -28,6 +28,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include <string.h> // memcpy
 
 trGlobals_t		tr;
+thread_local frontEndState_t	*fe = &tr.frontEnd;
 
 static float	s_flipMatrix[16] = {
 	// convert from our coordinate system (looking down X)
@@ -71,16 +72,16 @@ int R_CullLocalBox (vec3_t bounds[2]) {
 		v[1] = bounds[(i>>1)&1][1];
 		v[2] = bounds[(i>>2)&1][2];
 
-		VectorCopy( tr.orientation.origin, transformed[i] );
-		VectorMA( transformed[i], v[0], tr.orientation.axis[0], transformed[i] );
-		VectorMA( transformed[i], v[1], tr.orientation.axis[1], transformed[i] );
-		VectorMA( transformed[i], v[2], tr.orientation.axis[2], transformed[i] );
+		VectorCopy( fe->orientation.origin, transformed[i] );
+		VectorMA( transformed[i], v[0], fe->orientation.axis[0], transformed[i] );
+		VectorMA( transformed[i], v[1], fe->orientation.axis[1], transformed[i] );
+		VectorMA( transformed[i], v[2], fe->orientation.axis[2], transformed[i] );
 	}
 
 	// check against frustum planes
 	anyBack = 0;
 	for (i = 0 ; i < 4 ; i++) {
-		frust = &tr.viewParms.frustum[i];
+		frust = &fe->viewParms.frustum[i];
 
 		front = back = 0;
 		for (j = 0 ; j < 8 ; j++) {
@@ -137,7 +138,7 @@ int R_CullPointAndRadius( vec3_t pt, float radius )
 	// check against frustum planes
 	for (i = 0 ; i < 4 ; i++) 
 	{
-		frust = &tr.viewParms.frustum[i];
+		frust = &fe->viewParms.frustum[i];
 
 		dist = DotProduct( pt, frust->normal) - frust->dist;
 		if ( dist < -radius )
@@ -166,9 +167,9 @@ R_LocalNormalToWorld
 =================
 */
 void R_LocalNormalToWorld (vec3_t local, vec3_t world) {
-	world[0] = local[0] * tr.orientation.axis[0][0] + local[1] * tr.orientation.axis[1][0] + local[2] * tr.orientation.axis[2][0];
-	world[1] = local[0] * tr.orientation.axis[0][1] + local[1] * tr.orientation.axis[1][1] + local[2] * tr.orientation.axis[2][1];
-	world[2] = local[0] * tr.orientation.axis[0][2] + local[1] * tr.orientation.axis[1][2] + local[2] * tr.orientation.axis[2][2];
+	world[0] = local[0] * fe->orientation.axis[0][0] + local[1] * fe->orientation.axis[1][0] + local[2] * fe->orientation.axis[2][0];
+	world[1] = local[0] * fe->orientation.axis[0][1] + local[1] * fe->orientation.axis[1][1] + local[2] * fe->orientation.axis[2][1];
+	world[2] = local[0] * fe->orientation.axis[0][2] + local[1] * fe->orientation.axis[1][2] + local[2] * fe->orientation.axis[2][2];
 }
 
 /*
@@ -178,9 +179,9 @@ R_LocalPointToWorld
 =================
 */
 void R_LocalPointToWorld (vec3_t local, vec3_t world) {
-	world[0] = local[0] * tr.orientation.axis[0][0] + local[1] * tr.orientation.axis[1][0] + local[2] * tr.orientation.axis[2][0] + tr.orientation.origin[0];
-	world[1] = local[0] * tr.orientation.axis[0][1] + local[1] * tr.orientation.axis[1][1] + local[2] * tr.orientation.axis[2][1] + tr.orientation.origin[1];
-	world[2] = local[0] * tr.orientation.axis[0][2] + local[1] * tr.orientation.axis[1][2] + local[2] * tr.orientation.axis[2][2] + tr.orientation.origin[2];
+	world[0] = local[0] * fe->orientation.axis[0][0] + local[1] * fe->orientation.axis[1][0] + local[2] * fe->orientation.axis[2][0] + fe->orientation.origin[0];
+	world[1] = local[0] * fe->orientation.axis[0][1] + local[1] * fe->orientation.axis[1][1] + local[2] * fe->orientation.axis[2][1] + fe->orientation.origin[1];
+	world[2] = local[0] * fe->orientation.axis[0][2] + local[1] * fe->orientation.axis[1][2] + local[2] * fe->orientation.axis[2][2] + fe->orientation.origin[2];
 }
 
 /*
@@ -190,9 +191,9 @@ R_WorldToLocal
 =================
 */
 void R_WorldToLocal (vec3_t world, vec3_t local) {
-	local[0] = DotProduct(world, tr.orientation.axis[0]);
-	local[1] = DotProduct(world, tr.orientation.axis[1]);
-	local[2] = DotProduct(world, tr.orientation.axis[2]);
+	local[0] = DotProduct(world, fe->orientation.axis[0]);
+	local[1] = DotProduct(world, fe->orientation.axis[1]);
+	local[2] = DotProduct(world, fe->orientation.axis[2]);
 }
 
 /*
@@ -343,28 +344,28 @@ void R_RotateForViewer (void)
 	float	viewerMatrix[16];
 	vec3_t	origin;
 
-	Com_Memset (&tr.orientation, 0, sizeof(tr.orientation));
-	tr.orientation.axis[0][0] = 1;
-	tr.orientation.axis[1][1] = 1;
-	tr.orientation.axis[2][2] = 1;
-	VectorCopy (tr.viewParms.orientation.origin, tr.orientation.viewOrigin);
+	Com_Memset (&fe->orientation, 0, sizeof(fe->orientation));
+	fe->orientation.axis[0][0] = 1;
+	fe->orientation.axis[1][1] = 1;
+	fe->orientation.axis[2][2] = 1;
+	VectorCopy (fe->viewParms.orientation.origin, fe->orientation.viewOrigin);
 
 	// transform by the camera placement
-	VectorCopy( tr.viewParms.orientation.origin, origin );
+	VectorCopy( fe->viewParms.orientation.origin, origin );
 
-	viewerMatrix[0] = tr.viewParms.orientation.axis[0][0];
-	viewerMatrix[4] = tr.viewParms.orientation.axis[0][1];
-	viewerMatrix[8] = tr.viewParms.orientation.axis[0][2];
+	viewerMatrix[0] = fe->viewParms.orientation.axis[0][0];
+	viewerMatrix[4] = fe->viewParms.orientation.axis[0][1];
+	viewerMatrix[8] = fe->viewParms.orientation.axis[0][2];
 	viewerMatrix[12] = -origin[0] * viewerMatrix[0] + -origin[1] * viewerMatrix[4] + -origin[2] * viewerMatrix[8];
 
-	viewerMatrix[1] = tr.viewParms.orientation.axis[1][0];
-	viewerMatrix[5] = tr.viewParms.orientation.axis[1][1];
-	viewerMatrix[9] = tr.viewParms.orientation.axis[1][2];
+	viewerMatrix[1] = fe->viewParms.orientation.axis[1][0];
+	viewerMatrix[5] = fe->viewParms.orientation.axis[1][1];
+	viewerMatrix[9] = fe->viewParms.orientation.axis[1][2];
 	viewerMatrix[13] = -origin[0] * viewerMatrix[1] + -origin[1] * viewerMatrix[5] + -origin[2] * viewerMatrix[9];
 
-	viewerMatrix[2] = tr.viewParms.orientation.axis[2][0];
-	viewerMatrix[6] = tr.viewParms.orientation.axis[2][1];
-	viewerMatrix[10] = tr.viewParms.orientation.axis[2][2];
+	viewerMatrix[2] = fe->viewParms.orientation.axis[2][0];
+	viewerMatrix[6] = fe->viewParms.orientation.axis[2][1];
+	viewerMatrix[10] = fe->viewParms.orientation.axis[2][2];
 	viewerMatrix[14] = -origin[0] * viewerMatrix[2] + -origin[1] * viewerMatrix[6] + -origin[2] * viewerMatrix[10];
 
 	viewerMatrix[3] = 0;
@@ -374,9 +375,9 @@ void R_RotateForViewer (void)
 
 	// convert from our coordinate system (looking down X)
 	// to OpenGL's coordinate system (looking down -Z)
-	myGlMultMatrix( viewerMatrix, s_flipMatrix, tr.orientation.modelMatrix );
+	myGlMultMatrix( viewerMatrix, s_flipMatrix, fe->orientation.modelMatrix );
 
-	tr.viewParms.world = tr.orientation;
+	fe->viewParms.world = fe->orientation;
 
 }
 
@@ -391,7 +392,7 @@ static void R_SetFarClip( void )
 	// if not rendering the world (icons, menus, etc)
 	// set a 2k far clip plane
 	if ( tr.refdef.rdflags & RDF_NOWORLDMODEL ) {
-		tr.viewParms.zFar = 2048;
+		fe->viewParms.zFar = 2048;
 		return;
 	}
 
@@ -407,32 +408,32 @@ static void R_SetFarClip( void )
 
 		if ( i & 1 )
 		{
-			v[0] = tr.viewParms.visBounds[0][0];
+			v[0] = fe->viewParms.visBounds[0][0];
 		}
 		else
 		{
-			v[0] = tr.viewParms.visBounds[1][0];
+			v[0] = fe->viewParms.visBounds[1][0];
 		}
 
 		if ( i & 2 )
 		{
-			v[1] = tr.viewParms.visBounds[0][1];
+			v[1] = fe->viewParms.visBounds[0][1];
 		}
 		else
 		{
-			v[1] = tr.viewParms.visBounds[1][1];
+			v[1] = fe->viewParms.visBounds[1][1];
 		}
 
 		if ( i & 4 )
 		{
-			v[2] = tr.viewParms.visBounds[0][2];
+			v[2] = fe->viewParms.visBounds[0][2];
 		}
 		else
 		{
-			v[2] = tr.viewParms.visBounds[1][2];
+			v[2] = fe->viewParms.visBounds[1][2];
 		}
 
-		VectorSubtract( v, tr.viewParms.orientation.origin, vecTo );
+		VectorSubtract( v, fe->viewParms.orientation.origin, vecTo );
 
 		distance = vecTo[0] * vecTo[0] + vecTo[1] * vecTo[1] + vecTo[2] * vecTo[2];
 
@@ -441,7 +442,7 @@ static void R_SetFarClip( void )
 			farthestCornerDistance = distance;
 		}
 	}
-	tr.viewParms.zFar = sqrt( farthestCornerDistance );
+	fe->viewParms.zFar = sqrt( farthestCornerDistance );
 }
 
 /*
@@ -682,19 +683,19 @@ bool R_GetPortalOrientations( drawSurf_t *drawSurf, int entityNum,
 
 	// rotate the plane if necessary
 	if ( entityNum != REFENTITYNUM_WORLD ) {
-		tr.currentEntityNum = entityNum;
-		tr.currentEntity = &tr.refdef.entities[entityNum];
+		fe->currentEntityNum = entityNum;
+		fe->currentEntity = &tr.refdef.entities[entityNum];
 
 		// get the orientation of the entity
-		R_RotateForEntity( tr.currentEntity, &tr.viewParms, &tr.orientation );
+		R_RotateForEntity( fe->currentEntity, &fe->viewParms, &fe->orientation );
 
 		// rotate the plane, but keep the non-rotated version for matching
 		// against the portalSurface entities
 		R_LocalNormalToWorld( originalPlane.normal, plane.normal );
-		plane.dist = originalPlane.dist + DotProduct( plane.normal, tr.orientation.origin );
+		plane.dist = originalPlane.dist + DotProduct( plane.normal, fe->orientation.origin );
 
 		// translate the original plane
-		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, tr.orientation.origin );
+		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, fe->orientation.origin );
 	} else {
 		plane = originalPlane;
 	}
@@ -800,19 +801,19 @@ static bool IsMirror( const drawSurf_t *drawSurf, int entityNum )
 	// rotate the plane if necessary
 	if ( entityNum != REFENTITYNUM_WORLD )
 	{
-		tr.currentEntityNum = entityNum;
-		tr.currentEntity = &tr.refdef.entities[entityNum];
+		fe->currentEntityNum = entityNum;
+		fe->currentEntity = &tr.refdef.entities[entityNum];
 
 		// get the orientation of the entity
-		R_RotateForEntity( tr.currentEntity, &tr.viewParms, &tr.orientation );
+		R_RotateForEntity( fe->currentEntity, &fe->viewParms, &fe->orientation );
 
 		// rotate the plane, but keep the non-rotated version for matching
 		// against the portalSurface entities
 		R_LocalNormalToWorld( originalPlane.normal, plane.normal );
-		plane.dist = originalPlane.dist + DotProduct( plane.normal, tr.orientation.origin );
+		plane.dist = originalPlane.dist + DotProduct( plane.normal, fe->orientation.origin );
 
 		// translate the original plane
-		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, tr.orientation.origin );
+		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, fe->orientation.origin );
 	} 
 
 	// locate the portal entity closest to this plane.
@@ -873,7 +874,7 @@ static bool SurfIsOffscreen( const drawSurf_t *drawSurf, vec4_t clipDest[128] )
 		int j;
 		unsigned int pointFlags = 0;
 
-		R_TransformModelToClip( tess.xyz[i], tr.orientation.modelMatrix, tr.viewParms.projectionMatrix, eye, clip );
+		R_TransformModelToClip( tess.xyz[i], fe->orientation.modelMatrix, fe->viewParms.projectionMatrix, eye, clip );
 
 		for ( j = 0; j < 3; j++ )
 		{
@@ -908,7 +909,7 @@ static bool SurfIsOffscreen( const drawSurf_t *drawSurf, vec4_t clipDest[128] )
 		vec3_t normal;
 		float len;
 
-		VectorSubtract( tess.xyz[tess.indexes[i]], tr.viewParms.orientation.origin, normal );
+		VectorSubtract( tess.xyz[tess.indexes[i]], fe->viewParms.orientation.origin, normal );
 
 		len = VectorLengthSquared( normal );			// lose the sqrt
 		if ( len < shortest )
@@ -955,7 +956,7 @@ bool R_MirrorViewBySurface (drawSurf_t *drawSurf, int entityNum) {
 	orientation_t	surface, camera;
 
 	// don't recursively mirror
-	if (tr.viewParms.isPortal) {
+	if (fe->viewParms.isPortal) {
 		ri.Printf( PRINT_DEVELOPER, "WARNING: recursive mirror/portal found\n" );
 		return false;
 	}
@@ -970,9 +971,9 @@ bool R_MirrorViewBySurface (drawSurf_t *drawSurf, int entityNum) {
 	}
 
 	// save old viewParms so we can return to it after the mirror view
-	oldParms = tr.viewParms;
+	oldParms = fe->viewParms;
 
-	newParms = tr.viewParms;
+	newParms = fe->viewParms;
 	newParms.isPortal = true;
 	if ( !R_GetPortalOrientations( drawSurf, entityNum, &surface, &camera, 
 		newParms.pvsOrigin, &newParms.isMirror ) ) {
@@ -993,7 +994,7 @@ bool R_MirrorViewBySurface (drawSurf_t *drawSurf, int entityNum) {
 	// render the mirror view
 	R_RenderView (&newParms);
 
-	tr.viewParms = oldParms;
+	fe->viewParms = oldParms;
 
 	return true;
 }
@@ -1096,6 +1097,41 @@ static void R_RadixSort( drawSurf_t *source, int size )
 
 //==========================================================================================
 
+/*
+=================
+R_PackDrawSurf
+
+Fills in a draw surface for the current entity without adding it
+to the refdef, so jobs can build their own lists
+=================
+*/
+void R_PackDrawSurf( drawSurf_t *drawSurf, surfaceType_t *surface, shader_t *shader, 
+				   int fogIndex, int dlightMap ) {
+	// the sort data is packed into a single 32 bit value so it can be
+	// compared quickly during the qsorting process
+	drawSurf->sort = (shader->sortedIndex << QSORT_SHADERNUM_SHIFT) 
+		| fe->shiftedEntityNum | ( fogIndex << QSORT_FOGNUM_SHIFT ) | (int)dlightMap;
+	drawSurf->surface = surface;
+}
+
+/*
+=================
+R_EntityJobFailed
+
+Entity jobs can't print, drop or touch the world surfaces, so they
+give up on the entity instead and the calling thread adds it again.
+Returns false outside of the jobs.
+=================
+*/
+bool R_EntityJobFailed( void ) {
+	if ( fe == &tr.frontEnd ) {
+		return false;
+	}
+
+	fe->failed = true;
+	return true;
+}
+
 /*
 =================
 R_AddDrawSurf
@@ -1105,17 +1141,38 @@ void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader,
 				   int fogIndex, int dlightMap ) {
 	int			index;
 
+	if ( fe->drawSurfs ) {
+		if ( fe->numDrawSurfs >= fe->maxDrawSurfs ) {
+			R_EntityJobFailed();
+			return;
+		}
+		R_PackDrawSurf( &fe->drawSurfs[fe->numDrawSurfs++], surface, shader, fogIndex, dlightMap );
+		return;
+	}
+
 	// instead of checking for overflow, we just mask the index
 	// so it wraps around
 	index = tr.refdef.numDrawSurfs & DRAWSURF_MASK;
-	// the sort data is packed into a single 32 bit value so it can be
-	// compared quickly during the qsorting process
-	tr.refdef.drawSurfs[index].sort = (shader->sortedIndex << QSORT_SHADERNUM_SHIFT) 
-		| tr.shiftedEntityNum | ( fogIndex << QSORT_FOGNUM_SHIFT ) | (int)dlightMap;
-	tr.refdef.drawSurfs[index].surface = surface;
+	R_PackDrawSurf( &tr.refdef.drawSurfs[index], surface, shader, fogIndex, dlightMap );
 	tr.refdef.numDrawSurfs++;
 }
 
+/*
+=================
+R_AddDrawSurfs
+
+Appends surfaces filled in by R_PackDrawSurf
+=================
+*/
+void R_AddDrawSurfs( const drawSurf_t *drawSurfs, int numDrawSurfs ) {
+	int			i;
+
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		tr.refdef.drawSurfs[tr.refdef.numDrawSurfs & DRAWSURF_MASK] = drawSurfs[i];
+		tr.refdef.numDrawSurfs++;
+	}
+}
+
 /*
 =================
 R_DecomposeSort
@@ -1178,95 +1235,240 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	R_AddDrawSurfCmd( drawSurfs, numDrawSurfs );
 }
 
+extern	cvar_t	*r_debugLight;
+
+#define	MIN_ENTITY_JOB_ENTITIES		32
+// fewer entities than this are added on the calling thread
+
+#define	ENTITY_JOB_SIZE				16
+#define	MAX_ENTITY_JOBS				( ( MAX_REFENTITIES + ENTITY_JOB_SIZE - 1 ) / ENTITY_JOB_SIZE )
+#define	MAX_ENTITY_JOB_DRAWSURFS	1024
+
+// a range of entities
+typedef struct {
+	frontEndState_t		state;
+	frontEndCounters_t	pc;
+
+	int					firstEntity;
+	int					failedEntities[ENTITY_JOB_SIZE];
+	int					numFailedEntities;
+} entityJob_t;
+
+static entityJob_t	entityJobs[MAX_ENTITY_JOBS];
+static drawSurf_t	entityJobDrawSurfs[MAX_ENTITY_JOBS][MAX_ENTITY_JOB_DRAWSURFS];
+
 /*
 =============
-R_AddEntitySurfaces
+R_AddEntitySurface
 =============
 */
-void R_AddEntitySurfaces (void) {
+static void R_AddEntitySurface( int entityNum ) {
 	trRefEntity_t	*ent;
 	shader_t		*shader;
 
-	if ( !r_drawentities->integer ) {
-		return;
-	}
+	fe->currentEntityNum = entityNum;
 
-	for ( tr.currentEntityNum = 0; 
-	      tr.currentEntityNum < tr.refdef.num_entities; 
-		  tr.currentEntityNum++ ) {
-		ent = tr.currentEntity = &tr.refdef.entities[tr.currentEntityNum];
+	ent = fe->currentEntity = &tr.refdef.entities[fe->currentEntityNum];
 
-		ent->needDlights = false;
+	ent->needDlights = false;
 
-		// preshift the value we are going to OR into the drawsurf sort
-		tr.shiftedEntityNum = tr.currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
+	// preshift the value we are going to OR into the drawsurf sort
+	fe->shiftedEntityNum = fe->currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
 
-		//
-		// the weapon model must be handled special --
-		// we don't want the hacked weapon position showing in 
-		// mirrors, because the true body position will already be drawn
-		//
-		if ( (ent->e.renderfx & RF_FIRST_PERSON) && tr.viewParms.isPortal) {
-			continue;
-		}
+	//
+	// the weapon model must be handled special --
+	// we don't want the hacked weapon position showing in 
+	// mirrors, because the true body position will already be drawn
+	//
+	if ( (ent->e.renderfx & RF_FIRST_PERSON) && fe->viewParms.isPortal) {
+		return;
+	}
 
-		// simple generated models, like sprites and beams, are not culled
-		switch ( ent->e.reType ) {
-		case RT_PORTALSURFACE:
-			break;		// don't draw anything
-		case RT_SPRITE:
-		case RT_BEAM:
-		case RT_LIGHTNING:
-		case RT_RAIL_CORE:
-		case RT_RAIL_RINGS:
-			// self blood sprites, talk balloons, etc should not be drawn in the primary
-			// view.  We can't just do this check for all entities, because md3
-			// entities may still want to cast shadows from them
-			if ( (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal) {
-				continue;
-			}
-			shader = R_GetShaderByHandle( ent->e.customShader );
-			R_AddDrawSurf( &entitySurface, shader, R_SpriteFogNum( ent ), 0 );
-			break;
+	// simple generated models, like sprites and beams, are not culled
+	switch ( ent->e.reType ) {
+	case RT_PORTALSURFACE:
+		break;		// don't draw anything
+	case RT_SPRITE:
+	case RT_BEAM:
+	case RT_LIGHTNING:
+	case RT_RAIL_CORE:
+	case RT_RAIL_RINGS:
+		// self blood sprites, talk balloons, etc should not be drawn in the primary
+		// view.  We can't just do this check for all entities, because md3
+		// entities may still want to cast shadows from them
+		if ( (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal) {
+			return;
+		}
+		shader = R_GetShaderByHandle( ent->e.customShader );
+		R_AddDrawSurf( &entitySurface, shader, R_SpriteFogNum( ent ), 0 );
+		break;
 
-		case RT_MODEL:
-			// we must set up parts of tr.orientation for model culling
-			R_RotateForEntity( ent, &tr.viewParms, &tr.orientation );
+	case RT_MODEL:
+		// we must set up parts of fe->orientation for model culling
+		R_RotateForEntity( ent, &fe->viewParms, &fe->orientation );
 
-			tr.currentModel = R_GetModelByHandle( ent->e.hModel );
-			if (!tr.currentModel) {
-				R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
-			} else {
-				switch ( tr.currentModel->type ) {
-				case MOD_MESH:
-					R_AddMD3Surfaces( ent );
-					break;
-				case MOD_MDR:
-					R_MDRAddAnimSurfaces( ent );
-					break;
-				case MOD_IQM:
-					R_AddIQMSurfaces( ent );
-					break;
-				case MOD_BRUSH:
-					R_AddBrushModelSurfaces( ent );
+		fe->currentModel = R_GetModelByHandle( ent->e.hModel );
+		if (!fe->currentModel) {
+			R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
+		} else {
+			switch ( fe->currentModel->type ) {
+			case MOD_MESH:
+				R_AddMD3Surfaces( ent );
+				break;
+			case MOD_MDR:
+				R_MDRAddAnimSurfaces( ent );
+				break;
+			case MOD_IQM:
+				R_AddIQMSurfaces( ent );
+				break;
+			case MOD_BRUSH:
+				// brush models mark the world surfaces they add
+				if ( R_EntityJobFailed() ) {
 					break;
-				case MOD_BAD:		// null model axis
-					if ( (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal) {
-						break;
-					}
-					R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
+				}
+				R_AddBrushModelSurfaces( ent );
+				break;
+			case MOD_BAD:		// null model axis
+				if ( (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal) {
 					break;
-				default:
-					ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad modeltype" );
+				}
+				R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0 );
+				break;
+			default:
+				if ( R_EntityJobFailed() ) {
 					break;
 				}
+				ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad modeltype" );
+				break;
 			}
+		}
+		break;
+	default:
+		if ( R_EntityJobFailed() ) {
+			break;
+		}
+		ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad reType" );
+	}
+}
+
+/*
+=================
+R_AddJobEntitySurface
+
+Adds an entity to the draw surfaces of the job.  If the job fails on
+it, the entity is left to the calling thread with nothing added.
+=================
+*/
+static void R_AddJobEntitySurface( entityJob_t *job, int entityNum ) {
+	trRefEntity_t			*ent = &tr.refdef.entities[entityNum];
+	struct animSurface_s	*animSurfaces = ent->animSurfaces;
+	int						numDrawSurfs = fe->numDrawSurfs;
+
+	fe->failed = false;
+	R_AddEntitySurface( entityNum );
+	if ( !fe->failed ) {
+		return;
+	}
+
+	fe->numDrawSurfs = numDrawSurfs;
+	ent->animSurfaces = animSurfaces;
+	job->failedEntities[job->numFailedEntities++] = entityNum;
+}
+
+/*
+=================
+R_AddEntitySurfacesJob
+
+Points fe at the state of the job, starting from the view of the
+calling thread, and adds a range of entities
+=================
+*/
+static void R_AddEntitySurfacesJob( void *data, int index ) {
+	entityJob_t	*job = &entityJobs[index];
+	int			i;
+
+	job->state = tr.frontEnd;
+	job->state.pc = &job->pc;
+	job->state.drawSurfs = entityJobDrawSurfs[index];
+	job->state.numDrawSurfs = 0;
+	job->state.maxDrawSurfs = MAX_ENTITY_JOB_DRAWSURFS;
+	job->numFailedEntities = 0;
+	Com_Memset( &job->pc, 0, sizeof( job->pc ) );
+
+	fe = &job->state;
+
+	for ( i = 0 ; i < ENTITY_JOB_SIZE ; i++ ) {
+		if ( job->firstEntity + i >= tr.refdef.num_entities ) {
 			break;
-		default:
-			ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad reType" );
+		}
+		R_AddJobEntitySurface( job, job->firstEntity + i );
+	}
+
+	fe = &tr.frontEnd;
+}
+
+/*
+=================
+R_EndEntityJob
+
+Appends the draw surfaces of the job and adds the entities it failed
+on.  Surfaces of different entities never sort equal, so these can
+go after the rest.
+=================
+*/
+static void R_EndEntityJob( entityJob_t *job ) {
+	int		i;
+
+	R_AddDrawSurfs( job->state.drawSurfs, job->state.numDrawSurfs );
+
+	tr.pc.c_sphere_cull_md3_in += job->pc.c_sphere_cull_md3_in;
+	tr.pc.c_sphere_cull_md3_clip += job->pc.c_sphere_cull_md3_clip;
+	tr.pc.c_sphere_cull_md3_out += job->pc.c_sphere_cull_md3_out;
+	tr.pc.c_box_cull_md3_in += job->pc.c_box_cull_md3_in;
+	tr.pc.c_box_cull_md3_clip += job->pc.c_box_cull_md3_clip;
+	tr.pc.c_box_cull_md3_out += job->pc.c_box_cull_md3_out;
+
+	for ( i = 0 ; i < job->numFailedEntities ; i++ ) {
+		R_AddEntitySurface( job->failedEntities[i] );
+	}
+}
+
+/*
+=============
+R_AddEntitySurfaces
+=============
+*/
+void R_AddEntitySurfaces (void) {
+	int				i;
+	int				numJobs;
+	int				firstAnimSurface;
+
+	if ( !r_drawentities->integer ) {
+		return;
+	}
+
+	firstAnimSurface = r_numAnimSurfaces;
+
+	// r_debuglight prints from inside the lighting
+	if ( !r_frontEndJobs->integer || r_debugLight->integer
+		|| tr.refdef.num_entities < MIN_ENTITY_JOB_ENTITIES ) {
+		for ( i = 0 ; i < tr.refdef.num_entities ; i++ ) {
+			R_AddEntitySurface( i );
+		}
+	} else {
+		numJobs = ( tr.refdef.num_entities + ENTITY_JOB_SIZE - 1 ) / ENTITY_JOB_SIZE;
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			entityJobs[i].firstEntity = i * ENTITY_JOB_SIZE;
+		}
+
+		ri.ParallelFor( numJobs, R_AddEntitySurfacesJob, NULL );
+
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			R_EndEntityJob( &entityJobs[i] );
 		}
 	}
 
+	R_AnimateEntitySurfaces( firstAnimSurface );
 }
 
 
@@ -1290,7 +1492,7 @@ void R_GenerateDrawSurfs( void ) {
 	R_SetFarClip();
 
 	// we know the size of the clipping volume. Now set the rest of the projection matrix.
-	R_SetupProjectionZ (&tr.viewParms);
+	R_SetupProjectionZ (&fe->viewParms);
 
 	R_AddEntitySurfaces ();
 }
@@ -1364,9 +1566,9 @@ void R_RenderView (viewParms_t *parms) {
 
 	tr.viewCount++;
 
-	tr.viewParms = *parms;
-	tr.viewParms.frameSceneNum = tr.frameSceneNum;
-	tr.viewParms.frameCount = tr.frameCount;
+	fe->viewParms = *parms;
+	fe->viewParms.frameSceneNum = tr.frameSceneNum;
+	fe->viewParms.frameCount = tr.frameCount;
 
 	firstDrawSurf = tr.refdef.numDrawSurfs;
 
@@ -1375,7 +1577,7 @@ void R_RenderView (viewParms_t *parms) {
 	// set viewParms.world
 	R_RotateForViewer ();
 
-	R_SetupProjection(&tr.viewParms, r_zproj->value, true);
+	R_SetupProjection(&fe->viewParms, r_zproj->value, true);
 
 	R_GenerateDrawSurfs();
 
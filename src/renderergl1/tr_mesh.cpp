@@ -33,8 +33,8 @@ static float ProjectRadius( float r, vec3_t location )
 	vec3_t	p;
 	float	projected[4];
 
-	c = DotProduct( tr.viewParms.orientation.axis[0], tr.viewParms.orientation.origin );
-	dist = DotProduct( tr.viewParms.orientation.axis[0], location ) - c;
+	c = DotProduct( fe->viewParms.orientation.axis[0], fe->viewParms.orientation.origin );
+	dist = DotProduct( fe->viewParms.orientation.axis[0], location ) - c;
 
 	if ( dist <= 0 )
 		return 0;
@@ -43,25 +43,25 @@ static float ProjectRadius( float r, vec3_t location )
 	p[1] = fabs( r );
 	p[2] = -dist;
 
-	projected[0] = p[0] * tr.viewParms.projectionMatrix[0] + 
-		           p[1] * tr.viewParms.projectionMatrix[4] +
-				   p[2] * tr.viewParms.projectionMatrix[8] +
-				   tr.viewParms.projectionMatrix[12];
+	projected[0] = p[0] * fe->viewParms.projectionMatrix[0] + 
+		           p[1] * fe->viewParms.projectionMatrix[4] +
+				   p[2] * fe->viewParms.projectionMatrix[8] +
+				   fe->viewParms.projectionMatrix[12];
 
-	projected[1] = p[0] * tr.viewParms.projectionMatrix[1] + 
-		           p[1] * tr.viewParms.projectionMatrix[5] +
-				   p[2] * tr.viewParms.projectionMatrix[9] +
-				   tr.viewParms.projectionMatrix[13];
+	projected[1] = p[0] * fe->viewParms.projectionMatrix[1] + 
+		           p[1] * fe->viewParms.projectionMatrix[5] +
+				   p[2] * fe->viewParms.projectionMatrix[9] +
+				   fe->viewParms.projectionMatrix[13];
 
-	projected[2] = p[0] * tr.viewParms.projectionMatrix[2] + 
-		           p[1] * tr.viewParms.projectionMatrix[6] +
-				   p[2] * tr.viewParms.projectionMatrix[10] +
-				   tr.viewParms.projectionMatrix[14];
+	projected[2] = p[0] * fe->viewParms.projectionMatrix[2] + 
+		           p[1] * fe->viewParms.projectionMatrix[6] +
+				   p[2] * fe->viewParms.projectionMatrix[10] +
+				   fe->viewParms.projectionMatrix[14];
 
-	projected[3] = p[0] * tr.viewParms.projectionMatrix[3] + 
-		           p[1] * tr.viewParms.projectionMatrix[7] +
-				   p[2] * tr.viewParms.projectionMatrix[11] +
-				   tr.viewParms.projectionMatrix[15];
+	projected[3] = p[0] * fe->viewParms.projectionMatrix[3] + 
+		           p[1] * fe->viewParms.projectionMatrix[7] +
+				   p[2] * fe->viewParms.projectionMatrix[11] +
+				   fe->viewParms.projectionMatrix[15];
 
 
 	pr = projected[1] / projected[3];
@@ -94,15 +94,15 @@ static int R_CullModel( md3Header_t *header, trRefEntity_t *ent ) {
 			switch ( R_CullLocalPointAndRadius( newFrame->localOrigin, newFrame->radius ) )
 			{
 			case CULL_OUT:
-				tr.pc.c_sphere_cull_md3_out++;
+				fe->pc->c_sphere_cull_md3_out++;
 				return CULL_OUT;
 
 			case CULL_IN:
-				tr.pc.c_sphere_cull_md3_in++;
+				fe->pc->c_sphere_cull_md3_in++;
 				return CULL_IN;
 
 			case CULL_CLIP:
-				tr.pc.c_sphere_cull_md3_clip++;
+				fe->pc->c_sphere_cull_md3_clip++;
 				break;
 			}
 		}
@@ -121,17 +121,17 @@ static int R_CullModel( md3Header_t *header, trRefEntity_t *ent ) {
 			{
 				if ( sphereCull == CULL_OUT )
 				{
-					tr.pc.c_sphere_cull_md3_out++;
+					fe->pc->c_sphere_cull_md3_out++;
 					return CULL_OUT;
 				}
 				else if ( sphereCull == CULL_IN )
 				{
-					tr.pc.c_sphere_cull_md3_in++;
+					fe->pc->c_sphere_cull_md3_in++;
 					return CULL_IN;
 				}
 				else
 				{
-					tr.pc.c_sphere_cull_md3_clip++;
+					fe->pc->c_sphere_cull_md3_clip++;
 				}
 			}
 		}
@@ -146,14 +146,14 @@ static int R_CullModel( md3Header_t *header, trRefEntity_t *ent ) {
 	switch ( R_CullLocalBox( bounds ) )
 	{
 	case CULL_IN:
-		tr.pc.c_box_cull_md3_in++;
+		fe->pc->c_box_cull_md3_in++;
 		return CULL_IN;
 	case CULL_CLIP:
-		tr.pc.c_box_cull_md3_clip++;
+		fe->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	case CULL_OUT:
 	default:
-		tr.pc.c_box_cull_md3_out++;
+		fe->pc->c_box_cull_md3_out++;
 		return CULL_OUT;
 	}
 }
@@ -174,7 +174,7 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 	mdrFrame_t *mdrframe;
 	int lod;
 
-	if ( tr.currentModel->numLods < 2 )
+	if ( fe->currentModel->numLods < 2 )
 	{
 		// model has only 1 LOD level, skip computations and bias
 		lod = 0;
@@ -184,10 +184,10 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 		// multiple LODs exist, so compute projected bounding sphere
 		// and use that as a criteria for selecting LOD
 
-		if(tr.currentModel->type == MOD_MDR)
+		if(fe->currentModel->type == MOD_MDR)
 		{
 			int frameSize;
-			mdr = (mdrHeader_t *) tr.currentModel->modelData;
+			mdr = (mdrHeader_t *) fe->currentModel->modelData;
 			frameSize = (size_t) (&((mdrFrame_t *)0)->bones[mdr->numBones]);
 			
 			mdrframe = (mdrFrame_t *) ((byte *) mdr + mdr->ofsFrames + frameSize * ent->e.frame);
@@ -196,7 +196,7 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 		}
 		else
 		{
-			frame = ( md3Frame_t * ) ( ( ( unsigned char * ) tr.currentModel->md3[0] ) + tr.currentModel->md3[0]->ofsFrames );
+			frame = ( md3Frame_t * ) ( ( ( unsigned char * ) fe->currentModel->md3[0] ) + fe->currentModel->md3[0]->ofsFrames );
 
 			frame += ent->e.frame;
 
@@ -215,23 +215,23 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 			flod = 0;
 		}
 
-		flod *= tr.currentModel->numLods;
+		flod *= fe->currentModel->numLods;
 		lod = static_cast<int>(flod);
 
 		if ( lod < 0 )
 		{
 			lod = 0;
 		}
-		else if ( lod >= tr.currentModel->numLods )
+		else if ( lod >= fe->currentModel->numLods )
 		{
-			lod = tr.currentModel->numLods - 1;
+			lod = fe->currentModel->numLods - 1;
 		}
 	}
 
 	lod += r_lodbias->integer;
 	
-	if ( lod >= tr.currentModel->numLods )
-		lod = tr.currentModel->numLods - 1;
+	if ( lod >= fe->currentModel->numLods )
+		lod = fe->currentModel->numLods - 1;
 	if ( lod < 0 )
 		lod = 0;
 
@@ -293,11 +293,11 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	bool		personalModel;
 
 	// don't add third_person objects if not in a portal
-	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal;
+	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal;
 
 	if ( ent->e.renderfx & RF_WRAP_FRAMES ) {
-		ent->e.frame %= tr.currentModel->md3[0]->numFrames;
-		ent->e.oldframe %= tr.currentModel->md3[0]->numFrames;
+		ent->e.frame %= fe->currentModel->md3[0]->numFrames;
+		ent->e.oldframe %= fe->currentModel->md3[0]->numFrames;
 	}
 
 	//
@@ -306,13 +306,16 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	// when the surfaces are rendered, they don't need to be
 	// range checked again.
 	//
-	if ( (ent->e.frame >= tr.currentModel->md3[0]->numFrames) 
+	if ( (ent->e.frame >= fe->currentModel->md3[0]->numFrames) 
 		|| (ent->e.frame < 0)
-		|| (ent->e.oldframe >= tr.currentModel->md3[0]->numFrames)
+		|| (ent->e.oldframe >= fe->currentModel->md3[0]->numFrames)
 		|| (ent->e.oldframe < 0) ) {
+			if ( R_EntityJobFailed() ) {
+				return;
+			}
 			ri.Printf( PRINT_DEVELOPER, "R_AddMD3Surfaces: no such frame %d to %d for '%s'\n",
 				ent->e.oldframe, ent->e.frame,
-				tr.currentModel->name );
+				fe->currentModel->name );
 			ent->e.frame = 0;
 			ent->e.oldframe = 0;
 	}
@@ -322,7 +325,7 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	//
 	lod = R_ComputeLOD( ent );
 
-	header = tr.currentModel->md3[lod];
+	header = fe->currentModel->md3[lod];
 
 	//
 	// cull the entire model if merged bounding box of both frames
@@ -368,6 +371,9 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 					break;
 				}
 			}
+			if ( ( shader == tr.defaultShader || shader->defaultShader ) && R_EntityJobFailed() ) {
+				return;
+			}
 			if (shader == tr.defaultShader) {
 				ri.Printf( PRINT_DEVELOPER, "WARNING: no shader for surface %s in skin %s\n", surface->name, skin->name);
 			}
@@ -407,7 +413,135 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 			R_AddDrawSurf( (surfaceType_t*)surface, shader, fogNum, false );
 		}
 
+		if ( !personalModel || r_shadows->integer == 3 ) {
+			R_QueueSurfaceAnimation( ent, (surfaceType_t*)surface, surface->numVerts );
+		}
+
 		surface = (md3Surface_t *)( (byte *)surface + surface->ofsEnd );
 	}
 
 }
+
+
+/*
+=================
+R_FindSurfaceAnimation
+
+Returns the vertexes the front end animated for this surface of the
+entity, or NULL if the back end has to animate it itself.
+=================
+*/
+const animSurface_t *R_FindSurfaceAnimation( const trRefEntity_t *ent, const surfaceType_t *surface ) {
+	const animSurface_t	*anim;
+
+	for ( anim = ent->animSurfaces ; anim ; anim = anim->next ) {
+		if ( anim->surface == surface ) {
+			return anim;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+=================
+R_QueueSurfaceAnimation
+
+Reserves room for the animated vertexes of an md3 or iqm surface, to be
+filled in by R_AnimateEntitySurfaces.  A surface that is drawn again in
+a portal view keeps the vertexes of the first view.
+=================
+*/
+void R_QueueSurfaceAnimation( trRefEntity_t *ent, surfaceType_t *surface, int numVertexes ) {
+	animSurface_t	*anim;
+	int				surfaceNum;
+	int				firstVertex;
+
+	if ( !r_frontEndJobs->integer ) {
+		return;
+	}
+
+	if ( R_FindSurfaceAnimation( ent, surface ) ) {
+		return;
+	}
+
+	// the entity jobs queue surfaces at the same time
+	surfaceNum = r_numAnimSurfaces;
+	do {
+		if ( surfaceNum >= MAX_ANIMSURFACES ) {
+			return;
+		}
+	} while ( !r_numAnimSurfaces.compare_exchange_weak( surfaceNum, surfaceNum + 1 ) );
+
+	anim = &backEndData->animSurfaces[surfaceNum];
+	anim->surface = NULL;
+
+	firstVertex = r_numAnimVertexes;
+	do {
+		if ( firstVertex + numVertexes > MAX_ANIMVERTEXES ) {
+			return;
+		}
+	} while ( !r_numAnimVertexes.compare_exchange_weak( firstVertex, firstVertex + numVertexes ) );
+
+	anim->surface = surface;
+	anim->entity = ent;
+	anim->firstVertex = firstVertex;
+	anim->numVertexes = numVertexes;
+	anim->next = ent->animSurfaces;
+	ent->animSurfaces = anim;
+}
+
+/*
+=================
+R_AnimateSurfaceJob
+=================
+*/
+static void R_AnimateSurfaceJob( void *data, int index ) {
+	const animSurface_t	*anim = (const animSurface_t *)data + index;
+	const refEntity_t	*e;
+	vec4_t				*xyz;
+	vec4_t				*normal;
+	const srfIQModel_t	*iqm;
+	int					numFrames;
+
+	// out of vertexes when it was queued
+	if ( !anim->surface ) {
+		return;
+	}
+
+	e = &anim->entity->e;
+	xyz = &backEndData->animXyz[anim->firstVertex];
+	normal = &backEndData->animNormals[anim->firstVertex];
+
+	switch ( *anim->surface ) {
+	case SF_MD3:
+		R_LerpMeshVertexes( (const md3Surface_t *)anim->surface, e->frame, e->oldframe,
+			e->oldframe == e->frame ? 0 : e->backlerp, xyz, normal );
+		break;
+	case SF_IQM:
+		iqm = (const srfIQModel_t *)anim->surface;
+		numFrames = iqm->data->num_frames;
+		R_IQMTransformVertexes( iqm, numFrames ? e->frame % numFrames : 0,
+			numFrames ? e->oldframe % numFrames : 0, e->backlerp, xyz, normal );
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+=================
+R_AnimateEntitySurfaces
+
+Animates the surfaces queued since firstAnimSurface on the job threads,
+so the back end only has to copy the vertexes into tess.
+=================
+*/
+void R_AnimateEntitySurfaces( int firstAnimSurface ) {
+	if ( r_numAnimSurfaces <= firstAnimSurface ) {
+		return;
+	}
+
+	ri.ParallelFor( r_numAnimSurfaces - firstAnimSurface, R_AnimateSurfaceJob,
+		&backEndData->animSurfaces[firstAnimSurface] );
+}
@@ -752,7 +752,7 @@ static int R_CullIQM( iqmData_t *data, trRefEntity_t *ent ) {
 	int		i;
 
 	if (!data->bounds) {
-		tr.pc.c_box_cull_md3_clip++;
+		fe->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	}
 
@@ -769,14 +769,14 @@ static int R_CullIQM( iqmData_t *data, trRefEntity_t *ent ) {
 	switch ( R_CullLocalBox( bounds ) )
 	{
 	case CULL_IN:
-		tr.pc.c_box_cull_md3_in++;
+		fe->pc->c_box_cull_md3_in++;
 		return CULL_IN;
 	case CULL_CLIP:
-		tr.pc.c_box_cull_md3_clip++;
+		fe->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	case CULL_OUT:
 	default:
-		tr.pc.c_box_cull_md3_out++;
+		fe->pc->c_box_cull_md3_out++;
 		return CULL_OUT;
 	}
 }
@@ -846,11 +846,11 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 	shader_t		*shader;
 	skin_t			*skin;
 
-	data = (iqmData_t*)tr.currentModel->modelData;
+	data = (iqmData_t*)fe->currentModel->modelData;
 	surface = data->surfaces;
 
 	// don't add third_person objects if not in a portal
-	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal;
+	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal;
 
 	if ( ent->e.renderfx & RF_WRAP_FRAMES ) {
 		ent->e.frame %= data->num_frames;
@@ -867,9 +867,12 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 	     || (ent->e.frame < 0)
 	     || (ent->e.oldframe >= data->num_frames)
 	     || (ent->e.oldframe < 0) ) {
+		if ( R_EntityJobFailed() ) {
+			return;
+		}
 		ri.Printf( PRINT_DEVELOPER, "R_AddIQMSurfaces: no such frame %d to %d for '%s'\n",
 			   ent->e.oldframe, ent->e.frame,
-			   tr.currentModel->name );
+			   fe->currentModel->name );
 		ent->e.frame = 0;
 		ent->e.oldframe = 0;
 	}
@@ -938,6 +941,10 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 			R_AddDrawSurf( (surfaceType_t*)surface, shader, fogNum, 0 );
 		}
 
+		if( !personalModel || r_shadows->integer == 3 ) {
+			R_QueueSurfaceAnimation( ent, (surfaceType_t*)surface, surface->num_vertexes );
+		}
+
 		surface++;
 	}
 }
@@ -1011,45 +1018,26 @@ static void ComputeJointMats( iqmData_t *data, int frame, int oldframe,
 
 /*
 =================
-RB_AddIQMSurfaces
+R_IQMTransformVertexes
 
-Compute vertices for this model surface
+Writes the skinned positions and normals of this model surface to
+outXYZ and outNormal.  Only reads the model data, so the front end can
+call it from the job threads.
 =================
 */
-void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
-	srfIQModel_t	*surf = (srfIQModel_t *)surface;
+void R_IQMTransformVertexes( const srfIQModel_t *surf, int frame, int oldframe, float backlerp,
+                             vec4_t *outXYZ, vec4_t *outNormal ) {
 	iqmData_t	*data = surf->data;
 	float		jointMats[IQM_MAX_JOINTS * 12];
 	int		i;
 
-	vec4_t		*outXYZ;
-	vec4_t		*outNormal;
-	vec2_t		(*outTexCoord)[2];
-	color4ub_t	*outColor;
-
-	int	frame = data->num_frames ? backEnd.currentEntity->e.frame % data->num_frames : 0;
-	int	oldframe = data->num_frames ? backEnd.currentEntity->e.oldframe % data->num_frames : 0;
-	float	backlerp = backEnd.currentEntity->e.backlerp;
-
-	int		*tri;
-	glIndex_t	*ptr;
-	glIndex_t	base;
-
-	RB_CHECKOVERFLOW( surf->num_vertexes, surf->num_triangles * 3 );
-
-	outXYZ = &tess.xyz[tess.numVertexes];
-	outNormal = &tess.normal[tess.numVertexes];
-	outTexCoord = &tess.texCoords[tess.numVertexes];
-	outColor = &tess.vertexColors[tess.numVertexes];
-
 	// compute interpolated joint matrices
 	if ( data->num_poses > 0 ) {
 		ComputePoseMats( data, frame, oldframe, backlerp, jointMats );
 	}
 
-	// transform vertexes and fill other data
-	for( i = 0; i < surf->num_vertexes;
-	     i++, outXYZ++, outNormal++, outTexCoord++, outColor++ ) {
+	// transform vertexes
+	for( i = 0; i < surf->num_vertexes; i++, outXYZ++, outNormal++ ) {
 		int	j, k;
 		float	vtxMat[12];
 		float	nrmMat[9];
@@ -1093,11 +1081,6 @@ void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
 		nrmMat[ 7] = vtxMat[ 2]*vtxMat[ 4] - vtxMat[ 0]*vtxMat[ 6];
 		nrmMat[ 8] = vtxMat[ 0]*vtxMat[ 5] - vtxMat[ 1]*vtxMat[ 4];
 
-		(*outTexCoord)[0][0] = data->texcoords[2*vtx + 0];
-		(*outTexCoord)[0][1] = data->texcoords[2*vtx + 1];
-		(*outTexCoord)[1][0] = (*outTexCoord)[0][0];
-		(*outTexCoord)[1][1] = (*outTexCoord)[0][1];
-
 		(*outXYZ)[0] =
 			vtxMat[ 0] * data->positions[3*vtx+0] +
 			vtxMat[ 1] * data->positions[3*vtx+1] +
@@ -1128,6 +1111,57 @@ void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
 			nrmMat[ 7] * data->normals[3*vtx+1] +
 			nrmMat[ 8] * data->normals[3*vtx+2];
 		(*outNormal)[3] = 0.0f;
+	}
+}
+
+/*
+=================
+RB_AddIQMSurfaces
+
+Compute vertices for this model surface
+=================
+*/
+void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
+	srfIQModel_t	*surf = (srfIQModel_t *)surface;
+	iqmData_t	*data = surf->data;
+	const animSurface_t	*anim;
+	int		i;
+
+	vec2_t		(*outTexCoord)[2];
+	color4ub_t	*outColor;
+
+	int	frame = data->num_frames ? backEnd.currentEntity->e.frame % data->num_frames : 0;
+	int	oldframe = data->num_frames ? backEnd.currentEntity->e.oldframe % data->num_frames : 0;
+	float	backlerp = backEnd.currentEntity->e.backlerp;
+
+	int		*tri;
+	glIndex_t	*ptr;
+	glIndex_t	base;
+
+	RB_CHECKOVERFLOW( surf->num_vertexes, surf->num_triangles * 3 );
+
+	// the front end may have skinned it already
+	anim = R_FindSurfaceAnimation( backEnd.currentEntity, surface );
+	if ( anim ) {
+		Com_Memcpy( tess.xyz[tess.numVertexes], backEndData->animXyz[anim->firstVertex], anim->numVertexes * sizeof( vec4_t ) );
+		Com_Memcpy( tess.normal[tess.numVertexes], backEndData->animNormals[anim->firstVertex], anim->numVertexes * sizeof( vec4_t ) );
+	} else {
+		R_IQMTransformVertexes( surf, frame, oldframe, backlerp,
+					&tess.xyz[tess.numVertexes], &tess.normal[tess.numVertexes] );
+	}
+
+	outTexCoord = &tess.texCoords[tess.numVertexes];
+	outColor = &tess.vertexColors[tess.numVertexes];
+
+	// fill other data
+	for( i = 0; i < surf->num_vertexes;
+	     i++, outTexCoord++, outColor++ ) {
+		int	vtx = i + surf->first_vertex;
+
+		(*outTexCoord)[0][0] = data->texcoords[2*vtx + 0];
+		(*outTexCoord)[0][1] = data->texcoords[2*vtx + 1];
+		(*outTexCoord)[1][0] = (*outTexCoord)[0][0];
+		(*outTexCoord)[1][1] = (*outTexCoord)[0][1];
 
 		(*outColor)[0] = data->colors[4*vtx+0];
 		(*outColor)[1] = data->colors[4*vtx+1];
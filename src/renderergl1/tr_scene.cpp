@@ -37,6 +37,9 @@ int			r_firstScenePoly;
 
 int			r_numpolyverts;
 
+std::atomic<int>	r_numAnimSurfaces;
+std::atomic<int>	r_numAnimVertexes;
+
 
 /*
 ====================
@@ -59,6 +62,9 @@ void R_InitNextFrame( void ) {
 	r_firstScenePoly = 0;
 
 	r_numpolyverts = 0;
+
+	r_numAnimSurfaces = 0;
+	r_numAnimVertexes = 0;
 }
 
 
@@ -94,8 +100,8 @@ void R_AddPolygonSurfaces( void ) {
 	shader_t	*sh;
 	srfPoly_t	*poly;
 
-	tr.currentEntityNum = REFENTITYNUM_WORLD;
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
+	fe->currentEntityNum = REFENTITYNUM_WORLD;
+	fe->shiftedEntityNum = fe->currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
 
 	for ( i = 0, poly = tr.refdef.polys; i < tr.refdef.numPolys ; i++, poly++ ) {
 		sh = R_GetShaderByHandle( poly->hShader );
@@ -220,6 +226,7 @@ void RE_AddRefEntityToScene( const refEntity_t *ent ) {
 
 	backEndData->entities[r_numentities].e = *ent;
 	backEndData->entities[r_numentities].lightingCalculated = false;
+	backEndData->entities[r_numentities].animSurfaces = NULL;
 
 	r_numentities++;
 }
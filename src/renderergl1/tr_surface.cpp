@@ -27,6 +27,13 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include <altivec.h>
 #endif
 
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define	MESH_SIMD			1
+#include <xmmintrin.h>
+#else
+#define	MESH_SIMD			0
+#endif
+
 /*
 
   THIS ENTIRE FILE IS BACK END
@@ -553,6 +560,7 @@ static void RB_SurfaceLightningBolt( void ) {
 	}
 }
 
+#if !MESH_SIMD || idppc_altivec
 /*
 ** VectorArrayNormalize
 *
@@ -608,6 +616,7 @@ static void VectorArrayNormalize(vec4_t *normals, unsigned int count)
 #endif
 
 }
+#endif
 
 
 
@@ -744,7 +753,9 @@ static void LerpMeshVertexes_altivec(md3Surface_t *surf, float backlerp)
 }
 #endif
 
-static void LerpMeshVertexes_scalar(md3Surface_t *surf, float backlerp)
+#if !MESH_SIMD
+static void LerpMeshVertexes_scalar(const md3Surface_t *surf, int frame, int oldframe, float backlerp,
+	vec4_t *outXyzs, vec4_t *outNormals)
 {
 	short	*oldXyz, *newXyz, *oldNormals, *newNormals;
 	float	*outXyz, *outNormal;
@@ -754,11 +765,11 @@ static void LerpMeshVertexes_scalar(md3Surface_t *surf, float backlerp)
 	unsigned lat, lng;
 	int		numVerts;
 
-	outXyz = tess.xyz[tess.numVertexes];
-	outNormal = tess.normal[tess.numVertexes];
+	outXyz = outXyzs[0];
+	outNormal = outNormals[0];
 
 	newXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
-		+ (backEnd.currentEntity->e.frame * surf->numVerts * 4);
+		+ (frame * surf->numVerts * 4);
 	newNormals = newXyz + 3;
 
 	newXyzScale = MD3_XYZ_SCALE * (1.0 - backlerp);
@@ -797,7 +808,7 @@ static void LerpMeshVertexes_scalar(md3Surface_t *surf, float backlerp)
 		// interpolate and copy the vertex and normal
 		//
 		oldXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
-			+ (backEnd.currentEntity->e.oldframe * surf->numVerts * 4);
+			+ (oldframe * surf->numVerts * 4);
 		oldNormals = oldXyz + 3;
 
 		oldXyzScale = MD3_XYZ_SCALE * backlerp;
@@ -838,9 +849,116 @@ static void LerpMeshVertexes_scalar(md3Surface_t *surf, float backlerp)
 
 //			VectorNormalize (outNormal);
 		}
-    	VectorArrayNormalize((vec4_t *)tess.normal[tess.numVertexes], numVerts);
+    	VectorArrayNormalize(outNormals, numVerts);
    	}
 }
+#endif
+
+#if MESH_SIMD
+/*
+** DecodeMeshNormal
+*/
+static ID_INLINE __m128 DecodeMeshNormal(short packed)
+{
+	unsigned lat, lng;
+
+	lat = ( ( packed >> 8 ) & 0xff ) * (FUNCTABLE_SIZE/256);
+	lng = ( packed & 0xff ) * (FUNCTABLE_SIZE/256);
+
+	// decode X as cos( lat ) * sin( long )
+	// decode Y as sin( lat ) * sin( long )
+	// decode Z as cos( long )
+	return _mm_set_ps( 0.0f,
+		tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK],
+		tr.sinTable[lat] * tr.sinTable[lng],
+		tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng] );
+}
+
+/*
+** LerpMeshVertexes_sse
+*
+* Same results as the scalar version, with each position and normal
+* interpolated as a single vector and the normal renormalized with a
+* refined reciprocal square root estimate.
+*/
+static void LerpMeshVertexes_sse(const md3Surface_t *surf, int frame, int oldframe, float backlerp,
+	vec4_t *outXyz, vec4_t *outNormal)
+{
+	const short	*oldXyz, *newXyz;
+	__m128	oldXyzScale, newXyzScale;
+	__m128	oldNormalScale, newNormalScale;
+	__m128	xyz, normal, lengthSq, scale;
+	int		vertNum;
+	int		numVerts;
+
+	numVerts = surf->numVerts;
+
+	newXyz = (const short *)((const byte *)surf + surf->ofsXyzNormals)
+		+ (frame * numVerts * 4);
+	newXyzScale = _mm_set1_ps( MD3_XYZ_SCALE * (1.0f - backlerp) );
+
+	if ( backlerp == 0 ) {
+		for ( vertNum = 0 ; vertNum < numVerts ; vertNum++, newXyz += 4 ) {
+			xyz = _mm_set_ps( 0.0f, newXyz[2], newXyz[1], newXyz[0] );
+			_mm_storeu_ps( outXyz[vertNum], _mm_mul_ps( xyz, newXyzScale ) );
+			_mm_storeu_ps( outNormal[vertNum], DecodeMeshNormal( newXyz[3] ) );
+		}
+		return;
+	}
+
+	oldXyz = (const short *)((const byte *)surf + surf->ofsXyzNormals)
+		+ (oldframe * numVerts * 4);
+	oldXyzScale = _mm_set1_ps( MD3_XYZ_SCALE * backlerp );
+	oldNormalScale = _mm_set1_ps( backlerp );
+	newNormalScale = _mm_set1_ps( 1.0f - backlerp );
+
+	for ( vertNum = 0 ; vertNum < numVerts ; vertNum++, oldXyz += 4, newXyz += 4 ) {
+		// interpolate the xyz
+		xyz = _mm_add_ps(
+			_mm_mul_ps( _mm_set_ps( 0.0f, oldXyz[2], oldXyz[1], oldXyz[0] ), oldXyzScale ),
+			_mm_mul_ps( _mm_set_ps( 0.0f, newXyz[2], newXyz[1], newXyz[0] ), newXyzScale ) );
+		_mm_storeu_ps( outXyz[vertNum], xyz );
+
+		// interpolate and renormalize the normal
+		normal = _mm_add_ps(
+			_mm_mul_ps( DecodeMeshNormal( oldXyz[3] ), oldNormalScale ),
+			_mm_mul_ps( DecodeMeshNormal( newXyz[3] ), newNormalScale ) );
+
+		lengthSq = _mm_mul_ps( normal, normal );
+		lengthSq = _mm_add_ss( lengthSq, _mm_add_ss(
+			_mm_shuffle_ps( lengthSq, lengthSq, _MM_SHUFFLE( 1, 1, 1, 1 ) ),
+			_mm_shuffle_ps( lengthSq, lengthSq, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+
+		// one Newton-Raphson step, as Q_rsqrt does
+		scale = _mm_rsqrt_ss( lengthSq );
+		scale = _mm_mul_ss( scale, _mm_sub_ss( _mm_set_ss( 1.5f ),
+			_mm_mul_ss( _mm_mul_ss( _mm_set_ss( 0.5f ), lengthSq ), _mm_mul_ss( scale, scale ) ) ) );
+
+		// opposite normals half way through cancel out; rsqrt( 0 ) is
+		// infinite, so leave a zero normal like the scalar path does
+		scale = _mm_and_ps( scale, _mm_cmpgt_ss( lengthSq, _mm_setzero_ps( ) ) );
+
+		_mm_storeu_ps( outNormal[vertNum], _mm_mul_ps( normal, _mm_shuffle_ps( scale, scale, 0 ) ) );
+	}
+}
+#endif
+
+/*
+** R_LerpMeshVertexes
+*
+* Writes the interpolated positions and normals of an md3 surface to
+* outXyz and outNormal.  Only reads the surface and tr.sinTable, so the
+* front end can call it from the job threads.
+*/
+void R_LerpMeshVertexes(const md3Surface_t *surf, int frame, int oldframe, float backlerp,
+	vec4_t *outXyz, vec4_t *outNormal)
+{
+#if MESH_SIMD
+	LerpMeshVertexes_sse( surf, frame, oldframe, backlerp, outXyz, outNormal );
+#else
+	LerpMeshVertexes_scalar( surf, frame, oldframe, backlerp, outXyz, outNormal );
+#endif
+}
 
 static void LerpMeshVertexes(md3Surface_t *surf, float backlerp)
 {
@@ -851,7 +969,8 @@ static void LerpMeshVertexes(md3Surface_t *surf, float backlerp)
 		return;
 	}
 #endif // idppc_altivec
-	LerpMeshVertexes_scalar( surf, backlerp );
+	R_LerpMeshVertexes( surf, backEnd.currentEntity->e.frame, backEnd.currentEntity->e.oldframe,
+		backlerp, &tess.xyz[tess.numVertexes], &tess.normal[tess.numVertexes] );
 }
 
 
@@ -868,6 +987,7 @@ static void RB_SurfaceMesh(md3Surface_t *surface) {
 	int				indexes;
 	int				Bob, Doug;
 	int				numVerts;
+	const animSurface_t	*anim;
 
 	if (  backEnd.currentEntity->e.oldframe == backEnd.currentEntity->e.frame ) {
 		backlerp = 0;
@@ -877,7 +997,13 @@ static void RB_SurfaceMesh(md3Surface_t *surface) {
 
 	RB_CHECKOVERFLOW( surface->numVerts, surface->numTriangles*3 );
 
-	LerpMeshVertexes (surface, backlerp);
+	anim = R_FindSurfaceAnimation( backEnd.currentEntity, (surfaceType_t *)surface );
+	if ( anim ) {
+		Com_Memcpy( tess.xyz[tess.numVertexes], backEndData->animXyz[anim->firstVertex], anim->numVertexes * sizeof( vec4_t ) );
+		Com_Memcpy( tess.normal[tess.numVertexes], backEndData->animNormals[anim->firstVertex], anim->numVertexes * sizeof( vec4_t ) );
+	} else {
+		LerpMeshVertexes (surface, backlerp);
+	}
 
 	triangles = (int *) ((byte *)surface + surface->ofsTriangles);
 	indexes = surface->numTriangles * 3;
@@ -52,7 +52,7 @@ Returns true if the grid is completely culled away.
 Also sets the clipped hint bit in tess
 =================
 */
-static bool	R_CullGrid( srfGridMesh_t *cv ) {
+static bool	R_CullGrid( srfGridMesh_t *cv, frontEndCounters_t *pc ) {
 	int 	boxCull;
 	int 	sphereCull;
 
@@ -60,7 +60,7 @@ static bool	R_CullGrid( srfGridMesh_t *cv ) {
 		return true;
 	}
 
-	if ( tr.currentEntityNum != REFENTITYNUM_WORLD ) {
+	if ( fe->currentEntityNum != REFENTITYNUM_WORLD ) {
 		sphereCull = R_CullLocalPointAndRadius( cv->localOrigin, cv->meshRadius );
 	} else {
 		sphereCull = R_CullPointAndRadius( cv->localOrigin, cv->meshRadius );
@@ -69,33 +69,33 @@ static bool	R_CullGrid( srfGridMesh_t *cv ) {
 	// check for trivial reject
 	if ( sphereCull == CULL_OUT )
 	{
-		tr.pc.c_sphere_cull_patch_out++;
+		pc->c_sphere_cull_patch_out++;
 		return true;
 	}
 	// check bounding box if necessary
 	else if ( sphereCull == CULL_CLIP )
 	{
-		tr.pc.c_sphere_cull_patch_clip++;
+		pc->c_sphere_cull_patch_clip++;
 
 		boxCull = R_CullLocalBox( cv->meshBounds );
 
 		if ( boxCull == CULL_OUT ) 
 		{
-			tr.pc.c_box_cull_patch_out++;
+			pc->c_box_cull_patch_out++;
 			return true;
 		}
 		else if ( boxCull == CULL_IN )
 		{
-			tr.pc.c_box_cull_patch_in++;
+			pc->c_box_cull_patch_in++;
 		}
 		else
 		{
-			tr.pc.c_box_cull_patch_clip++;
+			pc->c_box_cull_patch_clip++;
 		}
 	}
 	else
 	{
-		tr.pc.c_sphere_cull_patch_in++;
+		pc->c_sphere_cull_patch_in++;
 	}
 
 	return false;
@@ -112,7 +112,7 @@ added to the sorting list.
 This will also allow mirrors on both sides of a model without recursion.
 ================
 */
-static bool	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
+static bool	R_CullSurface( surfaceType_t *surface, shader_t *shader, frontEndCounters_t *pc ) {
 	srfSurfaceFace_t *sface;
 	float			d;
 
@@ -121,7 +121,7 @@ static bool	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
 	}
 
 	if ( *surface == SF_GRID ) {
-		return R_CullGrid( (srfGridMesh_t *)surface );
+		return R_CullGrid( (srfGridMesh_t *)surface, pc );
 	}
 
 	if ( *surface == SF_TRIANGLES ) {
@@ -142,7 +142,7 @@ static bool	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
 	}
 
 	sface = ( srfSurfaceFace_t * ) surface;
-	d = DotProduct (tr.orientation.viewOrigin, sface->plane.normal);
+	d = DotProduct (fe->orientation.viewOrigin, sface->plane.normal);
 
 	// don't cull exactly on the plane, because there are levels of rounding
 	// through the BSP, ICD, and hardware that may cause pixel gaps if an
@@ -161,7 +161,7 @@ static bool	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
 }
 
 
-static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits ) {
+static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits, frontEndCounters_t *pc ) {
 	float		d;
 	int			i;
 	dlight_t	*dl;
@@ -179,14 +179,14 @@ static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		pc->c_dlightSurfacesCulled++;
 	}
 
 	face->dlightBits = dlightBits;
 	return dlightBits;
 }
 
-static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits ) {
+static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits, frontEndCounters_t *pc ) {
 	int			i;
 	dlight_t	*dl;
 
@@ -207,7 +207,7 @@ static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		pc->c_dlightSurfacesCulled++;
 	}
 
 	grid->dlightBits = dlightBits;
@@ -257,11 +257,11 @@ that is touched by one or more dlights, so try to throw out
 more dlights if possible.
 ====================
 */
-static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
+static int R_DlightSurface( msurface_t *surf, int dlightBits, frontEndCounters_t *pc ) {
 	if ( *surf->data == SF_FACE ) {
-		dlightBits = R_DlightFace( (srfSurfaceFace_t *)surf->data, dlightBits );
+		dlightBits = R_DlightFace( (srfSurfaceFace_t *)surf->data, dlightBits, pc );
 	} else if ( *surf->data == SF_GRID ) {
-		dlightBits = R_DlightGrid( (srfGridMesh_t *)surf->data, dlightBits );
+		dlightBits = R_DlightGrid( (srfGridMesh_t *)surf->data, dlightBits, pc );
 	} else if ( *surf->data == SF_TRIANGLES ) {
 		dlightBits = R_DlightTrisurf( (srfTriangles_t *)surf->data, dlightBits );
 	} else {
@@ -269,7 +269,7 @@ static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
 	}
 
 	if ( dlightBits ) {
-		tr.pc.c_dlightSurfaces++;
+		pc->c_dlightSurfaces++;
 	}
 
 	return dlightBits;
@@ -277,6 +277,31 @@ static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
 
 
 
+/*
+======================
+R_PrepareWorldSurface
+
+Returns false if the surface is culled, otherwise narrows
+dlightBits down to the flag for the draw surface
+======================
+*/
+static bool R_PrepareWorldSurface( msurface_t *surf, int *dlightBits, frontEndCounters_t *pc ) {
+	// FIXME: bmodel fog?
+
+	// try to cull before dlighting or adding
+	if ( R_CullSurface( surf->data, surf->shader, pc ) ) {
+		return false;
+	}
+
+	// check for dlighting
+	if ( *dlightBits ) {
+		*dlightBits = R_DlightSurface( surf, *dlightBits, pc );
+		*dlightBits = ( *dlightBits != 0 );
+	}
+
+	return true;
+}
+
 /*
 ======================
 R_AddWorldSurface
@@ -288,20 +313,10 @@ static void R_AddWorldSurface( msurface_t *surf, int dlightBits ) {
 	}
 
 	surf->viewCount = tr.viewCount;
-	// FIXME: bmodel fog?
 
-	// try to cull before dlighting or adding
-	if ( R_CullSurface( surf->data, surf->shader ) ) {
-		return;
-	}
-
-	// check for dlighting
-	if ( dlightBits ) {
-		dlightBits = R_DlightSurface( surf, dlightBits );
-		dlightBits = ( dlightBits != 0 );
+	if ( R_PrepareWorldSurface( surf, &dlightBits, &tr.pc ) ) {
+		R_AddDrawSurf( surf->data, surf->shader, surf->fogIndex, dlightBits );
 	}
-
-	R_AddDrawSurf( surf->data, surf->shader, surf->fogIndex, dlightBits );
 }
 
 /*
@@ -336,7 +351,7 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 	R_DlightBmodel( bmodel );
 
 	for ( i = 0 ; i < bmodel->numSurfaces ; i++ ) {
-		R_AddWorldSurface( bmodel->firstSurface + i, tr.currentEntity->needDlights );
+		R_AddWorldSurface( bmodel->firstSurface + i, fe->currentEntity->needDlights );
 	}
 }
 
@@ -349,68 +364,124 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 =============================================================
 */
 
+// the top levels of the tree are walked on the calling thread and the
+// subtrees below them are handed to the job threads
+#define	WORLD_JOB_DEPTH		6
+#define	MAX_WORLD_JOBS		( 1 << WORLD_JOB_DEPTH )
+
+// fewest surfaces worth giving a job of their own
+#define	WORLD_JOB_SURFACES	128
+
+typedef struct {
+	worldLeaf_t	*leafs;			// NULL to add the surfaces straight away
+	int			numLeafs;
+	vec3_t		visBounds[2];
+} worldWalk_t;
+
+typedef struct {
+	mnode_t		*node;
+	int			planeBits;
+	int			dlightBits;
+	worldWalk_t	walk;
+} worldSubtree_t;
+
+typedef struct {
+	int			firstSurface;	// in jobSurfaces and jobDrawSurfs
+	int			numSurfaces;
+	int			numDrawSurfs;
+	frontEndCounters_t	pc;
+} worldSurfaceJob_t;
+
+static worldSubtree_t		worldSubtrees[MAX_WORLD_JOBS];
+static int					numWorldSubtrees;
+static int					numWorldJobLeafs;
+
+static worldSurfaceJob_t	worldSurfaceJobs[MAX_WORLD_JOBS];
+
 
 /*
 ================
-R_RecursiveWorldNode
+R_CullWorldNode
+
+Returns true if nothing under the node can be visible, otherwise
+clears the planeBits the node is entirely in front of
 ================
 */
-static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits ) {
+static bool R_CullWorldNode( mnode_t *node, int *planeBits ) {
+	int		i, r;
 
-	do {
-		int			newDlights[2];
+	// if the node wasn't marked as potentially visible, exit
+	if (node->visframe != tr.visCount) {
+		return true;
+	}
 
-		// if the node wasn't marked as potentially visible, exit
-		if (node->visframe != tr.visCount) {
-			return;
+	// if the bounding volume is outside the frustum, nothing
+	// inside can be visible OPTIMIZE: don't do this all the way to leafs?
+
+	if ( r_nocull->integer ) {
+		return false;
+	}
+
+	for ( i = 0 ; i < 4 ; i++ ) {
+		if ( *planeBits & ( 1 << i ) ) {
+			r = BoxOnPlaneSide(node->mins, node->maxs, &fe->viewParms.frustum[i]);
+			if (r == 2) {
+				return true;						// culled
+			}
+			if ( r == 1 ) {
+				*planeBits &= ~( 1 << i );			// all descendants will also be in front
+			}
 		}
+	}
 
-		// if the bounding volume is outside the frustum, nothing
-		// inside can be visible OPTIMIZE: don't do this all the way to leafs?
+	return false;
+}
 
-		if ( !r_nocull->integer ) {
-			int		r;
+/*
+================
+R_SplitNodeDlights
 
-			if ( planeBits & 1 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[0]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~1;			// all descendants will also be in front
-				}
-			}
+Determines which dlights are needed on each side of a decision node
+================
+*/
+static void R_SplitNodeDlights( mnode_t *node, int dlightBits, int newDlights[2] ) {
+	int			i;
+	dlight_t	*dl;
+	float		dist;
 
-			if ( planeBits & 2 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[1]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~2;			// all descendants will also be in front
-				}
-			}
+	newDlights[0] = 0;
+	newDlights[1] = 0;
+	if ( !dlightBits ) {
+		return;
+	}
 
-			if ( planeBits & 4 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[2]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~4;			// all descendants will also be in front
-				}
+	for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
+		if ( dlightBits & ( 1 << i ) ) {
+			dl = &tr.refdef.dlights[i];
+			dist = DotProduct( dl->origin, node->plane->normal ) - node->plane->dist;
+			
+			if ( dist > -dl->radius ) {
+				newDlights[0] |= ( 1 << i );
 			}
-
-			if ( planeBits & 8 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[3]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~8;			// all descendants will also be in front
-				}
+			if ( dist < dl->radius ) {
+				newDlights[1] |= ( 1 << i );
 			}
+		}
+	}
+}
+
+/*
+================
+R_RecursiveWorldNode
+================
+*/
+static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits, worldWalk_t *walk ) {
 
+	do {
+		int			newDlights[2];
+
+		if ( R_CullWorldNode( node, &planeBits ) ) {
+			return;
 		}
 
 		if ( node->contents != -1 ) {
@@ -421,31 +492,10 @@ static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits )
 		// since we don't care about sort orders, just go positive to negative
 
 		// determine which dlights are needed
-		newDlights[0] = 0;
-		newDlights[1] = 0;
-		if ( dlightBits ) {
-			int	i;
-
-			for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
-				dlight_t	*dl;
-				float		dist;
-
-				if ( dlightBits & ( 1 << i ) ) {
-					dl = &tr.refdef.dlights[i];
-					dist = DotProduct( dl->origin, node->plane->normal ) - node->plane->dist;
-					
-					if ( dist > -dl->radius ) {
-						newDlights[0] |= ( 1 << i );
-					}
-					if ( dist < dl->radius ) {
-						newDlights[1] |= ( 1 << i );
-					}
-				}
-			}
-		}
+		R_SplitNodeDlights( node, dlightBits, newDlights );
 
 		// recurse down the children, front side first
-		R_RecursiveWorldNode (node->children[0], planeBits, newDlights[0] );
+		R_RecursiveWorldNode (node->children[0], planeBits, newDlights[0], walk );
 
 		// tail recurse
 		node = node->children[1];
@@ -457,28 +507,35 @@ static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits )
 		int			c;
 		msurface_t	*surf, **mark;
 
-		tr.pc.c_leafs++;
-
 		// add to z buffer bounds
-		if ( node->mins[0] < tr.viewParms.visBounds[0][0] ) {
-			tr.viewParms.visBounds[0][0] = node->mins[0];
+		if ( node->mins[0] < walk->visBounds[0][0] ) {
+			walk->visBounds[0][0] = node->mins[0];
 		}
-		if ( node->mins[1] < tr.viewParms.visBounds[0][1] ) {
-			tr.viewParms.visBounds[0][1] = node->mins[1];
+		if ( node->mins[1] < walk->visBounds[0][1] ) {
+			walk->visBounds[0][1] = node->mins[1];
 		}
-		if ( node->mins[2] < tr.viewParms.visBounds[0][2] ) {
-			tr.viewParms.visBounds[0][2] = node->mins[2];
+		if ( node->mins[2] < walk->visBounds[0][2] ) {
+			walk->visBounds[0][2] = node->mins[2];
 		}
 
-		if ( node->maxs[0] > tr.viewParms.visBounds[1][0] ) {
-			tr.viewParms.visBounds[1][0] = node->maxs[0];
+		if ( node->maxs[0] > walk->visBounds[1][0] ) {
+			walk->visBounds[1][0] = node->maxs[0];
+		}
+		if ( node->maxs[1] > walk->visBounds[1][1] ) {
+			walk->visBounds[1][1] = node->maxs[1];
 		}
-		if ( node->maxs[1] > tr.viewParms.visBounds[1][1] ) {
-			tr.viewParms.visBounds[1][1] = node->maxs[1];
+		if ( node->maxs[2] > walk->visBounds[1][2] ) {
+			walk->visBounds[1][2] = node->maxs[2];
 		}
-		if ( node->maxs[2] > tr.viewParms.visBounds[1][2] ) {
-			tr.viewParms.visBounds[1][2] = node->maxs[2];
+
+		// on a job thread, keep the leaf for R_AddWorldSurfaces
+		if ( walk->leafs ) {
+			walk->leafs[walk->numLeafs].node = node;
+			walk->leafs[walk->numLeafs].dlightBits = dlightBits;
+			walk->numLeafs++;
+			return;
 		}
+		walk->numLeafs++;
 
 		// add the individual surfaces
 		mark = node->firstmarksurface;
@@ -494,6 +551,165 @@ static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits )
 
 }
 
+/*
+================
+R_SplitWorldNode
+
+Walks the top WORLD_JOB_DEPTH levels of the tree, collecting the
+subtrees below them in the order R_RecursiveWorldNode would reach
+them.  Returns false if the leafs don't fit in jobLeafs.
+================
+*/
+static bool R_SplitWorldNode( mnode_t *node, int planeBits, int dlightBits, int depth ) {
+	worldSubtree_t	*subtree;
+	int				newDlights[2];
+
+	if ( R_CullWorldNode( node, &planeBits ) ) {
+		return true;
+	}
+
+	if ( node->contents != -1 || !depth ) {
+		if ( numWorldJobLeafs + node->numLeafs > tr.world->numnodes - tr.world->numDecisionNodes ) {
+			return false;
+		}
+
+		subtree = &worldSubtrees[numWorldSubtrees++];
+		subtree->node = node;
+		subtree->planeBits = planeBits;
+		subtree->dlightBits = dlightBits;
+		subtree->walk.leafs = tr.world->jobLeafs + numWorldJobLeafs;
+		subtree->walk.numLeafs = 0;
+		ClearBounds( subtree->walk.visBounds[0], subtree->walk.visBounds[1] );
+
+		numWorldJobLeafs += node->numLeafs;
+		return true;
+	}
+
+	R_SplitNodeDlights( node, dlightBits, newDlights );
+
+	if ( !R_SplitWorldNode( node->children[0], planeBits, newDlights[0], depth - 1 ) ) {
+		return false;
+	}
+	return R_SplitWorldNode( node->children[1], planeBits, newDlights[1], depth - 1 );
+}
+
+/*
+================
+R_WalkSubtreeJob
+================
+*/
+static void R_WalkSubtreeJob( void *data, int index ) {
+	worldSubtree_t	*subtree = &worldSubtrees[index];
+
+	R_RecursiveWorldNode( subtree->node, subtree->planeBits, subtree->dlightBits, &subtree->walk );
+}
+
+/*
+================
+R_AddWorldSurfacesJob
+================
+*/
+static void R_AddWorldSurfacesJob( void *data, int index ) {
+	worldSurfaceJob_t	*job = &worldSurfaceJobs[index];
+	msurface_t			*surf;
+	int					i, dlightBits;
+
+	for ( i = job->firstSurface ; i < job->firstSurface + job->numSurfaces ; i++ ) {
+		surf = tr.world->jobSurfaces[i];
+		dlightBits = tr.world->jobDlightBits[i];
+
+		if ( R_PrepareWorldSurface( surf, &dlightBits, &job->pc ) ) {
+			R_PackDrawSurf( &tr.world->jobDrawSurfs[job->firstSurface + job->numDrawSurfs],
+				surf->data, surf->shader, surf->fogIndex, dlightBits );
+			job->numDrawSurfs++;
+		}
+	}
+}
+
+/*
+================
+R_AddWorldCounters
+================
+*/
+static void R_AddWorldCounters( const frontEndCounters_t *pc ) {
+	tr.pc.c_sphere_cull_patch_in += pc->c_sphere_cull_patch_in;
+	tr.pc.c_sphere_cull_patch_clip += pc->c_sphere_cull_patch_clip;
+	tr.pc.c_sphere_cull_patch_out += pc->c_sphere_cull_patch_out;
+	tr.pc.c_box_cull_patch_in += pc->c_box_cull_patch_in;
+	tr.pc.c_box_cull_patch_clip += pc->c_box_cull_patch_clip;
+	tr.pc.c_box_cull_patch_out += pc->c_box_cull_patch_out;
+	tr.pc.c_dlightSurfaces += pc->c_dlightSurfaces;
+	tr.pc.c_dlightSurfacesCulled += pc->c_dlightSurfacesCulled;
+}
+
+/*
+================
+R_WalkWorldJobs
+
+The subtrees are walked on the job threads, then the surfaces of the
+visible leafs are gathered here in the same order the serial walk
+would add them, so each keeps the dlights of the first leaf it was
+reached through.  The gathered surfaces are culled and packed on the
+job threads again, and the lists appended in order.
+================
+*/
+static void R_WalkWorldJobs( void ) {
+	worldSubtree_t		*subtree;
+	worldSurfaceJob_t	*job;
+	worldLeaf_t			*leaf;
+	msurface_t			*surf, **mark;
+	int					i, j, c;
+	int					numSurfaces, numJobs;
+
+	ri.ParallelFor( numWorldSubtrees, R_WalkSubtreeJob, NULL );
+
+	numSurfaces = 0;
+	for ( i = 0, subtree = worldSubtrees ; i < numWorldSubtrees ; i++, subtree++ ) {
+		if ( !subtree->walk.numLeafs ) {
+			continue;
+		}
+
+		tr.pc.c_leafs += subtree->walk.numLeafs;
+		AddPointToBounds( subtree->walk.visBounds[0], fe->viewParms.visBounds[0], fe->viewParms.visBounds[1] );
+		AddPointToBounds( subtree->walk.visBounds[1], fe->viewParms.visBounds[0], fe->viewParms.visBounds[1] );
+
+		for ( j = 0, leaf = subtree->walk.leafs ; j < subtree->walk.numLeafs ; j++, leaf++ ) {
+			mark = leaf->node->firstmarksurface;
+			c = leaf->node->nummarksurfaces;
+			while (c--) {
+				surf = *mark++;
+				if ( surf->viewCount == tr.viewCount ) {
+					continue;		// already in this view
+				}
+				surf->viewCount = tr.viewCount;
+
+				tr.world->jobSurfaces[numSurfaces] = surf;
+				tr.world->jobDlightBits[numSurfaces] = leaf->dlightBits;
+				numSurfaces++;
+			}
+		}
+	}
+
+	numJobs = ( numSurfaces + WORLD_JOB_SURFACES - 1 ) / WORLD_JOB_SURFACES;
+	if ( numJobs > MAX_WORLD_JOBS ) {
+		numJobs = MAX_WORLD_JOBS;
+	}
+
+	for ( i = 0, job = worldSurfaceJobs ; i < numJobs ; i++, job++ ) {
+		job->firstSurface = numSurfaces * i / numJobs;
+		job->numSurfaces = numSurfaces * ( i + 1 ) / numJobs - job->firstSurface;
+		job->numDrawSurfs = 0;
+		Com_Memset( &job->pc, 0, sizeof( job->pc ) );
+	}
+
+	ri.ParallelFor( numJobs, R_AddWorldSurfacesJob, NULL );
+
+	for ( i = 0, job = worldSurfaceJobs ; i < numJobs ; i++, job++ ) {
+		R_AddDrawSurfs( tr.world->jobDrawSurfs + job->firstSurface, job->numDrawSurfs );
+		R_AddWorldCounters( &job->pc );
+	}
+}
+
 
 /*
 ===============
@@ -579,7 +795,7 @@ static void R_MarkLeaves (void) {
 	}
 
 	// current viewcluster
-	leaf = R_PointInLeaf( tr.viewParms.pvsOrigin );
+	leaf = R_PointInLeaf( fe->viewParms.pvsOrigin );
 	cluster = leaf->cluster;
 
 	// if the cluster is the same and the area visibility matrix
@@ -645,6 +861,9 @@ R_AddWorldSurfaces
 =============
 */
 void R_AddWorldSurfaces (void) {
+	worldWalk_t	walk;
+	int			dlightBits;
+
 	if ( !r_drawworld->integer ) {
 		return;
 	}
@@ -653,18 +872,37 @@ void R_AddWorldSurfaces (void) {
 		return;
 	}
 
-	tr.currentEntityNum = REFENTITYNUM_WORLD;
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
+	fe->currentEntityNum = REFENTITYNUM_WORLD;
+	fe->shiftedEntityNum = fe->currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
 
 	// determine which leaves are in the PVS / areamask
 	R_MarkLeaves ();
 
 	// clear out the visible min/max
-	ClearBounds( tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+	ClearBounds( fe->viewParms.visBounds[0], fe->viewParms.visBounds[1] );
 
 	// perform frustum culling and add all the potentially visible surfaces
 	if ( tr.refdef.num_dlights > 32 ) {
 		tr.refdef.num_dlights = 32 ;
 	}
-	R_RecursiveWorldNode( tr.world->nodes, 15, ( 1 << tr.refdef.num_dlights ) - 1 );
+	dlightBits = ( 1 << tr.refdef.num_dlights ) - 1;
+
+	if ( r_frontEndJobs->integer ) {
+		numWorldSubtrees = 0;
+		numWorldJobLeafs = 0;
+		if ( R_SplitWorldNode( tr.world->nodes, 15, dlightBits, WORLD_JOB_DEPTH ) ) {
+			R_WalkWorldJobs();
+			return;
+		}
+	}
+
+	walk.leafs = NULL;
+	walk.numLeafs = 0;
+	ClearBounds( walk.visBounds[0], walk.visBounds[1] );
+
+	R_RecursiveWorldNode( tr.world->nodes, 15, dlightBits, &walk );
+
+	tr.pc.c_leafs += walk.numLeafs;
+	VectorCopy( walk.visBounds[0], fe->viewParms.visBounds[0] );
+	VectorCopy( walk.visBounds[1], fe->viewParms.visBounds[1] );
 }
@@ -12,6 +12,9 @@ attribute vec4 attr_Tangent;
 attribute vec3 attr_Position2;
 attribute vec3 attr_Normal2;
 attribute vec4 attr_Tangent2;
+#elif defined(USE_BONE_ANIMATION)
+attribute vec4 attr_BoneIndexes;
+attribute vec4 attr_BoneWeights;
 #endif
 
 #if defined(USE_LIGHT) && !defined(USE_LIGHT_VECTOR)
@@ -48,6 +51,8 @@ uniform mat4   u_ModelMatrix;
 
 #if defined(USE_VERTEX_ANIMATION)
 uniform float  u_VertexLerp;
+#elif defined(USE_BONE_ANIMATION)
+uniform mat4   u_BoneMatrix[MAX_GLSL_BONES];
 #endif
 
 #if defined(USE_LIGHT_VECTOR)
@@ -151,6 +156,19 @@ void main()
   #if defined(USE_LIGHT) && !defined(USE_FAST_LIGHT)
 	vec3 tangent   = mix(attr_Tangent.xyz, attr_Tangent2.xyz, u_VertexLerp);
   #endif
+#elif defined(USE_BONE_ANIMATION)
+	mat4 vtxMat  = mat4(step(attr_BoneWeights.x, 0.0));
+	     vtxMat += u_BoneMatrix[int(attr_BoneIndexes.x)] * attr_BoneWeights.x;
+	     vtxMat += u_BoneMatrix[int(attr_BoneIndexes.y)] * attr_BoneWeights.y;
+	     vtxMat += u_BoneMatrix[int(attr_BoneIndexes.z)] * attr_BoneWeights.z;
+	     vtxMat += u_BoneMatrix[int(attr_BoneIndexes.w)] * attr_BoneWeights.w;
+	mat3 nrmMat  = mat3(cross(vtxMat[1].xyz, vtxMat[2].xyz), cross(vtxMat[2].xyz, vtxMat[0].xyz), cross(vtxMat[0].xyz, vtxMat[1].xyz));
+
+	vec3 position  = vec3(vtxMat * vec4(attr_Position, 1.0));
+	vec3 normal    = normalize(nrmMat * attr_Normal);
+  #if defined(USE_LIGHT) && !defined(USE_FAST_LIGHT)
+	vec3 tangent   = normalize(nrmMat * attr_Tangent.xyz);
+  #endif
 #else
 	vec3 position  = attr_Position;
 	vec3 normal    = attr_Normal;
@@ -60,7 +60,8 @@ void GL_BindToTMU( image_t *image, int tmu )
 		ri.Printf(PRINT_WARNING, "GL_BindToTMU: NULL image\n");
 	}
 
-	GL_BindMultiTexture(GL_TEXTURE0_ARB + tmu, target, texture);
+	if (GL_BindMultiTexture(GL_TEXTURE0_ARB + tmu, target, texture))
+		backEnd.pc.c_textureBinds++;
 }
 
 
@@ -107,6 +108,8 @@ void GL_State( unsigned long stateBits )
 		return;
 	}
 
+	backEnd.pc.c_stateChanges++;
+
 	//
 	// check depthFunc bits
 	//
@@ -1780,8 +1783,10 @@ RB_ExecuteRenderCommands
 */
 void RB_ExecuteRenderCommands( const void *data ) {
 	int		t1, t2;
+	int		backEndSpan, span;
 
 	t1 = ri.Milliseconds ();
+	backEndSpan = R_ProfileBegin( RP_BACKEND );
 
 	while ( 1 ) {
 		data = PADP(data, sizeof(void *));
@@ -1794,13 +1799,20 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			data = RB_StretchPic( data );
 			break;
 		case RC_DRAW_SURFS:
+			if ( ((const drawSurfsCommand_t *)data)->viewParms.flags & VPF_DEPTHSHADOW )
+				span = R_ProfileBegin( RP_SHADOWMAP );
+			else
+				span = R_ProfileBegin( RP_DRAWVIEW );
 			data = RB_DrawSurfs( data );
+			R_ProfileEnd( span );
 			break;
 		case RC_DRAW_BUFFER:
 			data = RB_DrawBuffer( data );
 			break;
 		case RC_SWAP_BUFFERS:
+			span = R_ProfileBegin( RP_SWAP );
 			data = RB_SwapBuffers( data );
+			R_ProfileEnd( span );
 			break;
 		case RC_SCREENSHOT:
 			data = RB_TakeScreenshotCmd( data );
@@ -1815,10 +1827,14 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			data = RB_ClearDepth( data );
 			break;
 		case RC_CAPSHADOWMAP:
+			span = R_ProfileBegin( RP_SHADOWMAP );
 			data = RB_CapShadowMap( data );
+			R_ProfileEnd( span );
 			break;
 		case RC_POSTPROCESS:
+			span = R_ProfileBegin( RP_POSTPROCESS );
 			data = RB_PostProcess( data );
+			R_ProfileEnd( span );
 			break;
 		case RC_EXPORT_CUBEMAPS:
 			data = RB_ExportCubemaps( data );
@@ -1835,6 +1851,7 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			// stop rendering
 			t2 = ri.Milliseconds ();
 			backEnd.pc.msec = t2 - t1;
+			R_ProfileEnd( backEndSpan );
 			return;
 		}
 	}
@@ -1702,6 +1702,466 @@ void R_MovePatchSurfacesToHunk(void) {
 }
 
 
+/*
+===============
+R_RequestWorldImages
+
+Queues the images of the world shaders in the order R_LoadSurfaces will
+first use them, so the job threads decode them ahead of it
+===============
+*/
+static void R_RequestWorldImages( lump_t *surfs ) {
+	dsurface_t	*in;
+	byte		*requested;
+	int			i, count, shaderNum;
+
+	if ( !r_imageJobs->integer || !s_worldData.numShaders ) {
+		return;
+	}
+
+	in = (dsurface_t *)(fileBase + surfs->fileofs);
+	count = surfs->filelen / sizeof(*in);
+
+	requested = (byte *)ri.Hunk_AllocateTempMemory( s_worldData.numShaders );
+	Com_Memset( requested, 0, s_worldData.numShaders );
+
+	for ( i = 0 ; i < count ; i++, in++ ) {
+		shaderNum = LittleLong( in->shaderNum );
+		if ( shaderNum < 0 || shaderNum >= s_worldData.numShaders || requested[shaderNum] ) {
+			continue;
+		}
+		requested[shaderNum] = 1;
+
+		R_RequestShaderImages( s_worldData.shaders[shaderNum].shader, true );
+	}
+
+	ri.Hunk_FreeTempMemory( requested );
+}
+
+/*
+=============================================================================
+
+WORLD CACHE
+
+The surfaces as R_LoadSurfaces leaves them, after patch subdivision,
+stitching, the LoD fixes and the tangent vectors, are saved under
+worldcache/ so the next load of the same map only has to copy them back.
+
+=============================================================================
+*/
+
+#define WORLDCACHE_DIR		"worldcache"
+#define WORLDCACHE_IDENT	(('C'<<24)+('D'<<16)+('L'<<8)+'W')
+#define WORLDCACHE_VERSION	1
+#define WORLDCACHE_MAX_LENGTH	0x40000000
+
+// followed by numSurfaces worldCacheSurface_t, then numVerts srfVert_t,
+// numIndexes glIndex_t and numLodErrors floats
+typedef struct {
+	int			ident;
+	int			version;
+	uint64_t	key;
+	int			numSurfaces;
+	int			numVerts;
+	int			numIndexes;
+	int			numLodErrors;
+} worldCacheHeader_t;
+
+typedef struct {
+	int			surfaceType;
+	int			numVerts;
+	int			numIndexes;
+	int			width, height;		// SF_GRID only, with width + height lod errors
+	cullinfo_t	cullinfo;
+	vec3_t		cullBounds[2];
+	vec3_t		cullOrigin;
+	float		cullRadius;
+	cplane_t	cullPlane;
+	vec3_t		lodOrigin;
+	float		lodRadius;
+	int			lodFixed;
+} worldCacheSurface_t;
+
+/*
+===============
+R_WorldCachePath
+===============
+*/
+static const char *R_WorldCachePath( void ) {
+	return va( "%s/%s.dat", WORLDCACHE_DIR, s_worldData.baseName );
+}
+
+/*
+===============
+R_WorldCacheHash
+===============
+*/
+static uint64_t R_WorldCacheHash( uint64_t hash, const void *data, size_t len ) {
+	const byte	*b = (const byte *)data;
+	size_t		i;
+
+	for ( i = 0 ; i < len ; i++ ) {
+		hash = ( hash ^ b[i] ) * 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/*
+===============
+R_WorldCacheKey
+
+Hashes everything the loaded surfaces are made from: the surface, vertex,
+index and shader lumps, the hdr vertex colors and the settings that
+change the vertexes
+===============
+*/
+static bool R_WorldCacheKey( lump_t *surfs, lump_t *verts, lump_t *indexLump, const float *hdrVertColors, uint64_t *key ) {
+	float		values[9];
+	uint64_t	hash;
+
+	if ( !r_worldCache->integer ) {
+		return false;
+	}
+
+	hash = 14695981039346656037ULL;
+	hash = R_WorldCacheHash( hash, fileBase + surfs->fileofs, surfs->filelen );
+	hash = R_WorldCacheHash( hash, fileBase + verts->fileofs, verts->filelen );
+	hash = R_WorldCacheHash( hash, fileBase + indexLump->fileofs, indexLump->filelen );
+	hash = R_WorldCacheHash( hash, s_worldData.shaders, s_worldData.numShaders * sizeof( *s_worldData.shaders ) );
+	if ( hdrVertColors ) {
+		hash = R_WorldCacheHash( hash, hdrVertColors, verts->filelen / sizeof( drawVert_t ) * 3 * sizeof( float ) );
+	}
+
+	values[0] = r_hdr->integer;
+	values[1] = r_subdivisions->value;
+	values[2] = r_mapOverBrightBits->integer;
+	values[3] = r_mapLightmapMin->value;
+	values[4] = tr.overbrightBits;
+	values[5] = tr.worldDeluxeMapping;
+	values[6] = tr.fatLightmapCols;
+	values[7] = tr.fatLightmapRows;
+	values[8] = sizeof( srfVert_t );
+	hash = R_WorldCacheHash( hash, values, sizeof( values ) );
+
+	*key = hash;
+	return true;
+}
+
+/*
+===============
+R_WorldCacheSurfaceValid
+
+Checks a cached surface against the type of its surface in the map
+===============
+*/
+static bool R_WorldCacheSurfaceValid( const worldCacheSurface_t *c, int mapSurfaceType ) {
+	if ( c->numVerts < 0 || c->numIndexes < 0 ) {
+		return false;
+	}
+
+	switch ( mapSurfaceType ) {
+	case MST_PATCH:
+		if ( c->surfaceType == SF_SKIP ) {
+			return !c->numVerts && !c->numIndexes;
+		}
+		return c->surfaceType == SF_GRID && c->width > 0 && c->width <= MAX_GRID_SIZE &&
+			c->height > 0 && c->height <= MAX_GRID_SIZE && c->width * c->height == c->numVerts;
+	case MST_TRIANGLE_SOUP:
+		return c->surfaceType == SF_TRIANGLES;
+	case MST_PLANAR:
+		return c->surfaceType == SF_FACE && c->numVerts <= MAX_FACE_POINTS;
+	case MST_FLARE:
+		return c->surfaceType == SF_FLARE && !c->numVerts && !c->numIndexes;
+	default:
+		return false;
+	}
+}
+
+/*
+===============
+R_WorldCacheShader
+
+Sets the shader and fog the way the Parse functions do
+===============
+*/
+static void R_WorldCacheShader( dsurface_t *ds, msurface_t *surf ) {
+	int		surfaceType;
+
+	surfaceType = LittleLong( ds->surfaceType );
+
+	// get fog volume
+	surf->fogIndex = LittleLong( ds->fogNum ) + 1;
+
+	// get shader value
+	if ( surfaceType == MST_PATCH || surfaceType == MST_PLANAR ) {
+		surf->shader = ShaderForShaderNum( ds->shaderNum, FatLightmap( LittleLong( ds->lightmapNum ) ) );
+	} else {
+		surf->shader = ShaderForShaderNum( ds->shaderNum, LIGHTMAP_BY_VERTEX );
+	}
+	if ( r_singleShader->integer && !surf->shader->isSky ) {
+		surf->shader = tr.defaultShader;
+	}
+
+	if ( surfaceType == MST_PLANAR && LittleLong( ds->numVerts ) > MAX_FACE_POINTS ) {
+		surf->shader = tr.defaultShader;
+	}
+}
+
+/*
+===============
+R_LoadWorldCache
+
+Fills in every surface but the flares.  The whole file is checked
+before anything is allocated, so a stale or broken cache leaves
+nothing behind and the map is parsed as usual.
+===============
+*/
+static bool R_LoadWorldCache( uint64_t key, lump_t *surfs ) {
+	worldCacheHeader_t			header;
+	const worldCacheSurface_t	*cached, *c;
+	const srfVert_t				*cachedVerts;
+	const glIndex_t				*cachedIndexes;
+	const float					*cachedLodErrors;
+	dsurface_t					*in;
+	msurface_t					*out;
+	srfBspSurface_t				*cv;
+	byte						*buf;
+	fileHandle_t				f;
+	long						length;
+	int							i, j, numVerts, numIndexes, numLodErrors;
+	static surfaceType_t		skipData = SF_SKIP;
+
+	// read into malloced memory rather than the temp hunk, so a large
+	// world can't make the cache fail the load
+	length = ri.FS_FOpenFileRead( R_WorldCachePath(), &f, true );
+	if ( !f ) {
+		return false;
+	}
+
+	buf = NULL;
+	if ( length >= (long)sizeof( header ) && length <= WORLDCACHE_MAX_LENGTH ) {
+		buf = (byte *)malloc( length );
+	}
+	if ( buf && ri.FS_Read( buf, length, f ) != length ) {
+		free( buf );
+		buf = NULL;
+	}
+	ri.FS_FCloseFile( f );
+	if ( !buf ) {
+		return false;
+	}
+
+	Com_Memcpy( &header, buf, sizeof( header ) );
+	if ( header.ident != WORLDCACHE_IDENT || header.version != WORLDCACHE_VERSION ||
+		header.key != key || header.numSurfaces != s_worldData.numsurfaces ||
+		header.numVerts < 0 || header.numIndexes < 0 || header.numLodErrors < 0 ||
+		length != (long)( sizeof( header ) + (int64_t)header.numSurfaces * sizeof( worldCacheSurface_t ) +
+			(int64_t)header.numVerts * sizeof( srfVert_t ) + (int64_t)header.numIndexes * sizeof( glIndex_t ) +
+			(int64_t)header.numLodErrors * sizeof( float ) ) ) {
+		free( buf );
+		return false;
+	}
+
+	cached = (const worldCacheSurface_t *)( buf + sizeof( header ) );
+	cachedVerts = (const srfVert_t *)( cached + header.numSurfaces );
+	cachedIndexes = (const glIndex_t *)( cachedVerts + header.numVerts );
+	cachedLodErrors = (const float *)( cachedIndexes + header.numIndexes );
+
+	numVerts = numIndexes = numLodErrors = 0;
+	in = (dsurface_t *)( fileBase + surfs->fileofs );
+	for ( i = 0, c = cached ; i < header.numSurfaces ; i++, in++, c++ ) {
+		if ( !R_WorldCacheSurfaceValid( c, LittleLong( in->surfaceType ) ) ||
+			c->numVerts > header.numVerts - numVerts || c->numIndexes > header.numIndexes - numIndexes ) {
+			free( buf );
+			return false;
+		}
+
+		for ( j = 0 ; j < c->numIndexes ; j++ ) {
+			if ( cachedIndexes[numIndexes + j] >= (glIndex_t)c->numVerts ) {
+				free( buf );
+				return false;
+			}
+		}
+		numVerts += c->numVerts;
+		numIndexes += c->numIndexes;
+
+		if ( c->surfaceType == SF_GRID ) {
+			if ( c->width + c->height > header.numLodErrors - numLodErrors ) {
+				free( buf );
+				return false;
+			}
+			numLodErrors += c->width + c->height;
+		}
+	}
+
+	if ( numVerts != header.numVerts || numIndexes != header.numIndexes || numLodErrors != header.numLodErrors ) {
+		free( buf );
+		return false;
+	}
+
+	numVerts = numIndexes = numLodErrors = 0;
+	in = (dsurface_t *)( fileBase + surfs->fileofs );
+	out = s_worldData.surfaces;
+	for ( i = 0, c = cached ; i < header.numSurfaces ; i++, in++, out++, c++ ) {
+		if ( c->surfaceType == SF_FLARE ) {
+			continue;
+		}
+
+		R_WorldCacheShader( in, out );
+		out->cullinfo = c->cullinfo;
+
+		// we may have a nodraw surface, because they might still need to
+		// be around for movement clipping
+		if ( c->surfaceType == SF_SKIP ) {
+			out->data = &skipData;
+			continue;
+		}
+
+		cv = (srfBspSurface_t *)out->data;
+		cv->surfaceType = (surfaceType_t)c->surfaceType;
+
+		VectorCopy( c->cullBounds[0], cv->cullBounds[0] );
+		VectorCopy( c->cullBounds[1], cv->cullBounds[1] );
+		VectorCopy( c->cullOrigin, cv->cullOrigin );
+		cv->cullRadius = c->cullRadius;
+		cv->cullPlane = c->cullPlane;
+
+		cv->numIndexes = c->numIndexes;
+		cv->indexes = (glIndex_t *)ri.Hunk_Alloc( c->numIndexes * sizeof( cv->indexes[0] ), h_low );
+		Com_Memcpy( cv->indexes, cachedIndexes + numIndexes, c->numIndexes * sizeof( cv->indexes[0] ) );
+		numIndexes += c->numIndexes;
+
+		cv->numVerts = c->numVerts;
+		cv->verts = (srfVert_t *)ri.Hunk_Alloc( c->numVerts * sizeof( cv->verts[0] ), h_low );
+		Com_Memcpy( cv->verts, cachedVerts + numVerts, c->numVerts * sizeof( cv->verts[0] ) );
+		numVerts += c->numVerts;
+
+		if ( c->surfaceType != SF_GRID ) {
+			continue;
+		}
+
+		VectorCopy( c->lodOrigin, cv->lodOrigin );
+		cv->lodRadius = c->lodRadius;
+		cv->lodFixed = c->lodFixed;
+		cv->lodStitched = true;
+
+		cv->width = c->width;
+		cv->widthLodError = (float *)ri.Hunk_Alloc( c->width * sizeof( float ), h_low );
+		Com_Memcpy( cv->widthLodError, cachedLodErrors + numLodErrors, c->width * sizeof( float ) );
+		numLodErrors += c->width;
+
+		cv->height = c->height;
+		cv->heightLodError = (float *)ri.Hunk_Alloc( c->height * sizeof( float ), h_low );
+		Com_Memcpy( cv->heightLodError, cachedLodErrors + numLodErrors, c->height * sizeof( float ) );
+		numLodErrors += c->height;
+	}
+
+	free( buf );
+
+	ri.Printf( PRINT_DEVELOPER, "...loaded surfaces from %s\n", R_WorldCachePath() );
+	return true;
+}
+
+/*
+===============
+R_SaveWorldCache
+===============
+*/
+static void R_SaveWorldCache( uint64_t key ) {
+	worldCacheHeader_t	header;
+	worldCacheSurface_t	*c;
+	srfVert_t			*verts;
+	glIndex_t			*indexes;
+	float				*lodErrors;
+	msurface_t			*surf;
+	srfBspSurface_t		*cv;
+	byte				*buf;
+	int64_t				length;
+	int					i;
+
+	Com_Memset( &header, 0, sizeof( header ) );
+	header.ident = WORLDCACHE_IDENT;
+	header.version = WORLDCACHE_VERSION;
+	header.key = key;
+	header.numSurfaces = s_worldData.numsurfaces;
+
+	for ( i = 0, surf = s_worldData.surfaces ; i < s_worldData.numsurfaces ; i++, surf++ ) {
+		cv = (srfBspSurface_t *)surf->data;
+		if ( cv->surfaceType != SF_FACE && cv->surfaceType != SF_GRID && cv->surfaceType != SF_TRIANGLES ) {
+			continue;
+		}
+
+		header.numVerts += cv->numVerts;
+		header.numIndexes += cv->numIndexes;
+		if ( cv->surfaceType == SF_GRID ) {
+			header.numLodErrors += cv->width + cv->height;
+		}
+	}
+
+	length = sizeof( header ) + (int64_t)header.numSurfaces * sizeof( worldCacheSurface_t ) +
+		(int64_t)header.numVerts * sizeof( srfVert_t ) + (int64_t)header.numIndexes * sizeof( glIndex_t ) +
+		(int64_t)header.numLodErrors * sizeof( float );
+	if ( length > WORLDCACHE_MAX_LENGTH ) {
+		return;
+	}
+
+	// not the temp hunk, the cache must never be able to fail a load
+	buf = (byte *)malloc( length );
+	if ( !buf ) {
+		return;
+	}
+	Com_Memset( buf, 0, length );
+	Com_Memcpy( buf, &header, sizeof( header ) );
+
+	c = (worldCacheSurface_t *)( buf + sizeof( header ) );
+	verts = (srfVert_t *)( c + header.numSurfaces );
+	indexes = (glIndex_t *)( verts + header.numVerts );
+	lodErrors = (float *)( indexes + header.numIndexes );
+
+	for ( i = 0, surf = s_worldData.surfaces ; i < s_worldData.numsurfaces ; i++, surf++, c++ ) {
+		cv = (srfBspSurface_t *)surf->data;
+		c->surfaceType = cv->surfaceType;
+		if ( cv->surfaceType != SF_FACE && cv->surfaceType != SF_GRID && cv->surfaceType != SF_TRIANGLES ) {
+			continue;
+		}
+
+		c->cullinfo = surf->cullinfo;
+		VectorCopy( cv->cullBounds[0], c->cullBounds[0] );
+		VectorCopy( cv->cullBounds[1], c->cullBounds[1] );
+		VectorCopy( cv->cullOrigin, c->cullOrigin );
+		c->cullRadius = cv->cullRadius;
+		c->cullPlane = cv->cullPlane;
+
+		c->numVerts = cv->numVerts;
+		Com_Memcpy( verts, cv->verts, cv->numVerts * sizeof( *verts ) );
+		verts += cv->numVerts;
+
+		c->numIndexes = cv->numIndexes;
+		Com_Memcpy( indexes, cv->indexes, cv->numIndexes * sizeof( *indexes ) );
+		indexes += cv->numIndexes;
+
+		if ( cv->surfaceType != SF_GRID ) {
+			continue;
+		}
+
+		VectorCopy( cv->lodOrigin, c->lodOrigin );
+		c->lodRadius = cv->lodRadius;
+		c->lodFixed = cv->lodFixed;
+
+		c->width = cv->width;
+		Com_Memcpy( lodErrors, cv->widthLodError, cv->width * sizeof( *lodErrors ) );
+		lodErrors += cv->width;
+
+		c->height = cv->height;
+		Com_Memcpy( lodErrors, cv->heightLodError, cv->height * sizeof( *lodErrors ) );
+		lodErrors += cv->height;
+	}
+
+	ri.FS_WriteFile( R_WorldCachePath(), buf, length );
+	free( buf );
+}
+
 /*
 ===============
 R_LoadSurfaces
@@ -1716,6 +2176,8 @@ static	void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump ) {
 	int			numFaces, numMeshes, numTriSurfs, numFlares;
 	int			i;
 	float *hdrVertColors = NULL;
+	uint64_t	key;
+	bool		useCache, cached;
 
 	numFaces = 0;
 	numMeshes = 0;
@@ -1741,6 +2203,7 @@ static	void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump ) {
 	s_worldData.surfacesViewCount = (int*)ri.Hunk_Alloc ( count * sizeof(*s_worldData.surfacesViewCount), h_low );
 	s_worldData.surfacesDlightBits = (int*)ri.Hunk_Alloc ( count * sizeof(*s_worldData.surfacesDlightBits), h_low );
 	s_worldData.surfacesPshadowBits = (int*)ri.Hunk_Alloc ( count * sizeof(*s_worldData.surfacesPshadowBits), h_low );
+	s_worldData.jobDrawSurfs = (drawSurf_t *)ri.Hunk_Alloc( count * sizeof( *s_worldData.jobDrawSurfs ), h_low );
 
 	// load hdr vertex colors
 	if (r_hdr->integer)
@@ -1786,20 +2249,26 @@ static	void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump ) {
 		}
 	}
 
+	useCache = R_WorldCacheKey( surfs, verts, indexLump, hdrVertColors, &key );
+	cached = useCache && R_LoadWorldCache( key, surfs );
+
 	in = (dsurface_t*)(fileBase + surfs->fileofs);
 	out = s_worldData.surfaces;
 	for ( i = 0 ; i < count ; i++, in++, out++ ) {
 		switch ( LittleLong( in->surfaceType ) ) {
 		case MST_PATCH:
-			ParseMesh ( in, dv, hdrVertColors, out );
+			if ( !cached )
+				ParseMesh ( in, dv, hdrVertColors, out );
 			numMeshes++;
 			break;
 		case MST_TRIANGLE_SOUP:
-			ParseTriSurf( in, dv, hdrVertColors, out, indexes );
+			if ( !cached )
+				ParseTriSurf( in, dv, hdrVertColors, out, indexes );
 			numTriSurfs++;
 			break;
 		case MST_PLANAR:
-			ParseFace( in, dv, hdrVertColors, out, indexes );
+			if ( !cached )
+				ParseFace( in, dv, hdrVertColors, out, indexes );
 			numFaces++;
 			break;
 		case MST_FLARE:
@@ -1816,16 +2285,22 @@ static	void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump ) {
 		ri.FS_FreeFile(hdrVertColors);
 	}
 
+	if ( !cached ) {
 #ifdef PATCH_STITCHING
-	R_StitchAllPatches();
+		R_StitchAllPatches();
 #endif
 
-	R_FixSharedVertexLodError();
+		R_FixSharedVertexLodError();
 
 #ifdef PATCH_STITCHING
-	R_MovePatchSurfacesToHunk();
+		R_MovePatchSurfacesToHunk();
 #endif
 
+		if ( useCache ) {
+			R_SaveWorldCache( key );
+		}
+	}
+
 	ri.Printf( PRINT_ALL, "...loaded %d faces, %i meshes, %i trisurfs, %i flares\n", 
 		numFaces, numMeshes, numTriSurfs, numFlares );
 }
@@ -1971,6 +2446,125 @@ static	void R_LoadNodesAndLeafs (lump_t *nodeLump, lump_t *leafLump) {
 
 	// chain decendants
 	R_SetParent (s_worldData.nodes, NULL);
+
+	s_worldData.jobLeafs = (worldLeaf_t *)ri.Hunk_Alloc( numLeafs * sizeof( *s_worldData.jobLeafs ), h_low );
+}
+
+/*
+=================
+R_LeafGroupCluster
+=================
+*/
+static int R_LeafGroupCluster( const mnode_t *leaf ) {
+	if ( leaf->cluster < 0 || leaf->cluster >= s_worldData.numClusters ) {
+		return -1;
+	}
+	return leaf->cluster;
+}
+
+/*
+=================
+R_SameLeafGroup
+=================
+*/
+static bool R_SameLeafGroup( const mnode_t *leafA, const mnode_t *leafB ) {
+	return R_LeafGroupCluster( leafA ) == R_LeafGroupCluster( leafB ) && leafA->area == leafB->area;
+}
+
+/*
+=================
+R_LeafGroupCompare
+=================
+*/
+static int R_LeafGroupCompare( const void *a, const void *b ) {
+	const mnode_t	*leafA = *(const mnode_t **)a;
+	const mnode_t	*leafB = *(const mnode_t **)b;
+	int				clusterA, clusterB;
+
+	clusterA = R_LeafGroupCluster( leafA );
+	clusterB = R_LeafGroupCluster( leafB );
+	if ( clusterA != clusterB ) {
+		return clusterA < clusterB ? -1 : 1;
+	}
+	if ( leafA->area != leafB->area ) {
+		return leafA->area < leafB->area ? -1 : 1;
+	}
+
+	// keep the map's order inside a group
+	return leafA < leafB ? -1 : ( leafA > leafB );
+}
+
+/*
+=================
+R_SetupLeafGroups
+
+Sorts the leafs into groups that share a cluster and an area, so
+R_MarkLeaves only has to pick the groups in the PVS
+=================
+*/
+static void R_SetupLeafGroups( void ) {
+	world_t		*w = &s_worldData;
+	leafGroup_t	*group;
+	mnode_t		*leaf;
+	int			numLeafs, numPadded;
+	int			i, j;
+
+	numLeafs = w->numnodes - w->numDecisionNodes;
+	numPadded = numLeafs + 3;
+
+	w->sortedLeafs = (mnode_t **)ri.Hunk_Alloc( numLeafs * sizeof( *w->sortedLeafs ), h_low );
+	for ( i = 0 ; i < numLeafs ; i++ ) {
+		w->sortedLeafs[i] = w->nodes + w->numDecisionNodes + i;
+	}
+	qsort( w->sortedLeafs, numLeafs, sizeof( *w->sortedLeafs ), R_LeafGroupCompare );
+
+	w->numLeafGroups = 0;
+	for ( i = 0 ; i < numLeafs ; i++ ) {
+		if ( !i || !R_SameLeafGroup( w->sortedLeafs[i - 1], w->sortedLeafs[i] ) ) {
+			w->numLeafGroups++;
+		}
+	}
+
+	w->leafGroups = (leafGroup_t *)ri.Hunk_Alloc( w->numLeafGroups * sizeof( *w->leafGroups ), h_low );
+	w->numLeafGroups = 0;
+	group = NULL;
+	for ( i = 0 ; i < numLeafs ; i++ ) {
+		leaf = w->sortedLeafs[i];
+		if ( !i || !R_SameLeafGroup( w->sortedLeafs[i - 1], leaf ) ) {
+			group = &w->leafGroups[w->numLeafGroups++];
+			group->cluster = R_LeafGroupCluster( leaf );
+			group->area = leaf->area;
+			group->firstLeaf = i;
+			group->numLeafs = 0;
+			ClearBounds( group->bounds[0], group->bounds[1] );
+		}
+		group->numLeafs++;
+		AddPointToBounds( leaf->mins, group->bounds[0], group->bounds[1] );
+		AddPointToBounds( leaf->maxs, group->bounds[0], group->bounds[1] );
+	}
+
+	w->clusterLeafGroups = (int *)ri.Hunk_Alloc( ( w->numClusters + 1 ) * sizeof( *w->clusterLeafGroups ), h_low );
+	for ( i = 0, j = 0 ; i <= w->numClusters ; i++ ) {
+		while ( j < w->numLeafGroups && w->leafGroups[j].cluster < i ) {
+			j++;
+		}
+		w->clusterLeafGroups[i] = j;
+	}
+
+	// padded so four can be loaded starting at any leaf
+	for ( j = 0 ; j < 3 ; j++ ) {
+		w->leafMins[j] = (float *)ri.Hunk_Alloc( numPadded * sizeof( float ), h_low );
+		w->leafMaxs[j] = (float *)ri.Hunk_Alloc( numPadded * sizeof( float ), h_low );
+		for ( i = 0 ; i < numLeafs ; i++ ) {
+			w->leafMins[j][i] = w->sortedLeafs[i]->mins[j];
+			w->leafMaxs[j][i] = w->sortedLeafs[i]->maxs[j];
+		}
+	}
+
+	for ( i = 0 ; i < MAX_VISCOUNTS ; i++ ) {
+		w->visLeafGroups[i] = (int *)ri.Hunk_Alloc( w->numLeafGroups * sizeof( *w->visLeafGroups[i] ), h_low );
+		w->numVisLeafGroups[i] = 0;
+	}
 }
 
 //=============================================================================
@@ -2717,6 +3311,159 @@ void R_CalcVertexLightDirs( void )
 }
 
 
+/*
+=================
+R_WorldVaoSurface
+
+Returns the surface if it can be drawn straight from a static vao
+=================
+*/
+static srfBspSurface_t *R_WorldVaoSurface( msurface_t *surf ) {
+	srfBspSurface_t	*bspSurf;
+
+	if ( surf->shader->isPortal || surf->shader->isSky || ShaderRequiresCPUDeforms( surf->shader ) ) {
+		return NULL;
+	}
+
+	if ( *surf->data != SF_FACE && *surf->data != SF_GRID && *surf->data != SF_TRIANGLES ) {
+		return NULL;
+	}
+
+	bspSurf = (srfBspSurface_t *)surf->data;
+	if ( !bspSurf->numIndexes || !bspSurf->numVerts ) {
+		return NULL;
+	}
+
+	return bspSurf;
+}
+
+/*
+=================
+R_WorldVaoCompare
+=================
+*/
+static int R_WorldVaoCompare( const void *a, const void *b ) {
+	const msurface_t	*aa = *(const msurface_t **)a;
+	const msurface_t	*bb = *(const msurface_t **)b;
+
+	// shader first, which also keeps the lightmaps apart
+	if ( aa->shader->sortedIndex != bb->shader->sortedIndex ) {
+		return aa->shader->sortedIndex < bb->shader->sortedIndex ? -1 : 1;
+	}
+
+	if ( aa->fogIndex != bb->fogIndex ) {
+		return aa->fogIndex < bb->fogIndex ? -1 : 1;
+	}
+
+	if ( aa->cubemapIndex != bb->cubemapIndex ) {
+		return aa->cubemapIndex < bb->cubemapIndex ? -1 : 1;
+	}
+
+	// keep the map's order inside a batch
+	return aa < bb ? -1 : ( aa > bb );
+}
+
+/*
+=================
+R_CreateWorldVaos
+
+Packs the static world surfaces into vaos sorted by shader, fog and
+cubemap, so the surfaces of one batch are next to each other in the
+index buffer and RB_SurfaceVao can join the visible ones into a few
+glMultiDrawElements ranges
+=================
+*/
+#define MAX_WORLD_VAO_SIZE	( 64 * 1024 * 1024 )
+
+static void R_CreateWorldVaos( void ) {
+	msurface_t		**sorted, **first, **last, **surf;
+	srfBspSurface_t	*bspSurf;
+	srfVert_t		*verts;
+	glIndex_t		*indexes;
+	vao_t			*vao;
+	int				i, numSorted, numVaos;
+	int				numVerts, numIndexes, vaoSize, addSize, sortedIndex;
+	int				startTime;
+
+	if ( !r_worldVaos->integer ) {
+		return;
+	}
+
+	startTime = ri.Milliseconds();
+
+	sorted = (msurface_t **)ri.Hunk_AllocateTempMemory( s_worldData.numWorldSurfaces * sizeof( *sorted ) );
+	numSorted = 0;
+	for ( i = 0 ; i < s_worldData.numWorldSurfaces ; i++ ) {
+		if ( R_WorldVaoSurface( &s_worldData.surfaces[i] ) ) {
+			sorted[numSorted++] = &s_worldData.surfaces[i];
+		}
+	}
+
+	qsort( sorted, numSorted, sizeof( *sorted ), R_WorldVaoCompare );
+
+	numVaos = 0;
+	for ( first = last = sorted ; first < sorted + numSorted ; first = last ) {
+		// take whole shaders until the vao is full, but at least one
+		vaoSize = 0;
+		while ( last < sorted + numSorted ) {
+			sortedIndex = (*last)->shader->sortedIndex;
+			addSize = 0;
+			for ( surf = last ; surf < sorted + numSorted && (*surf)->shader->sortedIndex == sortedIndex ; surf++ ) {
+				addSize += ( (srfBspSurface_t *)(*surf)->data )->numVerts * sizeof( srfVert_t );
+			}
+
+			if ( vaoSize && vaoSize + addSize > MAX_WORLD_VAO_SIZE ) {
+				break;
+			}
+
+			vaoSize += addSize;
+			last = surf;
+		}
+
+		numVerts = 0;
+		numIndexes = 0;
+		for ( surf = first ; surf < last ; surf++ ) {
+			bspSurf = (srfBspSurface_t *)(*surf)->data;
+			numVerts += bspSurf->numVerts;
+			numIndexes += bspSurf->numIndexes;
+		}
+
+		verts = (srfVert_t *)ri.Hunk_AllocateTempMemory( numVerts * sizeof( *verts ) );
+		indexes = (glIndex_t *)ri.Hunk_AllocateTempMemory( numIndexes * sizeof( *indexes ) );
+
+		numVerts = 0;
+		numIndexes = 0;
+		for ( surf = first ; surf < last ; surf++ ) {
+			bspSurf = (srfBspSurface_t *)(*surf)->data;
+
+			bspSurf->firstIndex = numIndexes;
+			for ( i = 0 ; i < bspSurf->numIndexes ; i++ ) {
+				indexes[numIndexes++] = numVerts + bspSurf->indexes[i];
+			}
+
+			Com_Memcpy( verts + numVerts, bspSurf->verts, bspSurf->numVerts * sizeof( *verts ) );
+			numVerts += bspSurf->numVerts;
+		}
+
+		vao = R_CreateVao2( va( "staticWorld%i_VAO", numVaos ), numVerts, verts, numIndexes, indexes );
+
+		for ( surf = first ; surf < last ; surf++ ) {
+			( (srfBspSurface_t *)(*surf)->data )->vao = vao;
+		}
+
+		ri.Hunk_FreeTempMemory( indexes );
+		ri.Hunk_FreeTempMemory( verts );
+
+		ri.Printf( PRINT_DEVELOPER, "...world VAO %i: %i verts %i tris\n", numVaos, numVerts, numIndexes / 3 );
+		numVaos++;
+	}
+
+	ri.Hunk_FreeTempMemory( sorted );
+
+	ri.Printf( PRINT_ALL, "...packed %i surfaces into %i world VAOs in %i msec\n",
+		numSorted, numVaos, ri.Milliseconds() - startTime );
+}
+
 /*
 =================
 RE_LoadWorldMap
@@ -2801,11 +3548,13 @@ void RE_LoadWorldMap( const char *name ) {
 	R_LoadLightmaps( &header->lumps[LUMP_LIGHTMAPS], &header->lumps[LUMP_SURFACES] );
 	R_LoadPlanes (&header->lumps[LUMP_PLANES]);
 	R_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
+	R_RequestWorldImages( &header->lumps[LUMP_SURFACES] );
 	R_LoadSurfaces( &header->lumps[LUMP_SURFACES], &header->lumps[LUMP_DRAWVERTS], &header->lumps[LUMP_DRAWINDEXES] );
 	R_LoadMarksurfaces (&header->lumps[LUMP_LEAFSURFACES]);
 	R_LoadNodesAndLeafs (&header->lumps[LUMP_NODES], &header->lumps[LUMP_LEAFS]);
 	R_LoadSubmodels (&header->lumps[LUMP_MODELS]);
 	R_LoadVisibility( &header->lumps[LUMP_VISIBILITY] );
+	R_SetupLeafGroups();
 	R_LoadLightGrid( &header->lumps[LUMP_LIGHTGRID] );
 
 	// determine vertex light directions
@@ -3027,6 +3776,9 @@ void RE_LoadWorldMap( const char *name ) {
 		}
 	}
 
+	// pack the static world surfaces for multi-draw
+	R_CreateWorldVaos();
+
 	s_worldData.dataSize = (byte *)ri.Hunk_Alloc(0, h_low) - startMarker;
 
 	// only set tr.world now that we know the entire level has loaded properly
@@ -3042,5 +3794,9 @@ void RE_LoadWorldMap( const char *name ) {
 		R_RenderMissingCubemaps();
 	}
 
+	// anything left was asked for but never used
+	R_ClearImageJobs();
+	R_SaveImageCacheIndex();
+
     ri.FS_FreeFile( buffer.v );
 }
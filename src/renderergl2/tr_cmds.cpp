@@ -29,6 +29,8 @@ R_PerformanceCounters
 =====================
 */
 void R_PerformanceCounters( void ) {
+	R_ProfileFrontEndCounters();
+
 	if ( !r_speeds->integer ) {
 		// clear the counters even if we aren't printing
 		Com_Memset( &tr.pc, 0, sizeof( tr.pc ) );
@@ -49,7 +51,9 @@ void R_PerformanceCounters( void ) {
 			tr.pc.c_sphere_cull_md3_in, tr.pc.c_sphere_cull_md3_clip, tr.pc.c_sphere_cull_md3_out,
 			tr.pc.c_box_cull_md3_in, tr.pc.c_box_cull_md3_clip, tr.pc.c_box_cull_md3_out );
 	} else if (r_speeds->integer == 3) {
-		ri.Printf (PRINT_ALL, "viewcluster: %i\n", tr.viewCluster );
+		ri.Printf (PRINT_ALL, "viewcluster: %i  groups %i  leafs %i/%i  surfs %i/%i\n", tr.viewCluster,
+			tr.pc.c_leafGroupsTested, tr.pc.c_leafs, tr.pc.c_leafsTested,
+			tr.pc.c_worldSurfaces, tr.pc.c_worldSurfacesTested );
 	} else if (r_speeds->integer == 4) {
 		if ( backEnd.pc.c_dlightVertexes ) {
 			ri.Printf (PRINT_ALL, "dlight srf:%i  culled:%i  verts:%i  tris:%i\n",
@@ -59,7 +63,7 @@ void R_PerformanceCounters( void ) {
 	}
 	else if (r_speeds->integer == 5 )
 	{
-		ri.Printf( PRINT_ALL, "zFar: %.0f\n", tr.viewParms.zFar );
+		ri.Printf( PRINT_ALL, "zFar: %.0f\n", fe->viewParms.zFar );
 	}
 	else if (r_speeds->integer == 6 )
 	{
@@ -70,6 +74,10 @@ void R_PerformanceCounters( void ) {
 	{
 		ri.Printf( PRINT_ALL, "VAO draws: static %i dynamic %i\n",
 			backEnd.pc.c_staticVaoDraws, backEnd.pc.c_dynamicVaoDraws);
+		ri.Printf( PRINT_ALL, "draw calls: %i  state changes: %i  multidraw surfs: %i merged %i\n",
+			backEnd.pc.c_drawCalls, backEnd.pc.c_stateChanges, backEnd.pc.c_multidraws, backEnd.pc.c_multidrawsMerged);
+		ri.Printf( PRINT_ALL, "texture binds: %i  VAO uploads: %i (%i bytes)\n",
+			backEnd.pc.c_textureBinds, backEnd.pc.c_vaoUploads, backEnd.pc.c_vaoUploadBytes);
 		ri.Printf( PRINT_ALL, "GLSL binds: %i  draws: gen %i light %i fog %i dlight %i\n",
 			backEnd.pc.c_glslShaderBinds, backEnd.pc.c_genericDraws, backEnd.pc.c_lightallDraws, backEnd.pc.c_fogDraws, backEnd.pc.c_dlightDraws);
 	}
@@ -179,7 +187,7 @@ void	R_AddDrawSurfCmd( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	cmd->numDrawSurfs = numDrawSurfs;
 
 	cmd->refdef = tr.refdef;
-	cmd->viewParms = tr.viewParms;
+	cmd->viewParms = fe->viewParms;
 }
 
 
@@ -219,7 +227,7 @@ void	R_AddPostProcessCmd( ) {
 	cmd->commandId = RC_POSTPROCESS;
 
 	cmd->refdef = tr.refdef;
-	cmd->viewParms = tr.viewParms;
+	cmd->viewParms = fe->viewParms;
 }
 
 /*
@@ -452,6 +460,8 @@ void RE_BeginFrame( stereoFrame_t stereoFrame ) {
 	tr.frameCount++;
 	tr.frameSceneNum = 0;
 
+	R_ProfileBeginFrame();
+
 	//
 	// do overdraw measurement
 	//
@@ -653,6 +663,8 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec ) {
 
 	R_IssueRenderCommands( true );
 
+	R_ProfileEndFrame();
+
 	R_InitNextFrame();
 
 	if ( frontEndMsec ) {
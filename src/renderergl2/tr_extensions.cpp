@@ -33,11 +33,13 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #define GLE(ret, name, ...) name##proc *qgl##name;
 QGL_1_3_PROCS;
+QGL_1_4_PROCS;
 QGL_1_5_PROCS;
 QGL_2_0_PROCS;
 QGL_3_0_PROCS;
 QGL_ARB_framebuffer_object_PROCS;
 QGL_ARB_vertex_array_object_PROCS;
+QGL_ARB_timer_query_PROCS;
 QGL_EXT_direct_state_access_PROCS;
 #undef GLE
 
@@ -54,6 +56,8 @@ void GLimp_InitExtraExtensions()
     bool q_gl_version_at_least_3_0 = (glRefConfig.openglMajorVersion >= 3);
     bool q_gl_version_at_least_3_2 = (glRefConfig.openglMajorVersion > 3 ||
             (glRefConfig.openglMajorVersion == 3 && glRefConfig.openglMinorVersion > 2));
+    bool q_gl_version_at_least_3_3 = (glRefConfig.openglMajorVersion > 3 ||
+            (glRefConfig.openglMajorVersion == 3 && glRefConfig.openglMinorVersion >= 3));
 
     // Check if we need Intel graphics specific fixes.
     glRefConfig.intelGraphics = qfalse;
@@ -70,6 +74,9 @@ void GLimp_InitExtraExtensions()
     // OpenGL 1.3, was GL_ARB_texture_compression
     QGL_1_3_PROCS;
 
+    // OpenGL 1.4, was GL_EXT_multi_draw_arrays
+    QGL_1_4_PROCS;
+
     // OpenGL 1.5, was GL_ARB_vertex_buffer_object and GL_ARB_occlusion_query
     QGL_1_5_PROCS;
     glRefConfig.occlusionQuery = qtrue;
@@ -174,6 +181,22 @@ void GLimp_InitExtraExtensions()
         ri.Printf(PRINT_ALL, result[2], extension);
     }
 
+    // OpenGL 3.3 - GL_ARB_timer_query
+    extension = "GL_ARB_timer_query";
+    glRefConfig.timerQuery = qfalse;
+    if (q_gl_version_at_least_3_3 || SDL_GL_ExtensionSupported(extension))
+    {
+        glRefConfig.timerQuery = qtrue;
+
+        QGL_ARB_timer_query_PROCS;
+
+        ri.Printf(PRINT_ALL, result[glRefConfig.timerQuery], extension);
+    }
+    else
+    {
+        ri.Printf(PRINT_ALL, result[2], extension);
+    }
+
     // Determine GLSL version
     if (1)
     {
@@ -186,6 +209,25 @@ void GLimp_InitExtraExtensions()
         ri.Printf(PRINT_ALL, "...using GLSL version %s\n", version);
     }
 
+    // Determine how many bone matrices fit in the vertex shader uniforms,
+    // leaving room for the other uniforms
+    glRefConfig.glslMaxAnimatedBones = 0;
+    if (r_gpuSkinning->integer)
+    {
+        GLint maxVertexUniforms;
+
+        qglGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &maxVertexUniforms);
+
+        glRefConfig.glslMaxAnimatedBones = Com_Clamp(0, IQM_MAX_JOINTS, (maxVertexUniforms - 160) / 16);
+        if (glRefConfig.glslMaxAnimatedBones < 12)
+            glRefConfig.glslMaxAnimatedBones = 0;
+    }
+
+    if (glRefConfig.glslMaxAnimatedBones)
+        ri.Printf(PRINT_ALL, "...skinning IQM models with up to %d bones in GLSL\n", glRefConfig.glslMaxAnimatedBones);
+    else
+        ri.Printf(PRINT_ALL, "...skinning IQM models on the CPU\n");
+
     glRefConfig.memInfo = MI_NONE;
 
     // GL_NVX_gpu_memory_info
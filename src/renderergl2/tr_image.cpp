@@ -315,7 +315,8 @@ void R_ImageList_f( void ) {
 
 	ri.Printf (PRINT_ALL, " ---------\n");
 	ri.Printf (PRINT_ALL, " approx %i bytes\n", estTotalSize);
-	ri.Printf (PRINT_ALL, " %i total images\n\n", tr.numImages );
+	ri.Printf (PRINT_ALL, " %i total images\n", tr.numImages );
+	R_ImageCacheInfo();
 }
 
 //=======================================================================
@@ -342,7 +343,7 @@ static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,
 	byte	*pix1, *pix2, *pix3, *pix4;
 
 	if (outwidth>2048)
-		ri.Error(ERR_DROP, "ResampleTexture: max width");
+		R_ImageError(ERR_DROP, "ResampleTexture: max width");
 								
 	fracstep = inwidth*0x10000/outwidth;
 
@@ -1307,6 +1308,9 @@ void R_LightScaleTexture (byte *in, int inwidth, int inheight, bool only_gamma )
 }
 
 
+// filled in by R_InitImages, before any job can get to R_MipMapsRGB
+static float downmipSrgbLookup[256];
+
 /*
 ================
 R_MipMapsRGB
@@ -1320,16 +1324,8 @@ static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
 	int x, y, c, stride;
 	const byte *in2;
 	float total;
-	static float downmipSrgbLookup[256];
-	static int downmipSrgbLookupSet = 0;
 	byte *out = in;
 
-	if (!downmipSrgbLookupSet) {
-		for (x = 0; x < 256; x++)
-			downmipSrgbLookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
-		downmipSrgbLookupSet = 1;
-	}
-
 	if (inWidth == 1 && inHeight == 1)
 		return;
 
@@ -1533,7 +1529,7 @@ static bool RawImage_ScaleToPower2( byte **data, int *inout_width, int *inout_he
 			finalheight >>= 1;
 		}
 
-		*resampledBuffer = (byte*)ri.Hunk_AllocateTempMemory( finalwidth * finalheight * 4 );
+		*resampledBuffer = (byte*)R_ImageTempAlloc( finalwidth * finalheight * 4 );
 
 		if (scaled_width != width || scaled_height != height)
 			ResampleTexture (*data, width, height, *resampledBuffer, scaled_width, scaled_height);
@@ -1566,7 +1562,7 @@ static bool RawImage_ScaleToPower2( byte **data, int *inout_width, int *inout_he
 	{
 		if (data && resampledBuffer)
 		{
-			*resampledBuffer = (byte*)ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
+			*resampledBuffer = (byte*)R_ImageTempAlloc( scaled_width * scaled_height * 4 );
 			ResampleTexture (*data, width, height, *resampledBuffer, scaled_width, scaled_height);
 			*data = *resampledBuffer;
 		}
@@ -2099,31 +2095,15 @@ static void Upload32(byte *data, int x, int y, int width, int height, GLenum pic
 
 /*
 ================
-R_CreateImage2
-
-This is the only way any image_t are created
+R_AllocImage2
 ================
 */
-image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLenum picFormat, int numMips, imgType_t type, int/*imgFlags_t*/ flags, int internalFormat ) {
-	byte       *resampledBuffer = NULL;
+static image_t *R_AllocImage2( const char *name, int width, int height, imgType_t type, int/*imgFlags_t*/ flags ) {
 	image_t    *image;
-	bool    isLightmap = false, scaled = false;
-	long        hash;
-	int         glWrapClampMode, mipWidth, mipHeight, miplevel;
-	bool    rgba8 = picFormat == GL_RGBA8 || picFormat == GL_SRGB8_ALPHA8_EXT;
-	bool    mipmap = !!(flags & IMGFLAG_MIPMAP);
-	bool    cubemap = !!(flags & IMGFLAG_CUBEMAP);
-	bool    picmip = !!(flags & IMGFLAG_PICMIP);
-	bool    lastMip;
-	GLenum textureTarget = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
-	GLenum dataFormat;
 
 	if (strlen(name) >= MAX_QPATH ) {
 		ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long", name);
 	}
-	if ( !strncmp( name, "*lightmap", 9 ) ) {
-		isLightmap = true;
-	}
 
 	if ( tr.numImages == MAX_DRAWIMAGES ) {
 		ri.Error( ERR_DROP, "R_CreateImage: MAX_DRAWIMAGES hit");
@@ -2140,34 +2120,73 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 
 	image->width = width;
 	image->height = height;
-	if (flags & IMGFLAG_CLAMPTOEDGE)
-		glWrapClampMode = GL_CLAMP_TO_EDGE;
-	else
-		glWrapClampMode = GL_REPEAT;
 
-	if (!internalFormat)
-		internalFormat = RawImage_GetFormat(pic, width * height, picFormat, isLightmap, image->type, image->flags);
+	return image;
+}
 
-	image->internalFormat = internalFormat;
+/*
+================
+R_PrepareImage2
+
+Picks the internal format and scales the pic to the size it will be
+uploaded at.  Doesn't touch GL, so it can run on a job thread.
+================
+*/
+static bool R_PrepareImage2( byte **pic, int *width, int *height, GLenum picFormat, int *numMips, imgType_t type, int/*imgFlags_t*/ flags, bool isLightmap, int *internalFormat, byte **resampledBuffer ) {
+	bool    scaled = false;
+	int         miplevel;
+	bool    rgba8 = picFormat == GL_RGBA8 || picFormat == GL_SRGB8_ALPHA8_EXT;
+	bool    cubemap = !!(flags & IMGFLAG_CUBEMAP);
+	bool    picmip = !!(flags & IMGFLAG_PICMIP);
+
+	if (!*internalFormat)
+		*internalFormat = RawImage_GetFormat(*pic, *width * *height, picFormat, isLightmap, type, flags);
 
 	// Possibly scale image before uploading.
 	// if not rgba8 and uploading an image, skip picmips.
 	if (!cubemap)
 	{
 		if (rgba8)
-			scaled = RawImage_ScaleToPower2(&pic, &width, &height, type, flags, &resampledBuffer);
-		else if (pic && picmip)
+			scaled = RawImage_ScaleToPower2(pic, width, height, type, flags, resampledBuffer);
+		else if (*pic && picmip)
 		{
-			for (miplevel = r_picmip->integer; miplevel > 0 && numMips > 1; miplevel--, numMips--)
+			for (miplevel = r_picmip->integer; miplevel > 0 && *numMips > 1; miplevel--, (*numMips)--)
 			{
-				int size = CalculateMipSize(width, height, picFormat);
-				width = MAX(1, width >> 1);
-				height = MAX(1, height >> 1);
-				pic += size;
+				int size = CalculateMipSize(*width, *height, picFormat);
+				*width = MAX(1, *width >> 1);
+				*height = MAX(1, *height >> 1);
+				*pic += size;
 			}
 		}
 	}
 
+	return scaled;
+}
+
+/*
+================
+R_UploadImage2
+
+Allocates the texture storage for a prepared pic, uploads it and sets
+the texture parameters
+================
+*/
+static void R_UploadImage2( image_t *image, byte *pic, int width, int height, GLenum picFormat, int numMips, int internalFormat, bool scaled ) {
+	long        hash;
+	int         glWrapClampMode, mipWidth, mipHeight, miplevel;
+	int/*imgFlags_t*/ flags = image->flags;
+	bool    mipmap = !!(flags & IMGFLAG_MIPMAP);
+	bool    cubemap = !!(flags & IMGFLAG_CUBEMAP);
+	bool    lastMip;
+	GLenum textureTarget = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	GLenum dataFormat;
+
+	if (flags & IMGFLAG_CLAMPTOEDGE)
+		glWrapClampMode = GL_CLAMP_TO_EDGE;
+	else
+		glWrapClampMode = GL_REPEAT;
+
+	image->internalFormat = internalFormat;
 	image->uploadWidth = width;
 	image->uploadHeight = height;
 
@@ -2201,9 +2220,6 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 	if (pic)
 		Upload32(pic, 0, 0, width, height, picFormat, numMips, image, scaled);
 
-	if (resampledBuffer != NULL)
-		ri.Hunk_FreeTempMemory(resampledBuffer);
-
 	// Set all necessary texture parameters.
 	qglTextureParameterfEXT(image->texnum, textureTarget, GL_TEXTURE_WRAP_S, glWrapClampMode);
 	qglTextureParameterfEXT(image->texnum, textureTarget, GL_TEXTURE_WRAP_T, glWrapClampMode);
@@ -2235,13 +2251,52 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 
 	GL_CheckErrors();
 
-	hash = generateHashValue(name);
+	hash = generateHashValue(image->imgName);
 	image->next = hashTable[hash];
 	hashTable[hash] = image;
+}
+
+/*
+================
+R_CreateImage2
+
+This is the only way any image_t are created
+================
+*/
+image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLenum picFormat, int numMips, imgType_t type, int/*imgFlags_t*/ flags, int internalFormat ) {
+	byte       *resampledBuffer = NULL;
+	image_t    *image;
+	bool    scaled;
+
+	image = R_AllocImage2( name, width, height, type, flags );
+
+	scaled = R_PrepareImage2( &pic, &width, &height, picFormat, &numMips, type, flags,
+		!strncmp( name, "*lightmap", 9 ), &internalFormat, &resampledBuffer );
+
+	R_UploadImage2( image, pic, width, height, picFormat, numMips, internalFormat, scaled );
+
+	if (resampledBuffer != NULL)
+		R_ImageTempFree(resampledBuffer);
 
 	return image;
 }
 
+/*
+===============
+R_ImageLoaded
+===============
+*/
+bool R_ImageLoaded( const char *name ) {
+	image_t	*image;
+
+	for (image=hashTable[generateHashValue(name)]; image; image=image->next) {
+		if ( !strcmp( name, image->imgName ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
 
 /*
 ================
@@ -2267,12 +2322,6 @@ void R_UpdateSubImage( image_t *image, byte *pic, int x, int y, int width, int h
 // Prototype for dds loader function which isn't common to both renderers
 void R_LoadDDS(const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips);
 
-typedef struct
-{
-	const char *ext;
-	void (*ImageLoader)( const char *, unsigned char **, int *, int * );
-} imageExtToLoaderMap_t;
-
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
 static imageExtToLoaderMap_t imageLoaders[ ] =
@@ -2387,6 +2436,51 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum
 }
 
 
+/*
+===============
+R_GenNormalMap
+
+True if R_FindImageFile generates a normal map from the image, which
+is left to the main thread
+===============
+*/
+static bool R_GenNormalMap( GLenum picFormat, imgType_t type, int/*imgFlags_t*/ flags )
+{
+	int/*imgFlags_t*/ checkFlagsTrue, checkFlagsFalse;
+
+	checkFlagsTrue = IMGFLAG_PICMIP | IMGFLAG_MIPMAP | IMGFLAG_GENNORMALMAP;
+	checkFlagsFalse = IMGFLAG_CUBEMAP;
+	return r_normalMapping->integer && (picFormat == GL_RGBA8) && (type == IMGTYPE_COLORALPHA) &&
+		((flags & checkFlagsTrue) == checkFlagsTrue) && !(flags & checkFlagsFalse);
+}
+
+/*
+===============
+R_PrepareImageJob
+
+Runs on a job thread once the image is decoded
+===============
+*/
+static void R_PrepareImageJob( imageJob_t *job )
+{
+	byte	*resampledBuffer = NULL;
+	int		numMips = 0;
+
+	if ( R_GenNormalMap( GL_RGBA8, job->type, job->flags ) || ( job->flags & IMGFLAG_CUBEMAP ) ) {
+		return;
+	}
+
+	// the resampled buffer belongs to the job until it is released
+	job->upload = job->pic;
+	job->uploadWidth = job->width;
+	job->uploadHeight = job->height;
+	job->internalFormat = 0;
+	job->scaled = R_PrepareImage2( &job->upload, &job->uploadWidth, &job->uploadHeight, GL_RGBA8, &numMips,
+		job->type, job->flags, false, &job->internalFormat, &resampledBuffer );
+	job->numLevels = 1;
+	job->prepared = true;
+}
+
 /*
 ===============
 R_FindImageFile
@@ -2403,7 +2497,10 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, int/*imgFlags_t*/ fl
 	GLenum  picFormat;
 	int picNumMips;
 	long	hash;
-	int/*imgFlags_t*/ checkFlagsTrue, checkFlagsFalse;
+	imageJob_t	*job, prepared;
+	uint64_t	cacheKey;
+	bool	cacheable;
+	void	*cacheBuf;
 
 	if (!name) {
 		return NULL;
@@ -2427,17 +2524,73 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, int/*imgFlags_t*/ fl
 	}
 
 	//
-	// load the pic from disk
+	// see if the image cache has it ready to upload
 	//
-	R_LoadImage( name, &pic, &width, &height, &picFormat, &picNumMips );
-	if ( pic == NULL ) {
-		return NULL;
+	Com_Memset( &prepared, 0, sizeof( prepared ) );
+	Q_strncpyz( prepared.name, name, sizeof( prepared.name ) );
+	prepared.type = type;
+	prepared.flags = flags;
+
+	cacheable = R_ImageCacheKey( name, type, flags, &cacheKey ) &&
+		!R_GenNormalMap( GL_RGBA8, type, flags ) && !( flags & IMGFLAG_CUBEMAP );
+	if ( cacheable && R_LoadCachedImage( cacheKey, &prepared, &cacheBuf ) ) {
+		image = R_AllocImage2( name, prepared.width, prepared.height, type, flags );
+		R_UploadImage2( image, prepared.upload, prepared.uploadWidth, prepared.uploadHeight, GL_RGBA8, 0, prepared.internalFormat, prepared.scaled );
+		ri.FS_FreeFile( cacheBuf );
+		return image;
 	}
 
-	checkFlagsTrue = IMGFLAG_PICMIP | IMGFLAG_MIPMAP | IMGFLAG_GENNORMALMAP;
-	checkFlagsFalse = IMGFLAG_CUBEMAP;
-	if (r_normalMapping->integer && (picFormat == GL_RGBA8) && (type == IMGTYPE_COLORALPHA) &&
-		((flags & checkFlagsTrue) == checkFlagsTrue) && !(flags & checkFlagsFalse))
+	//
+	// see if the job threads have it ready
+	//
+	job = R_TakeImageJob( name, type, flags );
+	if ( job && job->prepared ) {
+		// Upload32 works on the pic in place, so save it first
+		if ( cacheable )
+			R_SaveCachedImage( cacheKey, job );
+
+		image = R_AllocImage2( name, job->width, job->height, type, flags );
+		R_UploadImage2( image, job->upload, job->uploadWidth, job->uploadHeight, GL_RGBA8, 0, job->internalFormat, job->scaled );
+		R_ReleaseImageJob( job );
+		return image;
+	}
+
+	if ( job ) {
+		// decoded, the rest is done here
+		pic = job->pic;
+		width = job->width;
+		height = job->height;
+		picFormat = GL_RGBA8;
+		picNumMips = 0;
+	} else {
+		//
+		// load the pic from disk
+		//
+		R_LoadImage( name, &pic, &width, &height, &picFormat, &picNumMips );
+		if ( pic == NULL ) {
+			return NULL;
+		}
+
+		if ( cacheable && picFormat == GL_RGBA8 ) {
+			// prepare it here instead of in R_CreateImage2, to keep it
+			prepared.pic = pic;
+			prepared.width = width;
+			prepared.height = height;
+			R_PrepareImageJob( &prepared );
+			R_SaveCachedImage( cacheKey, &prepared );
+
+			image = R_AllocImage2( name, width, height, type, flags );
+			R_UploadImage2( image, prepared.upload, prepared.uploadWidth, prepared.uploadHeight, GL_RGBA8, 0, prepared.internalFormat, prepared.scaled );
+
+			// scaling leaves it in a temp buffer
+			if ( prepared.upload != pic )
+				R_ImageTempFree( prepared.upload );
+			ri.Free( pic );
+			return image;
+		}
+	}
+
+	if (R_GenNormalMap(picFormat, type, flags))
 	{
 		char normalName[MAX_QPATH];
 		image_t *normalImage;
@@ -2555,7 +2708,10 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, int/*imgFlags_t*/ fl
 	}
 
 	image = R_CreateImage2( ( char * ) name, pic, width, height, picFormat, picNumMips, type, flags, 0 );
-	ri.Free( pic );
+	if ( job )
+		R_ReleaseImageJob( job );
+	else
+		ri.Free( pic );
 	return image;
 }
 
@@ -2913,18 +3069,63 @@ void R_SetColorMappings( void ) {
 	}
 }
 
+/*
+===============
+R_InitImageCacheSettings
+
+Everything besides the source file that R_PrepareImage2 depends on
+===============
+*/
+static void R_InitImageCacheSettings( void ) {
+	struct {
+		int		picmip, roundImagesDown, imageUpsample, imageUpsampleMaxSize;
+		int		texturebits, parallaxMapping;
+		float	greyscale;
+		int		maxTextureSize, textureCompression, refTextureCompression;
+	} settings;
+
+	// DDS files are looked for first, and are not cached
+	if ( r_ext_compressed_textures->integer ) {
+		R_InitImageCache( NULL, 0 );
+		return;
+	}
+
+	Com_Memset( &settings, 0, sizeof( settings ) );
+	settings.picmip = r_picmip->integer;
+	settings.roundImagesDown = r_roundImagesDown->integer;
+	settings.imageUpsample = r_imageUpsample->integer;
+	settings.imageUpsampleMaxSize = r_imageUpsampleMaxSize->integer;
+	settings.texturebits = r_texturebits->integer;
+	settings.parallaxMapping = r_parallaxMapping->integer;
+	settings.greyscale = r_greyscale->value;
+	settings.maxTextureSize = glConfig.maxTextureSize;
+	settings.textureCompression = glConfig.textureCompression;
+	settings.refTextureCompression = glRefConfig.textureCompression;
+
+	R_InitImageCache( &settings, sizeof( settings ) );
+}
+
 /*
 ===============
 R_InitImages
 ===============
 */
 void	R_InitImages( void ) {
+	int		i;
+
 	Com_Memset(hashTable, 0, sizeof(hashTable));
+
+	for (i = 0; i < 256; i++)
+		downmipSrgbLookup[i] = powf(i / 255.0f, 2.2f) * 0.25f;
+
 	// build brightness translation tables
 	R_SetColorMappings();
 
 	// create default texture and white texture
 	R_CreateBuiltinImages();
+
+	R_InitImageJobs( imageLoaders, numImageLoaders, R_PrepareImageJob );
+	R_InitImageCacheSettings();
 }
 
 /*
@@ -2935,6 +3136,9 @@ R_DeleteTextures
 void R_DeleteTextures( void ) {
 	int		i;
 
+	R_ClearImageJobs();
+	R_SaveImageCacheIndex();
+
 	for ( i=0; i<tr.numImages ; i++ ) {
 		qglDeleteTextures( 1, &tr.images[i]->texnum );
 	}
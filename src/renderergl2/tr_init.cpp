@@ -82,6 +82,8 @@ cvar_t	*r_norefresh;
 cvar_t	*r_drawentities;
 cvar_t	*r_drawworld;
 cvar_t	*r_speeds;
+cvar_t	*r_profile;
+cvar_t	*r_profileFile;
 cvar_t	*r_fullbright;
 cvar_t	*r_novis;
 cvar_t	*r_nocull;
@@ -104,6 +106,7 @@ cvar_t  *r_ext_framebuffer_multisample;
 cvar_t  *r_arb_seamless_cube_map;
 cvar_t  *r_arb_vertex_array_object;
 cvar_t  *r_ext_direct_state_access;
+cvar_t  *r_gpuSkinning;
 
 cvar_t  *r_cameraExposure;
 
@@ -141,6 +144,8 @@ cvar_t  *r_baseSpecular;
 cvar_t  *r_baseGloss;
 cvar_t  *r_glossType;
 cvar_t  *r_mergeLightmaps;
+cvar_t  *r_worldVaos;
+cvar_t  *r_mergeMultidraws;
 cvar_t  *r_dlightMode;
 cvar_t  *r_pshadowDist;
 cvar_t  *r_imageUpsample;
@@ -224,6 +229,12 @@ cvar_t	*r_debugLight;
 cvar_t	*r_debugSort;
 cvar_t	*r_printShaders;
 cvar_t	*r_saveFontData;
+cvar_t	*r_shaderCache;
+cvar_t	*r_imageJobs;
+cvar_t	*r_imageCache;
+cvar_t	*r_imageCacheSize;
+cvar_t	*r_frontEndJobs;
+cvar_t	*r_worldCache;
 
 cvar_t	*r_marksOnTriangleMeshes;
 
@@ -1087,6 +1098,7 @@ void R_Register( void )
 	r_arb_seamless_cube_map = ri.Cvar_Get( "r_arb_seamless_cube_map", "0", CVAR_ARCHIVE | CVAR_LATCH);
 	r_arb_vertex_array_object = ri.Cvar_Get( "r_arb_vertex_array_object", "1", CVAR_ARCHIVE | CVAR_LATCH);
 	r_ext_direct_state_access = ri.Cvar_Get("r_ext_direct_state_access", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	r_gpuSkinning = ri.Cvar_Get( "r_gpuSkinning", "1", CVAR_ARCHIVE | CVAR_LATCH );
 
 	r_ext_texture_filter_anisotropic = ri.Cvar_Get( "r_ext_texture_filter_anisotropic",
 			"1", CVAR_ARCHIVE | CVAR_LATCH );
@@ -1158,6 +1170,8 @@ void R_Register( void )
 	r_dlightMode = ri.Cvar_Get( "r_dlightMode", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_pshadowDist = ri.Cvar_Get( "r_pshadowDist", "128", CVAR_ARCHIVE );
 	r_mergeLightmaps = ri.Cvar_Get( "r_mergeLightmaps", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_worldVaos = ri.Cvar_Get( "r_worldVaos", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_mergeMultidraws = ri.Cvar_Get( "r_mergeMultidraws", "1", CVAR_ARCHIVE );
 	r_imageUpsample = ri.Cvar_Get( "r_imageUpsample", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_imageUpsampleMaxSize = ri.Cvar_Get( "r_imageUpsampleMaxSize", "1024", CVAR_ARCHIVE | CVAR_LATCH );
 	r_imageUpsampleType = ri.Cvar_Get( "r_imageUpsampleType", "1", CVAR_ARCHIVE | CVAR_LATCH );
@@ -1228,6 +1242,12 @@ void R_Register( void )
 	r_debugSort = ri.Cvar_Get( "r_debugSort", "0", CVAR_CHEAT );
 	r_printShaders = ri.Cvar_Get( "r_printShaders", "0", 0 );
 	r_saveFontData = ri.Cvar_Get( "r_saveFontData", "0", 0 );
+	r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE );
+	r_imageJobs = ri.Cvar_Get( "r_imageJobs", "1", CVAR_ARCHIVE );
+	r_imageCache = ri.Cvar_Get( "r_imageCache", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_imageCacheSize = ri.Cvar_Get( "r_imageCacheSize", "256", CVAR_ARCHIVE );
+	r_frontEndJobs = ri.Cvar_Get( "r_frontEndJobs", "1", CVAR_ARCHIVE );
+	r_worldCache = ri.Cvar_Get( "r_worldCache", "1", CVAR_ARCHIVE );
 
 	r_nocurves = ri.Cvar_Get ("r_nocurves", "0", CVAR_CHEAT );
 	r_drawworld = ri.Cvar_Get ("r_drawworld", "1", CVAR_CHEAT );
@@ -1249,6 +1269,8 @@ void R_Register( void )
 	r_novis = ri.Cvar_Get ("r_novis", "0", CVAR_CHEAT);
 	r_showcluster = ri.Cvar_Get ("r_showcluster", "0", CVAR_CHEAT);
 	r_speeds = ri.Cvar_Get ("r_speeds", "0", CVAR_CHEAT);
+	r_profile = ri.Cvar_Get( "r_profile", "0", CVAR_TEMP );
+	r_profileFile = ri.Cvar_Get( "r_profileFile", "profile.json", CVAR_ARCHIVE );
 	r_verbose = ri.Cvar_Get( "r_verbose", "0", CVAR_CHEAT );
 	r_logFile = ri.Cvar_Get( "r_logFile", "0", CVAR_CHEAT );
 	r_debugSurface = ri.Cvar_Get ("r_debugSurface", "0", CVAR_CHEAT);
@@ -1281,6 +1303,7 @@ void R_Register( void )
 	ri.Cmd_AddCommand( "screenshot", R_ScreenShot_f );
 	ri.Cmd_AddCommand( "screenshotJPEG", R_ScreenShotJPEG_f );
 	ri.Cmd_AddCommand( "gfxinfo", GfxInfo_f );
+	ri.Cmd_AddCommand( "r_pngBench", R_PNGBench_f );
 	ri.Cmd_AddCommand( "minimize", GLimp_Minimize );
 	ri.Cmd_AddCommand( "gfxmeminfo", GfxMemInfo_f );
 	ri.Cmd_AddCommand( "exportCubemaps", R_ExportCubemaps_f );
@@ -1320,6 +1343,7 @@ void R_Init( void ) {
 	Com_Memset( &tr, 0, sizeof( tr ) );
 	Com_Memset( &backEnd, 0, sizeof( backEnd ) );
 	Com_Memset( &tess, 0, sizeof( tess ) );
+	tr.frontEnd.pc = &tr.pc;
 
 //	Swap_Init();
 
@@ -1421,6 +1445,7 @@ void RE_Shutdown( bool destroyWindow ) {
 	ri.Cmd_RemoveCommand("imagelist");
 	ri.Cmd_RemoveCommand("minimize");
 	ri.Cmd_RemoveCommand("modellist");
+	ri.Cmd_RemoveCommand("r_pngBench");
 	ri.Cmd_RemoveCommand("screenshot");
 	ri.Cmd_RemoveCommand("screenshotJPEG");
 	ri.Cmd_RemoveCommand("shaderlist");
@@ -1428,6 +1453,7 @@ void RE_Shutdown( bool destroyWindow ) {
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
+		R_ProfileShutdown();
 		R_ShutDownQueries();
 		if (glRefConfig.framebufferObject)
 			FBO_Shutdown();
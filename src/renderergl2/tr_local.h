@@ -28,6 +28,8 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 
 #include <stdbool.h>
 
+#include <atomic>
+
 #include "qcommon/cvar.h"
 #include "qcommon/q_shared.h"
 #include "qcommon/qfiles.h"
@@ -91,6 +93,8 @@ typedef struct {
 	vec3_t		ambientLight;	// color normalized to 0-255
 	int			ambientLightInt;	// 32 bit rgba packed
 	vec3_t		directedLight;
+
+	struct animSurface_s	*animSurfaces;	// vertexes animated by R_AnimateEntitySurfaces
 } trRefEntity_t;
 
 
@@ -547,16 +551,18 @@ enum
 	GENERICDEF_USE_VERTEX_ANIMATION = 0x0004,
 	GENERICDEF_USE_FOG              = 0x0008,
 	GENERICDEF_USE_RGBAGEN          = 0x0010,
-	GENERICDEF_ALL                  = 0x001F,
-	GENERICDEF_COUNT                = 0x0020,
+	GENERICDEF_USE_BONE_ANIMATION   = 0x0020,
+	GENERICDEF_ALL                  = 0x003F,
+	GENERICDEF_COUNT                = 0x0040,
 };
 
 enum
 {
 	FOGDEF_USE_DEFORM_VERTEXES  = 0x0001,
 	FOGDEF_USE_VERTEX_ANIMATION = 0x0002,
-	FOGDEF_ALL                  = 0x0003,
-	FOGDEF_COUNT                = 0x0004,
+	FOGDEF_USE_BONE_ANIMATION   = 0x0004,
+	FOGDEF_ALL                  = 0x0007,
+	FOGDEF_COUNT                = 0x0008,
 };
 
 enum
@@ -572,12 +578,22 @@ enum
 	LIGHTDEF_USE_LIGHT_VECTOR    = 0x0002,
 	LIGHTDEF_USE_LIGHT_VERTEX    = 0x0003,
 	LIGHTDEF_LIGHTTYPE_MASK      = 0x0003,
-	LIGHTDEF_ENTITY              = 0x0004,
-	LIGHTDEF_USE_TCGEN_AND_TCMOD = 0x0008,
-	LIGHTDEF_USE_PARALLAXMAP     = 0x0010,
-	LIGHTDEF_USE_SHADOWMAP       = 0x0020,
-	LIGHTDEF_ALL                 = 0x003F,
-	LIGHTDEF_COUNT               = 0x0040
+	LIGHTDEF_ENTITY_VERTEX_ANIMATION = 0x0004,
+	LIGHTDEF_ENTITY_BONE_ANIMATION   = 0x0008,
+	LIGHTDEF_ENTITY_MASK         = 0x000C,
+	LIGHTDEF_USE_TCGEN_AND_TCMOD = 0x0010,
+	LIGHTDEF_USE_PARALLAXMAP     = 0x0020,
+	LIGHTDEF_USE_SHADOWMAP       = 0x0040,
+	LIGHTDEF_ALL                 = 0x007F,
+	LIGHTDEF_COUNT               = 0x0080
+};
+
+enum
+{
+	SHADOWMAPDEF_USE_VERTEX_ANIMATION = 0x0001,
+	SHADOWMAPDEF_USE_BONE_ANIMATION   = 0x0002,
+	SHADOWMAPDEF_ALL                  = 0x0003,
+	SHADOWMAPDEF_COUNT                = 0x0004
 };
 
 enum
@@ -588,7 +604,8 @@ enum
 	GLSL_VEC2,
 	GLSL_VEC3,
 	GLSL_VEC4,
-	GLSL_MAT16
+	GLSL_MAT16,
+	GLSL_MAT16_BONEMATRIX
 };
 
 typedef enum
@@ -656,6 +673,7 @@ typedef enum
 
 	UNIFORM_TIME,
 	UNIFORM_VERTEXLERP,
+	UNIFORM_BONEMATRIX,
 	UNIFORM_NORMALSCALE,
 	UNIFORM_SPECULARSCALE,
 
@@ -842,6 +860,7 @@ typedef enum {
 	SF_FLARE,
 	SF_ENTITY,				// beams, rails, lightning, etc that can be determined by entity
 	SF_VAO_MDVMESH,
+	SF_VAO_IQM,
 
 	SF_NUM_SURFACE_TYPES,
 	SF_MAX = 0x7fffffff			// ensures that sizeof( surfaceType_t ) == sizeof( int )
@@ -916,6 +935,10 @@ typedef struct srfBspSurface_s
 	int             numVerts;
 	srfVert_t      *verts;
 
+	// static world vao, if the surface was packed into one
+	vao_t          *vao;
+	int             firstIndex;
+
 	// SF_GRID specific variables after here
 
 	// lod information, which may be different
@@ -964,6 +987,10 @@ typedef struct {
 	float		*poseMats;
 	float		*bounds;
 	char		*names;
+
+	// static render data for skinning in the vertex shader, NULL if
+	// the model has too many joints or GPU skinning is off
+	struct srfVaoIQModel_s	*vaoSurfaces;
 } iqmData_t;
 
 // inter-quake-model surface
@@ -976,6 +1003,22 @@ typedef struct srfIQModel_s {
 	int		first_triangle, num_triangles;
 } srfIQModel_t;
 
+// inter-quake-model surface skinned in the vertex shader
+typedef struct srfVaoIQModel_s
+{
+	surfaceType_t   surfaceType;
+
+	iqmData_t      *iqmData;
+	srfIQModel_t   *iqmSurface;
+
+	// backEnd stats
+	int             numIndexes;
+	int             numVerts;
+
+	// static render data
+	vao_t          *vao;
+} srfVaoIQModel_t;
+
 typedef struct srfVaoMdvMesh_s
 {
 	surfaceType_t   surfaceType;
@@ -1067,7 +1110,6 @@ typedef struct msurface_s {
 typedef struct mnode_s {
 	// common with leaf and node
 	int			contents;		// -1 for nodes, to differentiate from leafs
-	int             visCounts[MAX_VISCOUNTS];	// node needs to be traversed if current
 	vec3_t		mins, maxs;		// for bounding box culling
 	struct mnode_s	*parent;
 
@@ -1083,6 +1125,21 @@ typedef struct mnode_s {
 	int			nummarksurfaces;
 } mnode_t;
 
+typedef struct {
+	mnode_t		*node;
+	uint32_t	dlightBits;
+	uint32_t	pshadowBits;
+} worldLeaf_t;
+
+// the leafs of one cluster in one area, which are visible or not together
+typedef struct {
+	int			cluster;		// -1 for leafs outside of any cluster
+	int			area;
+	int			firstLeaf;		// in sortedLeafs and leafMins / leafMaxs
+	int			numLeafs;
+	vec3_t		bounds[2];
+} leafGroup_t;
+
 typedef struct {
 	vec3_t		bounds[2];		// for culling
 	int	        firstSurface;
@@ -1136,6 +1193,23 @@ typedef struct {
 
 	char		*entityString;
 	char		*entityParsePoint;
+
+	// leafs sorted by cluster and area, with their bounds split by axis
+	// so R_AddWorldSurfaces can test four of them against a plane at once
+	int			numLeafGroups;
+	leafGroup_t	*leafGroups;
+	int			*clusterLeafGroups;	// first group of each cluster, numClusters + 1
+	mnode_t		**sortedLeafs;
+	float		*leafMins[3];
+	float		*leafMaxs[3];
+
+	// the groups in the PVS of tr.visClusters
+	int			*visLeafGroups[MAX_VISCOUNTS];
+	int			numVisLeafGroups[MAX_VISCOUNTS];
+
+	// scratch space for R_AddWorldSurfaces on the job threads
+	worldLeaf_t	*jobLeafs;			// numnodes - numDecisionNodes
+	drawSurf_t	*jobDrawSurfs;		// numsurfaces
 } world_t;
 
 
@@ -1301,10 +1375,36 @@ typedef struct {
 	int		c_box_cull_md3_in, c_box_cull_md3_clip, c_box_cull_md3_out;
 
 	int		c_leafs;
+	int		c_leafGroupsTested, c_leafsTested;
+	int		c_worldSurfacesTested, c_worldSurfaces;
 	int		c_dlightSurfaces;
 	int		c_dlightSurfacesCulled;
 } frontEndCounters_t;
 
+/*
+** frontEndState_t
+**
+** The view and the entity the front end is adding surfaces for.  fe
+** points at tr.frontEnd on every thread, except inside the entity and
+** pshadow jobs, which each add their surfaces with a copy of their own.
+*/
+typedef struct {
+	viewParms_t				viewParms;
+	orientationr_t			orientation;		// for current entity
+
+	trRefEntity_t			*currentEntity;
+	int						currentEntityNum;
+	int						shiftedEntityNum;	// currentEntityNum << QSORT_REFENTITYNUM_SHIFT
+	model_t					*currentModel;
+
+	frontEndCounters_t		*pc;				// tr.pc, or the counters of the job
+
+	drawSurf_t				*drawSurfs;			// NULL to add to tr.refdef.drawSurfs
+	int						numDrawSurfs;
+	int						maxDrawSurfs;
+	bool					failed;				// the calling thread has to add the entity
+} frontEndState_t;
+
 #define	FOG_TABLE_SIZE		256
 #define FUNCTABLE_SIZE		1024
 #define FUNCTABLE_SIZE2		10
@@ -1321,6 +1421,8 @@ typedef struct {
 	uint32_t    storedGlState;
 	float           vertexAttribsInterpolation;
 	bool        vertexAnimation;
+	int             boneAnimation;	// number of bones in boneMatrix, 0 if not skinning
+	mat4_t          boneMatrix[IQM_MAX_JOINTS];
 	uint32_t        vertexAttribsEnabled;  // global if no VAOs, tess only otherwise
 	FBO_t          *currentFBO;
 	vao_t          *currentVao;
@@ -1372,6 +1474,10 @@ typedef struct {
 
 	bool vertexArrayObject;
 	bool directStateAccess;
+
+	int glslMaxAnimatedBones;	// 0 if IQM models are skinned on the CPU
+
+	bool timerQuery;
 } glRefConfig_t;
 
 
@@ -1387,6 +1493,14 @@ typedef struct {
 	int     c_staticVaoDraws;
 	int     c_dynamicVaoDraws;
 
+	int     c_drawCalls;
+	int     c_stateChanges;
+	int     c_multidraws;
+	int     c_multidrawsMerged;
+	int     c_textureBinds;
+	int     c_vaoUploads;
+	int     c_vaoUploadBytes;
+
 	int		c_dlightVertexes;
 	int		c_dlightIndexes;
 
@@ -1438,7 +1552,6 @@ typedef struct {
 
 	int						visIndex;
 	int						visClusters[MAX_VISCOUNTS];
-	int						visCounts[MAX_VISCOUNTS];	// incremented every time a new vis cluster is entered
 
 	int						frameCount;		// incremented every frame
 	int						sceneCount;		// incremented every scene
@@ -1519,11 +1632,7 @@ typedef struct {
 	int                     numCubemaps;
 	cubemap_t               *cubemaps;
 
-	trRefEntity_t			*currentEntity;
 	trRefEntity_t			worldEntity;		// point currentEntity at this when rendering world
-	int						currentEntityNum;
-	int						shiftedEntityNum;	// currentEntityNum << QSORT_REFENTITYNUM_SHIFT
-	model_t					*currentModel;
 
 	//
 	// GPU shader programs
@@ -1533,7 +1642,7 @@ typedef struct {
 	shaderProgram_t fogShader[FOGDEF_COUNT];
 	shaderProgram_t dlightShader[DLIGHTDEF_COUNT];
 	shaderProgram_t lightallShader[LIGHTDEF_COUNT];
-	shaderProgram_t shadowmapShader;
+	shaderProgram_t shadowmapShader[SHADOWMAPDEF_COUNT];
 	shaderProgram_t pshadowShader;
 	shaderProgram_t down4xShader;
 	shaderProgram_t bokehShader;
@@ -1547,14 +1656,12 @@ typedef struct {
 
 	// -----------------------------------------
 
-	viewParms_t				viewParms;
+	frontEndState_t			frontEnd;			// use fe, not this
 
 	float					identityLight;		// 1.0 / ( 1 << overbrightBits )
 	int						identityLightByte;	// identityLight * 255
 	int						overbrightBits;		// r_overbrightBits->integer, but set to 0 if no hw gamma
 
-	orientationr_t			orientation;					// for current entity
-
 	trRefdef_t				refdef;
 
 	int						viewCluster;
@@ -1612,6 +1719,7 @@ typedef struct {
 
 extern backEndState_t	backEnd;
 extern trGlobals_t	tr;
+extern thread_local frontEndState_t	*fe;
 extern glstate_t	glState;		// outside of TR since it shouldn't be cleared during ref re-init
 extern glRefConfig_t glRefConfig;
 
@@ -1649,7 +1757,11 @@ extern cvar_t	*r_dlightBacks;			// dlight non-facing surfaces for continuity
 extern	cvar_t	*r_norefresh;			// bypasses the ref rendering
 extern	cvar_t	*r_drawentities;		// disable/enable entity rendering
 extern	cvar_t	*r_drawworld;			// disable/enable world rendering
+extern	cvar_t	*r_frontEndJobs;		// walk the world and add entities on the job threads
+extern	cvar_t	*r_worldCache;			// keep the loaded world surfaces on disk
 extern	cvar_t	*r_speeds;				// various levels of information display
+extern	cvar_t	*r_profile;				// capture frame timings and counters
+extern	cvar_t	*r_profileFile;			// trace written when the capture stops
 extern  cvar_t	*r_detailTextures;		// enables/disables detail texturing stages
 extern	cvar_t	*r_novis;				// disable/enable usage of PVS
 extern	cvar_t	*r_nocull;
@@ -1665,6 +1777,7 @@ extern  cvar_t  *r_ext_framebuffer_multisample;
 extern  cvar_t  *r_arb_seamless_cube_map;
 extern  cvar_t  *r_arb_vertex_array_object;
 extern  cvar_t  *r_ext_direct_state_access;
+extern  cvar_t  *r_gpuSkinning;					// skin iqm models in the vertex shader
 
 extern	cvar_t	*r_nobind;						// turns off binding to appropriate textures
 extern	cvar_t	*r_singleShader;				// make most world faces use default shader
@@ -1740,6 +1853,8 @@ extern  cvar_t  *r_glossType;
 extern  cvar_t  *r_dlightMode;
 extern  cvar_t  *r_pshadowDist;
 extern  cvar_t  *r_mergeLightmaps;
+extern  cvar_t  *r_worldVaos;
+extern  cvar_t  *r_mergeMultidraws;
 extern  cvar_t  *r_imageUpsample;
 extern  cvar_t  *r_imageUpsampleMaxSize;
 extern  cvar_t  *r_imageUpsampleType;
@@ -1800,6 +1915,10 @@ void R_DecomposeSort( unsigned sort, int *entityNum, shader_t **shader,
 
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader,
 				   int fogIndex, int dlightMap, int pshadowMap, int cubemap );
+void R_PackDrawSurf( drawSurf_t *drawSurf, surfaceType_t *surface, shader_t *shader,
+				   int fogIndex, int dlightMap, int pshadowMap, int cubemap );
+void R_AddDrawSurfs( const drawSurf_t *drawSurfs, int numDrawSurfs );
+bool R_EntityJobFailed( void );
 
 void R_CalcTexDirs(vec3_t sdir, vec3_t tdir, const vec3_t v1, const vec3_t v2,
 				   const vec3_t v3, const vec2_t w1, const vec2_t w2, const vec2_t w3);
@@ -1916,6 +2035,7 @@ shader_t	*R_FindShader( const char *name, int lightmapIndex, bool mipRawImage );
 shader_t	*R_GetShaderByHandle( qhandle_t hShader );
 shader_t	*R_GetShaderByState( int index, long *cycleTime );
 shader_t *R_FindShaderByName( const char *name );
+void		R_RequestShaderImages( const char *name, bool mipRawImage );
 void		R_InitShaders( void );
 void		R_ShaderList_f( void );
 void    R_RemapShader(const char *oldShader, const char *newShader, const char *timeOffset);
@@ -1944,6 +2064,8 @@ typedef struct stageVars
 	vec2_t		texcoords[NUM_TEXTURE_BUNDLES][SHADER_MAX_VERTEXES];
 } stageVars_t;
 
+#define MAX_MULTIDRAW_PRIMITIVES	16384
+
 typedef struct shaderCommands_s
 {
 	glIndex_t	indexes[SHADER_MAX_INDEXES] QALIGN(16);
@@ -1977,6 +2099,12 @@ typedef struct shaderCommands_s
 	int			numIndexes;
 	int			numVertexes;
 
+	// index ranges of a static vao, drawn with one glMultiDrawElements
+	int			multiDrawPrimitives;
+	GLsizei		multiDrawNumIndexes[MAX_MULTIDRAW_PRIMITIVES];
+	glIndex_t	*multiDrawFirstIndex[MAX_MULTIDRAW_PRIMITIVES];
+	glIndex_t	*multiDrawLastIndex[MAX_MULTIDRAW_PRIMITIVES];
+
 	// info extracted from current shader
 	int			numPasses;
 	void		(*currentStageIteratorFunc)( void );
@@ -1991,6 +2119,7 @@ void RB_CheckOverflow( int verts, int indexes );
 #define RB_CHECKOVERFLOW(v,i) if (tess.numVertexes + (v) >= SHADER_MAX_VERTEXES || tess.numIndexes + (i) >= SHADER_MAX_INDEXES ) {RB_CheckOverflow(v,i);}
 
 void R_DrawElements( int numIndexes, glIndex_t firstIndex );
+void R_DrawMultiElementsVao( int multiDrawPrimitives, GLsizei *multiDrawNumIndexes, glIndex_t **multiDrawFirstIndex );
 void RB_StageIteratorGeneric( void );
 void RB_StageIteratorSky( void );
 void RB_StageIteratorVertexLitTexture( void );
@@ -2158,6 +2287,7 @@ void GLSL_SetUniformVec2(shaderProgram_t *program, int uniformNum, const vec2_t
 void GLSL_SetUniformVec3(shaderProgram_t *program, int uniformNum, const vec3_t v);
 void GLSL_SetUniformVec4(shaderProgram_t *program, int uniformNum, const vec4_t v);
 void GLSL_SetUniformMat4(shaderProgram_t *program, int uniformNum, const mat4_t matrix);
+void GLSL_SetUniformMat4BoneMatrix(shaderProgram_t *program, int uniformNum, const mat4_t *matrix, int numMatricies);
 
 shaderProgram_t *GLSL_GetGenericShaderProgram(int stage);
 
@@ -2212,6 +2342,11 @@ void RB_MDRSurfaceAnim( mdrSurface_t *surface );
 bool R_LoadIQM (model_t *mod, void *buffer, int filesize, const char *name );
 void R_AddIQMSurfaces( trRefEntity_t *ent );
 void RB_IQMSurfaceAnim( surfaceType_t *surface );
+void RB_IQMSurfaceAnimVao( srfVaoIQModel_t *surface );
+void R_IQMTransformVertexes( const srfIQModel_t *surf, int frame, int oldframe, float backlerp,
+                             vec4_t *outXYZ, int16_t (*outNormal)[4], int16_t (*outTangent)[4] );
+void R_QueueSurfaceAnimation( trRefEntity_t *ent, surfaceType_t *surface, int numVertexes );
+void R_AnimateEntitySurfaces( int firstAnimSurface );
 int R_IQMLerpTag( orientation_t *tag, iqmData_t *data,
                   int startFrame, int endFrame,
                   float frac, const char *tagName );
@@ -2386,6 +2521,19 @@ typedef enum {
 #define	MAX_POLYS		600
 #define	MAX_POLYVERTS	3000
 
+// iqm surfaces skinned by the front end before the back end draws
+// them, anything over these is skinned by the back end as before
+#define	MAX_ANIMSURFACES	1024
+#define	MAX_ANIMVERTEXES	65536
+
+typedef struct animSurface_s {
+	surfaceType_t			*surface;
+	trRefEntity_t			*entity;
+	int						firstVertex;	// in backEndData->animXyz / animNormals / animTangents
+	int						numVertexes;
+	struct animSurface_s	*next;			// the next surface of the same entity
+} animSurface_t;
+
 // all of the information needed by the back end must be
 // contained in a backEndData_t
 typedef struct {
@@ -2395,12 +2543,21 @@ typedef struct {
 	srfPoly_t	*polys;//[MAX_POLYS];
 	polyVert_t	*polyVerts;//[MAX_POLYVERTS];
 	pshadow_t pshadows[MAX_CALC_PSHADOWS];
+	animSurface_t	animSurfaces[MAX_ANIMSURFACES];
+	vec4_t		animXyz[MAX_ANIMVERTEXES];
+	int16_t		animNormals[MAX_ANIMVERTEXES][4];
+	int16_t		animTangents[MAX_ANIMVERTEXES][4];
 	renderCommandList_t	commands;
 } backEndData_t;
 
 extern	int		max_polys;
 extern	int		max_polyverts;
 
+extern	std::atomic<int>	r_numAnimSurfaces;		// queued from the entity jobs too
+extern	std::atomic<int>	r_numAnimVertexes;
+
+const animSurface_t *R_FindSurfaceAnimation( const trRefEntity_t *ent, const surfaceType_t *surface );
+
 extern	backEndData_t	*backEndData;	// the second one may not be allocated
 
 
@@ -2427,5 +2584,38 @@ size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
 void RE_TakeVideoFrame( int width, int height,
 		byte *captureBuffer, byte *encodeBuffer, bool motionJpeg );
 
+/*
+============================================================
+
+PROFILE
+
+============================================================
+*/
+
+// the front end phases come first, back end phases are also
+// timed with GL timer queries
+typedef enum {
+	RP_RENDERVIEW,
+	RP_MARKLEAVES,
+	RP_ADDWORLD,
+	RP_ADDENTITIES,
+	RP_SORT,
+
+	RP_BACKEND,
+	RP_DRAWVIEW,
+	RP_SHADOWMAP,
+	RP_POSTPROCESS,
+	RP_SWAP,
+
+	RP_NUM_PHASES
+} profilePhase_t;
+
+void R_ProfileBeginFrame( void );
+void R_ProfileFrontEndCounters( void );
+void R_ProfileEndFrame( void );
+int R_ProfileBegin( profilePhase_t phase );
+void R_ProfileEnd( int spanNum );
+void R_ProfileShutdown( void );
+
 
 #endif //TR_LOCAL_H
@@ -28,6 +28,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include <string.h> // memcpy
 
 trGlobals_t		tr;
+thread_local frontEndState_t	*fe = &tr.frontEnd;
 
 static float	s_flipMatrix[16] = {
 	// convert from our coordinate system (looking down X)
@@ -215,16 +216,16 @@ int R_CullLocalBox(vec3_t localBounds[2]) {
 		v[1] = bounds[(i>>1)&1][1];
 		v[2] = bounds[(i>>2)&1][2];
 
-		VectorCopy( tr.orientation.origin, transformed[i] );
-		VectorMA( transformed[i], v[0], tr.orientation.axis[0], transformed[i] );
-		VectorMA( transformed[i], v[1], tr.orientation.axis[1], transformed[i] );
-		VectorMA( transformed[i], v[2], tr.orientation.axis[2], transformed[i] );
+		VectorCopy( fe->orientation.origin, transformed[i] );
+		VectorMA( transformed[i], v[0], fe->orientation.axis[0], transformed[i] );
+		VectorMA( transformed[i], v[1], fe->orientation.axis[1], transformed[i] );
+		VectorMA( transformed[i], v[2], fe->orientation.axis[2], transformed[i] );
 	}
 
 	// check against frustum planes
 	anyBack = 0;
 	for (i = 0 ; i < 4 ; i++) {
-		frust = &tr.viewParms.frustum[i];
+		frust = &fe->viewParms.frustum[i];
 
 		front = back = 0;
 		for (j = 0 ; j < 8 ; j++) {
@@ -292,13 +293,13 @@ int R_CullBox(vec3_t worldBounds[2]) {
 	bool        anyClip;
 	int             r, numPlanes;
 
-	numPlanes = (tr.viewParms.flags & VPF_FARPLANEFRUSTUM) ? 5 : 4;
+	numPlanes = (fe->viewParms.flags & VPF_FARPLANEFRUSTUM) ? 5 : 4;
 
 	// check against frustum planes
 	anyClip = false;
 	for(i = 0; i < numPlanes; i++)
 	{
-		frust = &tr.viewParms.frustum[i];
+		frust = &fe->viewParms.frustum[i];
 
 		r = BoxOnPlaneSide(worldBounds[0], worldBounds[1], frust);
 
@@ -378,7 +379,7 @@ int R_CullPointAndRadiusEx( const vec3_t pt, float radius, const cplane_t* frust
 */
 int R_CullPointAndRadius( const vec3_t pt, float radius )
 {
-	return R_CullPointAndRadiusEx(pt, radius, tr.viewParms.frustum, (tr.viewParms.flags & VPF_FARPLANEFRUSTUM) ? 5 : 4);
+	return R_CullPointAndRadiusEx(pt, radius, fe->viewParms.frustum, (fe->viewParms.flags & VPF_FARPLANEFRUSTUM) ? 5 : 4);
 }
 
 /*
@@ -388,9 +389,9 @@ R_LocalNormalToWorld
 =================
 */
 void R_LocalNormalToWorld (const vec3_t local, vec3_t world) {
-	world[0] = local[0] * tr.orientation.axis[0][0] + local[1] * tr.orientation.axis[1][0] + local[2] * tr.orientation.axis[2][0];
-	world[1] = local[0] * tr.orientation.axis[0][1] + local[1] * tr.orientation.axis[1][1] + local[2] * tr.orientation.axis[2][1];
-	world[2] = local[0] * tr.orientation.axis[0][2] + local[1] * tr.orientation.axis[1][2] + local[2] * tr.orientation.axis[2][2];
+	world[0] = local[0] * fe->orientation.axis[0][0] + local[1] * fe->orientation.axis[1][0] + local[2] * fe->orientation.axis[2][0];
+	world[1] = local[0] * fe->orientation.axis[0][1] + local[1] * fe->orientation.axis[1][1] + local[2] * fe->orientation.axis[2][1];
+	world[2] = local[0] * fe->orientation.axis[0][2] + local[1] * fe->orientation.axis[1][2] + local[2] * fe->orientation.axis[2][2];
 }
 
 /*
@@ -400,9 +401,9 @@ R_LocalPointToWorld
 =================
 */
 void R_LocalPointToWorld (const vec3_t local, vec3_t world) {
-	world[0] = local[0] * tr.orientation.axis[0][0] + local[1] * tr.orientation.axis[1][0] + local[2] * tr.orientation.axis[2][0] + tr.orientation.origin[0];
-	world[1] = local[0] * tr.orientation.axis[0][1] + local[1] * tr.orientation.axis[1][1] + local[2] * tr.orientation.axis[2][1] + tr.orientation.origin[1];
-	world[2] = local[0] * tr.orientation.axis[0][2] + local[1] * tr.orientation.axis[1][2] + local[2] * tr.orientation.axis[2][2] + tr.orientation.origin[2];
+	world[0] = local[0] * fe->orientation.axis[0][0] + local[1] * fe->orientation.axis[1][0] + local[2] * fe->orientation.axis[2][0] + fe->orientation.origin[0];
+	world[1] = local[0] * fe->orientation.axis[0][1] + local[1] * fe->orientation.axis[1][1] + local[2] * fe->orientation.axis[2][1] + fe->orientation.origin[1];
+	world[2] = local[0] * fe->orientation.axis[0][2] + local[1] * fe->orientation.axis[1][2] + local[2] * fe->orientation.axis[2][2] + fe->orientation.origin[2];
 }
 
 /*
@@ -412,9 +413,9 @@ R_WorldToLocal
 =================
 */
 void R_WorldToLocal (const vec3_t world, vec3_t local) {
-	local[0] = DotProduct(world, tr.orientation.axis[0]);
-	local[1] = DotProduct(world, tr.orientation.axis[1]);
-	local[2] = DotProduct(world, tr.orientation.axis[2]);
+	local[0] = DotProduct(world, fe->orientation.axis[0]);
+	local[1] = DotProduct(world, fe->orientation.axis[1]);
+	local[2] = DotProduct(world, fe->orientation.axis[2]);
 }
 
 /*
@@ -566,28 +567,28 @@ void R_RotateForViewer (void)
 	float	viewerMatrix[16];
 	vec3_t	origin;
 
-	Com_Memset (&tr.orientation, 0, sizeof(tr.orientation));
-	tr.orientation.axis[0][0] = 1;
-	tr.orientation.axis[1][1] = 1;
-	tr.orientation.axis[2][2] = 1;
-	VectorCopy (tr.viewParms.orientation.origin, tr.orientation.viewOrigin);
+	Com_Memset (&fe->orientation, 0, sizeof(fe->orientation));
+	fe->orientation.axis[0][0] = 1;
+	fe->orientation.axis[1][1] = 1;
+	fe->orientation.axis[2][2] = 1;
+	VectorCopy (fe->viewParms.orientation.origin, fe->orientation.viewOrigin);
 
 	// transform by the camera placement
-	VectorCopy( tr.viewParms.orientation.origin, origin );
+	VectorCopy( fe->viewParms.orientation.origin, origin );
 
-	viewerMatrix[0] = tr.viewParms.orientation.axis[0][0];
-	viewerMatrix[4] = tr.viewParms.orientation.axis[0][1];
-	viewerMatrix[8] = tr.viewParms.orientation.axis[0][2];
+	viewerMatrix[0] = fe->viewParms.orientation.axis[0][0];
+	viewerMatrix[4] = fe->viewParms.orientation.axis[0][1];
+	viewerMatrix[8] = fe->viewParms.orientation.axis[0][2];
 	viewerMatrix[12] = -origin[0] * viewerMatrix[0] + -origin[1] * viewerMatrix[4] + -origin[2] * viewerMatrix[8];
 
-	viewerMatrix[1] = tr.viewParms.orientation.axis[1][0];
-	viewerMatrix[5] = tr.viewParms.orientation.axis[1][1];
-	viewerMatrix[9] = tr.viewParms.orientation.axis[1][2];
+	viewerMatrix[1] = fe->viewParms.orientation.axis[1][0];
+	viewerMatrix[5] = fe->viewParms.orientation.axis[1][1];
+	viewerMatrix[9] = fe->viewParms.orientation.axis[1][2];
 	viewerMatrix[13] = -origin[0] * viewerMatrix[1] + -origin[1] * viewerMatrix[5] + -origin[2] * viewerMatrix[9];
 
-	viewerMatrix[2] = tr.viewParms.orientation.axis[2][0];
-	viewerMatrix[6] = tr.viewParms.orientation.axis[2][1];
-	viewerMatrix[10] = tr.viewParms.orientation.axis[2][2];
+	viewerMatrix[2] = fe->viewParms.orientation.axis[2][0];
+	viewerMatrix[6] = fe->viewParms.orientation.axis[2][1];
+	viewerMatrix[10] = fe->viewParms.orientation.axis[2][2];
 	viewerMatrix[14] = -origin[0] * viewerMatrix[2] + -origin[1] * viewerMatrix[6] + -origin[2] * viewerMatrix[10];
 
 	viewerMatrix[3] = 0;
@@ -597,9 +598,9 @@ void R_RotateForViewer (void)
 
 	// convert from our coordinate system (looking down X)
 	// to OpenGL's coordinate system (looking down -Z)
-	myGlMultMatrix( viewerMatrix, s_flipMatrix, tr.orientation.modelMatrix );
+	myGlMultMatrix( viewerMatrix, s_flipMatrix, fe->orientation.modelMatrix );
 
-	tr.viewParms.world = tr.orientation;
+	fe->viewParms.world = fe->orientation;
 
 }
 
@@ -614,7 +615,7 @@ static void R_SetFarClip( void )
 	// if not rendering the world (icons, menus, etc)
 	// set a 2k far clip plane
 	if ( tr.refdef.rdflags & RDF_NOWORLDMODEL ) {
-		tr.viewParms.zFar = 2048;
+		fe->viewParms.zFar = 2048;
 		return;
 	}
 
@@ -630,32 +631,32 @@ static void R_SetFarClip( void )
 
 		if ( i & 1 )
 		{
-			v[0] = tr.viewParms.visBounds[0][0];
+			v[0] = fe->viewParms.visBounds[0][0];
 		}
 		else
 		{
-			v[0] = tr.viewParms.visBounds[1][0];
+			v[0] = fe->viewParms.visBounds[1][0];
 		}
 
 		if ( i & 2 )
 		{
-			v[1] = tr.viewParms.visBounds[0][1];
+			v[1] = fe->viewParms.visBounds[0][1];
 		}
 		else
 		{
-			v[1] = tr.viewParms.visBounds[1][1];
+			v[1] = fe->viewParms.visBounds[1][1];
 		}
 
 		if ( i & 4 )
 		{
-			v[2] = tr.viewParms.visBounds[0][2];
+			v[2] = fe->viewParms.visBounds[0][2];
 		}
 		else
 		{
-			v[2] = tr.viewParms.visBounds[1][2];
+			v[2] = fe->viewParms.visBounds[1][2];
 		}
 
-		VectorSubtract( v, tr.viewParms.orientation.origin, vecTo );
+		VectorSubtract( v, fe->viewParms.orientation.origin, vecTo );
 
 		distance = vecTo[0] * vecTo[0] + vecTo[1] * vecTo[1] + vecTo[2] * vecTo[2];
 
@@ -664,7 +665,7 @@ static void R_SetFarClip( void )
 			farthestCornerDistance = distance;
 		}
 	}
-	tr.viewParms.zFar = sqrt( farthestCornerDistance );
+	fe->viewParms.zFar = sqrt( farthestCornerDistance );
 }
 
 /*
@@ -861,7 +862,7 @@ R_SetupProjectionOrtho
 void R_SetupProjectionOrtho(viewParms_t *dest, vec3_t viewBounds[2])
 {
 	float xmin, xmax, ymin, ymax, znear, zfar;
-	//viewParms_t *dest = &tr.viewParms;
+	//viewParms_t *dest = &fe->viewParms;
 	int i;
 	vec3_t pop;
 
@@ -1028,19 +1029,19 @@ bool R_GetPortalOrientations( drawSurf_t *drawSurf, int entityNum,
 
 	// rotate the plane if necessary
 	if ( entityNum != REFENTITYNUM_WORLD ) {
-		tr.currentEntityNum = entityNum;
-		tr.currentEntity = &tr.refdef.entities[entityNum];
+		fe->currentEntityNum = entityNum;
+		fe->currentEntity = &tr.refdef.entities[entityNum];
 
 		// get the orientation of the entity
-		R_RotateForEntity( tr.currentEntity, &tr.viewParms, &tr.orientation );
+		R_RotateForEntity( fe->currentEntity, &fe->viewParms, &fe->orientation );
 
 		// rotate the plane, but keep the non-rotated version for matching
 		// against the portalSurface entities
 		R_LocalNormalToWorld( originalPlane.normal, plane.normal );
-		plane.dist = originalPlane.dist + DotProduct( plane.normal, tr.orientation.origin );
+		plane.dist = originalPlane.dist + DotProduct( plane.normal, fe->orientation.origin );
 
 		// translate the original plane
-		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, tr.orientation.origin );
+		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, fe->orientation.origin );
 	} else {
 		plane = originalPlane;
 	}
@@ -1146,19 +1147,19 @@ static bool IsMirror( const drawSurf_t *drawSurf, int entityNum )
 	// rotate the plane if necessary
 	if ( entityNum != REFENTITYNUM_WORLD ) 
 	{
-		tr.currentEntityNum = entityNum;
-		tr.currentEntity = &tr.refdef.entities[entityNum];
+		fe->currentEntityNum = entityNum;
+		fe->currentEntity = &tr.refdef.entities[entityNum];
 
 		// get the orientation of the entity
-		R_RotateForEntity( tr.currentEntity, &tr.viewParms, &tr.orientation );
+		R_RotateForEntity( fe->currentEntity, &fe->viewParms, &fe->orientation );
 
 		// rotate the plane, but keep the non-rotated version for matching
 		// against the portalSurface entities
 		R_LocalNormalToWorld( originalPlane.normal, plane.normal );
-		plane.dist = originalPlane.dist + DotProduct( plane.normal, tr.orientation.origin );
+		plane.dist = originalPlane.dist + DotProduct( plane.normal, fe->orientation.origin );
 
 		// translate the original plane
-		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, tr.orientation.origin );
+		originalPlane.dist = originalPlane.dist + DotProduct( originalPlane.normal, fe->orientation.origin );
 	} 
 
 	// locate the portal entity closest to this plane.
@@ -1220,7 +1221,7 @@ static bool SurfIsOffscreen( const drawSurf_t *drawSurf, vec4_t clipDest[128] )
 		int j;
 		unsigned int pointFlags = 0;
 
-		R_TransformModelToClip( tess.xyz[i], tr.orientation.modelMatrix, tr.viewParms.projectionMatrix, eye, clip );
+		R_TransformModelToClip( tess.xyz[i], fe->orientation.modelMatrix, fe->viewParms.projectionMatrix, eye, clip );
 
 		for ( j = 0; j < 3; j++ )
 		{
@@ -1256,7 +1257,7 @@ static bool SurfIsOffscreen( const drawSurf_t *drawSurf, vec4_t clipDest[128] )
 
 		float len;
 
-		VectorSubtract( tess.xyz[tess.indexes[i]], tr.viewParms.orientation.origin, normal );
+		VectorSubtract( tess.xyz[tess.indexes[i]], fe->viewParms.orientation.origin, normal );
 
 		len = VectorLengthSquared( normal );			// lose the sqrt
 		if ( len < shortest )
@@ -1305,7 +1306,7 @@ bool R_MirrorViewBySurface (drawSurf_t *drawSurf, int entityNum) {
 	orientation_t	surface, camera;
 
 	// don't recursively mirror
-	if (tr.viewParms.isPortal) {
+	if (fe->viewParms.isPortal) {
 		ri.Printf( PRINT_DEVELOPER, "WARNING: recursive mirror/portal found\n" );
 		return false;
 	}
@@ -1320,9 +1321,9 @@ bool R_MirrorViewBySurface (drawSurf_t *drawSurf, int entityNum) {
 	}
 
 	// save old viewParms so we can return to it after the mirror view
-	oldParms = tr.viewParms;
+	oldParms = fe->viewParms;
 
-	newParms = tr.viewParms;
+	newParms = fe->viewParms;
 	newParms.isPortal = true;
 	newParms.zFar = 0.0f;
 	newParms.flags &= ~VPF_FARPLANEFRUSTUM;
@@ -1348,7 +1349,7 @@ bool R_MirrorViewBySurface (drawSurf_t *drawSurf, int entityNum) {
 	// render the mirror view
 	R_RenderView (&newParms);
 
-	tr.viewParms = oldParms;
+	fe->viewParms = oldParms;
 
 	return true;
 }
@@ -1451,6 +1452,43 @@ static void R_RadixSort( drawSurf_t *source, int size )
 
 //==========================================================================================
 
+/*
+=================
+R_PackDrawSurf
+
+Fills in a draw surface for the current entity without adding it
+to the refdef, so jobs can build their own lists
+=================
+*/
+void R_PackDrawSurf( drawSurf_t *drawSurf, surfaceType_t *surface, shader_t *shader, 
+				   int fogIndex, int dlightMap, int pshadowMap, int cubemap ) {
+	// the sort data is packed into a single 32 bit value so it can be
+	// compared quickly during the qsorting process
+	drawSurf->sort = (shader->sortedIndex << QSORT_SHADERNUM_SHIFT) 
+		| fe->shiftedEntityNum | ( fogIndex << QSORT_FOGNUM_SHIFT ) 
+		| ((int)pshadowMap << QSORT_PSHADOW_SHIFT) | (int)dlightMap;
+	drawSurf->cubemapIndex = cubemap;
+	drawSurf->surface = surface;
+}
+
+/*
+=================
+R_EntityJobFailed
+
+Entity jobs can't print, drop or touch the world surfaces, so they
+give up on the entity instead and the calling thread adds it again.
+Returns false outside of the jobs.
+=================
+*/
+bool R_EntityJobFailed( void ) {
+	if ( fe == &tr.frontEnd ) {
+		return false;
+	}
+
+	fe->failed = true;
+	return true;
+}
+
 /*
 =================
 R_AddDrawSurf
@@ -1460,19 +1498,38 @@ void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader,
 				   int fogIndex, int dlightMap, int pshadowMap, int cubemap ) {
 	int			index;
 
+	if ( fe->drawSurfs ) {
+		if ( fe->numDrawSurfs >= fe->maxDrawSurfs ) {
+			R_EntityJobFailed();
+			return;
+		}
+		R_PackDrawSurf( &fe->drawSurfs[fe->numDrawSurfs++], surface, shader, fogIndex, dlightMap, pshadowMap, cubemap );
+		return;
+	}
+
 	// instead of checking for overflow, we just mask the index
 	// so it wraps around
 	index = tr.refdef.numDrawSurfs & DRAWSURF_MASK;
-	// the sort data is packed into a single 32 bit value so it can be
-	// compared quickly during the qsorting process
-	tr.refdef.drawSurfs[index].sort = (shader->sortedIndex << QSORT_SHADERNUM_SHIFT) 
-		| tr.shiftedEntityNum | ( fogIndex << QSORT_FOGNUM_SHIFT ) 
-		| ((int)pshadowMap << QSORT_PSHADOW_SHIFT) | (int)dlightMap;
-	tr.refdef.drawSurfs[index].cubemapIndex = cubemap;
-	tr.refdef.drawSurfs[index].surface = surface;
+	R_PackDrawSurf( &tr.refdef.drawSurfs[index], surface, shader, fogIndex, dlightMap, pshadowMap, cubemap );
 	tr.refdef.numDrawSurfs++;
 }
 
+/*
+=================
+R_AddDrawSurfs
+
+Appends surfaces filled in by R_PackDrawSurf
+=================
+*/
+void R_AddDrawSurfs( const drawSurf_t *drawSurfs, int numDrawSurfs ) {
+	int			i;
+
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		tr.refdef.drawSurfs[tr.refdef.numDrawSurfs & DRAWSURF_MASK] = drawSurfs[i];
+		tr.refdef.numDrawSurfs++;
+	}
+}
+
 /*
 =================
 R_DecomposeSort
@@ -1513,7 +1570,7 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	R_RadixSort( drawSurfs, numDrawSurfs );
 
 	// skip pass through drawing if rendering a shadow map
-	if (tr.viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW))
+	if (fe->viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW))
 	{
 		R_AddDrawSurfCmd( drawSurfs, numDrawSurfs );
 		return;
@@ -1546,26 +1603,48 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	R_AddDrawSurfCmd( drawSurfs, numDrawSurfs );
 }
 
+extern	cvar_t	*r_debugLight;
+
+#define	MIN_ENTITY_JOB_ENTITIES		32
+// fewer entities than this are added on the calling thread
+
+#define	ENTITY_JOB_SIZE				16
+#define	MAX_ENTITY_JOBS				( ( MAX_REFENTITIES + ENTITY_JOB_SIZE - 1 ) / ENTITY_JOB_SIZE )
+#define	MAX_ENTITY_JOB_DRAWSURFS	1024
+
+// a range of entities, or the entities of a pshadow
+typedef struct {
+	frontEndState_t		state;
+	frontEndCounters_t	pc;
+
+	int					firstEntity;
+	int					failedEntities[ENTITY_JOB_SIZE];
+	int					numFailedEntities;
+} entityJob_t;
+
+static entityJob_t	entityJobs[MAX_ENTITY_JOBS];
+static drawSurf_t	entityJobDrawSurfs[MAX_ENTITY_JOBS][MAX_ENTITY_JOB_DRAWSURFS];
+
 static void R_AddEntitySurface (int entityNum)
 {
 	trRefEntity_t	*ent;
 	shader_t		*shader;
 
-	tr.currentEntityNum = entityNum;
+	fe->currentEntityNum = entityNum;
 
-	ent = tr.currentEntity = &tr.refdef.entities[tr.currentEntityNum];
+	ent = fe->currentEntity = &tr.refdef.entities[fe->currentEntityNum];
 
 	ent->needDlights = false;
 
 	// preshift the value we are going to OR into the drawsurf sort
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
+	fe->shiftedEntityNum = fe->currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
 
 	//
 	// the weapon model must be handled special --
 	// we don't want the hacked weapon position showing in 
 	// mirrors, because the true body position will already be drawn
 	//
-	if ( (ent->e.renderfx & RF_FIRST_PERSON) && (tr.viewParms.flags & VPF_NOVIEWMODEL)) {
+	if ( (ent->e.renderfx & RF_FIRST_PERSON) && (fe->viewParms.flags & VPF_NOVIEWMODEL)) {
 		return;
 	}
 
@@ -1581,7 +1660,7 @@ static void R_AddEntitySurface (int entityNum)
 		// self blood sprites, talk balloons, etc should not be drawn in the primary
 		// view.  We can't just do this check for all entities, because md3
 		// entities may still want to cast shadows from them
-		if ( (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal) {
+		if ( (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal) {
 			return;
 		}
 		shader = R_GetShaderByHandle( ent->e.customShader );
@@ -1590,13 +1669,13 @@ static void R_AddEntitySurface (int entityNum)
 
 	case RT_MODEL:
 		// we must set up parts of tr.or for model culling
-		R_RotateForEntity( ent, &tr.viewParms, &tr.orientation );
+		R_RotateForEntity( ent, &fe->viewParms, &fe->orientation );
 
-		tr.currentModel = R_GetModelByHandle( ent->e.hModel );
-		if (!tr.currentModel) {
+		fe->currentModel = R_GetModelByHandle( ent->e.hModel );
+		if (!fe->currentModel) {
 			R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0, 0, 0 /*cubeMap*/  );
 		} else {
-			switch ( tr.currentModel->type ) {
+			switch ( fe->currentModel->type ) {
 			case MOD_MESH:
 				R_AddMD3Surfaces( ent );
 				break;
@@ -1607,25 +1686,126 @@ static void R_AddEntitySurface (int entityNum)
 				R_AddIQMSurfaces( ent );
 				break;
 			case MOD_BRUSH:
+				// brush models mark the world surfaces they add
+				if ( R_EntityJobFailed() ) {
+					break;
+				}
 				R_AddBrushModelSurfaces( ent );
 				break;
 			case MOD_BAD:		// null model axis
-				if ( (ent->e.renderfx & RF_THIRD_PERSON) && !tr.viewParms.isPortal) {
+				if ( (ent->e.renderfx & RF_THIRD_PERSON) && !fe->viewParms.isPortal) {
 					break;
 				}
 				R_AddDrawSurf( &entitySurface, tr.defaultShader, 0, 0, 0, 0 );
 				break;
 			default:
+				if ( R_EntityJobFailed() ) {
+					break;
+				}
 				ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad modeltype" );
 				break;
 			}
 		}
 		break;
 	default:
+		if ( R_EntityJobFailed() ) {
+			break;
+		}
 		ri.Error( ERR_DROP, "R_AddEntitySurfaces: Bad reType" );
 	}
 }
 
+/*
+=================
+R_AddJobEntitySurface
+
+Adds an entity to the draw surfaces of the job.  If the job fails on
+it, the entity is left to the calling thread with nothing added.
+=================
+*/
+static void R_AddJobEntitySurface( entityJob_t *job, int entityNum ) {
+	trRefEntity_t			*ent = &tr.refdef.entities[entityNum];
+	struct animSurface_s	*animSurfaces = ent->animSurfaces;
+	int						numDrawSurfs = fe->numDrawSurfs;
+
+	fe->failed = false;
+	R_AddEntitySurface( entityNum );
+	if ( !fe->failed ) {
+		return;
+	}
+
+	fe->numDrawSurfs = numDrawSurfs;
+	ent->animSurfaces = animSurfaces;
+	job->failedEntities[job->numFailedEntities++] = entityNum;
+}
+
+/*
+=================
+R_BeginEntityJob
+
+Points fe at the state of the job, starting from the view of the
+calling thread
+=================
+*/
+static void R_BeginEntityJob( entityJob_t *job, int index ) {
+	job->state = tr.frontEnd;
+	job->state.pc = &job->pc;
+	job->state.drawSurfs = entityJobDrawSurfs[index];
+	job->state.numDrawSurfs = 0;
+	job->state.maxDrawSurfs = MAX_ENTITY_JOB_DRAWSURFS;
+	job->numFailedEntities = 0;
+	Com_Memset( &job->pc, 0, sizeof( job->pc ) );
+
+	fe = &job->state;
+}
+
+/*
+=================
+R_EndEntityJob
+
+Appends the draw surfaces of the job and adds the entities it failed
+on.  Surfaces of different entities never sort equal, so these can
+go after the rest.
+=================
+*/
+static void R_EndEntityJob( entityJob_t *job ) {
+	int		i;
+
+	R_AddDrawSurfs( job->state.drawSurfs, job->state.numDrawSurfs );
+
+	tr.pc.c_sphere_cull_md3_in += job->pc.c_sphere_cull_md3_in;
+	tr.pc.c_sphere_cull_md3_clip += job->pc.c_sphere_cull_md3_clip;
+	tr.pc.c_sphere_cull_md3_out += job->pc.c_sphere_cull_md3_out;
+	tr.pc.c_box_cull_md3_in += job->pc.c_box_cull_md3_in;
+	tr.pc.c_box_cull_md3_clip += job->pc.c_box_cull_md3_clip;
+	tr.pc.c_box_cull_md3_out += job->pc.c_box_cull_md3_out;
+
+	for ( i = 0 ; i < job->numFailedEntities ; i++ ) {
+		R_AddEntitySurface( job->failedEntities[i] );
+	}
+}
+
+/*
+=================
+R_AddEntitySurfacesJob
+=================
+*/
+static void R_AddEntitySurfacesJob( void *data, int index ) {
+	entityJob_t	*job = &entityJobs[index];
+	int			i;
+
+	R_BeginEntityJob( job, index );
+
+	for ( i = 0 ; i < ENTITY_JOB_SIZE ; i++ ) {
+		if ( job->firstEntity + i >= tr.refdef.num_entities ) {
+			break;
+		}
+		R_AddJobEntitySurface( job, job->firstEntity + i );
+	}
+
+	fe = &tr.frontEnd;
+}
+
 /*
 =============
 R_AddEntitySurfaces
@@ -1633,13 +1813,34 @@ R_AddEntitySurfaces
 */
 void R_AddEntitySurfaces (void) {
 	int i;
+	int firstAnimSurface;
+	int numJobs;
 
 	if ( !r_drawentities->integer ) {
 		return;
 	}
 
-	for ( i = 0; i < tr.refdef.num_entities; i++)
-		R_AddEntitySurface(i);
+	firstAnimSurface = r_numAnimSurfaces;
+
+	// r_debuglight prints from inside the lighting
+	if ( !r_frontEndJobs->integer || r_debugLight->integer
+		|| tr.refdef.num_entities < MIN_ENTITY_JOB_ENTITIES ) {
+		for ( i = 0; i < tr.refdef.num_entities; i++)
+			R_AddEntitySurface(i);
+	} else {
+		numJobs = ( tr.refdef.num_entities + ENTITY_JOB_SIZE - 1 ) / ENTITY_JOB_SIZE;
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			entityJobs[i].firstEntity = i * ENTITY_JOB_SIZE;
+		}
+
+		ri.ParallelFor( numJobs, R_AddEntitySurfacesJob, NULL );
+
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			R_EndEntityJob( &entityJobs[i] );
+		}
+	}
+
+	R_AnimateEntitySurfaces( firstAnimSurface );
 }
 
 
@@ -1649,7 +1850,11 @@ R_GenerateDrawSurfs
 ====================
 */
 void R_GenerateDrawSurfs( void ) {
+	int		span;
+
+	span = R_ProfileBegin( RP_ADDWORLD );
 	R_AddWorldSurfaces ();
+	R_ProfileEnd( span );
 
 	R_AddPolygonSurfaces();
 
@@ -1660,15 +1865,17 @@ void R_GenerateDrawSurfs( void ) {
 	// matrix for lod calculation
 
 	// dynamically compute far clip plane distance
-	if (!(tr.viewParms.flags & VPF_SHADOWMAP))
+	if (!(fe->viewParms.flags & VPF_SHADOWMAP))
 	{
 		R_SetFarClip();
 	}
 
 	// we know the size of the clipping volume. Now set the rest of the projection matrix.
-	R_SetupProjectionZ (&tr.viewParms);
+	R_SetupProjectionZ (&fe->viewParms);
 
+	span = R_ProfileBegin( RP_ADDENTITIES );
 	R_AddEntitySurfaces ();
+	R_ProfileEnd( span );
 }
 
 /*
@@ -1736,16 +1943,19 @@ or a mirror / remote location
 void R_RenderView (viewParms_t *parms) {
 	int		firstDrawSurf;
 	int		numDrawSurfs;
+	int		span, sortSpan;
 
 	if ( parms->viewportWidth <= 0 || parms->viewportHeight <= 0 ) {
 		return;
 	}
 
+	span = R_ProfileBegin( RP_RENDERVIEW );
+
 	tr.viewCount++;
 
-	tr.viewParms = *parms;
-	tr.viewParms.frameSceneNum = tr.frameSceneNum;
-	tr.viewParms.frameCount = tr.frameCount;
+	fe->viewParms = *parms;
+	fe->viewParms.frameSceneNum = tr.frameSceneNum;
+	fe->viewParms.frameCount = tr.frameCount;
 
 	firstDrawSurf = tr.refdef.numDrawSurfs;
 
@@ -1754,7 +1964,7 @@ void R_RenderView (viewParms_t *parms) {
 	// set viewParms.world
 	R_RotateForViewer ();
 
-	R_SetupProjection(&tr.viewParms, r_zproj->value, tr.viewParms.zFar, true);
+	R_SetupProjection(&fe->viewParms, r_zproj->value, fe->viewParms.zFar, true);
 
 	R_GenerateDrawSurfs();
 
@@ -1766,10 +1976,14 @@ void R_RenderView (viewParms_t *parms) {
 		numDrawSurfs = MAX_DRAWSURFS;
 	}
 
+	sortSpan = R_ProfileBegin( RP_SORT );
 	R_SortDrawSurfs( tr.refdef.drawSurfs + firstDrawSurf, numDrawSurfs - firstDrawSurf );
+	R_ProfileEnd( sortSpan );
 
 	// draw main system development information (surface outlines, etc)
 	R_DebugGraphics();
+
+	R_ProfileEnd( span );
 }
 
 
@@ -1852,10 +2066,170 @@ void R_RenderDlightCubemaps(const refdef_t *fd)
 }
 
 
+/*
+=================
+R_RenderPshadowJob
+
+Fills in the rest of a pshadow and adds the surfaces of its view to
+the draw surfaces of the job
+=================
+*/
+static void R_RenderPshadowJob( void *data, int index )
+{
+	entityJob_t *job = &entityJobs[index];
+	pshadow_t *shadow = &tr.refdef.pshadows[index];
+	viewParms_t shadowParms;
+	vec3_t up;
+	vec3_t ambientLight, directedLight, lightDir;
+	int j;
+
+	VectorSet(lightDir, 0.57735f, 0.57735f, 0.57735f);
+#if 1
+	R_LightForPoint(shadow->viewOrigin, ambientLight, directedLight, lightDir);
+
+	// sometimes there's no light
+	if (DotProduct(lightDir, lightDir) < 0.9f)
+		VectorSet(lightDir, 0.0f, 0.0f, 1.0f);
+#endif
+
+	if (shadow->viewRadius * 3.0f > shadow->lightRadius)
+	{
+		shadow->lightRadius = shadow->viewRadius * 3.0f;
+	}
+
+	VectorMA(shadow->viewOrigin, shadow->viewRadius, lightDir, shadow->lightOrigin);
+
+	// make up a projection, up doesn't matter
+	VectorScale(lightDir, -1.0f, shadow->lightViewAxis[0]);
+	VectorSet(up, 0, 0, -1);
+
+	if ( fabsf(DotProduct(up, shadow->lightViewAxis[0])) > 0.9f )
+	{
+		VectorSet(up, -1, 0, 0);
+	}
+
+	CrossProduct(shadow->lightViewAxis[0], up, shadow->lightViewAxis[1]);
+	VectorNormalize(shadow->lightViewAxis[1]);
+	CrossProduct(shadow->lightViewAxis[0], shadow->lightViewAxis[1], shadow->lightViewAxis[2]);
+
+	VectorCopy(shadow->lightViewAxis[0], shadow->cullPlane.normal);
+	shadow->cullPlane.dist = DotProduct(shadow->cullPlane.normal, shadow->lightOrigin);
+	shadow->cullPlane.type = PLANE_NON_AXIAL;
+	SetPlaneSignbits(&shadow->cullPlane);
+
+	Com_Memset( &shadowParms, 0, sizeof( shadowParms ) );
+
+	if (glRefConfig.framebufferObject)
+	{
+		shadowParms.viewportX = 0;
+		shadowParms.viewportY = 0;
+	}
+	else
+	{
+		shadowParms.viewportX = tr.refdef.x;
+		shadowParms.viewportY = glConfig.vidHeight - ( tr.refdef.y + PSHADOW_MAP_SIZE );
+	}
+	shadowParms.viewportWidth = PSHADOW_MAP_SIZE;
+	shadowParms.viewportHeight = PSHADOW_MAP_SIZE;
+	shadowParms.isPortal = false;
+	shadowParms.isMirror = false;
+
+	shadowParms.fovX = 90;
+	shadowParms.fovY = 90;
+
+	if (glRefConfig.framebufferObject)
+		shadowParms.targetFbo = tr.pshadowFbos[index];
+
+	shadowParms.flags = VPF_DEPTHSHADOW | VPF_NOVIEWMODEL;
+	shadowParms.zFar = shadow->lightRadius;
+
+	VectorCopy(shadow->lightOrigin, shadowParms.orientation.origin);
+	
+	VectorCopy(shadow->lightViewAxis[0], shadowParms.orientation.axis[0]);
+	VectorCopy(shadow->lightViewAxis[1], shadowParms.orientation.axis[1]);
+	VectorCopy(shadow->lightViewAxis[2], shadowParms.orientation.axis[2]);
+
+	R_BeginEntityJob( job, index );
+
+	fe->viewParms = shadowParms;
+	fe->viewParms.frameSceneNum = tr.frameSceneNum;
+	fe->viewParms.frameCount = tr.frameCount;
+
+	// set viewParms.world
+	R_RotateForViewer ();
+
+	{
+		float xmin, xmax, ymin, ymax, znear, zfar;
+		viewParms_t *dest = &fe->viewParms;
+		vec3_t pop;
+
+		xmin = ymin = -shadow->viewRadius;
+		xmax = ymax = shadow->viewRadius;
+		znear = 0;
+		zfar = shadow->lightRadius;
+
+		dest->projectionMatrix[0] = 2 / (xmax - xmin);
+		dest->projectionMatrix[4] = 0;
+		dest->projectionMatrix[8] = (xmax + xmin) / (xmax - xmin);
+		dest->projectionMatrix[12] =0;
+
+		dest->projectionMatrix[1] = 0;
+		dest->projectionMatrix[5] = 2 / (ymax - ymin);
+		dest->projectionMatrix[9] = ( ymax + ymin ) / (ymax - ymin);	// normally 0
+		dest->projectionMatrix[13] = 0;
+
+		dest->projectionMatrix[2] = 0;
+		dest->projectionMatrix[6] = 0;
+		dest->projectionMatrix[10] = 2 / (zfar - znear);
+		dest->projectionMatrix[14] = 0;
+
+		dest->projectionMatrix[3] = 0;
+		dest->projectionMatrix[7] = 0;
+		dest->projectionMatrix[11] = 0;
+		dest->projectionMatrix[15] = 1;
+
+		VectorScale(dest->orientation.axis[1],  1.0f, dest->frustum[0].normal);
+		VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[0].normal, pop);
+		dest->frustum[0].dist = DotProduct(pop, dest->frustum[0].normal);
+
+		VectorScale(dest->orientation.axis[1], -1.0f, dest->frustum[1].normal);
+		VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[1].normal, pop);
+		dest->frustum[1].dist = DotProduct(pop, dest->frustum[1].normal);
+
+		VectorScale(dest->orientation.axis[2],  1.0f, dest->frustum[2].normal);
+		VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[2].normal, pop);
+		dest->frustum[2].dist = DotProduct(pop, dest->frustum[2].normal);
+
+		VectorScale(dest->orientation.axis[2], -1.0f, dest->frustum[3].normal);
+		VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[3].normal, pop);
+		dest->frustum[3].dist = DotProduct(pop, dest->frustum[3].normal);
+
+		VectorScale(dest->orientation.axis[0], -1.0f, dest->frustum[4].normal);
+		VectorMA(dest->orientation.origin, -shadow->lightRadius, dest->frustum[4].normal, pop);
+		dest->frustum[4].dist = DotProduct(pop, dest->frustum[4].normal);
+
+		for (j = 0; j < 5; j++)
+		{
+			dest->frustum[j].type = PLANE_NON_AXIAL;
+			SetPlaneSignbits (&dest->frustum[j]);
+		}
+
+		dest->flags |= VPF_FARPLANEFRUSTUM;
+	}
+
+	for (j = 0; j < shadow->numEntities; j++)
+	{
+		R_AddJobEntitySurface( job, shadow->entityNums[j] );
+	}
+
+	fe = &tr.frontEnd;
+}
+
+
 void R_RenderPshadowMaps(const refdef_t *fd)
 {
-	viewParms_t		shadowParms;
 	int i;
+	int firstAnimSurface;
 
 	// first, make a list of shadows
 	for ( i = 0; i < tr.refdef.num_entities; i++)
@@ -2024,171 +2398,46 @@ void R_RenderPshadowMaps(const refdef_t *fd)
 		tr.refdef.num_pshadows = MAX_DRAWN_PSHADOWS;
 	}
 
-	// next, fill up the rest of the shadow info
-	for ( i = 0; i < tr.refdef.num_pshadows; i++)
-	{
-		pshadow_t *shadow = &tr.refdef.pshadows[i];
-		vec3_t up;
-		vec3_t ambientLight, directedLight, lightDir;
+	firstAnimSurface = r_numAnimSurfaces;
 
-		VectorSet(lightDir, 0.57735f, 0.57735f, 0.57735f);
-#if 1
-		R_LightForPoint(shadow->viewOrigin, ambientLight, directedLight, lightDir);
-
-		// sometimes there's no light
-		if (DotProduct(lightDir, lightDir) < 0.9f)
-			VectorSet(lightDir, 0.0f, 0.0f, 1.0f);
-#endif
-
-		if (shadow->viewRadius * 3.0f > shadow->lightRadius)
-		{
-			shadow->lightRadius = shadow->viewRadius * 3.0f;
-		}
-
-		VectorMA(shadow->viewOrigin, shadow->viewRadius, lightDir, shadow->lightOrigin);
-
-		// make up a projection, up doesn't matter
-		VectorScale(lightDir, -1.0f, shadow->lightViewAxis[0]);
-		VectorSet(up, 0, 0, -1);
-
-		if ( fabsf(DotProduct(up, shadow->lightViewAxis[0])) > 0.9f )
+	// next, fill up the rest of the shadow info and add the surfaces
+	// of each shadow view, on the job threads unless r_debuglight
+	// has to print from inside the lighting
+	if ( r_frontEndJobs->integer && !r_debugLight->integer )
+	{
+		ri.ParallelFor( tr.refdef.num_pshadows, R_RenderPshadowJob, NULL );
+	}
+	else
+	{
+		for ( i = 0; i < tr.refdef.num_pshadows; i++)
 		{
-			VectorSet(up, -1, 0, 0);
+			R_RenderPshadowJob( NULL, i );
 		}
-
-		CrossProduct(shadow->lightViewAxis[0], up, shadow->lightViewAxis[1]);
-		VectorNormalize(shadow->lightViewAxis[1]);
-		CrossProduct(shadow->lightViewAxis[0], shadow->lightViewAxis[1], shadow->lightViewAxis[2]);
-
-		VectorCopy(shadow->lightViewAxis[0], shadow->cullPlane.normal);
-		shadow->cullPlane.dist = DotProduct(shadow->cullPlane.normal, shadow->lightOrigin);
-		shadow->cullPlane.type = PLANE_NON_AXIAL;
-		SetPlaneSignbits(&shadow->cullPlane);
 	}
 
 	// next, render shadowmaps
 	for ( i = 0; i < tr.refdef.num_pshadows; i++)
 	{
 		int firstDrawSurf;
-		pshadow_t *shadow = &tr.refdef.pshadows[i];
-		int j;
 
-		Com_Memset( &shadowParms, 0, sizeof( shadowParms ) );
+		tr.viewCount++;
 
-		if (glRefConfig.framebufferObject)
-		{
-			shadowParms.viewportX = 0;
-			shadowParms.viewportY = 0;
-		}
-		else
-		{
-			shadowParms.viewportX = tr.refdef.x;
-			shadowParms.viewportY = glConfig.vidHeight - ( tr.refdef.y + PSHADOW_MAP_SIZE );
-		}
-		shadowParms.viewportWidth = PSHADOW_MAP_SIZE;
-		shadowParms.viewportHeight = PSHADOW_MAP_SIZE;
-		shadowParms.isPortal = false;
-		shadowParms.isMirror = false;
+		fe->viewParms = entityJobs[i].state.viewParms;
+		fe->orientation = entityJobs[i].state.orientation;
 
-		shadowParms.fovX = 90;
-		shadowParms.fovY = 90;
-
-		if (glRefConfig.framebufferObject)
-			shadowParms.targetFbo = tr.pshadowFbos[i];
-
-		shadowParms.flags = VPF_DEPTHSHADOW | VPF_NOVIEWMODEL;
-		shadowParms.zFar = shadow->lightRadius;
-
-		VectorCopy(shadow->lightOrigin, shadowParms.orientation.origin);
-		
-		VectorCopy(shadow->lightViewAxis[0], shadowParms.orientation.axis[0]);
-		VectorCopy(shadow->lightViewAxis[1], shadowParms.orientation.axis[1]);
-		VectorCopy(shadow->lightViewAxis[2], shadowParms.orientation.axis[2]);
-
-		{
-			tr.viewCount++;
+		firstDrawSurf = tr.refdef.numDrawSurfs;
 
-			tr.viewParms = shadowParms;
-			tr.viewParms.frameSceneNum = tr.frameSceneNum;
-			tr.viewParms.frameCount = tr.frameCount;
+		tr.viewCount++;
 
-			firstDrawSurf = tr.refdef.numDrawSurfs;
+		R_EndEntityJob( &entityJobs[i] );
 
-			tr.viewCount++;
-
-			// set viewParms.world
-			R_RotateForViewer ();
+		R_SortDrawSurfs( tr.refdef.drawSurfs + firstDrawSurf, tr.refdef.numDrawSurfs - firstDrawSurf );
 
-			{
-				float xmin, xmax, ymin, ymax, znear, zfar;
-				viewParms_t *dest = &tr.viewParms;
-				vec3_t pop;
-
-				xmin = ymin = -shadow->viewRadius;
-				xmax = ymax = shadow->viewRadius;
-				znear = 0;
-				zfar = shadow->lightRadius;
-
-				dest->projectionMatrix[0] = 2 / (xmax - xmin);
-				dest->projectionMatrix[4] = 0;
-				dest->projectionMatrix[8] = (xmax + xmin) / (xmax - xmin);
-				dest->projectionMatrix[12] =0;
-
-				dest->projectionMatrix[1] = 0;
-				dest->projectionMatrix[5] = 2 / (ymax - ymin);
-				dest->projectionMatrix[9] = ( ymax + ymin ) / (ymax - ymin);	// normally 0
-				dest->projectionMatrix[13] = 0;
-
-				dest->projectionMatrix[2] = 0;
-				dest->projectionMatrix[6] = 0;
-				dest->projectionMatrix[10] = 2 / (zfar - znear);
-				dest->projectionMatrix[14] = 0;
-
-				dest->projectionMatrix[3] = 0;
-				dest->projectionMatrix[7] = 0;
-				dest->projectionMatrix[11] = 0;
-				dest->projectionMatrix[15] = 1;
-
-				VectorScale(dest->orientation.axis[1],  1.0f, dest->frustum[0].normal);
-				VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[0].normal, pop);
-				dest->frustum[0].dist = DotProduct(pop, dest->frustum[0].normal);
-
-				VectorScale(dest->orientation.axis[1], -1.0f, dest->frustum[1].normal);
-				VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[1].normal, pop);
-				dest->frustum[1].dist = DotProduct(pop, dest->frustum[1].normal);
-
-				VectorScale(dest->orientation.axis[2],  1.0f, dest->frustum[2].normal);
-				VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[2].normal, pop);
-				dest->frustum[2].dist = DotProduct(pop, dest->frustum[2].normal);
-
-				VectorScale(dest->orientation.axis[2], -1.0f, dest->frustum[3].normal);
-				VectorMA(dest->orientation.origin, -shadow->viewRadius, dest->frustum[3].normal, pop);
-				dest->frustum[3].dist = DotProduct(pop, dest->frustum[3].normal);
-
-				VectorScale(dest->orientation.axis[0], -1.0f, dest->frustum[4].normal);
-				VectorMA(dest->orientation.origin, -shadow->lightRadius, dest->frustum[4].normal, pop);
-				dest->frustum[4].dist = DotProduct(pop, dest->frustum[4].normal);
-
-				for (j = 0; j < 5; j++)
-				{
-					dest->frustum[j].type = PLANE_NON_AXIAL;
-					SetPlaneSignbits (&dest->frustum[j]);
-				}
-
-				dest->flags |= VPF_FARPLANEFRUSTUM;
-			}
-
-			for (j = 0; j < shadow->numEntities; j++)
-			{
-				R_AddEntitySurface(shadow->entityNums[j]);
-			}
-
-			R_SortDrawSurfs( tr.refdef.drawSurfs + firstDrawSurf, tr.refdef.numDrawSurfs - firstDrawSurf );
-
-			if (!glRefConfig.framebufferObject)
-				R_AddCapShadowmapCmd( i, -1 );
-		}
+		if (!glRefConfig.framebufferObject)
+			R_AddCapShadowmapCmd( i, -1 );
 	}
+
+	R_AnimateEntitySurfaces( firstAnimSurface );
 }
 
 static float CalcSplit(float n, float f, float i, float m)
@@ -2517,9 +2766,9 @@ void R_RenderSunShadowMaps(const refdef_t *fd, int level)
 		{
 			tr.viewCount++;
 
-			tr.viewParms = shadowParms;
-			tr.viewParms.frameSceneNum = tr.frameSceneNum;
-			tr.viewParms.frameCount = tr.frameCount;
+			fe->viewParms = shadowParms;
+			fe->viewParms.frameSceneNum = tr.frameSceneNum;
+			fe->viewParms.frameCount = tr.frameCount;
 
 			firstDrawSurf = tr.refdef.numDrawSurfs;
 
@@ -2528,7 +2777,7 @@ void R_RenderSunShadowMaps(const refdef_t *fd, int level)
 			// set viewParms.world
 			R_RotateForViewer ();
 
-			R_SetupProjectionOrtho(&tr.viewParms, lightviewBounds);
+			R_SetupProjectionOrtho(&fe->viewParms, lightviewBounds);
 
 			R_AddWorldSurfaces ();
 
@@ -2539,7 +2788,7 @@ void R_RenderSunShadowMaps(const refdef_t *fd, int level)
 			R_SortDrawSurfs( tr.refdef.drawSurfs + firstDrawSurf, tr.refdef.numDrawSurfs - firstDrawSurf );
 		}
 
-		Mat4Multiply(tr.viewParms.projectionMatrix, tr.viewParms.world.modelMatrix, tr.refdef.sunShadowMvp[level]);
+		Mat4Multiply(fe->viewParms.projectionMatrix, fe->viewParms.world.modelMatrix, tr.refdef.sunShadowMvp[level]);
 	}
 }
 
@@ -33,8 +33,8 @@ static float ProjectRadius( float r, vec3_t location )
 	vec3_t	p;
 	float	projected[4];
 
-	c = DotProduct( tr.viewParms.orientation.axis[0], tr.viewParms.orientation.origin );
-	dist = DotProduct( tr.viewParms.orientation.axis[0], location ) - c;
+	c = DotProduct( fe->viewParms.orientation.axis[0], fe->viewParms.orientation.origin );
+	dist = DotProduct( fe->viewParms.orientation.axis[0], location ) - c;
 
 	if ( dist <= 0 )
 		return 0;
@@ -43,25 +43,25 @@ static float ProjectRadius( float r, vec3_t location )
 	p[1] = fabs( r );
 	p[2] = -dist;
 
-	projected[0] = p[0] * tr.viewParms.projectionMatrix[0] + 
-		           p[1] * tr.viewParms.projectionMatrix[4] +
-				   p[2] * tr.viewParms.projectionMatrix[8] +
-				   tr.viewParms.projectionMatrix[12];
+	projected[0] = p[0] * fe->viewParms.projectionMatrix[0] + 
+		           p[1] * fe->viewParms.projectionMatrix[4] +
+				   p[2] * fe->viewParms.projectionMatrix[8] +
+				   fe->viewParms.projectionMatrix[12];
 
-	projected[1] = p[0] * tr.viewParms.projectionMatrix[1] + 
-		           p[1] * tr.viewParms.projectionMatrix[5] +
-				   p[2] * tr.viewParms.projectionMatrix[9] +
-				   tr.viewParms.projectionMatrix[13];
+	projected[1] = p[0] * fe->viewParms.projectionMatrix[1] + 
+		           p[1] * fe->viewParms.projectionMatrix[5] +
+				   p[2] * fe->viewParms.projectionMatrix[9] +
+				   fe->viewParms.projectionMatrix[13];
 
-	projected[2] = p[0] * tr.viewParms.projectionMatrix[2] + 
-		           p[1] * tr.viewParms.projectionMatrix[6] +
-				   p[2] * tr.viewParms.projectionMatrix[10] +
-				   tr.viewParms.projectionMatrix[14];
+	projected[2] = p[0] * fe->viewParms.projectionMatrix[2] + 
+		           p[1] * fe->viewParms.projectionMatrix[6] +
+				   p[2] * fe->viewParms.projectionMatrix[10] +
+				   fe->viewParms.projectionMatrix[14];
 
-	projected[3] = p[0] * tr.viewParms.projectionMatrix[3] + 
-		           p[1] * tr.viewParms.projectionMatrix[7] +
-				   p[2] * tr.viewParms.projectionMatrix[11] +
-				   tr.viewParms.projectionMatrix[15];
+	projected[3] = p[0] * fe->viewParms.projectionMatrix[3] + 
+		           p[1] * fe->viewParms.projectionMatrix[7] +
+				   p[2] * fe->viewParms.projectionMatrix[11] +
+				   fe->viewParms.projectionMatrix[15];
 
 
 	pr = projected[1] / projected[3];
@@ -94,15 +94,15 @@ static int R_CullModel( mdvModel_t *model, trRefEntity_t *ent ) {
 			switch ( R_CullLocalPointAndRadius( newFrame->localOrigin, newFrame->radius ) )
 			{
 			case CULL_OUT:
-				tr.pc.c_sphere_cull_md3_out++;
+				fe->pc->c_sphere_cull_md3_out++;
 				return CULL_OUT;
 
 			case CULL_IN:
-				tr.pc.c_sphere_cull_md3_in++;
+				fe->pc->c_sphere_cull_md3_in++;
 				return CULL_IN;
 
 			case CULL_CLIP:
-				tr.pc.c_sphere_cull_md3_clip++;
+				fe->pc->c_sphere_cull_md3_clip++;
 				break;
 			}
 		}
@@ -121,17 +121,17 @@ static int R_CullModel( mdvModel_t *model, trRefEntity_t *ent ) {
 			{
 				if ( sphereCull == CULL_OUT )
 				{
-					tr.pc.c_sphere_cull_md3_out++;
+					fe->pc->c_sphere_cull_md3_out++;
 					return CULL_OUT;
 				}
 				else if ( sphereCull == CULL_IN )
 				{
-					tr.pc.c_sphere_cull_md3_in++;
+					fe->pc->c_sphere_cull_md3_in++;
 					return CULL_IN;
 				}
 				else
 				{
-					tr.pc.c_sphere_cull_md3_clip++;
+					fe->pc->c_sphere_cull_md3_clip++;
 				}
 			}
 		}
@@ -146,14 +146,14 @@ static int R_CullModel( mdvModel_t *model, trRefEntity_t *ent ) {
 	switch ( R_CullLocalBox( bounds ) )
 	{
 	case CULL_IN:
-		tr.pc.c_box_cull_md3_in++;
+		fe->pc->c_box_cull_md3_in++;
 		return CULL_IN;
 	case CULL_CLIP:
-		tr.pc.c_box_cull_md3_clip++;
+		fe->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	case CULL_OUT:
 	default:
-		tr.pc.c_box_cull_md3_out++;
+		fe->pc->c_box_cull_md3_out++;
 		return CULL_OUT;
 	}
 }
@@ -174,7 +174,7 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 	mdrFrame_t *mdrframe;
 	int lod;
 
-	if ( tr.currentModel->numLods < 2 )
+	if ( fe->currentModel->numLods < 2 )
 	{
 		// model has only 1 LOD level, skip computations and bias
 		lod = 0;
@@ -184,10 +184,10 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 		// multiple LODs exist, so compute projected bounding sphere
 		// and use that as a criteria for selecting LOD
 
-		if(tr.currentModel->type == MOD_MDR)
+		if(fe->currentModel->type == MOD_MDR)
 		{
 			int frameSize;
-			mdr = (mdrHeader_t *) tr.currentModel->modelData;
+			mdr = (mdrHeader_t *) fe->currentModel->modelData;
 			frameSize = (size_t) (&((mdrFrame_t *)0)->bones[mdr->numBones]);
 			
 			mdrframe = (mdrFrame_t *) ((byte *) mdr + mdr->ofsFrames + frameSize * ent->e.frame);
@@ -196,8 +196,8 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 		}
 		else
 		{
-			//frame = ( md3Frame_t * ) ( ( ( unsigned char * ) tr.currentModel->md3[0] ) + tr.currentModel->md3[0]->ofsFrames );
-			frame = tr.currentModel->mdv[0]->frames;
+			//frame = ( md3Frame_t * ) ( ( ( unsigned char * ) fe->currentModel->md3[0] ) + fe->currentModel->md3[0]->ofsFrames );
+			frame = fe->currentModel->mdv[0]->frames;
 
 			frame += ent->e.frame;
 
@@ -216,23 +216,23 @@ int R_ComputeLOD( trRefEntity_t *ent ) {
 			flod = 0;
 		}
 
-		flod *= tr.currentModel->numLods;
+		flod *= fe->currentModel->numLods;
 		lod = static_cast<int>(flod);
 
 		if ( lod < 0 )
 		{
 			lod = 0;
 		}
-		else if ( lod >= tr.currentModel->numLods )
+		else if ( lod >= fe->currentModel->numLods )
 		{
-			lod = tr.currentModel->numLods - 1;
+			lod = fe->currentModel->numLods - 1;
 		}
 	}
 
 	lod += r_lodbias->integer;
 	
-	if ( lod >= tr.currentModel->numLods )
-		lod = tr.currentModel->numLods - 1;
+	if ( lod >= fe->currentModel->numLods )
+		lod = fe->currentModel->numLods - 1;
 	if ( lod < 0 )
 		lod = 0;
 
@@ -294,12 +294,12 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	bool		personalModel;
 
 	// don't add third_person objects if not in a portal
-	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !(tr.viewParms.isPortal 
-	                 || (tr.viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW)));
+	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !(fe->viewParms.isPortal 
+	                 || (fe->viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW)));
 
 	if ( ent->e.renderfx & RF_WRAP_FRAMES ) {
-		ent->e.frame %= tr.currentModel->mdv[0]->numFrames;
-		ent->e.oldframe %= tr.currentModel->mdv[0]->numFrames;
+		ent->e.frame %= fe->currentModel->mdv[0]->numFrames;
+		ent->e.oldframe %= fe->currentModel->mdv[0]->numFrames;
 	}
 
 	//
@@ -308,13 +308,16 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	// when the surfaces are rendered, they don't need to be
 	// range checked again.
 	//
-	if ( (ent->e.frame >= tr.currentModel->mdv[0]->numFrames) 
+	if ( (ent->e.frame >= fe->currentModel->mdv[0]->numFrames) 
 		|| (ent->e.frame < 0)
-		|| (ent->e.oldframe >= tr.currentModel->mdv[0]->numFrames)
+		|| (ent->e.oldframe >= fe->currentModel->mdv[0]->numFrames)
 		|| (ent->e.oldframe < 0) ) {
+			if ( R_EntityJobFailed() ) {
+				return;
+			}
 			ri.Printf( PRINT_DEVELOPER, "R_AddMD3Surfaces: no such frame %d to %d for '%s'\n",
 				ent->e.oldframe, ent->e.frame,
-				tr.currentModel->name );
+				fe->currentModel->name );
 			ent->e.frame = 0;
 			ent->e.oldframe = 0;
 	}
@@ -324,7 +327,7 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 	//
 	lod = R_ComputeLOD( ent );
 
-	model = tr.currentModel->mdv[lod];
+	model = fe->currentModel->mdv[lod];
 
 	//
 	// cull the entire model if merged bounding box of both frames
@@ -372,6 +375,9 @@ void R_AddMD3Surfaces( trRefEntity_t *ent ) {
 					break;
 				}
 			}
+			if ( ( shader == tr.defaultShader || shader->defaultShader ) && R_EntityJobFailed() ) {
+				return;
+			}
 			if (shader == tr.defaultShader) {
 				ri.Printf( PRINT_DEVELOPER, "WARNING: no shader for surface %s in skin %s\n", surface->name, skin->name);
 			}
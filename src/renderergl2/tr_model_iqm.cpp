@@ -127,6 +127,183 @@ static void Matrix34Invert( float *inMat, float *outMat )
 	outMat[11] = -DotProduct(outMat + 8, trans);
 }
 
+/*
+=================
+R_CreateIQMVaos
+
+Builds a static vao per surface so the vertex shader can skin the
+model.  The joint matrices of a frame are uploaded when it is drawn.
+=================
+*/
+static void R_CreateIQMVaos( iqmData_t *data, const char *mod_name ) {
+	srfVaoIQModel_t	*vaoSurf;
+	srfIQModel_t	*surf;
+	int		i, j;
+
+	if ( !data->num_surfaces || !glRefConfig.glslMaxAnimatedBones ) {
+		return;
+	}
+
+	if ( data->num_joints > glRefConfig.glslMaxAnimatedBones ) {
+		ri.Printf( PRINT_DEVELOPER, "R_CreateIQMVaos: %s has %d joints, skinning on the CPU\n",
+			   mod_name, data->num_joints );
+		return;
+	}
+
+	data->vaoSurfaces = (srfVaoIQModel_t *)ri.Hunk_Alloc( sizeof( *data->vaoSurfaces ) * data->num_surfaces, h_low );
+
+	vaoSurf = data->vaoSurfaces;
+	surf = data->surfaces;
+	for ( i = 0; i < data->num_surfaces; i++, vaoSurf++, surf++ ) {
+		uint32_t	offset_xyz, offset_st, offset_normal, offset_tangent, offset_color;
+		uint32_t	offset_boneIndexes, offset_boneWeights, stride;
+		uint32_t	dataSize, dataOfs;
+		uint8_t		*vertexes;
+		glIndex_t	*indexes, *ptr;
+		int		*tri;
+
+		offset_xyz         = 0;
+		offset_st          = offset_xyz + sizeof( float ) * 3;
+		offset_normal      = offset_st + sizeof( float ) * 2;
+		offset_tangent     = offset_normal + sizeof( int16_t ) * 4;
+		offset_color       = offset_tangent + sizeof( int16_t ) * 4;
+		offset_boneIndexes = offset_color + sizeof( byte ) * 4;
+		offset_boneWeights = offset_boneIndexes + sizeof( byte ) * 4;
+		stride = offset_boneWeights;
+
+		if ( data->num_joints ) {
+			stride += ( data->blendWeightsType == IQM_FLOAT ) ? sizeof( float ) * 4 : sizeof( byte ) * 4;
+		} else {
+			stride = offset_boneIndexes;
+		}
+
+		dataSize = surf->num_vertexes * stride;
+		vertexes = (uint8_t *)ri.Malloc( dataSize );
+		dataOfs = 0;
+
+		for ( j = 0; j < surf->num_vertexes; j++ ) {
+			int	vtx = surf->first_vertex + j;
+
+			// xyz
+			Com_Memcpy( vertexes + dataOfs, &data->positions[3*vtx], sizeof( float ) * 3 );
+			dataOfs += sizeof( float ) * 3;
+
+			// st
+			Com_Memcpy( vertexes + dataOfs, &data->texcoords[2*vtx], sizeof( float ) * 2 );
+			dataOfs += sizeof( float ) * 2;
+
+			// normal
+			R_VaoPackNormal( (int16_t *)( vertexes + dataOfs ), &data->normals[3*vtx] );
+			dataOfs += sizeof( int16_t ) * 4;
+
+			// tangent
+			R_VaoPackTangent( (int16_t *)( vertexes + dataOfs ), &data->tangents[4*vtx] );
+			dataOfs += sizeof( int16_t ) * 4;
+
+			// color
+			Com_Memcpy( vertexes + dataOfs, &data->colors[4*vtx], sizeof( byte ) * 4 );
+			dataOfs += sizeof( byte ) * 4;
+
+			if ( data->num_joints ) {
+				// bone indexes
+				Com_Memcpy( vertexes + dataOfs, &data->blendIndexes[4*vtx], sizeof( byte ) * 4 );
+				dataOfs += sizeof( byte ) * 4;
+
+				// bone weights
+				if ( data->blendWeightsType == IQM_FLOAT ) {
+					Com_Memcpy( vertexes + dataOfs, &data->blendWeights.f[4*vtx], sizeof( float ) * 4 );
+					dataOfs += sizeof( float ) * 4;
+				} else {
+					Com_Memcpy( vertexes + dataOfs, &data->blendWeights.b[4*vtx], sizeof( byte ) * 4 );
+					dataOfs += sizeof( byte ) * 4;
+				}
+			}
+		}
+
+		indexes = (glIndex_t *)ri.Malloc( surf->num_triangles * 3 * sizeof( *indexes ) );
+		tri = data->triangles + 3 * surf->first_triangle;
+		ptr = indexes;
+
+		for ( j = 0; j < surf->num_triangles; j++ ) {
+			*ptr++ = *tri++ - surf->first_vertex;
+			*ptr++ = *tri++ - surf->first_vertex;
+			*ptr++ = *tri++ - surf->first_vertex;
+		}
+
+		vaoSurf->surfaceType = SF_VAO_IQM;
+		vaoSurf->iqmData = data;
+		vaoSurf->iqmSurface = surf;
+		vaoSurf->numIndexes = surf->num_triangles * 3;
+		vaoSurf->numVerts = surf->num_vertexes;
+
+		vaoSurf->vao = R_CreateVao( va( "staticIQMMesh_VAO '%s'", surf->name ), vertexes, dataSize,
+			(byte *)indexes, surf->num_triangles * 3 * sizeof( *indexes ), VAO_USAGE_STATIC );
+
+		vaoSurf->vao->attribs[ATTR_INDEX_POSITION].enabled = 1;
+		vaoSurf->vao->attribs[ATTR_INDEX_TEXCOORD].enabled = 1;
+		vaoSurf->vao->attribs[ATTR_INDEX_NORMAL  ].enabled = 1;
+		vaoSurf->vao->attribs[ATTR_INDEX_TANGENT ].enabled = 1;
+		vaoSurf->vao->attribs[ATTR_INDEX_COLOR   ].enabled = 1;
+
+		vaoSurf->vao->attribs[ATTR_INDEX_POSITION].count = 3;
+		vaoSurf->vao->attribs[ATTR_INDEX_TEXCOORD].count = 2;
+		vaoSurf->vao->attribs[ATTR_INDEX_NORMAL  ].count = 4;
+		vaoSurf->vao->attribs[ATTR_INDEX_TANGENT ].count = 4;
+		vaoSurf->vao->attribs[ATTR_INDEX_COLOR   ].count = 4;
+
+		vaoSurf->vao->attribs[ATTR_INDEX_POSITION].type = GL_FLOAT;
+		vaoSurf->vao->attribs[ATTR_INDEX_TEXCOORD].type = GL_FLOAT;
+		vaoSurf->vao->attribs[ATTR_INDEX_NORMAL  ].type = GL_SHORT;
+		vaoSurf->vao->attribs[ATTR_INDEX_TANGENT ].type = GL_SHORT;
+		vaoSurf->vao->attribs[ATTR_INDEX_COLOR   ].type = GL_UNSIGNED_BYTE;
+
+		vaoSurf->vao->attribs[ATTR_INDEX_POSITION].normalized = GL_FALSE;
+		vaoSurf->vao->attribs[ATTR_INDEX_TEXCOORD].normalized = GL_FALSE;
+		vaoSurf->vao->attribs[ATTR_INDEX_NORMAL  ].normalized = GL_TRUE;
+		vaoSurf->vao->attribs[ATTR_INDEX_TANGENT ].normalized = GL_TRUE;
+		vaoSurf->vao->attribs[ATTR_INDEX_COLOR   ].normalized = GL_TRUE;
+
+		vaoSurf->vao->attribs[ATTR_INDEX_POSITION].offset = offset_xyz;
+		vaoSurf->vao->attribs[ATTR_INDEX_TEXCOORD].offset = offset_st;
+		vaoSurf->vao->attribs[ATTR_INDEX_NORMAL  ].offset = offset_normal;
+		vaoSurf->vao->attribs[ATTR_INDEX_TANGENT ].offset = offset_tangent;
+		vaoSurf->vao->attribs[ATTR_INDEX_COLOR   ].offset = offset_color;
+
+		vaoSurf->vao->attribs[ATTR_INDEX_POSITION].stride = stride;
+		vaoSurf->vao->attribs[ATTR_INDEX_TEXCOORD].stride = stride;
+		vaoSurf->vao->attribs[ATTR_INDEX_NORMAL  ].stride = stride;
+		vaoSurf->vao->attribs[ATTR_INDEX_TANGENT ].stride = stride;
+		vaoSurf->vao->attribs[ATTR_INDEX_COLOR   ].stride = stride;
+
+		if ( data->num_joints ) {
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_INDEXES].enabled = 1;
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_WEIGHTS].enabled = 1;
+
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_INDEXES].count = 4;
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_WEIGHTS].count = 4;
+
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_INDEXES].type = GL_UNSIGNED_BYTE;
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_WEIGHTS].type =
+				( data->blendWeightsType == IQM_FLOAT ) ? GL_FLOAT : GL_UNSIGNED_BYTE;
+
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_INDEXES].normalized = GL_FALSE;
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_WEIGHTS].normalized =
+				( data->blendWeightsType == IQM_FLOAT ) ? GL_FALSE : GL_TRUE;
+
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_INDEXES].offset = offset_boneIndexes;
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_WEIGHTS].offset = offset_boneWeights;
+
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_INDEXES].stride = stride;
+			vaoSurf->vao->attribs[ATTR_INDEX_BONE_WEIGHTS].stride = stride;
+		}
+
+		Vao_SetVertexPointers( vaoSurf->vao );
+
+		ri.Free( vertexes );
+		ri.Free( indexes );
+	}
+}
+
 /*
 =================
 R_LoadIQM
@@ -737,6 +914,8 @@ bool R_LoadIQM( model_t *mod, void *buffer, int filesize, const char *mod_name )
 		}
 	}
 
+	R_CreateIQMVaos( iqmData, mod_name );
+
 	return true;
 }
 
@@ -751,7 +930,7 @@ static int R_CullIQM( iqmData_t *data, trRefEntity_t *ent ) {
 	int		i;
 
 	if (!data->bounds) {
-		tr.pc.c_box_cull_md3_clip++;
+		fe->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	}
 
@@ -768,14 +947,14 @@ static int R_CullIQM( iqmData_t *data, trRefEntity_t *ent ) {
 	switch ( R_CullLocalBox( bounds ) )
 	{
 	case CULL_IN:
-		tr.pc.c_box_cull_md3_in++;
+		fe->pc->c_box_cull_md3_in++;
 		return CULL_IN;
 	case CULL_CLIP:
-		tr.pc.c_box_cull_md3_clip++;
+		fe->pc->c_box_cull_md3_clip++;
 		return CULL_CLIP;
 	case CULL_OUT:
 	default:
-		tr.pc.c_box_cull_md3_out++;
+		fe->pc->c_box_cull_md3_out++;
 		return CULL_OUT;
 	}
 }
@@ -845,13 +1024,14 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 	int         cubemapIndex;
 	shader_t		*shader;
 	skin_t			*skin;
+	bool		cpuSkinned;
 
-	data = (iqmData_t*)tr.currentModel->modelData;
+	data = (iqmData_t*)fe->currentModel->modelData;
 	surface = data->surfaces;
 
 	// don't add third_person objects if not in a portal
-  	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !(tr.viewParms.isPortal
-			|| (tr.viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW)));
+  	personalModel = (ent->e.renderfx & RF_THIRD_PERSON) && !(fe->viewParms.isPortal
+			|| (fe->viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW)));
 
 
 	if ( ent->e.renderfx & RF_WRAP_FRAMES ) {
@@ -869,9 +1049,12 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 	     || (ent->e.frame < 0)
 	     || (ent->e.oldframe >= data->num_frames)
 	     || (ent->e.oldframe < 0) ) {
+		if ( R_EntityJobFailed() ) {
+			return;
+		}
 		ri.Printf( PRINT_DEVELOPER, "R_AddIQMSurfaces: no such frame %d to %d for '%s'\n",
 			   ent->e.oldframe, ent->e.frame,
-			   tr.currentModel->name );
+			   fe->currentModel->name );
 		ent->e.frame = 0;
 		ent->e.oldframe = 0;
 	}
@@ -919,6 +1102,8 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 			shader = surface->shader;
 		}
 
+		cpuSkinned = false;
+
 		// we will add shadows even if the main object isn't visible in the view
 
 		// stencil shadows can't do personal models unless I polyhedron clip
@@ -928,6 +1113,7 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 			&& !(ent->e.renderfx & ( RF_NOSHADOW | RF_DEPTHHACK ) ) 
 			&& shader->sort == SS_OPAQUE ) {
 			R_AddDrawSurf( (surfaceType_t*)surface, tr.shadowShader, 0, 0, 0, 0 );
+			cpuSkinned = true;
 		}
 
 		// projection shadows work fine with personal models
@@ -936,10 +1122,21 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 			&& (ent->e.renderfx & RF_SHADOW_PLANE )
 			&& shader->sort == SS_OPAQUE ) {
 			R_AddDrawSurf( (surfaceType_t*)surface, tr.projectionShadowShader, 0, 0, 0, 0 );
+			cpuSkinned = true;
 		}
 
 		if( !personalModel ) {
-			R_AddDrawSurf( (surfaceType_t*)surface, shader, fogNum, 0, 0, cubemapIndex );
+			// the vertex shader skins it unless the shader deforms on the CPU
+			if ( data->vaoSurfaces && !ShaderRequiresCPUDeforms( shader ) ) {
+				R_AddDrawSurf( (surfaceType_t*)&data->vaoSurfaces[i], shader, fogNum, 0, 0, cubemapIndex );
+			} else {
+				R_AddDrawSurf( (surfaceType_t*)surface, shader, fogNum, 0, 0, cubemapIndex );
+				cpuSkinned = true;
+			}
+		}
+
+		if( cpuSkinned ) {
+			R_QueueSurfaceAnimation( ent, (surfaceType_t*)surface, surface->num_vertexes );
 		}
 
 		surface++;
@@ -947,6 +1144,119 @@ void R_AddIQMSurfaces( trRefEntity_t *ent ) {
 }
 
 
+/*
+=================
+R_FindSurfaceAnimation
+
+Returns the vertexes the front end skinned for this surface of the
+entity, or NULL if the back end has to skin it itself.
+=================
+*/
+const animSurface_t *R_FindSurfaceAnimation( const trRefEntity_t *ent, const surfaceType_t *surface ) {
+	const animSurface_t	*anim;
+
+	for ( anim = ent->animSurfaces ; anim ; anim = anim->next ) {
+		if ( anim->surface == surface ) {
+			return anim;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+=================
+R_QueueSurfaceAnimation
+
+Reserves room for the skinned vertexes of an iqm surface, to be filled
+in by R_AnimateEntitySurfaces.  A surface that is drawn again in a
+portal or shadow view keeps the vertexes of the first view.
+=================
+*/
+void R_QueueSurfaceAnimation( trRefEntity_t *ent, surfaceType_t *surface, int numVertexes ) {
+	animSurface_t	*anim;
+	int				surfaceNum;
+	int				firstVertex;
+
+	if ( !r_frontEndJobs->integer ) {
+		return;
+	}
+
+	if ( R_FindSurfaceAnimation( ent, surface ) ) {
+		return;
+	}
+
+	// the entity jobs queue surfaces at the same time
+	surfaceNum = r_numAnimSurfaces;
+	do {
+		if ( surfaceNum >= MAX_ANIMSURFACES ) {
+			return;
+		}
+	} while ( !r_numAnimSurfaces.compare_exchange_weak( surfaceNum, surfaceNum + 1 ) );
+
+	anim = &backEndData->animSurfaces[surfaceNum];
+	anim->surface = NULL;
+
+	firstVertex = r_numAnimVertexes;
+	do {
+		if ( firstVertex + numVertexes > MAX_ANIMVERTEXES ) {
+			return;
+		}
+	} while ( !r_numAnimVertexes.compare_exchange_weak( firstVertex, firstVertex + numVertexes ) );
+
+	anim->surface = surface;
+	anim->entity = ent;
+	anim->firstVertex = firstVertex;
+	anim->numVertexes = numVertexes;
+	anim->next = ent->animSurfaces;
+	ent->animSurfaces = anim;
+}
+
+/*
+=================
+R_AnimateSurfaceJob
+=================
+*/
+static void R_AnimateSurfaceJob( void *data, int index ) {
+	const animSurface_t	*anim = (const animSurface_t *)data + index;
+	const refEntity_t	*e;
+	const srfIQModel_t	*surf;
+	int					numFrames;
+
+	// out of vertexes when it was queued
+	if ( !anim->surface ) {
+		return;
+	}
+
+	e = &anim->entity->e;
+	surf = (const srfIQModel_t *)anim->surface;
+	numFrames = surf->data->num_frames;
+
+	R_IQMTransformVertexes( surf, numFrames ? e->frame % numFrames : 0,
+		numFrames ? e->oldframe % numFrames : 0, e->backlerp,
+		&backEndData->animXyz[anim->firstVertex],
+		&backEndData->animNormals[anim->firstVertex],
+		&backEndData->animTangents[anim->firstVertex] );
+}
+
+/*
+=================
+R_AnimateEntitySurfaces
+
+Skins the surfaces queued since firstAnimSurface on the job threads,
+so the back end only has to copy the vertexes into tess.
+=================
+*/
+void R_AnimateEntitySurfaces( int firstAnimSurface ) {
+	if ( r_numAnimSurfaces <= firstAnimSurface ) {
+		return;
+	}
+
+	ri.ParallelFor( r_numAnimSurfaces - firstAnimSurface, R_AnimateSurfaceJob,
+		&backEndData->animSurfaces[firstAnimSurface] );
+}
+
+
 static void ComputePoseMats( iqmData_t *data, int frame, int oldframe,
 			      float backlerp, float *mat ) {
 	float	*mat1, *mat2;
@@ -1015,47 +1325,27 @@ static void ComputeJointMats( iqmData_t *data, int frame, int oldframe,
 
 /*
 =================
-RB_AddIQMSurfaces
+R_IQMTransformVertexes
 
-Compute vertices for this model surface
+Writes the skinned positions, normals and tangents of this model
+surface to outXYZ, outNormal and outTangent.  Only reads the model
+data, so the front end can call it from the job threads.
 =================
 */
-void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
-	srfIQModel_t	*surf = (srfIQModel_t *)surface;
+void R_IQMTransformVertexes( const srfIQModel_t *surf, int frame, int oldframe, float backlerp,
+                             vec4_t *outXYZ, int16_t (*outNormal)[4], int16_t (*outTangent)[4] ) {
 	iqmData_t	*data = surf->data;
 	float		jointMats[IQM_MAX_JOINTS * 12];
 	int		i;
 
-	vec4_t		*outXYZ;
-	int16_t	*outNormal;
-	int16_t	*outTangent;
-	vec2_t		*outTexCoord;
-	uint16_t *outColor;
-
-	int	frame = data->num_frames ? backEnd.currentEntity->e.frame % data->num_frames : 0;
-	int	oldframe = data->num_frames ? backEnd.currentEntity->e.oldframe % data->num_frames : 0;
-	float	backlerp = backEnd.currentEntity->e.backlerp;
-
-	int		*tri;
-	glIndex_t	*ptr;
-	glIndex_t	base;
-
-	RB_CHECKOVERFLOW( surf->num_vertexes, surf->num_triangles * 3 );
-
-	outXYZ = &tess.xyz[tess.numVertexes];
-	outNormal = tess.normal[tess.numVertexes];
-	outTangent = tess.tangent[tess.numVertexes];
-	outTexCoord = &tess.texCoords[tess.numVertexes];
-	outColor = tess.color[tess.numVertexes];
-
 	// compute interpolated joint matrices
 	if ( data->num_poses > 0 ) {
 		ComputePoseMats( data, frame, oldframe, backlerp, jointMats );
 	}
 
-	// transform vertexes and fill other data
+	// transform vertexes
 	for( i = 0; i < surf->num_vertexes;
-	     i++, outXYZ++, outNormal+=4, outTexCoord++, outColor+=4 ) {
+	     i++, outXYZ++, outNormal++, outTangent++ ) {
 		int	j, k;
 		float	vtxMat[12];
 		float	nrmMat[9];
@@ -1099,9 +1389,6 @@ void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
 		nrmMat[ 7] = vtxMat[ 2]*vtxMat[ 4] - vtxMat[ 0]*vtxMat[ 6];
 		nrmMat[ 8] = vtxMat[ 0]*vtxMat[ 5] - vtxMat[ 1]*vtxMat[ 4];
 
-		(*outTexCoord)[0] = data->texcoords[2*vtx + 0];
-		(*outTexCoord)[1] = data->texcoords[2*vtx + 1];
-
 		(*outXYZ)[0] =
 			vtxMat[ 0] * data->positions[3*vtx+0] +
 			vtxMat[ 1] * data->positions[3*vtx+1] +
@@ -1127,17 +1414,126 @@ void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
 			normal[1] = DotProduct(&nrmMat[3], &data->normals[3*vtx]);
 			normal[2] = DotProduct(&nrmMat[6], &data->normals[3*vtx]);
 
-			R_VaoPackNormal(outNormal, normal);
+			R_VaoPackNormal(*outNormal, normal);
 
 			tangent[0] = DotProduct(&nrmMat[0], &data->tangents[4*vtx]);
 			tangent[1] = DotProduct(&nrmMat[3], &data->tangents[4*vtx]);
 			tangent[2] = DotProduct(&nrmMat[6], &data->tangents[4*vtx]);
 			tangent[3] = data->tangents[4*vtx+3];
 
-			R_VaoPackTangent(outTangent, tangent);
-			outTangent+=4;
+			R_VaoPackTangent(*outTangent, tangent);
+		}
+	}
+}
+
+/*
+=================
+RB_IQMSurfaceAnimVao
+
+Draws the static vao of this model surface and has the vertex shader
+skin it with the joint matrices of the current frame
+=================
+*/
+void RB_IQMSurfaceAnimVao( srfVaoIQModel_t *surface ) {
+	iqmData_t	*data = surface->iqmData;
+	int		i;
+
+	GLimp_LogComment( "--- RB_IQMSurfaceAnimVao ---\n" );
+
+	if ( ShaderRequiresCPUDeforms( tess.shader ) ) {
+		RB_IQMSurfaceAnim( (surfaceType_t *)surface->iqmSurface );
+		return;
+	}
+
+	if ( !surface->vao ) {
+		return;
+	}
+
+	RB_EndSurface();
+	RB_BeginSurface( tess.shader, tess.fogNum, tess.cubemapIndex );
+
+	R_BindVao( surface->vao );
+
+	tess.useInternalVao = false;
+
+	tess.numIndexes = surface->numIndexes;
+	tess.numVertexes = surface->numVerts;
+
+	if ( data->num_poses > 0 ) {
+		float	jointMats[IQM_MAX_JOINTS * 12];
+		int	frame = data->num_frames ? backEnd.currentEntity->e.frame % data->num_frames : 0;
+		int	oldframe = data->num_frames ? backEnd.currentEntity->e.oldframe % data->num_frames : 0;
+
+		ComputePoseMats( data, frame, oldframe, backEnd.currentEntity->e.backlerp, jointMats );
+
+		// the 3x4 row major joint matrices become column major mat4s
+		for ( i = 0; i < data->num_poses; i++ ) {
+			float	*in = &jointMats[12 * i];
+			float	*out = glState.boneMatrix[i];
+
+			out[ 0] = in[ 0]; out[ 1] = in[ 4]; out[ 2] = in[ 8]; out[ 3] = 0.0f;
+			out[ 4] = in[ 1]; out[ 5] = in[ 5]; out[ 6] = in[ 9]; out[ 7] = 0.0f;
+			out[ 8] = in[ 2]; out[ 9] = in[ 6]; out[10] = in[10]; out[11] = 0.0f;
+			out[12] = in[ 3]; out[13] = in[ 7]; out[14] = in[11]; out[15] = 1.0f;
 		}
 
+		glState.boneAnimation = data->num_poses;
+	}
+
+	RB_EndSurface();
+
+	// so we don't skin surfaces that shouldn't be skinned
+	glState.boneAnimation = 0;
+}
+
+/*
+=================
+RB_AddIQMSurfaces
+
+Compute vertices for this model surface
+=================
+*/
+void RB_IQMSurfaceAnim( surfaceType_t *surface ) {
+	srfIQModel_t	*surf = (srfIQModel_t *)surface;
+	iqmData_t	*data = surf->data;
+	const animSurface_t	*anim;
+	int		i;
+
+	vec2_t		*outTexCoord;
+	uint16_t *outColor;
+
+	int	frame = data->num_frames ? backEnd.currentEntity->e.frame % data->num_frames : 0;
+	int	oldframe = data->num_frames ? backEnd.currentEntity->e.oldframe % data->num_frames : 0;
+	float	backlerp = backEnd.currentEntity->e.backlerp;
+
+	int		*tri;
+	glIndex_t	*ptr;
+	glIndex_t	base;
+
+	RB_CHECKOVERFLOW( surf->num_vertexes, surf->num_triangles * 3 );
+
+	// the front end may have skinned it already
+	anim = R_FindSurfaceAnimation( backEnd.currentEntity, surface );
+	if ( anim ) {
+		Com_Memcpy( tess.xyz[tess.numVertexes], backEndData->animXyz[anim->firstVertex], anim->numVertexes * sizeof( vec4_t ) );
+		Com_Memcpy( tess.normal[tess.numVertexes], backEndData->animNormals[anim->firstVertex], anim->numVertexes * sizeof( tess.normal[0] ) );
+		Com_Memcpy( tess.tangent[tess.numVertexes], backEndData->animTangents[anim->firstVertex], anim->numVertexes * sizeof( tess.tangent[0] ) );
+	} else {
+		R_IQMTransformVertexes( surf, frame, oldframe, backlerp, &tess.xyz[tess.numVertexes],
+					&tess.normal[tess.numVertexes], &tess.tangent[tess.numVertexes] );
+	}
+
+	outTexCoord = &tess.texCoords[tess.numVertexes];
+	outColor = tess.color[tess.numVertexes];
+
+	// fill other data
+	for( i = 0; i < surf->num_vertexes;
+	     i++, outTexCoord++, outColor+=4 ) {
+		int	vtx = i + surf->first_vertex;
+
+		(*outTexCoord)[0] = data->texcoords[2*vtx + 0];
+		(*outTexCoord)[1] = data->texcoords[2*vtx + 1];
+
 		outColor[0] = data->colors[4*vtx+0] * 257;
 		outColor[1] = data->colors[4*vtx+1] * 257;
 		outColor[2] = data->colors[4*vtx+2] * 257;
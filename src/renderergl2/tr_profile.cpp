@@ -0,0 +1,621 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2019 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, see <https://www.gnu.org/licenses/>
+
+===========================================================================
+*/
+// tr_profile.cpp -- per frame timings of the front and back end phases,
+// with the back end counters and GL timer queries, captured while
+// r_profile is set and written out as a chrome://tracing trace
+
+#include "tr_local.h"
+
+#define	MAX_PROFILE_FRAMES	8192
+#define	MAX_PROFILE_SPANS	32		// kept for the trace and the timer queries
+#define	PROFILE_BACKEND_SPANS	12		// of which the front end can't take these
+
+// spans past MAX_PROFILE_SPANS are still added to the phase totals; this
+// is how deeply they can nest
+#define	MAX_PROFILE_OVERFLOW	16
+
+// frames a timer query is given before its result is read back
+#define	PROFILE_GPU_FRAMES	4
+
+typedef enum {
+	RPC_SURFACES,
+	RPC_VERTEXES,
+	RPC_INDEXES,
+	RPC_DRAWCALLS,
+	RPC_STATECHANGES,
+	RPC_TEXTUREBINDS,
+	RPC_SHADERBINDS,
+	RPC_VAOBINDS,
+	RPC_VAOUPLOADS,
+	RPC_VAOUPLOADBYTES,
+	RPC_LEAFS,
+	RPC_WORLDSURFACES,
+
+	RPC_NUM_COUNTERS
+} profileCounter_t;
+
+static const char *profilePhaseNames[RP_NUM_PHASES] = {
+	"renderView",
+	"markLeaves",
+	"addWorld",
+	"addEntities",
+	"sort",
+	"backEnd",
+	"drawView",
+	"shadowMap",
+	"postProcess",
+	"swap"
+};
+
+static const char *profileCounterNames[RPC_NUM_COUNTERS] = {
+	"surfaces",
+	"vertexes",
+	"indexes",
+	"drawCalls",
+	"stateChanges",
+	"textureBinds",
+	"shaderBinds",
+	"vaoBinds",
+	"vaoUploads",
+	"vaoUploadBytes",
+	"leafs",
+	"worldSurfaces"
+};
+
+typedef struct {
+	int			phase;
+	int			start;		// usec after the start of the frame
+	int			cpuUsec;
+	int			gpuUsec;	// -1 without a timer query
+} profileSpan_t;
+
+typedef struct {
+	int64_t		start;		// usec after the start of the capture
+	int			usec;
+	int			cpuUsec[RP_NUM_PHASES];		// -1 if the phase didn't run
+	int			gpuUsec[RP_NUM_PHASES];		// -1 without timer query results
+	int			numSpans;
+	int			overflowSpans;				// only in the phase totals
+	profileSpan_t	spans[MAX_PROFILE_SPANS];
+	int			counters[RPC_NUM_COUNTERS];
+} profileFrame_t;
+
+typedef struct {
+	int			phase;
+	int			start;
+} profileOverflow_t;
+
+static struct {
+	profileFrame_t	*frames;	// NULL when not capturing
+	int				numFrames;
+	profileFrame_t	*current;	// NULL between frames and for frames without a world
+	int64_t			startTime;
+	int64_t			frameTime;
+	bool			full;
+
+	bool			gpu;
+	GLuint			queries[PROFILE_GPU_FRAMES][MAX_PROFILE_SPANS * 2];
+	int				queryFrame[PROFILE_GPU_FRAMES];		// -1 if nothing is pending
+
+	profileOverflow_t	overflow[MAX_PROFILE_OVERFLOW];	// open spans past MAX_PROFILE_SPANS
+	int				numOverflow;
+} profile;
+
+// the output buffer of R_ProfileWrite
+static char	*profileText;
+static int	profileTextSize, profileTextLength;
+
+/*
+====================
+R_ProfileResolveQueries
+
+Reads back the timer queries of the frame in this slot.
+====================
+*/
+static void R_ProfileResolveQueries( int slot ) {
+	profileFrame_t	*frame;
+	profileSpan_t	*span;
+	GLuint64		start, end;
+	int				i;
+
+	if ( profile.queryFrame[slot] < 0 ) {
+		return;
+	}
+
+	frame = &profile.frames[profile.queryFrame[slot]];
+	for ( i = 0, span = frame->spans ; i < frame->numSpans ; i++, span++ ) {
+		if ( span->gpuUsec < 0 ) {
+			continue;
+		}
+
+		qglGetQueryObjectui64v( profile.queries[slot][i * 2], GL_QUERY_RESULT, &start );
+		qglGetQueryObjectui64v( profile.queries[slot][i * 2 + 1], GL_QUERY_RESULT, &end );
+		span->gpuUsec = end > start ? ( end - start ) / 1000 : 0;
+
+		if ( frame->gpuUsec[span->phase] < 0 ) {
+			frame->gpuUsec[span->phase] = 0;
+		}
+		frame->gpuUsec[span->phase] += span->gpuUsec;
+	}
+
+	profile.queryFrame[slot] = -1;
+}
+
+/*
+====================
+R_ProfileStart
+====================
+*/
+static void R_ProfileStart( void ) {
+	int		i;
+
+	profile.frames = (profileFrame_t *)ri.Malloc( MAX_PROFILE_FRAMES * sizeof( profileFrame_t ) );
+	profile.numFrames = 0;
+	profile.current = NULL;
+	profile.numOverflow = 0;
+	profile.startTime = ri.Microseconds();
+	profile.full = false;
+
+	profile.gpu = glRefConfig.timerQuery;
+	for ( i = 0 ; i < PROFILE_GPU_FRAMES ; i++ ) {
+		if ( profile.gpu ) {
+			qglGenQueries( MAX_PROFILE_SPANS * 2, profile.queries[i] );
+		}
+		profile.queryFrame[i] = -1;
+	}
+
+	ri.Printf( PRINT_ALL, "profile: capturing%s\n", profile.gpu ? " with timer queries" : "" );
+}
+
+/*
+====================
+R_ProfileAppend
+====================
+*/
+static void QDECL R_ProfileAppend( const char *fmt, ... ) {
+	va_list		argptr;
+	int			len;
+
+	va_start( argptr, fmt );
+	len = Q_vsnprintf( profileText + profileTextLength, profileTextSize - profileTextLength, fmt, argptr );
+	va_end( argptr );
+
+	if ( len > 0 && profileTextLength + len < profileTextSize ) {
+		profileTextLength += len;
+	} else {
+		profileTextLength = profileTextSize - 1;
+	}
+}
+
+/*
+====================
+R_ProfileWrite
+
+Writes the capture in the Trace Event Format.  The front and back end
+phases are complete events on the cpu track, timer query results are
+placed on the gpu track at the time the phase started on the cpu, and
+the counters of each frame are a single counter event.  Returns false
+if the buffer for the trace couldn't be allocated.
+====================
+*/
+static bool R_ProfileWrite( const char *name ) {
+	profileFrame_t	*frame;
+	profileSpan_t	*span;
+	int				i, j, size;
+
+	size = 256;
+	for ( i = 0 ; i < profile.numFrames ; i++ ) {
+		size += 128 + RPC_NUM_COUNTERS * 32 + profile.frames[i].numSpans * 2 * 128;
+	}
+
+	// the whole capture can run to tens of MB, which is no business of the
+	// hunk or the zone; if it can't be had the trace is simply not written
+	profileText = (char *)malloc( size );
+	if ( !profileText ) {
+		ri.Printf( PRINT_WARNING, "profile: couldn't allocate %i bytes for %s\n", size, name );
+		return false;
+	}
+	profileTextSize = size;
+	profileTextLength = 0;
+
+	R_ProfileAppend( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	R_ProfileAppend( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"cpu\"}},\n" );
+	R_ProfileAppend( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"gpu\"}}" );
+
+	for ( i = 0, frame = profile.frames ; i < profile.numFrames ; i++, frame++ ) {
+		R_ProfileAppend( ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%i}",
+			(long long)frame->start, frame->usec );
+
+		for ( j = 0, span = frame->spans ; j < frame->numSpans ; j++, span++ ) {
+			R_ProfileAppend( ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%i}",
+				profilePhaseNames[span->phase], (long long)( frame->start + span->start ), span->cpuUsec );
+			if ( span->gpuUsec >= 0 ) {
+				R_ProfileAppend( ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%lld,\"dur\":%i}",
+					profilePhaseNames[span->phase], (long long)( frame->start + span->start ), span->gpuUsec );
+			}
+		}
+
+		R_ProfileAppend( ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%lld,\"args\":{", (long long)frame->start );
+		for ( j = 0 ; j < RPC_NUM_COUNTERS ; j++ ) {
+			R_ProfileAppend( "%s\"%s\":%i", j ? "," : "", profileCounterNames[j], frame->counters[j] );
+		}
+		R_ProfileAppend( "}}" );
+	}
+
+	R_ProfileAppend( "\n]}\n" );
+
+	ri.FS_WriteFile( name, profileText, profileTextLength );
+	free( profileText );
+	profileText = NULL;
+	return true;
+}
+
+/*
+====================
+R_ProfileCompareInts
+====================
+*/
+static int R_ProfileCompareInts( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+====================
+R_ProfilePrintPercentiles
+
+Prints the 50th, 90th and 99th percentile and the worst of the sorted
+samples, in msec.
+====================
+*/
+static void R_ProfilePrintPercentiles( int *samples, int numSamples ) {
+	qsort( samples, numSamples, sizeof( int ), R_ProfileCompareInts );
+
+	ri.Printf( PRINT_ALL, "  %6.2f %6.2f %6.2f %6.2f",
+		samples[( numSamples - 1 ) * 50 / 100] / 1000.0f,
+		samples[( numSamples - 1 ) * 90 / 100] / 1000.0f,
+		samples[( numSamples - 1 ) * 99 / 100] / 1000.0f,
+		samples[numSamples - 1] / 1000.0f );
+}
+
+/*
+====================
+R_ProfileReport
+
+Prints the percentiles of the time each phase took per frame, and the
+mean and worst value of each counter.
+====================
+*/
+static void R_ProfileReport( void ) {
+	profileFrame_t	*frame;
+	int				*cpu, *gpu;
+	int				phase, i, j, max, overflowSpans, overflowFrames;
+	bool			used, gpuUsed;
+	double			total;
+
+	cpu = (int *)ri.Malloc( profile.numFrames * sizeof( int ) );
+	gpu = (int *)ri.Malloc( profile.numFrames * sizeof( int ) );
+
+	ri.Printf( PRINT_ALL, "%-12s  %-27s  %s\n", "", "cpu msec 50% 90% 99% max", "gpu msec 50% 90% 99% max" );
+
+	for ( i = 0, frame = profile.frames ; i < profile.numFrames ; i++, frame++ ) {
+		cpu[i] = frame->usec;
+	}
+	ri.Printf( PRINT_ALL, "%-12s", "frame" );
+	R_ProfilePrintPercentiles( cpu, profile.numFrames );
+	ri.Printf( PRINT_ALL, "\n" );
+
+	for ( phase = 0 ; phase < RP_NUM_PHASES ; phase++ ) {
+		used = gpuUsed = false;
+		for ( i = 0, frame = profile.frames ; i < profile.numFrames ; i++, frame++ ) {
+			cpu[i] = MAX( frame->cpuUsec[phase], 0 );
+			gpu[i] = MAX( frame->gpuUsec[phase], 0 );
+			used |= frame->cpuUsec[phase] >= 0;
+			gpuUsed |= frame->gpuUsec[phase] >= 0;
+		}
+
+		if ( !used ) {
+			continue;
+		}
+
+		ri.Printf( PRINT_ALL, "%-12s", profilePhaseNames[phase] );
+		R_ProfilePrintPercentiles( cpu, profile.numFrames );
+		if ( gpuUsed ) {
+			R_ProfilePrintPercentiles( gpu, profile.numFrames );
+		}
+		ri.Printf( PRINT_ALL, "\n" );
+	}
+
+	overflowSpans = overflowFrames = 0;
+	for ( i = 0, frame = profile.frames ; i < profile.numFrames ; i++, frame++ ) {
+		if ( frame->overflowSpans ) {
+			overflowSpans += frame->overflowSpans;
+			overflowFrames++;
+		}
+	}
+	if ( overflowSpans ) {
+		ri.Printf( PRINT_WARNING, "profile: %i spans in %i frames went past the %i kept per frame; "
+			"they are in the cpu times but not in the trace or the gpu times\n",
+			overflowSpans, overflowFrames, MAX_PROFILE_SPANS );
+	}
+
+	ri.Printf( PRINT_ALL, "%-16s %10s %10s\n", "", "mean", "max" );
+	for ( j = 0 ; j < RPC_NUM_COUNTERS ; j++ ) {
+		total = 0;
+		max = 0;
+		for ( i = 0, frame = profile.frames ; i < profile.numFrames ; i++, frame++ ) {
+			total += frame->counters[j];
+			if ( frame->counters[j] > max ) {
+				max = frame->counters[j];
+			}
+		}
+		ri.Printf( PRINT_ALL, "%-16s %10.1f %10i\n", profileCounterNames[j], total / profile.numFrames, max );
+	}
+
+	ri.Free( gpu );
+	ri.Free( cpu );
+}
+
+/*
+====================
+R_ProfileStop
+====================
+*/
+static void R_ProfileStop( void ) {
+	int		i;
+
+	for ( i = 0 ; i < PROFILE_GPU_FRAMES ; i++ ) {
+		if ( profile.gpu ) {
+			R_ProfileResolveQueries( i );
+			qglDeleteQueries( MAX_PROFILE_SPANS * 2, profile.queries[i] );
+		}
+	}
+
+	if ( profile.numFrames ) {
+		R_ProfileReport();
+		if ( R_ProfileWrite( r_profileFile->string ) ) {
+			ri.Printf( PRINT_ALL, "profile: %i frames written to %s\n", profile.numFrames, r_profileFile->string );
+		}
+	} else {
+		ri.Printf( PRINT_ALL, "profile: no frames captured\n" );
+	}
+
+	ri.Free( profile.frames );
+	profile.frames = NULL;
+	profile.current = NULL;
+}
+
+/*
+====================
+R_ProfileBeginFrame
+
+Starts or stops the capture when r_profile changes, and starts timing
+the frame.  Frames without a world, such as the menus and the loading
+screen, are not captured.
+====================
+*/
+void R_ProfileBeginFrame( void ) {
+	int		slot, i;
+
+	if ( r_profile->modified ) {
+		r_profile->modified = false;
+
+		if ( r_profile->integer && !profile.frames ) {
+			R_ProfileStart();
+		} else if ( !r_profile->integer && profile.frames ) {
+			R_ProfileStop();
+		}
+	}
+
+	profile.current = NULL;
+	if ( !profile.frames || !tr.world ) {
+		return;
+	}
+
+	if ( profile.numFrames == MAX_PROFILE_FRAMES ) {
+		if ( !profile.full ) {
+			ri.Printf( PRINT_WARNING, "profile: stopped capturing after %i frames\n", MAX_PROFILE_FRAMES );
+			profile.full = true;
+		}
+		return;
+	}
+
+	// make room for this frame's timer queries
+	slot = profile.numFrames % PROFILE_GPU_FRAMES;
+	if ( profile.gpu ) {
+		R_ProfileResolveQueries( slot );
+	}
+
+	profile.frameTime = ri.Microseconds();
+
+	profile.current = &profile.frames[profile.numFrames];
+	profile.current->start = profile.frameTime - profile.startTime;
+	profile.current->usec = 0;
+	profile.current->numSpans = 0;
+	profile.current->overflowSpans = 0;
+	for ( i = 0 ; i < RP_NUM_PHASES ; i++ ) {
+		profile.current->cpuUsec[i] = profile.current->gpuUsec[i] = -1;
+	}
+	Com_Memset( profile.current->counters, 0, sizeof( profile.current->counters ) );
+	profile.numOverflow = 0;
+}
+
+/*
+====================
+R_ProfileFrontEndCounters
+
+Called by R_PerformanceCounters before the front end counters are cleared.
+====================
+*/
+void R_ProfileFrontEndCounters( void ) {
+	if ( !profile.current ) {
+		return;
+	}
+
+	profile.current->counters[RPC_LEAFS] = tr.pc.c_leafs;
+	profile.current->counters[RPC_WORLDSURFACES] = tr.pc.c_worldSurfaces;
+}
+
+/*
+====================
+R_ProfileEndFrame
+
+Called after the back end has run the frame, so backEnd.pc only holds
+this frame's work.
+====================
+*/
+void R_ProfileEndFrame( void ) {
+	profileFrame_t	*frame = profile.current;
+
+	if ( !frame ) {
+		return;
+	}
+
+	frame->usec = ri.Microseconds() - profile.frameTime;
+
+	frame->counters[RPC_SURFACES] = backEnd.pc.c_surfaces;
+	frame->counters[RPC_VERTEXES] = backEnd.pc.c_vertexes;
+	frame->counters[RPC_INDEXES] = backEnd.pc.c_indexes;
+	frame->counters[RPC_DRAWCALLS] = backEnd.pc.c_drawCalls;
+	frame->counters[RPC_STATECHANGES] = backEnd.pc.c_stateChanges;
+	frame->counters[RPC_TEXTUREBINDS] = backEnd.pc.c_textureBinds;
+	frame->counters[RPC_SHADERBINDS] = backEnd.pc.c_glslShaderBinds;
+	frame->counters[RPC_VAOBINDS] = backEnd.pc.c_vaoBinds;
+	frame->counters[RPC_VAOUPLOADS] = backEnd.pc.c_vaoUploads;
+	frame->counters[RPC_VAOUPLOADBYTES] = backEnd.pc.c_vaoUploadBytes;
+
+	if ( profile.gpu ) {
+		profile.queryFrame[profile.numFrames % PROFILE_GPU_FRAMES] = profile.numFrames;
+	}
+
+	profile.numFrames++;
+	profile.current = NULL;
+}
+
+/*
+====================
+R_ProfileBegin
+
+Returns the span to pass to R_ProfileEnd, or -1 when nothing is being
+captured.  Back end phases are also timed on the gpu.  Once a frame has
+used up its spans, or the front end its share of them, further spans
+only count towards the phase totals.
+====================
+*/
+int R_ProfileBegin( profilePhase_t phase ) {
+	profileFrame_t		*frame = profile.current;
+	profileSpan_t		*span;
+	profileOverflow_t	*overflow;
+	int					maxSpans;
+
+	if ( !frame ) {
+		return -1;
+	}
+
+	maxSpans = phase >= RP_BACKEND ? MAX_PROFILE_SPANS : MAX_PROFILE_SPANS - PROFILE_BACKEND_SPANS;
+	if ( frame->numSpans >= maxSpans ) {
+		frame->overflowSpans++;
+		if ( profile.numOverflow == MAX_PROFILE_OVERFLOW ) {
+			return -1;
+		}
+
+		overflow = &profile.overflow[profile.numOverflow];
+		overflow->phase = phase;
+		overflow->start = ri.Microseconds() - profile.frameTime;
+		return MAX_PROFILE_SPANS + profile.numOverflow++;
+	}
+
+	span = &frame->spans[frame->numSpans];
+	span->phase = phase;
+	span->start = ri.Microseconds() - profile.frameTime;
+	span->cpuUsec = 0;
+	span->gpuUsec = -1;
+
+	if ( profile.gpu && phase >= RP_BACKEND ) {
+		span->gpuUsec = 0;
+		qglQueryCounter( profile.queries[profile.numFrames % PROFILE_GPU_FRAMES][frame->numSpans * 2], GL_TIMESTAMP );
+	}
+
+	return frame->numSpans++;
+}
+
+/*
+====================
+R_ProfileAddTime
+====================
+*/
+static void R_ProfileAddTime( profileFrame_t *frame, int phase, int usec ) {
+	if ( frame->cpuUsec[phase] < 0 ) {
+		frame->cpuUsec[phase] = 0;
+	}
+	frame->cpuUsec[phase] += usec;
+}
+
+/*
+====================
+R_ProfileEnd
+====================
+*/
+void R_ProfileEnd( int spanNum ) {
+	profileFrame_t		*frame = profile.current;
+	profileSpan_t		*span;
+	profileOverflow_t	*overflow;
+
+	if ( !frame || spanNum < 0 ) {
+		return;
+	}
+
+	if ( spanNum >= MAX_PROFILE_SPANS ) {
+		// spans nest, so this is the innermost open one
+		profile.numOverflow = spanNum - MAX_PROFILE_SPANS;
+		overflow = &profile.overflow[profile.numOverflow];
+		R_ProfileAddTime( frame, overflow->phase, ri.Microseconds() - profile.frameTime - overflow->start );
+		return;
+	}
+
+	span = &frame->spans[spanNum];
+	span->cpuUsec = ri.Microseconds() - profile.frameTime - span->start;
+	R_ProfileAddTime( frame, span->phase, span->cpuUsec );
+
+	if ( span->gpuUsec >= 0 ) {
+		qglQueryCounter( profile.queries[profile.numFrames % PROFILE_GPU_FRAMES][spanNum * 2 + 1], GL_TIMESTAMP );
+	}
+}
+
+/*
+====================
+R_ProfileShutdown
+
+Writes out a capture that is still running, while the timer queries can
+still be read back.
+====================
+*/
+void R_ProfileShutdown( void ) {
+	if ( !profile.frames ) {
+		return;
+	}
+
+	R_ProfileStop();
+	ri.Cvar_Set( "r_profile", "0" );
+	r_profile->modified = false;
+}
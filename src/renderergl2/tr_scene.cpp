@@ -37,6 +37,9 @@ int			r_firstScenePoly;
 
 int			r_numpolyverts;
 
+std::atomic<int>	r_numAnimSurfaces;
+std::atomic<int>	r_numAnimVertexes;
+
 
 /*
 ====================
@@ -59,6 +62,9 @@ void R_InitNextFrame( void ) {
 	r_firstScenePoly = 0;
 
 	r_numpolyverts = 0;
+
+	r_numAnimSurfaces = 0;
+	r_numAnimVertexes = 0;
 }
 
 
@@ -95,8 +101,8 @@ void R_AddPolygonSurfaces( void ) {
 	srfPoly_t	*poly;
 	int		fogMask;
 
-	tr.currentEntityNum = REFENTITYNUM_WORLD;
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
+	fe->currentEntityNum = REFENTITYNUM_WORLD;
+	fe->shiftedEntityNum = fe->currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
 	fogMask = -((tr.refdef.rdflags & RDF_NOFOG) == 0);
 
 	for ( i = 0, poly = tr.refdef.polys; i < tr.refdef.numPolys ; i++, poly++ ) {
@@ -226,6 +232,7 @@ void RE_AddRefEntityToScene( const refEntity_t *ent ) {
 
 	backEndData->entities[r_numentities].e = *ent;
 	backEndData->entities[r_numentities].lightingCalculated = false;
+	backEndData->entities[r_numentities].animSurfaces = NULL;
 
 	CrossProduct(ent->axis[0], ent->axis[1], cross);
 	backEndData->entities[r_numentities].mirrored = (DotProduct(ent->axis[2], cross) < 0.f);
@@ -45,10 +45,48 @@ R_DrawElements
 
 void R_DrawElements( int numIndexes, glIndex_t firstIndex)
 {
+	backEnd.pc.c_drawCalls++;
+
 	qglDrawElements(GL_TRIANGLES, numIndexes, GL_INDEX_TYPE, BUFFER_OFFSET(firstIndex * sizeof(glIndex_t)));
 }
 
 
+/*
+==================
+R_DrawMultiElementsVao
+
+==================
+*/
+
+void R_DrawMultiElementsVao( int multiDrawPrimitives, GLsizei *multiDrawNumIndexes, glIndex_t **multiDrawFirstIndex )
+{
+	backEnd.pc.c_drawCalls++;
+
+	qglMultiDrawElements(GL_TRIANGLES, multiDrawNumIndexes, GL_INDEX_TYPE, (const GLvoid **)multiDrawFirstIndex, multiDrawPrimitives);
+}
+
+
+/*
+==================
+R_DrawTessElements
+
+Draws the static vao ranges gathered in tess, or its own indexes
+==================
+*/
+
+static void R_DrawTessElements( shaderCommands_t *input )
+{
+	if (input->multiDrawPrimitives)
+	{
+		R_DrawMultiElementsVao(input->multiDrawPrimitives, input->multiDrawNumIndexes, input->multiDrawFirstIndex);
+	}
+	else
+	{
+		R_DrawElements(input->numIndexes, input->firstIndex);
+	}
+}
+
+
 /*
 =============================================================
 
@@ -118,7 +156,7 @@ static void DrawTris (shaderCommands_t *input) {
 		GLSL_SetUniformVec4(sp, UNIFORM_COLOR, color);
 		GLSL_SetUniformInt(sp, UNIFORM_ALPHATEST, 0);
 
-		R_DrawElements(input->numIndexes, input->firstIndex);
+		R_DrawTessElements(input);
 	}
 
 	qglDepthRange( 0, 1 );
@@ -152,6 +190,7 @@ void RB_BeginSurface( shader_t *shader, int fogNum, int cubemapIndex ) {
 	tess.numIndexes = 0;
 	tess.firstIndex = 0;
 	tess.numVertexes = 0;
+	tess.multiDrawPrimitives = 0;
 	tess.shader = state;
 	tess.fogNum = fogNum;
 	tess.cubemapIndex = cubemapIndex;
@@ -387,7 +426,7 @@ static void ProjectDlightTexture( void ) {
 
 		GLSL_SetUniformInt(sp, UNIFORM_ALPHATEST, 1);
 
-		R_DrawElements(tess.numIndexes, tess.firstIndex);
+		R_DrawTessElements(&tess);
 
 		backEnd.pc.c_totalIndexes += tess.numIndexes;
 		backEnd.pc.c_dlightIndexes += tess.numIndexes;
@@ -801,7 +840,7 @@ static void ForwardDlight( void ) {
 		// draw
 		//
 
-		R_DrawElements(input->numIndexes, input->firstIndex);
+		R_DrawTessElements(input);
 
 		backEnd.pc.c_totalIndexes += tess.numIndexes;
 		backEnd.pc.c_dlightIndexes += tess.numIndexes;
@@ -871,7 +910,7 @@ static void ProjectPshadowVBOGLSL( void ) {
 		// draw
 		//
 
-		R_DrawElements(input->numIndexes, input->firstIndex);
+		R_DrawTessElements(input);
 
 		backEnd.pc.c_totalIndexes += tess.numIndexes;
 		//backEnd.pc.c_dlightIndexes += tess.numIndexes;
@@ -907,6 +946,8 @@ static void RB_FogPass( void ) {
 
 		if (glState.vertexAnimation)
 			index |= FOGDEF_USE_VERTEX_ANIMATION;
+		else if (glState.boneAnimation)
+			index |= FOGDEF_USE_BONE_ANIMATION;
 		
 		sp = &tr.fogShader[index];
 	}
@@ -920,6 +961,11 @@ static void RB_FogPass( void ) {
 	GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
 
 	GLSL_SetUniformFloat(sp, UNIFORM_VERTEXLERP, glState.vertexAttribsInterpolation);
+
+	if (glState.boneAnimation)
+	{
+		GLSL_SetUniformMat4BoneMatrix(sp, UNIFORM_BONEMATRIX, glState.boneMatrix, glState.boneAnimation);
+	}
 	
 	GLSL_SetUniformInt(sp, UNIFORM_DEFORMGEN, deformGen);
 	if (deformGen != DGEN_NONE)
@@ -947,7 +993,7 @@ static void RB_FogPass( void ) {
 	}
 	GLSL_SetUniformInt(sp, UNIFORM_ALPHATEST, 0);
 
-	R_DrawElements(tess.numIndexes, tess.firstIndex);
+	R_DrawTessElements(&tess);
 }
 
 
@@ -1004,7 +1050,10 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 
 				if (backEnd.currentEntity && backEnd.currentEntity != &tr.worldEntity)
 				{
-					index |= LIGHTDEF_ENTITY;
+					if (glState.boneAnimation)
+						index |= LIGHTDEF_ENTITY_BONE_ANIMATION;
+					else
+						index |= LIGHTDEF_ENTITY_VERTEX_ANIMATION;
 				}
 
 				if (pStage->stateBits & GLS_ATEST_BITS)
@@ -1027,6 +1076,10 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 				{
 					shaderAttribs |= GENERICDEF_USE_VERTEX_ANIMATION;
 				}
+				else if (glState.boneAnimation)
+				{
+					shaderAttribs |= GENERICDEF_USE_BONE_ANIMATION;
+				}
 
 				if (pStage->stateBits & GLS_ATEST_BITS)
 				{
@@ -1042,7 +1095,10 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 
 			if (backEnd.currentEntity && backEnd.currentEntity != &tr.worldEntity)
 			{
-				index |= LIGHTDEF_ENTITY;
+				if (glState.boneAnimation)
+					index |= LIGHTDEF_ENTITY_BONE_ANIMATION;
+				else
+					index |= LIGHTDEF_ENTITY_VERTEX_ANIMATION;
 			}
 
 			if (r_sunlightMode->integer && (backEnd.viewParms.flags & VPF_USESUNLIGHT) && (index & LIGHTDEF_LIGHTTYPE_MASK))
@@ -1073,6 +1129,11 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 		GLSL_SetUniformVec3(sp, UNIFORM_LOCALVIEWORIGIN, backEnd.orientation.viewOrigin);
 
 		GLSL_SetUniformFloat(sp, UNIFORM_VERTEXLERP, glState.vertexAttribsInterpolation);
+
+		if (glState.boneAnimation)
+		{
+			GLSL_SetUniformMat4BoneMatrix(sp, UNIFORM_BONEMATRIX, glState.boneMatrix, glState.boneAnimation);
+		}
 		
 		GLSL_SetUniformInt(sp, UNIFORM_DEFORMGEN, deformGen);
 		if (deformGen != DGEN_NONE)
@@ -1304,7 +1365,7 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 						GL_BindToTMU( tr.whiteImage, TB_SPECULARMAP );
 				}
 
-				enableTextures[3] = (r_cubeMapping->integer && !(tr.viewParms.flags & VPF_NOCUBEMAPS) && input->cubemapIndex) ? 1.0f : 0.0f;
+				enableTextures[3] = (r_cubeMapping->integer && !(fe->viewParms.flags & VPF_NOCUBEMAPS) && input->cubemapIndex) ? 1.0f : 0.0f;
 			}
 
 			GLSL_SetUniformVec4(sp, UNIFORM_ENABLETEXTURES, enableTextures);
@@ -1325,7 +1386,7 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 		//
 		// testing cube map
 		//
-		if (!(tr.viewParms.flags & VPF_NOCUBEMAPS) && input->cubemapIndex && r_cubeMapping->integer)
+		if (!(fe->viewParms.flags & VPF_NOCUBEMAPS) && input->cubemapIndex && r_cubeMapping->integer)
 		{
 			vec4_t vec;
 			cubemap_t *cubemap = &tr.cubemaps[input->cubemapIndex - 1];
@@ -1345,7 +1406,7 @@ static void RB_IterateStagesGeneric( shaderCommands_t *input )
 		//
 		// draw
 		//
-		R_DrawElements(input->numIndexes, input->firstIndex);
+		R_DrawTessElements(input);
 
 		// allow skipping out to show just lightmaps during development
 		if ( r_lightmap->integer && ( pStage->bundle[0].isLightmap || pStage->bundle[1].isLightmap ) )
@@ -1367,10 +1428,18 @@ static void RB_RenderShadowmap( shaderCommands_t *input )
 	ComputeDeformValues(&deformGen, deformParams);
 
 	{
-		shaderProgram_t *sp = &tr.shadowmapShader;
+		shaderProgram_t *sp;
+		int index = 0;
 
 		vec4_t vector;
 
+		if (glState.vertexAnimation)
+			index |= SHADOWMAPDEF_USE_VERTEX_ANIMATION;
+		else if (glState.boneAnimation)
+			index |= SHADOWMAPDEF_USE_BONE_ANIMATION;
+
+		sp = &tr.shadowmapShader[index];
+
 		GLSL_BindProgram(sp);
 
 		GLSL_SetUniformMat4(sp, UNIFORM_MODELVIEWPROJECTIONMATRIX, glState.modelviewProjection);
@@ -1379,6 +1448,11 @@ static void RB_RenderShadowmap( shaderCommands_t *input )
 
 		GLSL_SetUniformFloat(sp, UNIFORM_VERTEXLERP, glState.vertexAttribsInterpolation);
 
+		if (glState.boneAnimation)
+		{
+			GLSL_SetUniformMat4BoneMatrix(sp, UNIFORM_BONEMATRIX, glState.boneMatrix, glState.boneAnimation);
+		}
+
 		GLSL_SetUniformInt(sp, UNIFORM_DEFORMGEN, deformGen);
 		if (deformGen != DGEN_NONE)
 		{
@@ -1403,7 +1477,7 @@ static void RB_RenderShadowmap( shaderCommands_t *input )
 			// draw
 			//
 
-			R_DrawElements(input->numIndexes, input->firstIndex);
+			R_DrawTessElements(input);
 		}
 	}
 }
@@ -1629,6 +1703,7 @@ void RB_EndSurface( void ) {
 	tess.numIndexes = 0;
 	tess.numVertexes = 0;
 	tess.firstIndex = 0;
+	tess.multiDrawPrimitives = 0;
 
 	GLimp_LogComment( "----------\n" );
 }
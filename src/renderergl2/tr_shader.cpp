@@ -3112,8 +3112,8 @@ static shader_t *FinishShader( void ) {
 ====================
 FindShaderInShaderText
 
-Scans the combined text description of all the shader files for
-the given shader name.
+Looks the given shader name up in the index of the combined text
+description of all the shader files.
 
 return NULL if not found
 
@@ -3128,6 +3128,7 @@ static char *FindShaderInShaderText( const char *shadername ) {
 
 	hash = generateHashValue(shadername, MAX_SHADERTEXT_HASH);
 
+	// the table holds every shader in the text, so a miss here is final
 	if(shaderTextHashTable[hash])
 	{
 		for (i = 0; shaderTextHashTable[hash][i]; i++)
@@ -3140,29 +3141,148 @@ static char *FindShaderInShaderText( const char *shadername ) {
 		}
 	}
 
-	p = s_shaderText;
+	return NULL;
+}
+
+
+/*
+===============
+R_RequestShaderImages
+
+Queues the images R_FindShader( name, ..., mipRawImage ) is going to ask
+for, so the job threads can decode them ahead of the shader being parsed.
+Only the keywords that load images are looked at; anything the parse
+gets wrong just means the image is loaded the usual way.
+===============
+*/
+void R_RequestShaderImages( const char *name, bool mipRawImage ) {
+	const char	*suf[6] = {"rt", "bk", "lf", "ft", "up", "dn"};
+	char		strippedName[MAX_QPATH];
+	char		pathname[MAX_QPATH];
+	char		*text, *token;
+	bool		noMipMaps = false, noPicMip = false;
+	int			stageType = ST_COLORMAP;
+	imgType_t	type;
+	int			depth, i, box;
+	int/*imgFlags_t*/ flags;
+
+	if ( !r_imageJobs->integer || !name || !name[0] ) {
+		return;
+	}
+
+	// DDS files are looked for first and are not decoded on the jobs
+	if ( r_ext_compressed_textures->integer ) {
+		return;
+	}
+
+	COM_StripExtension( name, strippedName, sizeof( strippedName ) );
 
-	if ( !p ) {
-		return NULL;
+	text = FindShaderInShaderText( strippedName );
+	if ( !text ) {
+		flags = mipRawImage ? ( IMGFLAG_MIPMAP | IMGFLAG_PICMIP | ( r_genNormalMaps->integer ? IMGFLAG_GENNORMALMAP : 0 ) ) : IMGFLAG_CLAMPTOEDGE;
+		R_RequestImage( name, IMGTYPE_COLORALPHA, flags );
+		return;
 	}
 
-	// look for label
+	depth = 0;
 	while ( 1 ) {
-		token = COM_ParseExt( &p, qtrue );
-		if ( token[0] == 0 ) {
+		token = COM_ParseExt( &text, qtrue );
+		if ( !token[0] ) {
 			break;
 		}
 
-		if ( !Q_stricmp( token, shadername ) ) {
-			return p;
+		if ( token[0] == '{' ) {
+			depth++;
+			if ( depth == 2 ) {
+				stageType = ST_COLORMAP;
+			}
+			continue;
 		}
-		else {
-			// skip the definition
-			SkipBracedSection( &p, 0 );
+		if ( token[0] == '}' ) {
+			if ( --depth <= 0 ) {
+				break;
+			}
+			continue;
 		}
-	}
 
-	return NULL;
+		if ( depth == 1 ) {
+			if ( !Q_stricmp( token, "nomipmaps" ) ) {
+				noMipMaps = true;
+				noPicMip = true;
+			} else if ( !Q_stricmp( token, "nopicmip" ) ) {
+				noPicMip = true;
+			} else if ( !Q_stricmp( token, "skyParms" ) ) {
+				// outerbox, cloudheight, innerbox
+				for ( box = 0 ; box < 3 ; box++ ) {
+					token = COM_ParseExt( &text, qfalse );
+					if ( !token[0] ) {
+						break;
+					}
+					if ( box == 1 || !strcmp( token, "-" ) ) {
+						continue;
+					}
+					for ( i = 0 ; i < 6 ; i++ ) {
+						Com_sprintf( pathname, sizeof( pathname ), "%s_%s.tga", token, suf[i] );
+						R_RequestImage( pathname, IMGTYPE_COLORALPHA,
+							IMGFLAG_MIPMAP | IMGFLAG_PICMIP | ( box == 0 ? IMGFLAG_CLAMPTOEDGE : 0 ) );
+					}
+				}
+			}
+			continue;
+		}
+
+		if ( depth != 2 ) {
+			continue;
+		}
+
+		flags = IMGFLAG_NONE;
+		if ( !noMipMaps )
+			flags |= IMGFLAG_MIPMAP;
+		if ( !noPicMip )
+			flags |= IMGFLAG_PICMIP;
+
+		if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "clampmap" ) ) {
+			if ( !Q_stricmp( token, "clampmap" ) )
+				flags |= IMGFLAG_CLAMPTOEDGE;
+
+			token = COM_ParseExt( &text, qfalse );
+			if ( !token[0] || token[0] == '$' ) {
+				continue;
+			}
+
+			type = IMGTYPE_COLORALPHA;
+			if ( stageType == ST_NORMALMAP || stageType == ST_NORMALPARALLAXMAP ) {
+				type = stageType == ST_NORMALPARALLAXMAP ? IMGTYPE_NORMALHEIGHT : IMGTYPE_NORMAL;
+				flags |= IMGFLAG_NOLIGHTSCALE;
+			} else if ( r_genNormalMaps->integer ) {
+				flags |= IMGFLAG_GENNORMALMAP;
+			}
+
+			R_RequestImage( token, type, flags );
+		} else if ( !Q_stricmp( token, "animMap" ) ) {
+			// skip the frequency
+			token = COM_ParseExt( &text, qfalse );
+			if ( !token[0] ) {
+				continue;
+			}
+			for ( i = 0 ; i < MAX_IMAGE_ANIMATIONS ; i++ ) {
+				token = COM_ParseExt( &text, qfalse );
+				if ( !token[0] ) {
+					break;
+				}
+				R_RequestImage( token, IMGTYPE_COLORALPHA, flags );
+			}
+		} else if ( !Q_stricmp( token, "stage" ) ) {
+			token = COM_ParseExt( &text, qfalse );
+			if ( !Q_stricmp( token, "normalMap" ) || !Q_stricmp( token, "bumpMap" ) ) {
+				stageType = ST_NORMALMAP;
+			} else if ( !Q_stricmp( token, "normalParallaxMap" ) || !Q_stricmp( token, "bumpParallaxMap" ) ) {
+				stageType = r_parallaxMapping->integer ? ST_NORMALPARALLAXMAP : ST_NORMALMAP;
+			} else if ( token[0] ) {
+				stageType = ST_COLORMAP;
+			}
+		}
+	}
 }
 
 
@@ -3647,15 +3767,64 @@ a single large text block that can be scanned for shader names
 =====================
 */
 #define	MAX_SHADER_FILES	4096
+/*
+====================
+R_IndexShaderText
+
+Fills shaderTextHashTable from the position of every shader name in
+s_shaderText.  Every shader is in the table, so a name that is not
+there is not in the text either.
+====================
+*/
+static void R_IndexShaderText( const int *starts, int numStarts )
+{
+	char *p, *token, *hashMem;
+	int shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
+	int i;
+
+	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
+
+	for ( i = 0; i < numStarts; i++ ) {
+		p = s_shaderText + starts[i];
+		token = COM_ParseExt( &p, qtrue );
+
+		hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
+		shaderTextHashTableSizes[hash]++;
+	}
+
+	size = numStarts + MAX_SHADERTEXT_HASH;
+
+	hashMem = (char*)ri.Hunk_Alloc( size * sizeof(char *), h_low );
+
+	for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
+		shaderTextHashTable[i] = (char **) hashMem;
+		hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
+	}
+
+	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
+
+	for ( i = 0; i < numStarts; i++ ) {
+		p = s_shaderText + starts[i];
+		token = COM_ParseExt( &p, qtrue );
+
+		hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
+		shaderTextHashTable[hash][shaderTextHashTableSizes[hash]++] = s_shaderText + starts[i];
+	}
+}
+
 static void ScanAndLoadShaderFiles( void )
 {
 	char **shaderFiles;
 	char *buffers[MAX_SHADER_FILES] = {NULL};
+	char (*filenames)[MAX_QPATH];
 	char *p;
 	int numShaderFiles;
 	int i;
-	char *oldp, *token, *hashMem, *textEnd;
-	int shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
+	char *token, *textEnd;
+	int size;
+	int *starts, numStarts;
+	uint64_t cacheKey;
+	bool cacheable;
 	char shaderName[MAX_QPATH];
 	int shaderLine;
 
@@ -3673,35 +3842,52 @@ static void ScanAndLoadShaderFiles( void )
 		numShaderFiles = MAX_SHADER_FILES;
 	}
 
-	// load and parse shader files
+	filenames = (char (*)[MAX_QPATH])ri.Hunk_AllocateTempMemory( numShaderFiles * sizeof( *filenames ) );
+
 	for ( i = 0; i < numShaderFiles; i++ )
 	{
-		char filename[MAX_QPATH];
-
 		// look for a .mtr file first
 		{
 			char *ext;
-			Com_sprintf( filename, sizeof( filename ), "scripts/%s", shaderFiles[i] );
-			if ( (ext = strrchr(filename, '.')) )
+			Com_sprintf( filenames[i], sizeof( filenames[i] ), "scripts/%s", shaderFiles[i] );
+			if ( (ext = strrchr(filenames[i], '.')) )
 			{
 				strcpy(ext, ".mtr");
 			}
 
-			if ( ri.FS_ReadFile( filename, NULL ) <= 0 )
+			if ( ri.FS_ReadFile( filenames[i], NULL ) <= 0 )
 			{
-				Com_sprintf( filename, sizeof( filename ), "scripts/%s", shaderFiles[i] );
+				Com_sprintf( filenames[i], sizeof( filenames[i] ), "scripts/%s", shaderFiles[i] );
 			}
 		}
+	}
+
+	// free up memory
+	ri.FS_FreeFileList( shaderFiles );
+
+	// if the same files come from the same paks as last time, the
+	// text and the index can be read back in one go
+	cacheable = R_ShaderCacheKey( filenames, numShaderFiles, &cacheKey );
+	if ( cacheable && R_LoadShaderCache( cacheKey, numShaderFiles, &s_shaderText, &starts, &numStarts ) )
+	{
+		ri.Hunk_FreeTempMemory( filenames );
+		R_IndexShaderText( starts, numStarts );
+		ri.Free( starts );
+		return;
+	}
 
-		ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", filename );
-		summand = ri.FS_ReadFile( filename, (void **)&buffers[i] );
+	// load and parse shader files
+	for ( i = 0; i < numShaderFiles; i++ )
+	{
+		ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", filenames[i] );
+		summand = ri.FS_ReadFile( filenames[i], (void **)&buffers[i] );
 
 		if ( !buffers[i] )
-			ri.Error( ERR_DROP, "Couldn't load %s", filename );
+			ri.Error( ERR_DROP, "Couldn't load %s", filenames[i] );
 
 		// Do a simple check on the shader structure in that file to make sure one bad shader file cannot fuck up all other shaders.
 		p = buffers[i];
-		COM_BeginParseSession(filename);
+		COM_BeginParseSession(filenames[i]);
 		while(1)
 		{
 			token = COM_ParseExt(&p, qtrue);
@@ -3716,7 +3902,7 @@ static void ScanAndLoadShaderFiles( void )
 			if(token[0] != '{' || token[1] != '\0')
 			{
 				ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing opening brace",
-							filename, shaderName, shaderLine);
+							filenames[i], shaderName, shaderLine);
 				if (token[0])
 				{
 					ri.Printf(PRINT_WARNING, " (found \"%s\" on line %d)", token, COM_GetCurrentParseLine());
@@ -3730,7 +3916,7 @@ static void ScanAndLoadShaderFiles( void )
 			if(!SkipBracedSection(&p, 1))
 			{
 				ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing closing brace.\n",
-							filename, shaderName, shaderLine);
+							filenames[i], shaderName, shaderLine);
 				ri.FS_FreeFile(buffers[i]);
 				buffers[i] = NULL;
 				break;
@@ -3759,56 +3945,46 @@ static void ScanAndLoadShaderFiles( void )
 		ri.FS_FreeFile( buffers[i] );
 	}
 
-	COM_Compress( s_shaderText );
+	ri.Hunk_FreeTempMemory( filenames );
 
-	// free up memory
-	ri.FS_FreeFileList( shaderFiles );
+	COM_Compress( s_shaderText );
 
-	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
 	size = 0;
 
 	p = s_shaderText;
-	// look for shader names
+	// count shader names
 	while ( 1 ) {
 		token = COM_ParseExt( &p, qtrue );
 		if ( token[0] == 0 ) {
 			break;
 		}
 
-		hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-		shaderTextHashTableSizes[hash]++;
 		size++;
 		SkipBracedSection(&p, 0);
 	}
 
-	size += MAX_SHADERTEXT_HASH;
-
-	hashMem = (char*)ri.Hunk_Alloc( size * sizeof(char *), h_low );
-
-	for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
-		shaderTextHashTable[i] = (char **) hashMem;
-		hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
-	}
-
-	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
+	starts = (int *)ri.Malloc( ( size + 1 ) * sizeof( int ) );
+	numStarts = 0;
 
 	p = s_shaderText;
 	// look for shader names
 	while ( 1 ) {
-		oldp = p;
+		starts[numStarts] = p - s_shaderText;
 		token = COM_ParseExt( &p, qtrue );
 		if ( token[0] == 0 ) {
 			break;
 		}
 
-		hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-		shaderTextHashTable[hash][shaderTextHashTableSizes[hash]++] = oldp;
-
+		numStarts++;
 		SkipBracedSection(&p, 0);
 	}
 
-	return;
+	R_IndexShaderText( starts, numStarts );
+
+	if ( cacheable )
+		R_SaveShaderCache( cacheKey, numShaderFiles, s_shaderText, starts, numStarts );
 
+	ri.Free( starts );
 }
 
 
@@ -70,7 +70,7 @@ void RB_CheckOverflow( int verts, int indexes ) {
 
 void RB_CheckVao(vao_t *vao)
 {
-	if (vao != glState.currentVao)
+	if (vao != glState.currentVao || tess.multiDrawPrimitives >= MAX_MULTIDRAW_PRIMITIVES)
 	{
 		RB_EndSurface();
 		RB_BeginSurface(tess.shader, tess.fogNum, tess.cubemapIndex);
@@ -408,6 +408,105 @@ static void RB_SurfaceVertsAndIndexes( int numVerts, srfVert_t *verts, int numIn
 	tess.numVertexes += numVerts;
 }
 
+/*
+=============
+RB_SurfaceVao
+
+Adds the index range of a surface packed into a static vao, joined to
+the range before or after it when they touch, so a run of neighbouring
+surfaces is drawn as one primitive
+=============
+*/
+static bool RB_SurfaceVao(vao_t *vao, int numVerts, int numIndexes, int firstIndex, int dlightBits, int pshadowBits)
+{
+	int i, mergeForward, mergeBack;
+	glIndex_t *firstIndexOffset, *lastIndexOffset;
+
+	if (!vao)
+		return false;
+
+	if (!(!ShaderRequiresCPUDeforms(tess.shader) && !tess.shader->isSky && !tess.shader->isPortal))
+		return false;
+
+	// don't mix with surfaces that were copied into tess or the vao cache
+	if (tess.numIndexes && !tess.multiDrawPrimitives)
+	{
+		RB_EndSurface();
+		RB_BeginSurface(tess.shader, tess.fogNum, tess.cubemapIndex);
+	}
+
+	RB_CheckVao(vao);
+
+	tess.dlightBits |= dlightBits;
+	tess.pshadowBits |= pshadowBits;
+
+	// merge this into any existing multidraw primitives
+	mergeForward = -1;
+	mergeBack = -1;
+	firstIndexOffset = (glIndex_t *)BUFFER_OFFSET(firstIndex * sizeof(glIndex_t));
+	lastIndexOffset  = (glIndex_t *)BUFFER_OFFSET((firstIndex + numIndexes) * sizeof(glIndex_t));
+
+	if (r_mergeMultidraws->integer)
+	{
+		i = 0;
+
+		// lazy merge, only check the last primitive
+		if (r_mergeMultidraws->integer == 1 && tess.multiDrawPrimitives)
+			i = tess.multiDrawPrimitives - 1;
+
+		for (; i < tess.multiDrawPrimitives; i++)
+		{
+			if (tess.multiDrawLastIndex[i] == firstIndexOffset)
+				mergeBack = i;
+
+			if (lastIndexOffset == tess.multiDrawFirstIndex[i])
+				mergeForward = i;
+		}
+	}
+
+	if (mergeBack != -1 && mergeForward == -1)
+	{
+		tess.multiDrawNumIndexes[mergeBack] += numIndexes;
+		tess.multiDrawLastIndex[mergeBack] = lastIndexOffset;
+		backEnd.pc.c_multidrawsMerged++;
+	}
+	else if (mergeBack == -1 && mergeForward != -1)
+	{
+		tess.multiDrawNumIndexes[mergeForward] += numIndexes;
+		tess.multiDrawFirstIndex[mergeForward] = firstIndexOffset;
+		backEnd.pc.c_multidrawsMerged++;
+	}
+	else if (mergeBack != -1 && mergeForward != -1)
+	{
+		// fills the gap between two primitives, so join all three
+		tess.multiDrawNumIndexes[mergeBack] += numIndexes + tess.multiDrawNumIndexes[mergeForward];
+		tess.multiDrawLastIndex[mergeBack] = tess.multiDrawLastIndex[mergeForward];
+
+		tess.multiDrawPrimitives--;
+		if (mergeForward != tess.multiDrawPrimitives)
+		{
+			tess.multiDrawNumIndexes[mergeForward] = tess.multiDrawNumIndexes[tess.multiDrawPrimitives];
+			tess.multiDrawFirstIndex[mergeForward] = tess.multiDrawFirstIndex[tess.multiDrawPrimitives];
+			tess.multiDrawLastIndex[mergeForward] = tess.multiDrawLastIndex[tess.multiDrawPrimitives];
+		}
+		backEnd.pc.c_multidrawsMerged += 2;
+	}
+	else
+	{
+		tess.multiDrawNumIndexes[tess.multiDrawPrimitives] = numIndexes;
+		tess.multiDrawFirstIndex[tess.multiDrawPrimitives] = firstIndexOffset;
+		tess.multiDrawLastIndex[tess.multiDrawPrimitives] = lastIndexOffset;
+		tess.multiDrawPrimitives++;
+	}
+
+	backEnd.pc.c_multidraws++;
+
+	tess.numIndexes  += numIndexes;
+	tess.numVertexes += numVerts;
+
+	return true;
+}
+
 static bool RB_SurfaceVaoCached(int numVerts, srfVert_t *verts, int numIndexes, glIndex_t *indexes, int dlightBits, int pshadowBits)
 {
 	bool recycleVertexBuffer = false;
@@ -420,6 +519,13 @@ static bool RB_SurfaceVaoCached(int numVerts, srfVert_t *verts, int numIndexes,
 	if (!numIndexes || !numVerts)
 		return false;
 
+	// don't mix with ranges of a static vao
+	if (tess.multiDrawPrimitives)
+	{
+		RB_EndSurface();
+		RB_BeginSurface(tess.shader, tess.fogNum, tess.cubemapIndex);
+	}
+
 	VaoCache_BindVao();
 
 	tess.dlightBits |= dlightBits;
@@ -458,6 +564,12 @@ RB_SurfaceTriangles
 =============
 */
 static void RB_SurfaceTriangles( srfBspSurface_t *srf ) {
+	if (RB_SurfaceVao(srf->vao, srf->numVerts, srf->numIndexes, srf->firstIndex,
+		srf->dlightBits, srf->pshadowBits))
+	{
+		return;
+	}
+
 	if (RB_SurfaceVaoCached(srf->numVerts, srf->verts, srf->numIndexes,
 		srf->indexes, srf->dlightBits, srf->pshadowBits))
 	{
@@ -893,6 +1005,12 @@ RB_SurfaceFace
 ==============
 */
 static void RB_SurfaceFace( srfBspSurface_t *srf ) {
+	if (RB_SurfaceVao(srf->vao, srf->numVerts, srf->numIndexes, srf->firstIndex,
+		srf->dlightBits, srf->pshadowBits))
+	{
+		return;
+	}
+
 	if (RB_SurfaceVaoCached(srf->numVerts, srf->verts, srf->numIndexes,
 		srf->indexes, srf->dlightBits, srf->pshadowBits))
 	{
@@ -961,6 +1079,12 @@ static void RB_SurfaceGrid( srfBspSurface_t *srf ) {
 	int     pshadowBits;
 	//int		*vDlightBits;
 
+	if (RB_SurfaceVao(srf->vao, srf->numVerts, srf->numIndexes, srf->firstIndex,
+		srf->dlightBits, srf->pshadowBits))
+	{
+		return;
+	}
+
 	if (RB_SurfaceVaoCached(srf->numVerts, srf->verts, srf->numIndexes,
 		srf->indexes, srf->dlightBits, srf->pshadowBits))
 	{
@@ -1317,4 +1441,5 @@ void (*rb_surfaceTable[SF_NUM_SURFACE_TYPES])( void *) = {
 	(void(*)(void*))RB_SurfaceFlare,		// SF_FLARE,
 	(void(*)(void*))RB_SurfaceEntity,		// SF_ENTITY
 	(void(*)(void*))RB_SurfaceVaoMdvMesh,   // SF_VAO_MDVMESH
+	(void(*)(void*))RB_IQMSurfaceAnimVao,   // SF_VAO_IQM
 };
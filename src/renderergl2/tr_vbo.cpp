@@ -355,6 +355,7 @@ void R_BindVao(vao_t * vao)
 
 		glState.vertexAttribsInterpolation = 0;
 		glState.vertexAnimation = false;
+		glState.boneAnimation = 0;
 		backEnd.pc.c_vaoBinds++;
 
 		if (glRefConfig.vertexArrayObject)
@@ -624,6 +625,7 @@ void RB_UpdateTessVao(unsigned int attribBits)
 			{
 				// note: tess has a VBO where stride == size
 				qglBufferSubData(GL_ARRAY_BUFFER, vAtb->offset, tess.numVertexes * vAtb->stride, tess.attribPointers[attribIndex]);
+				backEnd.pc.c_vaoUploadBytes += tess.numVertexes * vAtb->stride;
 			}
 
 			if (attribBits & attribBit)
@@ -651,6 +653,8 @@ void RB_UpdateTessVao(unsigned int attribBits)
 		qglBufferData(GL_ELEMENT_ARRAY_BUFFER, tess.vao->indexesSize, NULL, GL_DYNAMIC_DRAW);
 
 		qglBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, tess.numIndexes * sizeof(tess.indexes[0]), tess.indexes);
+		backEnd.pc.c_vaoUploadBytes += tess.numIndexes * sizeof(tess.indexes[0]);
+		backEnd.pc.c_vaoUploads++;
 	}
 }
 
@@ -779,6 +783,7 @@ void VaoCache_Commit(void)
 		{
 			qglBindBuffer(GL_ARRAY_BUFFER, vc.vao->vertexesVBO);
 			qglBufferSubData(GL_ARRAY_BUFFER, vc.vertexOffset, vc.vertexCommitSize, vc.vertexes);
+			backEnd.pc.c_vaoUploadBytes += vc.vertexCommitSize;
 			vc.vertexOffset += vc.vertexCommitSize;
 		}
 
@@ -786,8 +791,11 @@ void VaoCache_Commit(void)
 		{
 			qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vc.vao->indexesIBO);
 			qglBufferSubData(GL_ELEMENT_ARRAY_BUFFER, vc.indexOffset, vc.indexCommitSize, vc.indexes);
+			backEnd.pc.c_vaoUploadBytes += vc.indexCommitSize;
 			vc.indexOffset += vc.indexCommitSize;
 		}
+
+		backEnd.pc.c_vaoUploads++;
 	}
 }
 
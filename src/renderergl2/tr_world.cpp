@@ -23,6 +23,13 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 */
 #include "tr_local.h"
 
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define	WORLD_SIMD			1
+#include <xmmintrin.h>
+#else
+#define	WORLD_SIMD			0
+#endif
+
 
 
 /*
@@ -61,14 +68,14 @@ static bool	R_CullSurface( msurface_t *surf ) {
 
 		// don't cull for depth shadow
 		/*
-		if ( tr.viewParms.flags & VPF_DEPTHSHADOW )
+		if ( fe->viewParms.flags & VPF_DEPTHSHADOW )
 		{
 			return false;
 		}
 		*/
 
 		// shadowmaps draw back surfaces
-		if ( tr.viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW) )
+		if ( fe->viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW) )
 		{
 			if (ct == CT_FRONT_SIDED)
 			{
@@ -81,8 +88,8 @@ static bool	R_CullSurface( msurface_t *surf ) {
 		}
 
 		// do proper cull for orthographic projection
-		if (tr.viewParms.flags & VPF_ORTHOGRAPHIC) {
-			d = DotProduct(tr.viewParms.orientation.axis[0], surf->cullinfo.plane.normal);
+		if (fe->viewParms.flags & VPF_ORTHOGRAPHIC) {
+			d = DotProduct(fe->viewParms.orientation.axis[0], surf->cullinfo.plane.normal);
 			if ( ct == CT_FRONT_SIDED ) {
 				if (d > 0)
 					return true;
@@ -93,7 +100,7 @@ static bool	R_CullSurface( msurface_t *surf ) {
 			return false;
 		}
 
-		d = DotProduct (tr.orientation.viewOrigin, surf->cullinfo.plane.normal);
+		d = DotProduct (fe->orientation.viewOrigin, surf->cullinfo.plane.normal);
 
 		// don't cull exactly on the plane, because there are levels of rounding
 		// through the BSP, ICD, and hardware that may cause pixel gaps if an
@@ -115,7 +122,7 @@ static bool	R_CullSurface( msurface_t *surf ) {
 	{
 		int 	sphereCull;
 
-		if ( tr.currentEntityNum != REFENTITYNUM_WORLD ) {
+		if ( fe->currentEntityNum != REFENTITYNUM_WORLD ) {
 			sphereCull = R_CullLocalPointAndRadius( surf->cullinfo.localOrigin, surf->cullinfo.radius );
 		} else {
 			sphereCull = R_CullPointAndRadius( surf->cullinfo.localOrigin, surf->cullinfo.radius );
@@ -131,7 +138,7 @@ static bool	R_CullSurface( msurface_t *surf ) {
 	{
 		int boxCull;
 
-		if ( tr.currentEntityNum != REFENTITYNUM_WORLD ) {
+		if ( fe->currentEntityNum != REFENTITYNUM_WORLD ) {
 			boxCull = R_CullLocalBox( surf->cullinfo.bounds );
 		} else {
 			boxCull = R_CullBox( surf->cullinfo.bounds );
@@ -156,7 +163,7 @@ that is touched by one or more dlights, so try to throw out
 more dlights if possible.
 ====================
 */
-static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
+static int R_DlightSurface( msurface_t *surf, int dlightBits, frontEndCounters_t *pc ) {
 	float       d;
 	int         i;
 	dlight_t    *dl;
@@ -224,9 +231,9 @@ static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
 	}
 
 	if ( dlightBits ) {
-		tr.pc.c_dlightSurfaces++;
+		pc->c_dlightSurfaces++;
 	} else {
-		tr.pc.c_dlightSurfacesCulled++;
+		pc->c_dlightSurfacesCulled++;
 	}
 
 	return dlightBits;
@@ -318,30 +325,44 @@ static int R_PshadowSurface( msurface_t *surf, int pshadowBits ) {
 
 /*
 ======================
-R_AddWorldSurface
+R_PrepareWorldSurface
+
+Returns false if the surface is culled, otherwise narrows the
+dlight and pshadow bits down to the flags for the draw surface
 ======================
 */
-static void R_AddWorldSurface( msurface_t *surf, int dlightBits, int pshadowBits ) {
+static bool R_PrepareWorldSurface( msurface_t *surf, int *dlightBits, int *pshadowBits, frontEndCounters_t *pc ) {
 	// FIXME: bmodel fog?
 
 	// try to cull before dlighting or adding
 	if ( R_CullSurface( surf ) ) {
-		return;
+		return false;
 	}
 
 	// check for dlighting
 	/*if ( dlightBits ) */{
-		dlightBits = R_DlightSurface( surf, dlightBits );
-		dlightBits = ( dlightBits != 0 );
+		*dlightBits = R_DlightSurface( surf, *dlightBits, pc );
+		*dlightBits = ( *dlightBits != 0 );
 	}
 
 	// check for pshadows
 	/*if ( pshadowBits ) */{
-		pshadowBits = R_PshadowSurface( surf, pshadowBits);
-		pshadowBits = ( pshadowBits != 0 );
+		*pshadowBits = R_PshadowSurface( surf, *pshadowBits);
+		*pshadowBits = ( *pshadowBits != 0 );
 	}
 
-	R_AddDrawSurf( surf->data, surf->shader, surf->fogIndex, dlightBits, pshadowBits, surf->cubemapIndex );
+	return true;
+}
+
+/*
+======================
+R_AddWorldSurface
+======================
+*/
+static void R_AddWorldSurface( msurface_t *surf, int dlightBits, int pshadowBits ) {
+	if ( R_PrepareWorldSurface( surf, &dlightBits, &pshadowBits, &tr.pc ) ) {
+		R_AddDrawSurf( surf->data, surf->shader, surf->fogIndex, dlightBits, pshadowBits, surf->cubemapIndex );
+	}
 }
 
 /*
@@ -381,7 +402,7 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 		if (tr.world->surfacesViewCount[surf] != tr.viewCount)
 		{
 			tr.world->surfacesViewCount[surf] = tr.viewCount;
-			R_AddWorldSurface( tr.world->surfaces + surf, tr.currentEntity->needDlights, 0 );
+			R_AddWorldSurface( tr.world->surfaces + surf, fe->currentEntity->needDlights, 0 );
 		}
 	}
 }
@@ -395,194 +416,401 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 =============================================================
 */
 
+#define	MAX_WORLD_JOBS		64
+
+// fewest leafs and surfaces worth giving a job of their own
+#define	WORLD_JOB_LEAFS		256
+#define	WORLD_JOB_SURFACES	256
+
+typedef struct {
+	int			firstGroup;		// in worldJobGroups
+	int			numGroups;
+	int			firstLeaf;		// in jobLeafs
+	int			numLeafs;
+	vec3_t		visBounds[2];
+	frontEndCounters_t	pc;
+} worldLeafJob_t;
+
+typedef struct {
+	int			firstSurface;	// in surfaces and jobDrawSurfs
+	int			numSurfaces;
+	int			numDrawSurfs;
+	int			dlightMask;
+	frontEndCounters_t	pc;
+} worldSurfaceJob_t;
+
+static const int			*worldJobGroups;	// NULL for every group
+static uint32_t				worldJobPlaneBits;
+static uint32_t				worldJobDlightBits;
+static uint32_t				worldJobPshadowBits;
+
+static worldLeafJob_t		worldLeafJobs[MAX_WORLD_JOBS];
+static worldSurfaceJob_t	worldSurfaceJobs[MAX_WORLD_JOBS];
+
 
 /*
 ================
-R_RecursiveWorldNode
+R_CullLeafGroup
+
+Returns true if the whole group is outside the frustum, otherwise
+clears the planeBits it is entirely in front of
 ================
 */
-static void R_RecursiveWorldNode( mnode_t *node, uint32_t planeBits, uint32_t dlightBits, uint32_t pshadowBits ) {
+static bool R_CullLeafGroup( leafGroup_t *group, uint32_t *planeBits ) {
+	int		i, r;
+
+	for ( i = 0 ; i < 5 ; i++ ) {
+		if ( *planeBits & ( 1 << i ) ) {
+			r = BoxOnPlaneSide( group->bounds[0], group->bounds[1], &fe->viewParms.frustum[i] );
+			if ( r == 2 ) {
+				return true;				// culled
+			}
+			if ( r == 1 ) {
+				*planeBits &= ~( 1 << i );	// all leafs will also be in front
+			}
+		}
+	}
 
-	do {
-		uint32_t newDlights[2];
-		uint32_t newPShadows[2];
+	return false;
+}
 
-		// if the node wasn't marked as potentially visible, exit
-		// pvs is skipped for depth shadows
-		if (!(tr.viewParms.flags & VPF_DEPTHSHADOW) && node->visCounts[tr.visIndex] != tr.visCounts[tr.visIndex]) {
-			return;
+/*
+================
+R_CullLeafs4
+
+Returns a bit for each of the four sorted leafs from first on that
+is not entirely behind one of the planeBits frustum planes
+================
+*/
+static int R_CullLeafs4( const world_t *w, int first, uint32_t planeBits ) {
+	const cplane_t	*frust;
+	int				i;
+#if WORLD_SIMD
+	__m128	mins[3], maxs[3];
+	__m128	d, culled;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		mins[i] = _mm_loadu_ps( w->leafMins[i] + first );
+		maxs[i] = _mm_loadu_ps( w->leafMaxs[i] + first );
+	}
+
+	culled = _mm_setzero_ps();
+	for ( i = 0 ; i < 5 ; i++ ) {
+		if ( !( planeBits & ( 1 << i ) ) ) {
+			continue;
 		}
+		frust = &fe->viewParms.frustum[i];
 
-		// if the bounding volume is outside the frustum, nothing
-		// inside can be visible OPTIMIZE: don't do this all the way to leafs?
+		// the corner furthest along the normal
+		d = _mm_mul_ps( frust->normal[0] >= 0 ? maxs[0] : mins[0], _mm_set1_ps( frust->normal[0] ) );
+		d = _mm_add_ps( d, _mm_mul_ps( frust->normal[1] >= 0 ? maxs[1] : mins[1], _mm_set1_ps( frust->normal[1] ) ) );
+		d = _mm_add_ps( d, _mm_mul_ps( frust->normal[2] >= 0 ? maxs[2] : mins[2], _mm_set1_ps( frust->normal[2] ) ) );
+		culled = _mm_or_ps( culled, _mm_cmplt_ps( d, _mm_set1_ps( frust->dist ) ) );
+	}
 
-		if ( !r_nocull->integer ) {
-			int		r;
+	return ~_mm_movemask_ps( culled ) & 15;
+#else
+	int		j, visible;
+	float	d;
 
-			if ( planeBits & 1 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[0]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~1;			// all descendants will also be in front
-				}
+	visible = 15;
+	for ( j = 0 ; j < 4 ; j++ ) {
+		for ( i = 0 ; i < 5 ; i++ ) {
+			if ( !( planeBits & ( 1 << i ) ) ) {
+				continue;
 			}
-
-			if ( planeBits & 2 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[1]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~2;			// all descendants will also be in front
-				}
+			frust = &fe->viewParms.frustum[i];
+
+			// the corner furthest along the normal
+			d = ( frust->normal[0] >= 0 ? w->leafMaxs[0][first + j] : w->leafMins[0][first + j] ) * frust->normal[0];
+			d += ( frust->normal[1] >= 0 ? w->leafMaxs[1][first + j] : w->leafMins[1][first + j] ) * frust->normal[1];
+			d += ( frust->normal[2] >= 0 ? w->leafMaxs[2][first + j] : w->leafMins[2][first + j] ) * frust->normal[2];
+			if ( d < frust->dist ) {
+				visible &= ~( 1 << j );
+				break;
 			}
+		}
+	}
 
-			if ( planeBits & 4 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[2]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~4;			// all descendants will also be in front
-				}
-			}
+	return visible;
+#endif
+}
 
-			if ( planeBits & 8 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[3]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~8;			// all descendants will also be in front
-				}
-			}
+/*
+================
+R_DlightsInBounds
+================
+*/
+static uint32_t R_DlightsInBounds( const vec3_t mins, const vec3_t maxs, uint32_t dlightBits ) {
+	dlight_t	*dl;
+	int			i;
 
-			if ( planeBits & 16 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[4]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~16;			// all descendants will also be in front
-				}
+	for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
+		if ( dlightBits & ( 1 << i ) ) {
+			dl = &tr.refdef.dlights[i];
+			if ( !BoundsIntersectSphere( mins, maxs, dl->origin, dl->radius ) ) {
+				dlightBits &= ~( 1 << i );
 			}
 		}
+	}
 
-		if ( node->contents != -1 ) {
-			break;
-		}
+	return dlightBits;
+}
 
-		// node is just a decision point, so go down both sides
-		// since we don't care about sort orders, just go positive to negative
-
-		// determine which dlights are needed
-		newDlights[0] = 0;
-		newDlights[1] = 0;
-		if ( dlightBits ) {
-			int	i;
-
-			for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
-				dlight_t	*dl;
-				float		dist;
-
-				if ( dlightBits & ( 1 << i ) ) {
-					dl = &tr.refdef.dlights[i];
-					dist = DotProduct( dl->origin, node->plane->normal ) - node->plane->dist;
-					
-					if ( dist > -dl->radius ) {
-						newDlights[0] |= ( 1 << i );
-					}
-					if ( dist < dl->radius ) {
-						newDlights[1] |= ( 1 << i );
-					}
-				}
-			}
-		}
+/*
+================
+R_PshadowsInBounds
+================
+*/
+static uint32_t R_PshadowsInBounds( const vec3_t mins, const vec3_t maxs, uint32_t pshadowBits ) {
+	pshadow_t	*shadow;
+	int			i;
 
-		newPShadows[0] = 0;
-		newPShadows[1] = 0;
-		if ( pshadowBits ) {
-			int	i;
-
-			for ( i = 0 ; i < tr.refdef.num_pshadows ; i++ ) {
-				pshadow_t	*shadow;
-				float		dist;
-
-				if ( pshadowBits & ( 1 << i ) ) {
-					shadow = &tr.refdef.pshadows[i];
-					dist = DotProduct( shadow->lightOrigin, node->plane->normal ) - node->plane->dist;
-					
-					if ( dist > -shadow->lightRadius ) {
-						newPShadows[0] |= ( 1 << i );
-					}
-					if ( dist < shadow->lightRadius ) {
-						newPShadows[1] |= ( 1 << i );
-					}
-				}
+	for ( i = 0 ; i < tr.refdef.num_pshadows ; i++ ) {
+		if ( pshadowBits & ( 1 << i ) ) {
+			shadow = &tr.refdef.pshadows[i];
+			if ( !BoundsIntersectSphere( mins, maxs, shadow->lightOrigin, shadow->lightRadius ) ) {
+				pshadowBits &= ~( 1 << i );
 			}
 		}
+	}
 
-		// recurse down the children, front side first
-		R_RecursiveWorldNode (node->children[0], planeBits, newDlights[0], newPShadows[0] );
+	return pshadowBits;
+}
 
-		// tail recurse
-		node = node->children[1];
-		dlightBits = newDlights[1];
-		pshadowBits = newPShadows[1];
-	} while ( 1 );
+/*
+================
+R_MarkLeafSurfaces
+================
+*/
+static void R_MarkLeafSurfaces( mnode_t *node, uint32_t dlightBits, uint32_t pshadowBits ) {
+	int			c;
+	int surf, *view;
 
-	{
-		// leaf node, so add mark surfaces
-		int			c;
-		int surf, *view;
+	view = tr.world->marksurfaces + node->firstmarksurface;
+
+	c = node->nummarksurfaces;
+	while (c--) {
+		// just mark it as visible, so we don't jump out of the cache derefencing the surface
+		surf = *view;
+		if (tr.world->surfacesViewCount[surf] != tr.viewCount)
+		{
+			tr.world->surfacesViewCount[surf] = tr.viewCount;
+			tr.world->surfacesDlightBits[surf] = dlightBits;
+			tr.world->surfacesPshadowBits[surf] = pshadowBits;
+		}
+		else
+		{
+			tr.world->surfacesDlightBits[surf] |= dlightBits;
+			tr.world->surfacesPshadowBits[surf] |= pshadowBits;
+		}
+		view++;
+	}
+}
 
-		tr.pc.c_leafs++;
+/*
+================
+R_CullLeafGroupsJob
 
-		// add to z buffer bounds
-		if ( node->mins[0] < tr.viewParms.visBounds[0][0] ) {
-			tr.viewParms.visBounds[0][0] = node->mins[0];
+Tests the groups against the frustum, then the leafs of the groups
+that are only partly inside four at a time, and keeps the visible
+leafs with the dlights and pshadows touching them
+================
+*/
+static void R_CullLeafGroupsJob( void *data, int index ) {
+	worldLeafJob_t	*job = &worldLeafJobs[index];
+	world_t			*w = tr.world;
+	leafGroup_t		*group;
+	worldLeaf_t		*out;
+	mnode_t			*leaf;
+	uint32_t		planeBits, dlightBits, pshadowBits;
+	int				i, j, k, end, visible;
+
+	for ( i = job->firstGroup ; i < job->firstGroup + job->numGroups ; i++ ) {
+		group = &w->leafGroups[worldJobGroups ? worldJobGroups[i] : i];
+		job->pc.c_leafGroupsTested++;
+
+		planeBits = worldJobPlaneBits;
+		if ( R_CullLeafGroup( group, &planeBits ) ) {
+			continue;
 		}
-		if ( node->mins[1] < tr.viewParms.visBounds[0][1] ) {
-			tr.viewParms.visBounds[0][1] = node->mins[1];
+
+		dlightBits = R_DlightsInBounds( group->bounds[0], group->bounds[1], worldJobDlightBits );
+		pshadowBits = R_PshadowsInBounds( group->bounds[0], group->bounds[1], worldJobPshadowBits );
+
+		end = group->firstLeaf + group->numLeafs;
+		for ( j = group->firstLeaf ; j < end ; j += 4 ) {
+			if ( planeBits ) {
+				visible = R_CullLeafs4( w, j, planeBits );
+				job->pc.c_leafsTested += MIN( 4, end - j );
+			} else {
+				visible = 15;
+			}
+
+			if ( end - j < 4 ) {
+				visible &= ( 1 << ( end - j ) ) - 1;
+			}
+
+			for ( k = 0 ; visible ; k++, visible >>= 1 ) {
+				if ( !( visible & 1 ) ) {
+					continue;
+				}
+				leaf = w->sortedLeafs[j + k];
+
+				out = &w->jobLeafs[job->firstLeaf + job->numLeafs++];
+				out->node = leaf;
+				out->dlightBits = dlightBits ? R_DlightsInBounds( leaf->mins, leaf->maxs, dlightBits ) : 0;
+				out->pshadowBits = pshadowBits ? R_PshadowsInBounds( leaf->mins, leaf->maxs, pshadowBits ) : 0;
+
+				// add to z buffer bounds
+				AddPointToBounds( leaf->mins, job->visBounds[0], job->visBounds[1] );
+				AddPointToBounds( leaf->maxs, job->visBounds[0], job->visBounds[1] );
+			}
 		}
-		if ( node->mins[2] < tr.viewParms.visBounds[0][2] ) {
-			tr.viewParms.visBounds[0][2] = node->mins[2];
+	}
+}
+
+/*
+================
+R_AddWorldSurfacesJob
+================
+*/
+static void R_AddWorldSurfacesJob( void *data, int index ) {
+	worldSurfaceJob_t	*job = &worldSurfaceJobs[index];
+	msurface_t			*surf;
+	int					i, dlightBits, pshadowBits;
+
+	for ( i = job->firstSurface ; i < job->firstSurface + job->numSurfaces ; i++ ) {
+		if ( tr.world->surfacesViewCount[i] != tr.viewCount ) {
+			continue;
 		}
 
-		if ( node->maxs[0] > tr.viewParms.visBounds[1][0] ) {
-			tr.viewParms.visBounds[1][0] = node->maxs[0];
+		surf = tr.world->surfaces + i;
+		dlightBits = tr.world->surfacesDlightBits[i];
+		pshadowBits = tr.world->surfacesPshadowBits[i];
+		job->dlightMask |= dlightBits;
+		job->pc.c_worldSurfacesTested++;
+
+		if ( R_PrepareWorldSurface( surf, &dlightBits, &pshadowBits, &job->pc ) ) {
+			R_PackDrawSurf( &tr.world->jobDrawSurfs[job->firstSurface + job->numDrawSurfs],
+				surf->data, surf->shader, surf->fogIndex, dlightBits, pshadowBits, surf->cubemapIndex );
+			job->numDrawSurfs++;
 		}
-		if ( node->maxs[1] > tr.viewParms.visBounds[1][1] ) {
-			tr.viewParms.visBounds[1][1] = node->maxs[1];
+	}
+}
+
+/*
+================
+R_RunWorldJobs
+================
+*/
+static void R_RunWorldJobs( int count, void (*func)( void *data, int index ) ) {
+	int		i;
+
+	if ( r_frontEndJobs->integer ) {
+		ri.ParallelFor( count, func, NULL );
+		return;
+	}
+
+	for ( i = 0 ; i < count ; i++ ) {
+		func( NULL, i );
+	}
+}
+
+/*
+================
+R_CullWorld
+
+The groups are culled in ranges on the job threads and the visible
+leafs marked here, then the world surfaces are culled and packed in
+ranges and the lists appended in surface order
+================
+*/
+static void R_CullWorld( const int *groups, int numGroups, uint32_t planeBits, uint32_t dlightBits, uint32_t pshadowBits ) {
+	world_t				*w = tr.world;
+	worldLeafJob_t		*leafJob;
+	worldSurfaceJob_t	*job;
+	worldLeaf_t			*leaf;
+	int					i, j, numJobs;
+	int					numLeafs, jobLeafs;
+
+	worldJobGroups = groups;
+	worldJobPlaneBits = r_nocull->integer ? 0 : planeBits;
+	worldJobDlightBits = dlightBits;
+	worldJobPshadowBits = pshadowBits;
+
+	// split the groups into jobs of about the same number of leafs
+	numLeafs = 0;
+	for ( i = 0 ; i < numGroups ; i++ ) {
+		numLeafs += w->leafGroups[groups ? groups[i] : i].numLeafs;
+	}
+	jobLeafs = MAX( WORLD_JOB_LEAFS, numLeafs / MAX_WORLD_JOBS + 1 );
+
+	numJobs = 0;
+	leafJob = NULL;
+	numLeafs = 0;
+	for ( i = 0 ; i < numGroups ; i++ ) {
+		if ( !leafJob || ( numLeafs - leafJob->firstLeaf >= jobLeafs && numJobs < MAX_WORLD_JOBS ) ) {
+			leafJob = &worldLeafJobs[numJobs++];
+			leafJob->firstGroup = i;
+			leafJob->numGroups = 0;
+			leafJob->firstLeaf = numLeafs;
+			leafJob->numLeafs = 0;
+			ClearBounds( leafJob->visBounds[0], leafJob->visBounds[1] );
+			Com_Memset( &leafJob->pc, 0, sizeof( leafJob->pc ) );
 		}
-		if ( node->maxs[2] > tr.viewParms.visBounds[1][2] ) {
-			tr.viewParms.visBounds[1][2] = node->maxs[2];
+		leafJob->numGroups++;
+		numLeafs += w->leafGroups[groups ? groups[i] : i].numLeafs;
+	}
+
+	R_RunWorldJobs( numJobs, R_CullLeafGroupsJob );
+
+	for ( i = 0, leafJob = worldLeafJobs ; i < numJobs ; i++, leafJob++ ) {
+		tr.pc.c_leafGroupsTested += leafJob->pc.c_leafGroupsTested;
+		tr.pc.c_leafsTested += leafJob->pc.c_leafsTested;
+
+		if ( !leafJob->numLeafs ) {
+			continue;
 		}
 
-		// add surfaces
-		view = tr.world->marksurfaces + node->firstmarksurface;
+		tr.pc.c_leafs += leafJob->numLeafs;
+		AddPointToBounds( leafJob->visBounds[0], fe->viewParms.visBounds[0], fe->viewParms.visBounds[1] );
+		AddPointToBounds( leafJob->visBounds[1], fe->viewParms.visBounds[0], fe->viewParms.visBounds[1] );
 
-		c = node->nummarksurfaces;
-		while (c--) {
-			// just mark it as visible, so we don't jump out of the cache derefencing the surface
-			surf = *view;
-			if (tr.world->surfacesViewCount[surf] != tr.viewCount)
-			{
-				tr.world->surfacesViewCount[surf] = tr.viewCount;
-				tr.world->surfacesDlightBits[surf] = dlightBits;
-				tr.world->surfacesPshadowBits[surf] = pshadowBits;
-			}
-			else
-			{
-				tr.world->surfacesDlightBits[surf] |= dlightBits;
-				tr.world->surfacesPshadowBits[surf] |= pshadowBits;
-			}
-			view++;
+		for ( j = 0, leaf = w->jobLeafs + leafJob->firstLeaf ; j < leafJob->numLeafs ; j++, leaf++ ) {
+			R_MarkLeafSurfaces( leaf->node, leaf->dlightBits, leaf->pshadowBits );
 		}
 	}
 
+	// now add all the potentially visible surfaces
+	numJobs = ( w->numWorldSurfaces + WORLD_JOB_SURFACES - 1 ) / WORLD_JOB_SURFACES;
+	if ( numJobs > MAX_WORLD_JOBS ) {
+		numJobs = MAX_WORLD_JOBS;
+	}
+
+	for ( i = 0, job = worldSurfaceJobs ; i < numJobs ; i++, job++ ) {
+		job->firstSurface = w->numWorldSurfaces * i / numJobs;
+		job->numSurfaces = w->numWorldSurfaces * ( i + 1 ) / numJobs - job->firstSurface;
+		job->numDrawSurfs = 0;
+		job->dlightMask = 0;
+		Com_Memset( &job->pc, 0, sizeof( job->pc ) );
+	}
+
+	R_RunWorldJobs( numJobs, R_AddWorldSurfacesJob );
+
+	// also mask invisible dlights for next frame
+	tr.refdef.dlightMask = 0;
+
+	for ( i = 0, job = worldSurfaceJobs ; i < numJobs ; i++, job++ ) {
+		R_AddDrawSurfs( w->jobDrawSurfs + job->firstSurface, job->numDrawSurfs );
+		tr.refdef.dlightMask |= job->dlightMask;
+		tr.pc.c_worldSurfacesTested += job->pc.c_worldSurfacesTested;
+		tr.pc.c_worldSurfaces += job->numDrawSurfs;
+		tr.pc.c_dlightSurfaces += job->pc.c_dlightSurfaces;
+		tr.pc.c_dlightSurfacesCulled += job->pc.c_dlightSurfacesCulled;
+	}
+
+	tr.refdef.dlightMask = ~tr.refdef.dlightMask;
 }
 
 
@@ -653,15 +881,18 @@ bool R_inPVS( const vec3_t p1, const vec3_t p2 ) {
 ===============
 R_MarkLeaves
 
-Mark the leaves and nodes that are in the PVS for the current
-cluster
+Picks the leaf groups that are in the PVS for the current cluster.
+The last MAX_VISCOUNTS clusters keep their lists, so walking back
+and forth between them costs nothing.
 ===============
 */
 static void R_MarkLeaves (void) {
 	const byte	*vis;
-	mnode_t	*leaf, *parent;
-	int		i;
-	int		cluster;
+	mnode_t		*leaf;
+	leafGroup_t	*group;
+	int			*visGroups;
+	int			i, numVisGroups;
+	int			cluster;
 
 	// lockpvs lets designers walk around to determine the
 	// extent of the current pvs
@@ -670,8 +901,9 @@ static void R_MarkLeaves (void) {
 	}
 
 	// current viewcluster
-	leaf = R_PointInLeaf( tr.viewParms.pvsOrigin );
+	leaf = R_PointInLeaf( fe->viewParms.pvsOrigin );
 	cluster = leaf->cluster;
+	tr.viewCluster = cluster;
 
 	// if the cluster is the same and the area visibility matrix
 	// hasn't changed, we don't need to mark everything again
@@ -696,7 +928,6 @@ static void R_MarkLeaves (void) {
 	}
 
 	tr.visIndex = (tr.visIndex + 1) % MAX_VISCOUNTS;
-	tr.visCounts[tr.visIndex]++;
 	tr.visClusters[tr.visIndex] = cluster;
 
 	if ( r_showcluster->modified || r_showcluster->integer ) {
@@ -707,31 +938,32 @@ static void R_MarkLeaves (void) {
 	}
 
 	vis = R_ClusterPVS(tr.visClusters[tr.visIndex]);
-	
-	for (i=0,leaf=tr.world->nodes ; i<tr.world->numnodes ; i++, leaf++) {
-		cluster = leaf->cluster;
-		if ( cluster < 0 || cluster >= tr.world->numClusters ) {
+	visGroups = tr.world->visLeafGroups[tr.visIndex];
+	numVisGroups = 0;
+
+	for ( cluster = 0 ; cluster < tr.world->numClusters ; cluster++ ) {
+		// check general pvs, a byte at a time where it is empty
+		if ( vis && !vis[cluster>>3] ) {
+			cluster |= 7;
 			continue;
 		}
-
-		// check general pvs
 		if ( vis && !(vis[cluster>>3] & (1<<(cluster&7))) ) {
 			continue;
 		}
 
-		// check for door connection
-		if ( (tr.refdef.areamask[leaf->area>>3] & (1<<(leaf->area&7)) ) ) {
-			continue;		// not visible
-		}
+		for ( i = tr.world->clusterLeafGroups[cluster] ; i < tr.world->clusterLeafGroups[cluster + 1] ; i++ ) {
+			group = &tr.world->leafGroups[i];
 
-		parent = leaf;
-		do {
-			if(parent->visCounts[tr.visIndex] == tr.visCounts[tr.visIndex])
-				break;
-			parent->visCounts[tr.visIndex] = tr.visCounts[tr.visIndex];
-			parent = parent->parent;
-		} while (parent);
+			// check for door connection
+			if ( (tr.refdef.areamask[group->area>>3] & (1<<(group->area&7)) ) ) {
+				continue;		// not visible
+			}
+
+			visGroups[numVisGroups++] = i;
+		}
 	}
+
+	tr.world->numVisLeafGroups[tr.visIndex] = numVisGroups;
 }
 
 
@@ -742,6 +974,7 @@ R_AddWorldSurfaces
 */
 void R_AddWorldSurfaces (void) {
 	uint32_t planeBits, dlightBits, pshadowBits;
+	int span;
 
 	if ( !r_drawworld->integer ) {
 		return;
@@ -751,15 +984,19 @@ void R_AddWorldSurfaces (void) {
 		return;
 	}
 
-	tr.currentEntityNum = REFENTITYNUM_WORLD;
-	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
+	fe->currentEntityNum = REFENTITYNUM_WORLD;
+	fe->shiftedEntityNum = fe->currentEntityNum << QSORT_REFENTITYNUM_SHIFT;
 
 	// determine which leaves are in the PVS / areamask
-	if (!(tr.viewParms.flags & VPF_DEPTHSHADOW))
+	if (!(fe->viewParms.flags & VPF_DEPTHSHADOW))
+	{
+		span = R_ProfileBegin( RP_MARKLEAVES );
 		R_MarkLeaves ();
+		R_ProfileEnd( span );
+	}
 
 	// clear out the visible min/max
-	ClearBounds( tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+	ClearBounds( fe->viewParms.visBounds[0], fe->viewParms.visBounds[1] );
 
 	// perform frustum culling and flag all the potentially visible surfaces
 	if ( tr.refdef.num_dlights > MAX_DLIGHTS ) {
@@ -770,14 +1007,14 @@ void R_AddWorldSurfaces (void) {
 		tr.refdef.num_pshadows = MAX_DRAWN_PSHADOWS;
 	}
 
-	planeBits = (tr.viewParms.flags & VPF_FARPLANEFRUSTUM) ? 31 : 15;
+	planeBits = (fe->viewParms.flags & VPF_FARPLANEFRUSTUM) ? 31 : 15;
 
-	if ( tr.viewParms.flags & VPF_DEPTHSHADOW )
+	if ( fe->viewParms.flags & VPF_DEPTHSHADOW )
 	{
 		dlightBits = 0;
 		pshadowBits = 0;
 	}
-	else if ( !(tr.viewParms.flags & VPF_SHADOWMAP) )
+	else if ( !(fe->viewParms.flags & VPF_SHADOWMAP) )
 	{
 		dlightBits = ( 1ULL << tr.refdef.num_dlights ) - 1;
 		pshadowBits = ( 1ULL << tr.refdef.num_pshadows ) - 1;
@@ -788,24 +1025,11 @@ void R_AddWorldSurfaces (void) {
 		pshadowBits = 0;
 	}
 
-	R_RecursiveWorldNode( tr.world->nodes, planeBits, dlightBits, pshadowBits);
-
-	// now add all the potentially visible surfaces
-	// also mask invisible dlights for next frame
-	{
-		int i;
-
-		tr.refdef.dlightMask = 0;
-
-		for (i = 0; i < tr.world->numWorldSurfaces; i++)
-		{
-			if (tr.world->surfacesViewCount[i] != tr.viewCount)
-				continue;
-
-			R_AddWorldSurface( tr.world->surfaces + i, tr.world->surfacesDlightBits[i], tr.world->surfacesPshadowBits[i] );
-			tr.refdef.dlightMask |= tr.world->surfacesDlightBits[i];
-		}
-
-		tr.refdef.dlightMask = ~tr.refdef.dlightMask;
+	// pvs is skipped for depth shadows
+	if ( fe->viewParms.flags & VPF_DEPTHSHADOW ) {
+		R_CullWorld( NULL, tr.world->numLeafGroups, planeBits, dlightBits, pshadowBits );
+	} else {
+		R_CullWorld( tr.world->visLeafGroups[tr.visIndex], tr.world->numVisLeafGroups[tr.visIndex],
+			planeBits, dlightBits, pshadowBits );
 	}
 }
@@ -444,6 +444,15 @@ int SV_SendQueuedMessages(void);
 //
 void SV_Heartbeat_f(void);
 
+//
+// sv_http.c
+//
+void SV_HTTPInit(void);
+void SV_HTTPUpdate(void);
+void SV_HTTPFrame(void);
+void SV_HTTPShutdown(void);
+void SV_HTTPStatus_f(void);
+
 //
 // sv_snapshot.c
 //
@@ -466,6 +475,8 @@ void SV_InitGameProgs(void);
 void SV_ShutdownGameProgs(void);
 void SV_RestartGameProgs(void);
 bool SV_inPVS(const vec3_t p1, const vec3_t p2);
+void SV_InPVSMany(const vec3_t *origins, int numOrigins, const vec3_t *targets, int numTargets,
+                  byte *results, bool ignorePortals);
 
 //============================================================
 //
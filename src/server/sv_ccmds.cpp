@@ -379,6 +379,7 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("devmap", SV_Map_f);
 	Cmd_SetCommandCompletionFunc( "devmap", SV_CompleteMapName );
 	Cmd_AddCommand ("killserver", SV_KillServer_f);
+	Cmd_AddCommand ("httpstatus", SV_HTTPStatus_f);
 }
 
 /*
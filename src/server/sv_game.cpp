@@ -194,6 +194,58 @@ bool SV_inPVSIgnorePortals( const vec3_t p1, const vec3_t p2)
 }
 
 
+/*
+=================
+SV_InPVSMany
+
+Answers SV_inPVS, or SV_inPVSIgnorePortals, for every origin against
+every target.  Each point is walked down the tree once, instead of
+twice per pair.  results[ i * numTargets + j ] is set when targets[ j ]
+is visible from origins[ i ].
+=================
+*/
+void SV_InPVSMany( const vec3_t *origins, int numOrigins, const vec3_t *targets, int numTargets,
+		byte *results, bool ignorePortals )
+{
+	static int	clusters[MAX_GENTITIES];
+	static int	areas[MAX_GENTITIES];
+	int		i, j;
+	int		leafnum;
+	int		cluster, area;
+	byte	*mask, *row;
+
+	if ( numOrigins < 0 || numOrigins > MAX_GENTITIES || numTargets < 0 || numTargets > MAX_GENTITIES ) {
+		Com_Error( ERR_DROP, "SV_InPVSMany: bad point count %i x %i", numOrigins, numTargets );
+	}
+
+	for ( j = 0 ; j < numTargets ; j++ ) {
+		leafnum = CM_PointLeafnum( targets[j] );
+		clusters[j] = CM_LeafCluster( leafnum );
+		areas[j] = CM_LeafArea( leafnum );
+	}
+
+	for ( i = 0 ; i < numOrigins ; i++ ) {
+		leafnum = CM_PointLeafnum( origins[i] );
+		area = CM_LeafArea( leafnum );
+		mask = CM_ClusterPVS( CM_LeafCluster( leafnum ) );
+		row = results + i * numTargets;
+
+		for ( j = 0 ; j < numTargets ; j++ ) {
+			cluster = clusters[j];
+
+			// points inside solid have no cluster and see nothing
+			if ( mask && ( cluster < 0 || !( mask[cluster>>3] & ( 1 << ( cluster & 7 ) ) ) ) ) {
+				row[j] = false;
+			} else if ( !ignorePortals && !CM_AreasConnected( area, areas[j] ) ) {
+				row[j] = false;		// a door blocks sight
+			} else {
+				row[j] = true;
+			}
+		}
+	}
+}
+
+
 /*
 ========================
 SV_AdjustAreaPortalState
@@ -377,6 +429,14 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
             return SV_inPVS( (const vec_t*)VMA(1), (const vec_t*)VMA(2) );
         case G_IN_PVS_IGNORE_PORTALS:
             return SV_inPVSIgnorePortals( (const vec_t*)VMA(1), (const vec_t*)VMA(2) );
+        case G_IN_PVS_MANY:
+            if ( args[2] < 0 || args[2] > MAX_GENTITIES || args[4] < 0 || args[4] > MAX_GENTITIES )
+                Com_Error( ERR_DROP, "G_IN_PVS_MANY: bad point count %i x %i", (int)args[2], (int)args[4] );
+            VM_CheckBlock( args[1], args[2] * sizeof( vec3_t ), "G_IN_PVS_MANY" );
+            VM_CheckBlock( args[3], args[4] * sizeof( vec3_t ), "G_IN_PVS_MANY" );
+            VM_CheckBlock( args[5], args[2] * args[4], "G_IN_PVS_MANY" );
+            SV_InPVSMany( (const vec3_t*)VMA(1), args[2], (const vec3_t*)VMA(3), args[4], (byte*)VMA(5), (bool)args[6] );
+            return 0;
 
         case G_SET_CONFIGSTRING:
             SV_SetConfigstring( args[1], (const char*)VMA(2) );
@@ -501,6 +561,73 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	return 0;
 }
 
+/*
+====================
+Fast path game system calls
+
+These are issued thousands of times per frame, so they skip the
+SV_GameSystemCalls switch and read their arguments straight off the
+QVM stack.
+====================
+*/
+static intptr_t SV_GameMilliseconds( byte *dataBase, int dataMask, const int *args ) {
+	return Sys_Milliseconds();
+}
+
+static intptr_t SV_GameCvarUpdate( byte *dataBase, int dataMask, const int *args ) {
+	Cvar_Update( (vmCvar_t*)VMFA(1) );
+	return 0;
+}
+
+static intptr_t SV_GameLinkEntity( byte *dataBase, int dataMask, const int *args ) {
+	SV_LinkEntity( (sharedEntity_t*)VMFA(1) );
+	return 0;
+}
+
+static intptr_t SV_GameUnlinkEntity( byte *dataBase, int dataMask, const int *args ) {
+	SV_UnlinkEntity( (sharedEntity_t*)VMFA(1) );
+	return 0;
+}
+
+static intptr_t SV_GameEntitiesInBox( byte *dataBase, int dataMask, const int *args ) {
+	return SV_AreaEntities( (const vec_t*)VMFA(1), (const vec_t*)VMFA(2), (int*)VMFA(3), args[4] );
+}
+
+static intptr_t SV_GameTrace( byte *dataBase, int dataMask, const int *args ) {
+	SV_Trace( (trace_t*)VMFA(1), (const vec_t*)VMFA(2), (vec_t*)VMFA(3), (vec_t*)VMFA(4), (const vec_t*)VMFA(5), args[6], args[7], TT_AABB );
+	return 0;
+}
+
+static intptr_t SV_GameTraceCapsule( byte *dataBase, int dataMask, const int *args ) {
+	SV_Trace( (trace_t*)VMFA(1), (const vec_t*)VMFA(2), (vec_t*)VMFA(3), (vec_t*)VMFA(4), (const vec_t*)VMFA(5), args[6], args[7], TT_CAPSULE );
+	return 0;
+}
+
+static intptr_t SV_GamePointContents( byte *dataBase, int dataMask, const int *args ) {
+	return SV_PointContents( (const vec_t*)VMFA(1), args[2] );
+}
+
+static intptr_t SV_GameInPVS( byte *dataBase, int dataMask, const int *args ) {
+	return SV_inPVS( (const vec_t*)VMFA(1), (const vec_t*)VMFA(2) );
+}
+
+static intptr_t SV_GameEntityContact( byte *dataBase, int dataMask, const int *args ) {
+	return SV_EntityContact( (vec_t*)VMFA(1), (vec_t*)VMFA(2), (const sharedEntity_t*)VMFA(3), TT_AABB );
+}
+
+static const vmSyscall_t sv_gameSyscalls[] = {
+	{ G_MILLISECONDS,		"G_MILLISECONDS",		SV_GameMilliseconds },
+	{ G_CVAR_UPDATE,		"G_CVAR_UPDATE",		SV_GameCvarUpdate },
+	{ G_LINKENTITY,			"G_LINKENTITY",			SV_GameLinkEntity },
+	{ G_UNLINKENTITY,		"G_UNLINKENTITY",		SV_GameUnlinkEntity },
+	{ G_ENTITIES_IN_BOX,	"G_ENTITIES_IN_BOX",	SV_GameEntitiesInBox },
+	{ G_TRACE,				"G_TRACE",				SV_GameTrace },
+	{ G_TRACECAPSULE,		"G_TRACECAPSULE",		SV_GameTraceCapsule },
+	{ G_POINT_CONTENTS,		"G_POINT_CONTENTS",		SV_GamePointContents },
+	{ G_IN_PVS,				"G_IN_PVS",				SV_GameInPVS },
+	{ G_ENTITY_CONTACT,		"G_ENTITY_CONTACT",		SV_GameEntityContact }
+};
+
 /*
 ===============
 SV_ShutdownGameProgs
@@ -581,6 +708,7 @@ void SV_InitGameProgs( void ) {
 	if ( !sv.gvm ) {
 		Com_Error( ERR_FATAL, "VM_Create on game failed" );
 	}
+	VM_SetSyscallTable( sv.gvm, sv_gameSyscalls, ARRAY_LEN( sv_gameSyscalls ) );
 
 	SV_InitGameVM( false );
 }
@@ -0,0 +1,762 @@
+/*
+ * This file is part of Tremulous.
+ * Copyright (C) 2015-2019 GrangerHub
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License,  or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not,  see <http://www.gnu.org/licenses/>.
+ */
+
+// sv_http.cpp -- built-in HTTP server for pak downloads
+
+#include "server.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sys/sys_shared.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+typedef int socklen_t;
+#define socketError WSAGetLastError()
+#define SOCKET_WOULDBLOCK WSAEWOULDBLOCK
+#define MSG_NOSIGNAL 0
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef int SOCKET;
+#define INVALID_SOCKET -1
+#define closesocket close
+#define socketError errno
+#define SOCKET_WOULDBLOCK EAGAIN
+
+#endif
+
+/*
+The server runs on its own thread and only ever serves the paks listed
+by FS_ReferencedPakNames.  The main thread publishes that list, resolved
+to OS paths, whenever a map is spawned; the HTTP thread never calls into
+the filesystem, the zone or the console.  Every response closes its
+connection, which is all the cURL downloader needs.
+*/
+
+#define HTTP_MAX_CONNECTIONS 32
+#define HTTP_MAX_REQUEST 4096
+#define HTTP_TIMEOUT 30000  // msec without progress before a connection is dropped
+#define HTTP_CHUNK 65536
+
+struct httpFile_t {
+    std::string name;  // gamename/basename.pk3
+    std::string ospath;
+};
+
+struct httpConn_t {
+    SOCKET sock;
+    int lastActive;
+
+    char request[HTTP_MAX_REQUEST];
+    int requestLen;
+
+    char header[512];
+    int headerLen;
+    int headerSent;
+
+    FILE *file;
+    int64_t offset;
+    int64_t remaining;
+};
+
+struct httpServer_t {
+    std::thread thread;
+    std::atomic<bool> quit;
+    SOCKET listenSock;
+    int port;
+
+    std::mutex lock;  // guards files
+    std::vector<httpFile_t> files;
+
+    std::atomic<int> requests;
+    std::atomic<int> completed;
+    std::atomic<int> refused;
+    std::atomic<int64_t> bytesSent;
+};
+
+static cvar_t *sv_httpServer;
+static cvar_t *sv_httpPort;
+
+static httpServer_t *http;
+
+/*
+=================
+SV_HTTPMilliseconds
+
+Sys_Milliseconds keeps shared state, so the HTTP thread has its own clock
+=================
+*/
+static int SV_HTTPMilliseconds(void)
+{
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+=================
+SV_HTTPSetNonBlocking
+=================
+*/
+static bool SV_HTTPSetNonBlocking(SOCKET sock)
+{
+#ifdef _WIN32
+    u_long arg = 1;
+    return ioctlsocket(sock, FIONBIO, &arg) == 0;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    return flags != -1 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+/*
+=================
+SV_HTTPClose
+=================
+*/
+static void SV_HTTPClose(httpConn_t *conn)
+{
+    if (conn->file) fclose(conn->file);
+    closesocket(conn->sock);
+
+    conn->sock = INVALID_SOCKET;
+    conn->file = NULL;
+}
+
+/*
+=================
+SV_HTTPStatus
+
+Queues a response with no body or a short text one
+=================
+*/
+static void SV_HTTPStatus(httpConn_t *conn, const char *status, const char *extra)
+{
+    conn->headerLen = Com_sprintf(conn->header, sizeof(conn->header),
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: %d\r\n"
+        "%s"
+        "Connection: close\r\n"
+        "\r\n"
+        "%s\n",
+        status, (int)strlen(status) + 1, extra, status);
+    conn->headerSent = 0;
+}
+
+/*
+=================
+SV_HTTPDecodeTarget
+
+Turns the request target into a pak name: drops the leading slash and
+any query string and undoes percent escapes
+=================
+*/
+static bool SV_HTTPDecodeTarget(const char *target, char *out, int outSize)
+{
+    int len = 0;
+
+    if (*target++ != '/') return false;
+
+    for (; *target && *target != '?' && *target != '#'; target++)
+    {
+        int c = *target;
+
+        if (c == '%')
+        {
+            char hex[3] = {target[1], target[2], 0};
+            char *end;
+
+            if (!hex[0] || !hex[1]) return false;
+            c = strtol(hex, &end, 16);
+            if (*end || !c) return false;
+            target += 2;
+        }
+
+        if (len + 1 >= outSize) return false;
+        out[len++] = c;
+    }
+    out[len] = '\0';
+
+    return len > 0;
+}
+
+/*
+=================
+SV_HTTPRespond
+
+Parses a complete request head and queues the response
+=================
+*/
+static void SV_HTTPRespond(httpServer_t *srv, httpConn_t *conn)
+{
+    char *method, *target, *version;
+    char name[MAX_OSPATH];
+    std::string ospath;
+    int64_t size, mtime;
+    bool head;
+
+    srv->requests++;
+
+    // request line: method SP target SP version
+    method = conn->request;
+    target = strchr(method, ' ');
+    if (!target)
+    {
+        SV_HTTPStatus(conn, "400 Bad Request", "");
+        return;
+    }
+    *target++ = '\0';
+    version = strchr(target, ' ');
+    if (!version || strncmp(version + 1, "HTTP/1.", 7))
+    {
+        SV_HTTPStatus(conn, "400 Bad Request", "");
+        return;
+    }
+    *version = '\0';
+
+    head = !strcmp(method, "HEAD");
+    if (!head && strcmp(method, "GET"))
+    {
+        SV_HTTPStatus(conn, "405 Method Not Allowed", "Allow: GET, HEAD\r\n");
+        return;
+    }
+
+    if (!SV_HTTPDecodeTarget(target, name, sizeof(name)))
+    {
+        SV_HTTPStatus(conn, "404 Not Found", "");
+        srv->refused++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(srv->lock);
+
+        for (const auto &file : srv->files)
+        {
+            if (!Q_stricmp(file.name.c_str(), name))
+            {
+                ospath = file.ospath;
+                break;
+            }
+        }
+    }
+
+    if (ospath.empty() || !Sys_FileStat(ospath.c_str(), &size, &mtime) ||
+        !(conn->file = Sys_FOpen(ospath.c_str(), "rb")))
+    {
+        SV_HTTPStatus(conn, "404 Not Found", "");
+        srv->refused++;
+        return;
+    }
+
+    conn->headerLen = Com_sprintf(conn->header, sizeof(conn->header),
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/zip\r\n"
+        "Content-Length: %lld\r\n"
+        "Connection: close\r\n"
+        "\r\n",
+        (long long)size);
+    conn->headerSent = 0;
+    conn->offset = 0;
+    conn->remaining = size;
+
+    if (head)
+    {
+        fclose(conn->file);
+        conn->file = NULL;
+    }
+}
+
+/*
+=================
+SV_HTTPRead
+
+Collects the request head; the body of a GET or HEAD is ignored
+=================
+*/
+static void SV_HTTPRead(httpServer_t *srv, httpConn_t *conn)
+{
+    int n;
+
+    n = recv(conn->sock, conn->request + conn->requestLen,
+        sizeof(conn->request) - 1 - conn->requestLen, 0);
+    if (n <= 0)
+    {
+        if (n == 0 || socketError != SOCKET_WOULDBLOCK) SV_HTTPClose(conn);
+        return;
+    }
+
+    conn->requestLen += n;
+    conn->request[conn->requestLen] = '\0';
+
+    char *end = strstr(conn->request, "\r\n\r\n");
+    if (end)
+    {
+        // only the request line is needed
+        *strstr(conn->request, "\r\n") = '\0';
+        SV_HTTPRespond(srv, conn);
+    }
+    else if (conn->requestLen == sizeof(conn->request) - 1)
+    {
+        SV_HTTPStatus(conn, "431 Request Header Fields Too Large", "");
+    }
+}
+
+/*
+=================
+SV_HTTPWrite
+
+Sends the response head, then as much of the file as the socket takes
+=================
+*/
+static void SV_HTTPWrite(httpServer_t *srv, httpConn_t *conn)
+{
+    int n;
+
+    if (conn->headerSent < conn->headerLen)
+    {
+        n = send(conn->sock, conn->header + conn->headerSent,
+            conn->headerLen - conn->headerSent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (socketError != SOCKET_WOULDBLOCK) SV_HTTPClose(conn);
+            return;
+        }
+        conn->headerSent += n;
+        if (conn->headerSent < conn->headerLen) return;
+    }
+
+    if (!conn->file)
+    {
+        // error responses and HEAD are done once the head is out
+        SV_HTTPClose(conn);
+        return;
+    }
+
+#ifdef __linux__
+    off_t offset = conn->offset;
+    ssize_t sent = sendfile(conn->sock, fileno(conn->file), &offset,
+        (size_t)MIN(conn->remaining, (int64_t)HTTP_CHUNK * 4));
+    if (sent <= 0)
+    {
+        if (sent == 0 || errno != EAGAIN) SV_HTTPClose(conn);
+        return;
+    }
+    n = (int)sent;
+#else
+    static char buffer[HTTP_CHUNK];  // only the HTTP thread writes
+    int len = (int)MIN(conn->remaining, (int64_t)sizeof(buffer));
+
+    if (fseek(conn->file, (long)conn->offset, SEEK_SET) ||
+        (int)fread(buffer, 1, len, conn->file) != len)
+    {
+        SV_HTTPClose(conn);
+        return;
+    }
+
+    n = send(conn->sock, buffer, len, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+        if (socketError != SOCKET_WOULDBLOCK) SV_HTTPClose(conn);
+        return;
+    }
+#endif
+
+    conn->offset += n;
+    conn->remaining -= n;
+    srv->bytesSent += n;
+
+    if (conn->remaining <= 0)
+    {
+        srv->completed++;
+        SV_HTTPClose(conn);
+    }
+}
+
+/*
+=================
+SV_HTTPAccept
+=================
+*/
+static void SV_HTTPAccept(httpServer_t *srv, httpConn_t *conns)
+{
+    SOCKET sock;
+    int i;
+
+    while ((sock = accept(srv->listenSock, NULL, NULL)) != INVALID_SOCKET)
+    {
+        for (i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+        {
+            if (conns[i].sock == INVALID_SOCKET) break;
+        }
+
+        if (i == HTTP_MAX_CONNECTIONS || !SV_HTTPSetNonBlocking(sock))
+        {
+            closesocket(sock);
+            srv->refused++;
+            continue;
+        }
+
+        httpConn_t *conn = &conns[i];
+        conn->sock = sock;
+        conn->lastActive = SV_HTTPMilliseconds();
+        conn->requestLen = 0;
+        conn->headerLen = conn->headerSent = 0;
+        conn->file = NULL;
+        conn->offset = conn->remaining = 0;
+    }
+}
+
+/*
+=================
+SV_HTTPThread
+=================
+*/
+static void SV_HTTPThread(httpServer_t *srv)
+{
+    static httpConn_t conns[HTTP_MAX_CONNECTIONS];
+    int i;
+
+#ifndef _WIN32
+    // a client hanging up mid-transfer must not raise SIGPIPE; it is
+    // delivered to the writing thread, so blocking it here is enough
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+    for (i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+    {
+        conns[i].sock = INVALID_SOCKET;
+        conns[i].file = NULL;
+    }
+
+    while (!srv->quit)
+    {
+        fd_set readSet, writeSet;
+        struct timeval timeout;
+        SOCKET maxSock = srv->listenSock;
+
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_SET(srv->listenSock, &readSet);
+
+        for (i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+        {
+            if (conns[i].sock == INVALID_SOCKET) continue;
+
+            if (conns[i].headerLen)
+                FD_SET(conns[i].sock, &writeSet);
+            else
+                FD_SET(conns[i].sock, &readSet);
+
+            if (conns[i].sock > maxSock) maxSock = conns[i].sock;
+        }
+
+        // wake up regularly to notice shutdown
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        if (select(maxSock + 1, &readSet, &writeSet, NULL, &timeout) < 0) continue;
+
+        if (FD_ISSET(srv->listenSock, &readSet)) SV_HTTPAccept(srv, conns);
+
+        int now = SV_HTTPMilliseconds();
+        for (i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+        {
+            httpConn_t *conn = &conns[i];
+
+            if (conn->sock == INVALID_SOCKET) continue;
+
+            if (FD_ISSET(conn->sock, &readSet))
+            {
+                SV_HTTPRead(srv, conn);
+                conn->lastActive = now;
+            }
+            else if (FD_ISSET(conn->sock, &writeSet))
+            {
+                SV_HTTPWrite(srv, conn);
+                conn->lastActive = now;
+            }
+            else if (now - conn->lastActive > HTTP_TIMEOUT)
+            {
+                SV_HTTPClose(conn);
+            }
+        }
+    }
+
+    for (i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+    {
+        if (conns[i].sock != INVALID_SOCKET) SV_HTTPClose(&conns[i]);
+    }
+}
+
+/*
+=================
+SV_HTTPOpenSocket
+
+Listens on net_ip at the given TCP port
+=================
+*/
+static SOCKET SV_HTTPOpenSocket(int port)
+{
+    struct addrinfo hints, *res;
+    char service[16];
+    const char *host;
+    SOCKET sock;
+    int one = 1;
+
+    ::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    host = Cvar_VariableString("net_ip");
+    if (!*host || !strcmp(host, "0.0.0.0") || !Q_stricmp(host, "localhost")) host = NULL;
+
+    Com_sprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &res))
+    {
+        Com_Printf("WARNING: SV_HTTPOpenSocket: can't resolve %s\n", host);
+        return INVALID_SOCKET;
+    }
+
+    sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sock == INVALID_SOCKET)
+    {
+        Com_Printf("WARNING: SV_HTTPOpenSocket: socket: %i\n", socketError);
+        freeaddrinfo(res);
+        return INVALID_SOCKET;
+    }
+
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one));
+
+    if (bind(sock, res->ai_addr, res->ai_addrlen) || listen(sock, 16) ||
+        !SV_HTTPSetNonBlocking(sock))
+    {
+        Com_Printf("WARNING: SV_HTTPOpenSocket: can't listen on TCP port %d: %i\n", port, socketError);
+        closesocket(sock);
+        freeaddrinfo(res);
+        return INVALID_SOCKET;
+    }
+
+    freeaddrinfo(res);
+    return sock;
+}
+
+/*
+=================
+SV_HTTPStop
+=================
+*/
+static void SV_HTTPStop(void)
+{
+    if (!http) return;
+
+    http->quit = true;
+    http->thread.join();
+    closesocket(http->listenSock);
+
+    delete http;
+    http = NULL;
+
+    Com_Printf("HTTP download server stopped\n");
+}
+
+/*
+=================
+SV_HTTPPublishFiles
+
+Resolves the referenced paks of both protocols for the HTTP thread
+=================
+*/
+static void SV_HTTPPublishFiles(void)
+{
+    std::vector<httpFile_t> files;
+
+    // not tokenized with Cmd_TokenizeString, this can run inside a command
+    for (int alternate = 0; alternate < 2; alternate++)
+    {
+        char names[BIG_INFO_STRING];
+        char *pakName, *next;
+
+        Q_strncpyz(names, FS_ReferencedPakNames(alternate), sizeof(names));
+
+        for (pakName = names; *pakName; pakName = next)
+        {
+            const char *ospath;
+            std::string name;
+            bool listed = false;
+
+            next = strchr(pakName, ' ');
+            if (next)
+                *next++ = '\0';
+            else
+                next = pakName + strlen(pakName);
+
+            if (!*pakName || !(ospath = FS_PakOSPath(pakName))) continue;
+            name = std::string(pakName) + ".pk3";
+
+            for (const auto &file : files)
+            {
+                if (!Q_stricmp(file.name.c_str(), name.c_str())) listed = true;
+            }
+
+            if (!listed) files.push_back({name, ospath});
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(http->lock);
+    http->files.swap(files);
+}
+
+/*
+=================
+SV_HTTPUpdate
+
+Starts, stops or moves the server to follow sv_httpServer and
+sv_httpPort, and republishes the downloadable paks.  Called when a
+map is spawned and whenever either cvar changes.
+=================
+*/
+void SV_HTTPUpdate(void)
+{
+    int port;
+
+    sv_httpServer->modified = false;
+    sv_httpPort->modified = false;
+
+    if (!sv_httpServer->integer || !com_sv_running->integer)
+    {
+        SV_HTTPStop();
+        return;
+    }
+
+    port = sv_httpPort->integer;
+    if (port <= 0) port = Cvar_VariableIntegerValue("net_port");
+
+    if (http && http->port != port) SV_HTTPStop();
+
+    if (!http)
+    {
+        SOCKET sock = SV_HTTPOpenSocket(port);
+
+        if (sock == INVALID_SOCKET) return;
+
+        http = new httpServer_t;
+        http->quit = false;
+        http->listenSock = sock;
+        http->port = port;
+        http->requests = http->completed = http->refused = 0;
+        http->bytesSent = 0;
+        SV_HTTPPublishFiles();
+        http->thread = std::thread(SV_HTTPThread, http);
+
+        Com_Printf("HTTP download server listening on TCP port %d\n", port);
+        if (sv_allowDownload->integer & DLF_NO_REDIRECT)
+            Com_Printf("WARNING: sv_allowDownload forbids download redirection, clients won't use it\n");
+        else
+            Com_Printf("Point sv_dlURL at http://<this server's address>:%d to use it\n", port);
+        return;
+    }
+
+    SV_HTTPPublishFiles();
+}
+
+/*
+=================
+SV_HTTPInit
+=================
+*/
+void SV_HTTPInit(void)
+{
+    sv_httpServer = Cvar_Get("sv_httpServer", "0", CVAR_ARCHIVE);
+    sv_httpPort = Cvar_Get("sv_httpPort", "0", CVAR_ARCHIVE);
+}
+
+/*
+=================
+SV_HTTPFrame
+=================
+*/
+void SV_HTTPFrame(void)
+{
+    if (sv_httpServer->modified || sv_httpPort->modified) SV_HTTPUpdate();
+}
+
+/*
+=================
+SV_HTTPShutdown
+=================
+*/
+void SV_HTTPShutdown(void)
+{
+    SV_HTTPStop();
+}
+
+/*
+=================
+SV_HTTPStatus_f
+=================
+*/
+void SV_HTTPStatus_f(void)
+{
+    if (!http)
+    {
+        Com_Printf("HTTP download server is not running\n");
+        return;
+    }
+
+    Com_Printf("HTTP download server on TCP port %d\n", http->port);
+    {
+        std::lock_guard<std::mutex> lk(http->lock);
+
+        for (const auto &file : http->files)
+            Com_Printf("  %s\n", file.name.c_str());
+        Com_Printf("%d files offered\n", (int)http->files.size());
+    }
+    Com_Printf("%d requests, %d downloads completed, %d refused, %lld KB sent\n",
+        (int)http->requests, (int)http->completed, (int)http->refused,
+        (long long)(http->bytesSent / 1024));
+}
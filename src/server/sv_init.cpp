@@ -748,6 +748,9 @@ void SV_SpawnServer(char *server)
     p = FS_ReferencedPakNames(true);
     Cvar_Set("sv_referencedAlternatePakNames", p);
 
+    // offer the same paks over HTTP
+    SV_HTTPUpdate();
+
     // save systeminfo and serverinfo strings
     Q_strncpyz(systemInfo, Cvar_InfoString_Big(CVAR_SYSTEMINFO), sizeof(systemInfo));
     cvar_modifiedFlags &= ~CVAR_SYSTEMINFO;
@@ -898,6 +901,7 @@ void SV_Init(void)
 
     sv_allowDownload = Cvar_Get("sv_allowDownload", "0", CVAR_SERVERINFO);
     Cvar_Get("sv_dlURL", "http://downloads.tremulous.net", CVAR_SERVERINFO | CVAR_ARCHIVE);
+    SV_HTTPInit();
 
     sv_protect    = Cvar_Get("sv_protect", "3", CVAR_ARCHIVE);
 	sv_protectLog = Cvar_Get("sv_protectLog", "sv_protect.log", CVAR_ARCHIVE);
@@ -984,6 +988,7 @@ void SV_Shutdown(const char *finalmsg)
 
     SV_RemoveOperatorCommands();
     SV_MasterShutdown();
+    SV_HTTPShutdown();
     SV_ShutdownGameProgs();
 
     // free current level
@@ -1216,6 +1216,9 @@ void SV_Frame( int msec ) {
 		return;
 	}
 
+	// follow sv_httpServer and sv_httpPort changes
+	SV_HTTPFrame();
+
 	// allow pause if only the local client is connected
 	if ( SV_CheckPaused() ) {
 		return;
@@ -57,6 +57,9 @@ void Sys_Print(const char *msg);
 // any game related timing information should come from event timestamps
 int Sys_Milliseconds(void);
 
+// high resolution counterpart of Sys_Milliseconds, for profiling only
+int64_t Sys_Microseconds(void);
+
 bool Sys_RandomBytes(byte *string, int len);
 
 void Sys_CryptoRandomBytes(byte *string, int len);
@@ -71,6 +74,9 @@ void Sys_SetErrorText(const char *text);
 FILE *Sys_FOpen(const char *ospath, const char *mode);
 bool Sys_Mkdir(const char *path);
 FILE *Sys_Mkfifo(const char *ospath);
+const void *Sys_MapFile(const char *ospath, long *size);
+void Sys_UnmapFile(const void *data, long size);
+bool Sys_FileStat(const char *ospath, int64_t *size, int64_t *mtime);
 bool Sys_OpenWithDefault( const char *path );
 char *Sys_Cwd(void);
 void Sys_SetDefaultInstallPath(const char *path);
@@ -38,6 +38,7 @@ along with Tremulous; if not, see <https://www.gnu.org/licenses/>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <time.h>
 #include <pwd.h>
 #include <libgen.h>
 #include <fcntl.h>
@@ -115,6 +116,20 @@ int Sys_Milliseconds (void)
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+int64_t Sys_Microseconds (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 /*
 ==================
 Sys_RandomBytes
@@ -260,6 +275,66 @@ FILE *Sys_Mkfifo( const char *ospath )
 	return fifo;
 }
 
+/*
+==================
+Sys_MapFile
+
+Maps a whole file read only, NULL if it can't be mapped
+==================
+*/
+const void *Sys_MapFile( const char *ospath, long *size )
+{
+	struct stat	buf;
+	void		*data;
+	int			fd;
+
+	fd = open( ospath, O_RDONLY );
+	if( fd == -1 )
+		return NULL;
+
+	if( fstat( fd, &buf ) || !buf.st_size )
+	{
+		close( fd );
+		return NULL;
+	}
+
+	data = mmap( NULL, buf.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+
+	if( data == MAP_FAILED )
+		return NULL;
+
+	*size = buf.st_size;
+	return data;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( const void *data, long size )
+{
+	munmap( (void *)data, size );
+}
+
+/*
+==================
+Sys_FileStat
+==================
+*/
+bool Sys_FileStat( const char *ospath, int64_t *size, int64_t *mtime )
+{
+	struct stat	buf;
+
+	if( stat( ospath, &buf ) )
+		return false;
+
+	*size = buf.st_size;
+	*mtime = buf.st_mtime;
+	return true;
+}
+
 /*
 ==============
 Sys_OpenWithDefault
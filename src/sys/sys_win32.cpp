@@ -43,6 +43,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA	02110-1301	USA
 #include <psapi.h>
 #include <float.h>
 #include <shellapi.h>
+#include <sys/stat.h>
 
 #ifndef DEDICATED
 static UINT timerResolution = 0;
@@ -101,6 +102,23 @@ int Sys_Milliseconds (void)
 	return sys_curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+int64_t Sys_Microseconds (void)
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (!frequency.QuadPart)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return counter.QuadPart * 1000000 / frequency.QuadPart;
+}
+
 /*
 ================
 Sys_RandomBytes
@@ -257,6 +275,74 @@ FILE *Sys_Mkfifo( const char *ospath )
 	return NULL;
 }
 
+/*
+==================
+Sys_MapFile
+
+Maps a whole file read only, NULL if it can't be mapped
+==================
+*/
+const void *Sys_MapFile( const char *ospath, long *size )
+{
+	HANDLE	file, mapping;
+	DWORD	high;
+	DWORD	low;
+	void	*data;
+
+	file = CreateFile( ospath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+		return NULL;
+
+	low = GetFileSize( file, &high );
+	if( high || !low || low > 0x7fffffff )
+	{
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if( !mapping )
+		return NULL;
+
+	// the view keeps the mapping alive
+	data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+
+	if( !data )
+		return NULL;
+
+	*size = low;
+	return data;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( const void *data, long size )
+{
+	UnmapViewOfFile( data );
+}
+
+/*
+==================
+Sys_FileStat
+==================
+*/
+bool Sys_FileStat( const char *ospath, int64_t *size, int64_t *mtime )
+{
+	struct _stat64	buf;
+
+	if( _stat64( ospath, &buf ) )
+		return false;
+
+	*size = buf.st_size;
+	*mtime = buf.st_mtime;
+	return true;
+}
+
 /*
 ==============
 Sys_OpenWithDefault